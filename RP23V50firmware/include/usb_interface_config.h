@@ -7,10 +7,10 @@
 // =============================================================================
 // SIMPLE STATIC USB Interface Configuration
 // =============================================================================
-// Fixed configuration: 3 CDC + 1 MSC for testing
+// Fixed configuration: 4 CDC + 1 MSC
 
 // CDC Serial Interfaces (Communication Device Class)  
-#define USB_CDC_ENABLE_COUNT 3
+#define USB_CDC_ENABLE_COUNT 4
 
 // MSC (Mass Storage Class) - Always enabled
 #define USB_MSC_ENABLE 1
@@ -37,7 +37,8 @@
 static const char* USB_CDC_NAMES[] = {
     "Jumperless Main",       // CDC 0 - Main serial
     "Jumperless Serial 1",   // CDC 1 - Arduino/Serial1
-    "Jumperless Serial 2"    // CDC 2 - User serial
+    "Jumperless Serial 2",   // CDC 2 - User serial
+    "Jumperless Logic"       // CDC 3 - Logic analyzer (SUMP / sigrok ols)
 };
 
 #define USB_MSC_NAME     "JL Mass Storage"
@@ -430,10 +430,13 @@ QDEF0(MP_QSTR___sub__, 33, 7, "__sub__")
 QDEF1(MP_QSTR___traceback__, 79, 13, "__traceback__")
 QDEF1(MP_QSTR__machine, 191, 8, "_machine")
 QDEF1(MP_QSTR_acos, 27, 4, "acos")
+QDEF1(MP_QSTR_adc_capture, 248, 11, "adc_capture")
 QDEF1(MP_QSTR_adc_get, 170, 7, "adc_get")
+QDEF1(MP_QSTR_adc_to_voltage, 186, 14, "adc_to_voltage")
 QDEF1(MP_QSTR_add, 68, 3, "add")
 QDEF1(MP_QSTR_addr, 182, 4, "addr")
 QDEF1(MP_QSTR_addrsize, 147, 8, "addrsize")
+QDEF1(MP_QSTR_amplitude, 188, 9, "amplitude")
 QDEF1(MP_QSTR_arduino_reset, 101, 13, "arduino_reset")
 QDEF1(MP_QSTR_arg, 145, 3, "arg")
 QDEF1(MP_QSTR_argv, 199, 4, "argv")
@@ -443,15 +446,19 @@ QDEF1(MP_QSTR_atan, 31, 4, "atan")
 QDEF1(MP_QSTR_atan2, 205, 5, "atan2")
 QDEF1(MP_QSTR_atten, 175, 5, "atten")
 QDEF1(MP_QSTR_available, 156, 9, "available")
+QDEF1(MP_QSTR_begin_batch, 129, 11, "begin_batch")
 QDEF1(MP_QSTR_bin, 224, 3, "bin")
 QDEF1(MP_QSTR_bitstream, 166, 9, "bitstream")
 QDEF1(MP_QSTR_bound_method, 151, 12, "bound_method")
+QDEF1(MP_QSTR_buffer, 229, 6, "buffer")
 QDEF1(MP_QSTR_buffering, 37, 9, "buffering")
 QDEF1(MP_QSTR_button_check, 10, 12, "button_check")
 QDEF1(MP_QSTR_button_read, 254, 11, "button_read")
 QDEF1(MP_QSTR_byteorder, 97, 9, "byteorder")
 QDEF1(MP_QSTR_calcsize, 77, 8, "calcsize")
+QDEF1(MP_QSTR_cancel_batch, 1, 12, "cancel_batch")
 QDEF1(MP_QSTR_ceil, 6, 4, "ceil")
+QDEF1(MP_QSTR_channel, 38, 7, "channel")
 QDEF1(MP_QSTR_chdir, 177, 5, "chdir")
 QDEF1(MP_QSTR_check_button, 234, 12, "check_button")
 QDEF1(MP_QSTR_clickwheel_down, 245, 15, "clickwheel_down")
@@ -461,11 +468,13 @@ QDEF1(MP_QSTR_closure, 116, 7, "closure")
 QDEF1(MP_QSTR_code, 104, 4, "code")
 QDEF1(MP_QSTR_collect, 155, 7, "collect")
 QDEF1(MP_QSTR_collections, 224, 11, "collections")
+QDEF1(MP_QSTR_commit, 180, 6, "commit")
 QDEF1(MP_QSTR_compile, 244, 7, "compile")
 QDEF1(MP_QSTR_complex, 197, 7, "complex")
 QDEF1(MP_QSTR_connect, 219, 7, "connect")
 QDEF1(MP_QSTR_copysign, 51, 8, "copysign")
 QDEF1(MP_QSTR_cos, 122, 3, "cos")
+QDEF1(MP_QSTR_dac, 227, 3, "dac")
 QDEF1(MP_QSTR_dac_get, 138, 7, "dac_get")
 QDEF1(MP_QSTR_dac_set, 158, 7, "dac_set")
 QDEF1(MP_QSTR_decode, 169, 6, "decode")
@@ -487,6 +496,7 @@ QDEF1(MP_QSTR_duty, 25, 4, "duty")
 QDEF1(MP_QSTR_duty_ns, 59, 7, "duty_ns")
 QDEF1(MP_QSTR_duty_u16, 244, 8, "duty_u16")
 QDEF1(MP_QSTR_e, 192, 1, "e")
+QDEF1(MP_QSTR_edge, 198, 4, "edge")
 QDEF1(MP_QSTR_enable, 4, 6, "enable")
 QDEF1(MP_QSTR_enable_irq, 145, 10, "enable_irq")
 QDEF1(MP_QSTR_encode, 67, 6, "encode")
@@ -505,6 +515,7 @@ QDEF1(MP_QSTR_floor, 125, 5, "floor")
 QDEF1(MP_QSTR_flush, 97, 5, "flush")
 QDEF1(MP_QSTR_fmod, 229, 4, "fmod")
 QDEF1(MP_QSTR_freq, 229, 4, "freq")
+QDEF1(MP_QSTR_frequency, 161, 9, "frequency")
 QDEF1(MP_QSTR_frexp, 28, 5, "frexp")
 QDEF1(MP_QSTR_fromkeys, 55, 8, "fromkeys")
 QDEF1(MP_QSTR_fs_cwd, 191, 6, "fs_cwd")
@@ -546,10 +557,12 @@ QDEF1(MP_QSTR_idle, 161, 4, "idle")
 QDEF1(MP_QSTR_ilistdir, 113, 8, "ilistdir")
 QDEF1(MP_QSTR_imag, 71, 4, "imag")
 QDEF1(MP_QSTR_implementation, 23, 14, "implementation")
+QDEF1(MP_QSTR_ina_energy, 94, 10, "ina_energy")
 QDEF1(MP_QSTR_ina_get_bus_voltage, 12, 19, "ina_get_bus_voltage")
 QDEF1(MP_QSTR_ina_get_current, 220, 15, "ina_get_current")
 QDEF1(MP_QSTR_ina_get_power, 234, 13, "ina_get_power")
 QDEF1(MP_QSTR_ina_get_voltage, 183, 15, "ina_get_voltage")
+QDEF1(MP_QSTR_ina_window, 48, 10, "ina_window")
 QDEF1(MP_QSTR_info, 235, 4, "info")
 QDEF1(MP_QSTR_init, 31, 4, "init")
 QDEF1(MP_QSTR_intersection, 40, 12, "intersection")
@@ -605,6 +618,7 @@ QDEF1(MP_QSTR_nodes_clear, 112, 11, "nodes_clear")
 QDEF1(MP_QSTR_nodes_help, 24, 10, "nodes_help")
 QDEF1(MP_QSTR_oct, 253, 3, "oct")
 QDEF1(MP_QSTR_off, 138, 3, "off")
+QDEF1(MP_QSTR_offset, 72, 6, "offset")
 QDEF1(MP_QSTR_oled_clear, 225, 10, "oled_clear")
 QDEF1(MP_QSTR_oled_connect, 6, 12, "oled_connect")
 QDEF1(MP_QSTR_oled_disconnect, 88, 15, "oled_disconnect")
@@ -646,6 +660,7 @@ QDEF1(MP_QSTR_python_compiler, 141, 15, "python_compiler")
 QDEF1(MP_QSTR_qstr_info, 176, 9, "qstr_info")
 QDEF1(MP_QSTR_r, 215, 1, "r")
 QDEF1(MP_QSTR_radians, 135, 7, "radians")
+QDEF1(MP_QSTR_rate, 71, 4, "rate")
 QDEF1(MP_QSTR_read_button, 254, 11, "read_button")
 QDEF1(MP_QSTR_read_probe, 34, 10, "read_probe")
 QDEF1(MP_QSTR_read_u16, 218, 8, "read_u16")
@@ -673,6 +688,7 @@ QDEF1(MP_QSTR_set_pwm, 82, 7, "set_pwm")
 QDEF1(MP_QSTR_set_pwm_duty_cycle, 190, 18, "set_pwm_duty_cycle")
 QDEF1(MP_QSTR_set_pwm_frequency, 233, 17, "set_pwm_frequency")
 QDEF1(MP_QSTR_setter, 4, 6, "setter")
+QDEF1(MP_QSTR_shape, 202, 5, "shape")
 QDEF1(MP_QSTR_sin, 177, 3, "sin")
 QDEF1(MP_QSTR_single, 63, 6, "single")
 QDEF1(MP_QSTR_size, 32, 4, "size")
@@ -701,6 +717,8 @@ QDEF1(MP_QSTR_ticks_ms, 66, 8, "ticks_ms")
 QDEF1(MP_QSTR_ticks_us, 90, 8, "ticks_us")
 QDEF1(MP_QSTR_time, 240, 4, "time")
 QDEF1(MP_QSTR_time_pulse_us, 137, 13, "time_pulse_us")
+QDEF1(MP_QSTR_timeout, 62, 7, "timeout")
+QDEF1(MP_QSTR_trigger, 157, 7, "trigger")
 QDEF1(MP_QSTR_trunc, 91, 5, "trunc")
 QDEF1(MP_QSTR_umount, 221, 6, "umount")
 QDEF1(MP_QSTR_uname, 183, 5, "uname")
@@ -714,6 +732,10 @@ QDEF1(MP_QSTR_version, 191, 7, "version")
 QDEF1(MP_QSTR_version_info, 110, 12, "version_info")
 QDEF1(MP_QSTR_wait_probe, 219, 10, "wait_probe")
 QDEF1(MP_QSTR_wait_touch, 20, 10, "wait_touch")
+QDEF1(MP_QSTR_wave, 32, 4, "wave")
+QDEF1(MP_QSTR_wave_get, 137, 8, "wave_get")
+QDEF1(MP_QSTR_wave_stop, 231, 9, "wave_stop")
+QDEF1(MP_QSTR_wave_table, 193, 10, "wave_table")
 QDEF1(MP_QSTR_width, 35, 5, "width")
 QDEF1(MP_QSTR_write_readinto, 137, 14, "write_readinto")
 QDEF1(MP_QSTR_writeto, 3, 7, "writeto")
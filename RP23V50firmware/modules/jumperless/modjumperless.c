@@ -21,6 +21,7 @@
 #include "py/lexer.h"
 #include "py/mperrno.h"
 #include "py/builtin.h"
+#include "py/binary.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -32,10 +33,21 @@
 void jl_dac_set(int channel, float voltage, int save);
 float jl_dac_get(int channel);
 float jl_adc_get(int channel);
+float jl_adc_capture(int channel, void *buffer, int element_size, int count,
+                     float rate, int use_trigger, float trigger, int edge,
+                     int timeout_ms);
+float jl_adc_raw_to_voltage(int channel, int raw);
+int jl_wave_start(int dac, const char *shape, float frequency, float amplitude,
+                  float offset);
+void jl_wave_stop(int dac);
+int jl_wave_table(int dac, const float *values, int length);
+const char *jl_wave_get(int dac, float *frequency, float *amplitude, float *offset);
 float jl_ina_get_current(int sensor);
 float jl_ina_get_voltage(int sensor);
 float jl_ina_get_bus_voltage(int sensor);
 float jl_ina_get_power(int sensor);
+int jl_ina_window(int sensor, float *out);
+float jl_ina_energy(int sensor, int reset);
 void jl_gpio_set(int pin, int value);
 int jl_gpio_get(int pin);
 void jl_gpio_set_dir(int pin, int direction);
@@ -45,6 +57,11 @@ int jl_gpio_get_pull(int pin);
 int jl_nodes_connect(int node1, int node2, int save);
 int jl_nodes_disconnect(int node1, int node2);
 int jl_nodes_is_connected(int node1, int node2);
+void jl_nodes_begin_batch(void);
+int jl_nodes_commit_batch(int save);
+int jl_nodes_batch_count(void);
+int jl_nodes_batch_result(int index, int *node1, int *node2, int *remove);
+void jl_nodes_cancel_batch(void);
 int jl_nodes_print_bridges(void);
 int jl_nodes_print_paths(void);
 int jl_nodes_print_crossbars(void);
@@ -1062,6 +1079,165 @@ static mp_obj_t jl_adc_get_func(mp_obj_t channel_obj) {
 }
 static MP_DEFINE_CONST_FUN_OBJ_1(jl_adc_get_obj, jl_adc_get_func);
 
+// Block capture, the samples are written straight into the caller's
+// array('H') (raw 12 bit) or bytearray (top 8 bits), nothing is allocated
+static mp_obj_t jl_adc_capture_func(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_channel, ARG_buffer, ARG_rate, ARG_trigger, ARG_edge, ARG_timeout };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_channel, MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_buffer, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_rate, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_trigger, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_edge, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 1} },
+        { MP_QSTR_timeout, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 1000} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    int channel = args[ARG_channel].u_int;
+    if ((channel < 0 || channel > 4) && channel != 7) {
+        mp_raise_ValueError(MP_ERROR_TEXT("ADC channel must be 0-4 or 7"));
+    }
+
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[ARG_buffer].u_obj, &bufinfo, MP_BUFFER_WRITE);
+    int element_size;
+    if (bufinfo.typecode == 'H' || bufinfo.typecode == 'h') {
+        element_size = 2;
+    } else if (bufinfo.typecode == 'B' || bufinfo.typecode == 'b' || bufinfo.typecode == BYTEARRAY_TYPECODE) {
+        element_size = 1;
+    } else {
+        mp_raise_TypeError(MP_ERROR_TEXT("buffer must be array('H') or bytearray"));
+    }
+    int count = bufinfo.len / element_size;
+
+    float rate = 10000.0f;
+    if (args[ARG_rate].u_obj != mp_const_none) {
+        rate = mp_obj_get_float(args[ARG_rate].u_obj);
+    }
+    if (rate < 1.0f || rate > 62500.0f) {
+        mp_raise_ValueError(MP_ERROR_TEXT("ADC capture rate must be 1Hz to 62.5kHz"));
+    }
+
+    int use_trigger = args[ARG_trigger].u_obj != mp_const_none;
+    float trigger = use_trigger ? mp_obj_get_float(args[ARG_trigger].u_obj) : 0.0f;
+
+    float actual = jl_adc_capture(channel, bufinfo.buf, element_size, count, rate,
+                                  use_trigger, trigger, args[ARG_edge].u_int,
+                                  args[ARG_timeout].u_int);
+    if (actual == 0.0f) {
+        mp_raise_OSError(MP_ETIMEDOUT);
+    }
+    if (actual < 0.0f) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("ADC capture fell behind and lost samples"));
+    }
+
+    // the rate can only be the engine's per-channel rate divided down, so
+    // hand back the one that was actually used
+    return mp_obj_new_float(actual);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(jl_adc_capture_obj, 2, jl_adc_capture_func);
+
+static mp_obj_t jl_adc_to_voltage_func(mp_obj_t channel_obj, mp_obj_t raw_obj) {
+    int channel = mp_obj_get_int(channel_obj);
+
+    if (channel < 0 || channel > 7) {
+        mp_raise_ValueError(MP_ERROR_TEXT("ADC channel must be 0-7"));
+    }
+
+    return mp_obj_new_float(jl_adc_raw_to_voltage(channel, mp_obj_get_int(raw_obj)));
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(jl_adc_to_voltage_obj, jl_adc_to_voltage_func);
+
+// Waveform Functions
+static int get_wave_dac(mp_obj_t obj) {
+    int dac = get_dac_channel(obj);
+    if (dac > 1) {
+        mp_raise_ValueError(MP_ERROR_TEXT("Waveforms only run on DAC0 or DAC1"));
+    }
+    return dac;
+}
+
+// Anything left as None keeps the DAC's current setting, so this also
+// retunes a running wave in place without restarting it
+static mp_obj_t jl_wave_func(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_dac, ARG_shape, ARG_frequency, ARG_amplitude, ARG_offset };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_dac, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_shape, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_frequency, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_amplitude, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_offset, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    int dac = get_wave_dac(args[ARG_dac].u_obj);
+    float frequency, amplitude, offset;
+    const char *shape = jl_wave_get(dac, &frequency, &amplitude, &offset);
+
+    if (args[ARG_shape].u_obj != mp_const_none) {
+        shape = mp_obj_str_get_str(args[ARG_shape].u_obj);
+    } else if (strcmp(shape, "off") == 0) {
+        shape = "sine";
+    }
+    if (args[ARG_frequency].u_obj != mp_const_none) {
+        frequency = mp_obj_get_float(args[ARG_frequency].u_obj);
+    }
+    if (args[ARG_amplitude].u_obj != mp_const_none) {
+        amplitude = mp_obj_get_float(args[ARG_amplitude].u_obj);
+    }
+    if (args[ARG_offset].u_obj != mp_const_none) {
+        offset = mp_obj_get_float(args[ARG_offset].u_obj);
+    }
+
+    if (jl_wave_start(dac, shape, frequency, amplitude, offset) < 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("Unknown wave shape, or table before wave_table()"));
+    }
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(jl_wave_obj, 1, jl_wave_func);
+
+static mp_obj_t jl_wave_stop_func(size_t n_args, const mp_obj_t *args) {
+    jl_wave_stop(n_args > 0 ? get_wave_dac(args[0]) : -1);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(jl_wave_stop_obj, 0, 1, jl_wave_stop_func);
+
+// Loads one cycle of an arbitrary wave (-1.0 to 1.0 per entry), start it
+// with wave(dac, "table", frequency) or it swaps in if a table is playing
+static mp_obj_t jl_wave_table_func(mp_obj_t dac_obj, mp_obj_t values_obj) {
+    int dac = get_wave_dac(dac_obj);
+    size_t length;
+    mp_obj_t *items;
+    mp_obj_get_array(values_obj, &length, &items);
+
+    if (length < 2 || length > 1024) {
+        mp_raise_ValueError(MP_ERROR_TEXT("Wave table needs 2 to 1024 values"));
+    }
+    float *values = m_new(float, length);
+    for (size_t i = 0; i < length; i++) {
+        values[i] = mp_obj_get_float(items[i]);
+    }
+    jl_wave_table(dac, values, length);
+    m_del(float, values, length);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(jl_wave_table_obj, jl_wave_table_func);
+
+static mp_obj_t jl_wave_get_func(mp_obj_t dac_obj) {
+    float frequency, amplitude, offset;
+    const char *shape = jl_wave_get(get_wave_dac(dac_obj), &frequency, &amplitude, &offset);
+    mp_obj_t tuple[4] = {
+        mp_obj_new_str(shape, strlen(shape)),
+        mp_obj_new_float(frequency),
+        mp_obj_new_float(amplitude),
+        mp_obj_new_float(offset),
+    };
+    return mp_obj_new_tuple(4, tuple);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(jl_wave_get_obj, jl_wave_get_func);
+
 // INA Functions
 static mp_obj_t jl_ina_get_current_func(mp_obj_t sensor_obj) {
     int sensor = mp_obj_get_int(sensor_obj);
@@ -1119,6 +1295,38 @@ static mp_obj_t jl_ina_get_power_func(mp_obj_t sensor_obj) {
 }
 static MP_DEFINE_CONST_FUN_OBJ_1(jl_ina_get_power_obj, jl_ina_get_power_func);
 
+static mp_obj_t jl_ina_window_func(mp_obj_t sensor_obj) {
+    int sensor = mp_obj_get_int(sensor_obj);
+    
+    if (sensor < 0 || sensor > 1) {
+        mp_raise_ValueError(MP_ERROR_TEXT("INA sensor must be 0 or 1"));
+    }
+    
+    float values[11];
+    if (jl_ina_window(sensor, values) == 0) {
+        return mp_const_none; // monitor off or no readings
+    }
+    mp_obj_t tuple[11];
+    for (int i = 0; i < 10; i++) {
+        tuple[i] = mp_obj_new_float(values[i]);
+    }
+    tuple[10] = mp_obj_new_int((int)values[10]);
+    return mp_obj_new_tuple(11, tuple);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(jl_ina_window_obj, jl_ina_window_func);
+
+static mp_obj_t jl_ina_energy_func(size_t n_args, const mp_obj_t *args) {
+    int sensor = mp_obj_get_int(args[0]);
+    
+    if (sensor < 0 || sensor > 1) {
+        mp_raise_ValueError(MP_ERROR_TEXT("INA sensor must be 0 or 1"));
+    }
+    
+    int reset = n_args > 1 ? mp_obj_is_true(args[1]) : 0;
+    return mp_obj_new_float(jl_ina_energy(sensor, reset));
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(jl_ina_energy_obj, 1, 2, jl_ina_energy_func);
+
 // GPIO Functions
 static mp_obj_t jl_gpio_set_func(mp_obj_t pin_obj, mp_obj_t value_obj) {
     int pin = mp_obj_get_int(pin_obj);
@@ -1344,6 +1552,41 @@ static mp_obj_t jl_nodes_disconnect_func(mp_obj_t node1_obj, mp_obj_t node2_obj)
 }
 static MP_DEFINE_CONST_FUN_OBJ_2(jl_nodes_disconnect_obj, jl_nodes_disconnect_func);
 
+// connect() / disconnect() after begin_batch() are only collected, commit()
+// writes the slot once, routes once and returns (node1, node2, ok) for each
+static mp_obj_t jl_nodes_begin_batch_func(void) {
+    jl_nodes_begin_batch();
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(jl_nodes_begin_batch_obj, jl_nodes_begin_batch_func);
+
+static mp_obj_t jl_nodes_commit_batch_func(size_t n_args, const mp_obj_t *args) {
+    int save = (n_args > 0) ? mp_obj_is_true(args[0]) ? 1 : 0 : 1; // Default save=True
+    
+    jl_nodes_commit_batch(save);
+    
+    mp_obj_t list_obj = mp_obj_new_list(0, NULL);
+    int count = jl_nodes_batch_count();
+    for (int i = 0; i < count; i++) {
+        int node1 = 0, node2 = 0, remove = 0;
+        int result = jl_nodes_batch_result(i, &node1, &node2, &remove);
+        mp_obj_t items[3] = {
+            mp_obj_new_int(node1),
+            mp_obj_new_int(node2),
+            mp_obj_new_bool(result == 1),
+        };
+        mp_obj_list_append(list_obj, mp_obj_new_tuple(3, items));
+    }
+    return list_obj;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(jl_nodes_commit_batch_obj, 0, 1, jl_nodes_commit_batch_func);
+
+static mp_obj_t jl_nodes_cancel_batch_func(void) {
+    jl_nodes_cancel_batch();
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(jl_nodes_cancel_batch_obj, jl_nodes_cancel_batch_func);
+
 static mp_obj_t jl_nodes_clear_func(void) {
     jl_nodes_clear();
     return mp_const_none;
@@ -1962,13 +2205,29 @@ static mp_obj_t jl_help_func(void) {
     mp_printf(&mp_plat_print, "          voltage: -8.0 to 8.0V\n\n");
     mp_printf(&mp_plat_print, "ADC (Analog-to-Digital Converter):\n");
     mp_printf(&mp_plat_print, "  jumperless.adc_get(channel)                  - Read ADC input voltage\n");
-    mp_printf(&mp_plat_print, "  jumperless.get_adc(channel)                  - Alias for adc_get\n\n");
+    mp_printf(&mp_plat_print, "  jumperless.get_adc(channel)                  - Alias for adc_get\n");
+    mp_printf(&mp_plat_print, "  jumperless.adc_capture(channel, buf, rate)   - Fill an array('H') or bytearray\n");
+    mp_printf(&mp_plat_print, "         with samples at rate Hz (up to 62.5kHz), returns the rate used\n");
+    mp_printf(&mp_plat_print, "         trigger=volts waits for a crossing first, edge=1 rising, -1 falling, 0 either\n");
+    mp_printf(&mp_plat_print, "         timeout=ms for the trigger (OSError if it never comes)\n");
+    mp_printf(&mp_plat_print, "  jumperless.adc_to_voltage(channel, raw)      - Convert a captured sample to volts\n");
+    mp_printf(&mp_plat_print, "         (bytearray samples are raw >> 4, multiply by 16 first)\n\n");
     mp_printf(&mp_plat_print, "                                              channel: 0-4\n\n");
+    mp_printf(&mp_plat_print, "Waveforms (DAC0 / DAC1, run in the background):\n");
+    mp_printf(&mp_plat_print, "  jumperless.wave(dac, shape, frequency, amplitude, offset)\n");
+    mp_printf(&mp_plat_print, "         - Start or retune a wave, amplitude is peak to peak volts, offset is the middle\n");
+    mp_printf(&mp_plat_print, "         shape: sine, square, triangle, sawtooth, noise, table, off\n");
+    mp_printf(&mp_plat_print, "         anything left out keeps its current value, up to 5kHz\n");
+    mp_printf(&mp_plat_print, "  jumperless.wave_stop(dac)                    - Stop a wave and hold its offset (no dac = both)\n");
+    mp_printf(&mp_plat_print, "  jumperless.wave_table(dac, values)           - Load one cycle (2-1024 values, -1.0 to 1.0)\n");
+    mp_printf(&mp_plat_print, "  jumperless.wave_get(dac)                     - (shape, frequency, amplitude, offset)\n\n");
     mp_printf(&mp_plat_print, "INA (Current/Power Monitor):\n");
     mp_printf(&mp_plat_print, "  jumperless.ina_get_current(sensor)          - Read current in amps\n");
     mp_printf(&mp_plat_print, "  jumperless.ina_get_voltage(sensor)          - Read shunt voltage\n");
     mp_printf(&mp_plat_print, "  jumperless.ina_get_bus_voltage(sensor)      - Read bus voltage\n");
     mp_printf(&mp_plat_print, "  jumperless.ina_get_power(sensor)            - Read power in watts\n");
+    mp_printf(&mp_plat_print, "  jumperless.ina_window(sensor)               - Wait for the next window: mean/min/max amps, volts, watts, joules, samples\n");
+    mp_printf(&mp_plat_print, "  jumperless.ina_energy(sensor, [reset])      - Joules since the last reset\n");
     mp_printf(&mp_plat_print, "  Aliases: get_current, get_voltage, get_bus_voltage, get_power\n\n");
     mp_printf(&mp_plat_print, "             sensor: 0 or 1\n\n");
     mp_printf(&mp_plat_print, "GPIO:\n");
@@ -2002,6 +2261,10 @@ static mp_obj_t jl_help_func(void) {
     mp_printf(&mp_plat_print, "  jumperless.is_connected(node1, node2)       - Check if nodes are connected\n\n");
     mp_printf(&mp_plat_print, "  jumperless.nodes_clear()                    - Clear all connections\n");
     mp_printf(&mp_plat_print, "         set node2 to -1 to disconnect everything connected to node1\n\n");
+    mp_printf(&mp_plat_print, "  jumperless.begin_batch()                    - Collect connect()/disconnect() calls\n");
+    mp_printf(&mp_plat_print, "  jumperless.commit(save=True)                - Write and route them all at once,\n");
+    mp_printf(&mp_plat_print, "         returns a list of (node1, node2, ok) for each one\n");
+    mp_printf(&mp_plat_print, "  jumperless.cancel_batch()                   - Drop the collected calls\n\n");
     mp_printf(&mp_plat_print, "OLED Display:\n");
     mp_printf(&mp_plat_print, "  jumperless.oled_print(\"text\")               - Display text\n");
     mp_printf(&mp_plat_print, "  jumperless.oled_clear()                     - Clear display\n");
@@ -2857,6 +3120,14 @@ static const mp_rom_map_elem_t jumperless_module_globals_table[] = {
     
     // ADC functions
     { MP_ROM_QSTR(MP_QSTR_adc_get), MP_ROM_PTR(&jl_adc_get_obj) },
+    { MP_ROM_QSTR(MP_QSTR_adc_capture), MP_ROM_PTR(&jl_adc_capture_obj) },
+    { MP_ROM_QSTR(MP_QSTR_adc_to_voltage), MP_ROM_PTR(&jl_adc_to_voltage_obj) },
+
+    // Waveform functions
+    { MP_ROM_QSTR(MP_QSTR_wave), MP_ROM_PTR(&jl_wave_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wave_stop), MP_ROM_PTR(&jl_wave_stop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wave_table), MP_ROM_PTR(&jl_wave_table_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wave_get), MP_ROM_PTR(&jl_wave_get_obj) },
     
     // ADC function aliases
     { MP_ROM_QSTR(MP_QSTR_get_adc), MP_ROM_PTR(&jl_adc_get_obj) },
@@ -2866,6 +3137,8 @@ static const mp_rom_map_elem_t jumperless_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_ina_get_voltage), MP_ROM_PTR(&jl_ina_get_voltage_obj) },
     { MP_ROM_QSTR(MP_QSTR_ina_get_bus_voltage), MP_ROM_PTR(&jl_ina_get_bus_voltage_obj) },
     { MP_ROM_QSTR(MP_QSTR_ina_get_power), MP_ROM_PTR(&jl_ina_get_power_obj) },
+    { MP_ROM_QSTR(MP_QSTR_ina_window), MP_ROM_PTR(&jl_ina_window_obj) },
+    { MP_ROM_QSTR(MP_QSTR_ina_energy), MP_ROM_PTR(&jl_ina_energy_obj) },
     
     // INA function aliases
     { MP_ROM_QSTR(MP_QSTR_get_ina_current), MP_ROM_PTR(&jl_ina_get_current_obj) },
@@ -2910,6 +3183,9 @@ static const mp_rom_map_elem_t jumperless_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_disconnect), MP_ROM_PTR(&jl_nodes_disconnect_obj) },
     { MP_ROM_QSTR(MP_QSTR_nodes_clear), MP_ROM_PTR(&jl_nodes_clear_obj) },
     { MP_ROM_QSTR(MP_QSTR_is_connected), MP_ROM_PTR(&jl_nodes_is_connected_obj) },
+    { MP_ROM_QSTR(MP_QSTR_begin_batch), MP_ROM_PTR(&jl_nodes_begin_batch_obj) },
+    { MP_ROM_QSTR(MP_QSTR_commit), MP_ROM_PTR(&jl_nodes_commit_batch_obj) },
+    { MP_ROM_QSTR(MP_QSTR_cancel_batch), MP_ROM_PTR(&jl_nodes_cancel_batch_obj) },
 
 
     
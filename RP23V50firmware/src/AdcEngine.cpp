@@ -0,0 +1,471 @@
+// SPDX-License-Identifier: MIT
+#include "AdcEngine.h"
+
+#include <string.h>
+
+//! View and capture section, down to the DMA section this only needs
+//! AdcEngine.h, so it can be run on a PC against a ring filled from a
+//! synthetic source
+
+/// @brief How many of the first `written` stream samples belong to channel
+static uint64_t channelSamples(uint64_t written, uint32_t channel,
+                               uint32_t stride) {
+  return written > channel ? (written - channel - 1) / stride + 1 : 0;
+}
+
+uint32_t adcViewDepth(const struct adcView *view, uint64_t written) {
+  uint64_t count = channelSamples(written, view->channel, view->stride);
+  uint32_t safe = (view->size - view->guard) / view->stride;
+  return count < safe ? (uint32_t)count : safe;
+}
+
+/// @brief The nth newest sample of this channel (0 = newest), caller checks depth
+static int viewSample(const struct adcView *view, uint64_t written,
+                      uint32_t nth) {
+  uint64_t count = channelSamples(written, view->channel, view->stride);
+  uint64_t k = view->channel + (count - 1 - nth) * view->stride;
+  return view->ring[k & (view->size - 1)];
+}
+
+int adcViewLatest(const struct adcView *view, uint64_t written) {
+  if (adcViewDepth(view, written) == 0) {
+    return -1;
+  }
+  return viewSample(view, written, 0);
+}
+
+int adcViewAverage(const struct adcView *view, uint64_t written, int n) {
+  uint32_t depth = adcViewDepth(view, written);
+  if (n > (int)depth) {
+    n = depth;
+  }
+  if (n <= 0) {
+    return -1;
+  }
+  uint32_t sum = 0;
+  for (int i = 0; i < n; i++) {
+    sum += viewSample(view, written, i);
+  }
+  return (sum + n / 2) / n;
+}
+
+int adcViewMinMax(const struct adcView *view, uint64_t written, int n,
+                  int *min, int *max) {
+  uint32_t depth = adcViewDepth(view, written);
+  if (n > (int)depth) {
+    n = depth;
+  }
+  if (n <= 0) {
+    return 0;
+  }
+  *min = 0xffff;
+  *max = 0;
+  for (int i = 0; i < n; i++) {
+    int sample = viewSample(view, written, i);
+    if (sample < *min) {
+      *min = sample;
+    }
+    if (sample > *max) {
+      *max = sample;
+    }
+  }
+  return n;
+}
+
+int adcViewDecimate(const struct adcView *view, uint64_t written, int factor,
+                    uint16_t *out, int maxOut) {
+  if (factor < 1) {
+    factor = 1;
+  }
+  int blocks = adcViewDepth(view, written) / factor;
+  if (blocks > maxOut) {
+    blocks = maxOut;
+  }
+  // newest block goes last, so walk backwards from the end of out[]
+  for (int b = 0; b < blocks; b++) {
+    uint32_t sum = 0;
+    for (int i = 0; i < factor; i++) {
+      sum += viewSample(view, written, b * factor + i);
+    }
+    out[blocks - 1 - b] = (sum + factor / 2) / factor;
+  }
+  return blocks;
+}
+
+void adcCaptureBegin(struct adcCapture *cap, void *out, int elementSize,
+                     int count, int factor, int level, int edge) {
+  cap->out = out;
+  cap->elementSize = elementSize;
+  cap->count = count;
+  cap->filled = 0;
+  cap->factor = factor < 1 ? 1 : factor;
+  cap->phase = 0;
+  cap->sum = 0;
+  cap->level = level;
+  cap->edge = edge;
+  cap->previous = -1;
+  cap->triggered = level < 0;
+}
+
+int adcCaptureFeed(struct adcCapture *cap, uint16_t sample) {
+  if (cap->filled >= cap->count) {
+    return 1;
+  }
+  cap->sum += sample;
+  if (++cap->phase < cap->factor) {
+    return 0;
+  }
+  int value = (cap->sum + cap->factor / 2) / cap->factor;
+  cap->sum = 0;
+  cap->phase = 0;
+
+  if (cap->triggered == 0) {
+    int previous = cap->previous;
+    cap->previous = value;
+    if (previous < 0) {
+      return 0;
+    }
+    int rising = previous < cap->level && value >= cap->level;
+    int falling = previous > cap->level && value <= cap->level;
+    if ((cap->edge >= 0 && rising) || (cap->edge <= 0 && falling)) {
+      cap->triggered = 1;
+    } else {
+      return 0;
+    }
+  }
+
+  if (cap->elementSize == 1) {
+    ((uint8_t *)cap->out)[cap->filled] = value >> 4;
+  } else {
+    ((uint16_t *)cap->out)[cap->filled] = value;
+  }
+  cap->filled++;
+  return cap->filled >= cap->count;
+}
+
+uint64_t adcViewCount(const struct adcView *view, uint64_t written) {
+  return channelSamples(written, view->channel, view->stride);
+}
+
+int adcCaptureFactor(unsigned long engineRate, float rate) {
+  float channelRate = (float)engineRate / ADC_ENGINE_CHANNELS;
+  int factor = (int)(channelRate / rate + 0.5f);
+  return factor < 1 ? 1 : factor;
+}
+
+int adcCaptureDrain(struct adcCapture *cap, const struct adcView *view,
+                    uint64_t written, uint64_t *cursor) {
+  uint64_t available = adcViewCount(view, written);
+  uint32_t safe = (view->size - view->guard) / view->stride;
+  if (available - *cursor > safe) {
+    return -1;
+  }
+  int done = cap->filled >= cap->count;
+  while (*cursor < available && done == 0) {
+    uint64_t k = view->channel + *cursor * view->stride;
+    done = adcCaptureFeed(cap, view->ring[k & (view->size - 1)]);
+    (*cursor)++;
+  }
+  return done;
+}
+
+//! DMA side: the ADC round-robins ADC0-7 and one channel streams the FIFO
+//! into adcRing with the write address wrapping on the ring. The count runs
+//! down from ADC_DMA_COUNT, the IRQ restarts it and moves adcArmedBase on.
+
+#ifdef ARDUINO
+#include "JumperlessDefines.h"
+#include "Peripherals.h"
+
+#include <Arduino.h>
+
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+#define ADC_DMA_COUNT 0x00100000 // ~2 s at 500k, only sets how often the IRQ runs
+
+static uint16_t adcRing[ADC_RING_SAMPLES]
+    __attribute__((aligned(ADC_RING_SAMPLES * 2)));
+
+volatile int adcEngineRunning = 0;
+struct adcEngineStats adcStats = {};
+
+static int adcDmaChannel = -1;
+static unsigned long adcRate = 0;
+static volatile uint64_t adcArmedBase = 0;
+static volatile uint32_t adcArmSeq = 0; // odd while the IRQ is rearming
+
+static uint64_t rateWritten = 0;
+static unsigned long rateMicros = 0;
+
+static void adcDmaIrq(void) {
+  if (adcDmaChannel < 0 || !dma_channel_get_irq1_status(adcDmaChannel)) {
+    return;
+  }
+  dma_channel_acknowledge_irq1(adcDmaChannel);
+
+  adcArmSeq++;
+  // write address carries on from where it stopped, still inside the ring
+  dma_channel_set_trans_count(adcDmaChannel, ADC_DMA_COUNT, true);
+  adcArmedBase += ADC_DMA_COUNT;
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  adcArmSeq++;
+
+  adcStats.rearms++;
+  if (adc_hw->fcs & ADC_FCS_OVER_BITS) {
+    hw_set_bits(&adc_hw->fcs, ADC_FCS_OVER_BITS); // write 1 to clear
+    adcStats.fifoOverruns++;
+  }
+}
+
+uint64_t adcSamplesWritten(void) {
+  if (adcEngineRunning == 0) {
+    return 0;
+  }
+  uint32_t seq;
+  uint64_t base;
+  uint32_t remaining;
+  do {
+    seq = adcArmSeq;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    base = adcArmedBase;
+    remaining = dma_channel_hw_addr(adcDmaChannel)->transfer_count &
+                0x0fffffff;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  } while ((seq & 1) != 0 || seq != adcArmSeq);
+  return base + (ADC_DMA_COUNT - remaining);
+}
+
+static void adcChannelView(struct adcView *view, int channel) {
+  view->ring = adcRing;
+  view->size = ADC_RING_SAMPLES;
+  view->stride = ADC_ENGINE_CHANNELS;
+  view->channel = channel;
+  view->guard = ADC_RING_GUARD;
+}
+
+void startAdcEngine(unsigned long rate) {
+  stopAdcEngine();
+  if (rate == 0) {
+    return;
+  }
+  if (rate > ADC_MAX_RATE) {
+    rate = ADC_MAX_RATE;
+  } else if (rate < ADC_MIN_RATE) {
+    rate = ADC_MIN_RATE;
+  }
+
+  adc_init();
+  for (int i = 0; i < ADC_ENGINE_CHANNELS; i++) {
+    adc_gpio_init(ADC0_PIN + i);
+  }
+  adc_select_input(0); // round robin starts here, so sample k is channel k % 8
+  adc_set_round_robin((1 << ADC_ENGINE_CHANNELS) - 1);
+  adc_fifo_setup(true, true, 1, false, false);
+  // one conversion takes 96 clocks of the 48MHz ADC clock, clkdiv stretches it
+  adc_set_clkdiv(48000000.0f / rate - 1.0f);
+  adc_fifo_drain();
+
+  if (adcDmaChannel < 0) {
+    adcDmaChannel = dma_claim_unused_channel(true);
+    dma_channel_set_irq1_enabled(adcDmaChannel, true);
+    irq_add_shared_handler(DMA_IRQ_1, adcDmaIrq,
+                           PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+  }
+
+  dma_channel_config config = dma_channel_get_default_config(adcDmaChannel);
+  channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+  channel_config_set_read_increment(&config, false);
+  channel_config_set_write_increment(&config, true);
+  channel_config_set_ring(&config, true, ADC_RING_BITS);
+  channel_config_set_dreq(&config, DREQ_ADC);
+
+  adcArmedBase = 0;
+  adcArmSeq = 0;
+  dma_channel_configure(adcDmaChannel, &config, adcRing, &adc_hw->fifo,
+                        ADC_DMA_COUNT, true);
+
+  adcRate = rate;
+  adcEngineRunning = 1;
+  rateWritten = 0;
+  rateMicros = micros();
+  adc_run(true);
+}
+
+void stopAdcEngine(void) {
+  if (adcEngineRunning == 0) {
+    return;
+  }
+  adcEngineRunning = 0;
+  adc_run(false);
+  dma_channel_abort(adcDmaChannel);
+  adc_set_round_robin(0);
+  adc_fifo_setup(false, false, 0, false, false);
+  adc_fifo_drain();
+}
+
+int adcLatest(int channel) {
+  if (channel < 0 || channel >= ADC_ENGINE_CHANNELS) {
+    return 0;
+  }
+  if (adcEngineRunning == 0) {
+    return readAdc(channel, 1);
+  }
+  struct adcView view;
+  adcChannelView(&view, channel);
+  int sample = adcViewLatest(&view, adcSamplesWritten());
+  return sample < 0 ? adcFresh(channel, 1) : sample;
+}
+
+int adcAverage(int channel, int samples) {
+  if (channel < 0 || channel >= ADC_ENGINE_CHANNELS) {
+    return 0;
+  }
+  if (adcEngineRunning == 0) {
+    return readAdc(channel, samples);
+  }
+  struct adcView view;
+  adcChannelView(&view, channel);
+  int average = adcViewAverage(&view, adcSamplesWritten(), samples);
+  // only right after starting, before the channel's first conversion
+  return average < 0 ? adcFresh(channel, 1) : average;
+}
+
+int adcDecimate(int channel, int factor, uint16_t *out, int maxOut) {
+  if (channel < 0 || channel >= ADC_ENGINE_CHANNELS ||
+      adcEngineRunning == 0) {
+    return 0;
+  }
+  struct adcView view;
+  adcChannelView(&view, channel);
+  return adcViewDecimate(&view, adcSamplesWritten(), factor, out, maxOut);
+}
+
+int adcFresh(int channel, int samples) {
+  if (channel < 0 || channel >= ADC_ENGINE_CHANNELS) {
+    return 0;
+  }
+  if (adcEngineRunning == 0) {
+    return readAdc(channel, samples);
+  }
+  struct adcView view;
+  adcChannelView(&view, channel);
+  int maxSamples = (ADC_RING_SAMPLES - ADC_RING_GUARD) / ADC_ENGINE_CHANNELS;
+  if (samples > maxSamples) {
+    samples = maxSamples;
+  } else if (samples < 1) {
+    samples = 1;
+  }
+
+  adcStats.freshWaits++;
+  // +1 lap so a conversion already underway when we got here doesn't count
+  uint64_t target = adcSamplesWritten() +
+                    (uint64_t)(samples + 1) * ADC_ENGINE_CHANNELS;
+  unsigned long timeout =
+      (unsigned long)((samples + 1) * ADC_ENGINE_CHANNELS * 2000000ULL /
+                      adcRate) +
+      1000;
+  unsigned long start = micros();
+  uint64_t written;
+  while ((written = adcSamplesWritten()) < target) {
+    if (micros() - start > timeout) {
+      adcStats.freshTimeouts++;
+      break;
+    }
+  }
+  int average = adcViewAverage(&view, written, samples);
+  return average < 0 ? 0 : average;
+}
+
+float adcCaptureRun(int channel, void *out, int elementSize, int count,
+                    float rate, int level, int edge, unsigned long timeoutMs) {
+  if (channel < 0 || channel >= ADC_ENGINE_CHANNELS || count <= 0 ||
+      rate <= 0) {
+    return -1;
+  }
+  unsigned long previousRate = adcEngineRunning == 1 ? adcRate : 0;
+  unsigned long needed = (unsigned long)(rate * ADC_ENGINE_CHANNELS);
+  if (adcEngineRunning == 0 || adcRate < needed) {
+    startAdcEngine(needed > ADC_MAX_RATE ? ADC_MAX_RATE : needed);
+  }
+
+  float channelRate = (float)adcRate / ADC_ENGINE_CHANNELS;
+  int factor = adcCaptureFactor(adcRate, rate);
+  struct adcCapture cap;
+  adcCaptureBegin(&cap, out, elementSize, count, factor, level, edge);
+  adcStats.captures++;
+
+  struct adcView view;
+  adcChannelView(&view, channel);
+  uint64_t cursor = adcViewCount(&view, adcSamplesWritten());
+  unsigned long start = millis();
+  float result = channelRate / factor;
+
+  while (cap.filled < count) {
+    if (adcCaptureDrain(&cap, &view, adcSamplesWritten(), &cursor) < 0) {
+      adcStats.captureOverruns++;
+      result = -1;
+      break;
+    }
+    if (cap.triggered == 0 && millis() - start > timeoutMs) {
+      result = 0;
+      break;
+    }
+  }
+
+  if (previousRate != adcRate) {
+    startAdcEngine(previousRate);
+  }
+  return result;
+}
+
+float adcEffectiveRate(void) {
+  if (adcEngineRunning == 0) {
+    return 0.0;
+  }
+  uint64_t written = adcSamplesWritten();
+  unsigned long now = micros();
+  float rate = 0.0;
+  if (now != rateMicros) {
+    rate = (float)(written - rateWritten) * 1000000.0 /
+           (float)(now - rateMicros) / ADC_ENGINE_CHANNELS;
+  }
+  rateWritten = written;
+  rateMicros = now;
+  return rate;
+}
+
+void printAdcEngineStats(void) {
+  Serial.print("\n\rADC engine:\t");
+  if (adcEngineRunning == 0) {
+    Serial.println("off (readAdc uses analogRead)");
+    return;
+  }
+  Serial.print(adcRate / ADC_ENGINE_CHANNELS);
+  Serial.print(" S/s per channel set, ");
+  Serial.print(adcEffectiveRate(), 0);
+  Serial.print(" measured, DMA ch ");
+  Serial.println(adcDmaChannel);
+  Serial.print("  samples:\t");
+  Serial.print((unsigned long)(adcSamplesWritten() / ADC_ENGINE_CHANNELS));
+  Serial.print(" per channel\trearms ");
+  Serial.print(adcStats.rearms);
+  Serial.print("\toverruns ");
+  Serial.println(adcStats.fifoOverruns);
+  Serial.print("  fresh reads:\t");
+  Serial.print(adcStats.freshWaits);
+  Serial.print("\ttimeouts ");
+  Serial.print(adcStats.freshTimeouts);
+  Serial.print("\tcaptures ");
+  Serial.print(adcStats.captures);
+  Serial.print("\tfell behind ");
+  Serial.println(adcStats.captureOverruns);
+  Serial.print("  latest:\t");
+  for (int i = 0; i < ADC_ENGINE_CHANNELS; i++) {
+    Serial.print(adcLatest(i));
+    Serial.print(i < ADC_ENGINE_CHANNELS - 1 ? "\t" : "\n\r");
+  }
+}
+#endif
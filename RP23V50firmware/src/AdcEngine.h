@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: MIT
+#ifndef ADCENGINE_H
+#define ADCENGINE_H
+
+#include <stdint.h>
+
+#define ADC_ENGINE_CHANNELS 8     // ADC0-7, round robin order, power of 2
+#define ADC_RING_SAMPLES 4096     // 8 KB, all channels interleaved
+#define ADC_RING_BITS 13          // log2(ADC_RING_SAMPLES * 2 bytes)
+#define ADC_RING_GUARD 512        // samples the DMA may overwrite mid-read
+#define ADC_MAX_RATE 500000       // samples/s shared by all channels
+#define ADC_MIN_RATE 1000
+
+/// @brief One channel's slice of an interleaved sample ring.
+/// Sample k of the stream (k counts every sample ever written, across all
+/// channels) lives at ring[k % size] and belongs to channel k % stride.
+/// The newest `guard` slots are left alone since the writer may be lapping them.
+struct adcView {
+  const volatile uint16_t *ring;
+  uint32_t size;
+  uint32_t stride;
+  uint32_t channel;
+  uint32_t guard;
+};
+
+//! Portable: only needs this header, so views and captures can be checked
+//! against a synthetic ring on a PC
+/// @brief How many of this channel's samples are in the ring and safe to read
+uint32_t adcViewDepth(const struct adcView *view, uint64_t written);
+/// @brief Newest sample, or -1 if the channel hasn't been sampled yet
+int adcViewLatest(const struct adcView *view, uint64_t written);
+/// @brief Mean of the newest n samples (fewer if the ring doesn't have them)
+int adcViewAverage(const struct adcView *view, uint64_t written, int n);
+int adcViewMinMax(const struct adcView *view, uint64_t written, int n,
+                  int *min, int *max);
+/// @brief Box-car decimate the newest samples, oldest first in out[].
+/// Each output is the mean of `factor` inputs, returns how many were written.
+int adcViewDecimate(const struct adcView *view, uint64_t written, int factor,
+                    uint16_t *out, int maxOut);
+
+/// @brief Decimates one channel's sample stream into a caller's buffer,
+/// waiting for a trigger crossing first if there is one
+struct adcCapture {
+  void *out;
+  int elementSize; // 1 = top 8 bits, 2 = raw 12 bit samples
+  int count;
+  int filled;
+  int factor; // inputs averaged into each output
+  int phase;
+  uint32_t sum;
+  int level;    // raw trigger level, -1 starts right away
+  int edge;     // 1 rising, -1 falling, 0 either
+  int previous; // last output before the trigger, -1 = none yet
+  int triggered;
+};
+
+void adcCaptureBegin(struct adcCapture *cap, void *out, int elementSize,
+                     int count, int factor, int level, int edge);
+/// @brief Push one input sample, returns 1 once the buffer is full
+int adcCaptureFeed(struct adcCapture *cap, uint16_t sample);
+/// @brief Samples of this channel the first `written` of the stream hold,
+/// a capture's cursor starts here
+uint64_t adcViewCount(const struct adcView *view, uint64_t written);
+/// @brief Inputs averaged per output to get close to rate per second out of
+/// an engine running at engineRate samples/s over all channels
+int adcCaptureFactor(unsigned long engineRate, float rate);
+/// @brief Feed a capture everything its channel has from *cursor up to
+/// `written`. Returns 1 once it's full, 0 if it caught up with the writer,
+/// -1 if the writer lapped the cursor and samples were lost.
+int adcCaptureDrain(struct adcCapture *cap, const struct adcView *view,
+                    uint64_t written, uint64_t *cursor);
+
+struct adcEngineStats {
+  unsigned long rearms;       // DMA count exhaustions (every ~2 s at 500k)
+  unsigned long fifoOverruns; // ADC FIFO overflowed, DMA fell behind
+  unsigned long freshWaits;   // adcFresh() calls
+  unsigned long freshTimeouts;
+  unsigned long captures;
+  unsigned long captureOverruns; // capture loop got lapped by the DMA
+};
+
+extern volatile int adcEngineRunning;
+extern struct adcEngineStats adcStats;
+
+/// @brief Free-run the ADC over ADC0-7 into the sample ring, rate is total
+/// samples/s so each channel gets rate / 8. 0 stops it and readAdc() goes back
+/// to analogRead().
+void startAdcEngine(unsigned long rate);
+void stopAdcEngine(void);
+/// @brief Samples written since the engine started, all channels
+uint64_t adcSamplesWritten(void);
+
+/// @brief Non-blocking, newest raw 12 bit reading
+int adcLatest(int channel);
+/// @brief Non-blocking, mean of the newest samples already in the ring
+int adcAverage(int channel, int samples);
+/// @brief Non-blocking, the newest samples averaged in blocks of factor,
+/// oldest block first. Returns how many blocks there were (0 if it's off).
+int adcDecimate(int channel, int factor, uint16_t *out, int maxOut);
+/// @brief Waits for `samples` new conversions on this channel and averages
+/// them, for reads that have to come after something changed (a crosspoint)
+int adcFresh(int channel, int samples);
+
+/// @brief Fill out[] with count samples of channel at (close to) rate per
+/// second. The engine is sped up for the capture if it's running slower than
+/// that. Returns the rate actually used, 0 if the trigger never came within
+/// timeoutMs, -1 if the capture fell behind the DMA and lost samples.
+float adcCaptureRun(int channel, void *out, int elementSize, int count,
+                    float rate, int level, int edge, unsigned long timeoutMs);
+
+/// @brief Per-channel rate actually measured off the DMA since the last call
+float adcEffectiveRate(void);
+void printAdcEngineStats(void);
+
+#endif
@@ -1,5 +1,6 @@
 #include "Apps.h"
 #include "ArduinoStuff.h"
+#include "BoardScan.h"
 #include "CH446Q.h"
 #include "Commands.h"
 #include "FileParsing.h"
@@ -199,15 +200,15 @@ void customApp(void) {
   b.clear();
   delay(1000);
   b.print("This isa demo", (uint32_t)0x002008);
-  showLEDsCore2 = 2;
+  queueShowLEDs(2);
   delay(2000);
   b.clear();
   b.print("It will show", (uint32_t)0x002008);
-  // showLEDsCore2 = -2;
+  // queueShowLEDs(-2);
   delay(1000);
   b.clear();
   b.print("random stuff", (uint32_t)0x002008);
-  // showLEDsCore2 = -2;
+  // queueShowLEDs(-2);
   delay(1000);
   b.clear();
   b.print("look atthe FW", (uint32_t)0x002008);
@@ -366,9 +367,9 @@ void customApp(void) {
     return;
   }
   //! printing stuff on the breadboard
-  showLEDsCore2 =
-      -3; // this tells the second core to write to the LEDs (negative numbers
-          // clear first, check loop1() in main.cpp to see what it's doing)
+  queueShowLEDs(-3); // this tells the second core to write to the LEDs
+                     // (negative numbers clear first, check core2stuff() in
+                     // main.cpp to see what it's doing)
   // 3 or -3 will "hold" control of the LEDs (so animations and other stuff
   // aren't drawn)
 
@@ -391,7 +392,7 @@ void customApp(void) {
                          (uint32_t)rgbTextColor.b;
     b.print("Fuck    you!", (uint32_t)textColor);
 
-    showLEDsCore2 = -3;
+    queueShowLEDs(-3);
     delayMicroseconds(200);
   }
 
@@ -411,9 +412,9 @@ void customApp(void) {
   //! get row input from the probe
   b.clear();
   b.print(" Tap    Rows!", (uint32_t)0x00140a);
-  showLEDsCore2 = -3;
+  queueShowLEDs(-3);
   delay(100);
-  showLEDsCore2 = -1; //-1 will clear and then draw the wires as they are in the
+  queueShowLEDs(-1); //-1 will clear and then draw the wires as they are in the
                       // node file (without any extra stuff we drew)
 
   // check for tapped rows until the probe button is pressed
@@ -442,7 +443,7 @@ void customApp(void) {
 
       b.print(probeRow, (uint32_t)0x002008); // this will print the row number
                                              // on the breadboard
-      // showLEDsCore2 = -2;
+      // queueShowLEDs(-2);
       lastProbedRow = probeRow;
       delayMicroseconds(100);
     }
@@ -488,7 +489,7 @@ void customApp(void) {
     addBridgeToNodeFile(1, i, netSlot, 1);
     refreshLocalConnections(-1, 0); // you still need to refresh connections
 
-    showLEDsCore2 = -1;
+    queueShowLEDs(-1);
     waitCore2(); // wait for the other core to finish
   }
 
@@ -504,7 +505,7 @@ void customApp(void) {
     removeBridgeFromNodeFile(31, i - 1, netSlot, 0);
     addBridgeToNodeFile(31, i, netSlot, 0);
     refreshConnections(-1, 0); // you still need to refresh connections
-    showLEDsCore2 = -1;
+    queueShowLEDs(-1);
     // waitCore2(); //wait for the other core to finish
     if (digitalRead(BUTTON_ENC) == 0 || Serial.available() > 0) {
       leaveApp(lastNetSlot);
@@ -770,7 +771,7 @@ void bounceStartup(void) {
       break;
     }
     // clearLEDsExceptRails();
-    // showLEDsCore2 = 1;
+    // queueShowLEDs(1);
 
     // delay(2000);
     // rainbowBounce(3);
@@ -778,7 +779,7 @@ void bounceStartup(void) {
   pauseCore2 = 0;
   // showNets();
   // lightUpRail(-1, -1, 1);
-  showLEDsCore2 = -1;
+  queueShowLEDs(-1);
   waitCore2();
 }
 
@@ -789,7 +790,7 @@ void scanBoard(void) {
   refreshConnections(-1, 0);
 
   Serial.println("\n\n\r");
-  // showLEDsCore2 = -1;
+  // queueShowLEDs(-1);
 
   int lastRow = 0;
   int lastFloat = 0;
@@ -798,6 +799,10 @@ void scanBoard(void) {
 
   while (Serial.available() == 0 && leave == 0) {
 
+    // routes from ADC 2 to every row are found once, then each row only
+    // closes and opens its own crosspoints
+    beginBoardScan(2);
+
     for (int i = 1; i < 96; i++) {
 
       if (i == 84 || i == NANO_RESET_0 || i == NANO_RESET_1) {
@@ -812,7 +817,7 @@ void scanBoard(void) {
       //  addBridgeToNodeFile(i, 2, netSlot, 1);
       //  printNodeOrName(i);
       //  Serial.println();
-      float measuredVoltage = measureVoltage(2, i, true);
+      float measuredVoltage = boardScanVoltage(i, true);
 
       if (measuredVoltage == 0xFFFFFFFF) {
         if (lastFloat == -1 || i == 1) {
@@ -855,9 +860,8 @@ void scanBoard(void) {
         break;
       }
 
-      showLEDsCore2 = 2;
+      queueShowLEDs(2);
       // waitCore2();
-      delay(3);
       lastRow = i;
 
       // if (leave == 1) {
@@ -865,7 +869,10 @@ void scanBoard(void) {
       // }
     }
 
-    Serial.println("\r                   \r\n\n\r");
+    unsigned long sweepMicros = endBoardScan();
+    Serial.print("\r                   \r\n\rswept in ");
+    Serial.print(sweepMicros / 1000);
+    Serial.println(" ms\n\n\r");
     Serial.flush();
     // printNodeOrName(NANO_A7);
     // Serial.println("\tfloating\n\n\r");
@@ -978,20 +985,20 @@ int i2cScan(int sdaRow, int sclRow, int sdaPin, int sclPin,
   Serial.println("\n\nI2C Scan Results:");
   if (nDevices == 0) {
     Serial.println("No I2C devices found");
-    showLEDsCore2 = -3;
+    queueShowLEDs(-3);
     b.clear();
 
     b.print("No I2C  Found", (uint32_t)0x070003);
     delayWithButton(2000);
     b.clear();
-    showLEDsCore2 = -1;
+    queueShowLEDs(-1);
   } else {
     Serial.printf("Found %d I2C device(s)\n", nDevices);
 
     // b.print("0x", (uint32_t)0x000904 );
-    showLEDsCore2 = -3;
+    queueShowLEDs(-3);
     b.clear();
-    showLEDsCore2 = -3;
+    queueShowLEDs(-3);
     if (addressesFoundCount == 1) {
       b.print("Found", (uint32_t)0x000b01, (uint32_t)0x000000, 0, 0, 3);
       b.print(addressToHexString(addressesFound[0]), (uint32_t)0x000a05,
@@ -1004,10 +1011,10 @@ int i2cScan(int sdaRow, int sclRow, int sdaPin, int sclPin,
       b.print(addressToHexString(addressesFound[1]), (uint32_t)0x000808,
               (uint32_t)0x000000, 1, 1);
     }
-    // showLEDsCore2 = 3;
+    // queueShowLEDs(3);
     // delay(2000);
     delayWithButton(2000);
-    showLEDsCore2 = -1;
+    queueShowLEDs(-1);
   }
 
   // Clean up connections
@@ -1050,7 +1057,7 @@ void calibrateDacs(void) {
   float setVoltage = 0.0;
 
   uint32_t dacColors[4] = {0x150003, 0x101000, 0x001204, 0x000512};
-  // sendAllPathsCore2 = 1;
+  // queueSendPaths(1);
   INA0.setBusADC(0x0e);
   INA1.setBusADC(0x0e);
   int lastNetSlot = netSlot;
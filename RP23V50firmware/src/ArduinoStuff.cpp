@@ -12,6 +12,7 @@
 #include "Commands.h"
 #include "FileParsing.h"
 #include "NetManager.h"
+#include "SerialBridge.h"
 #include "config.h"
 #include "configManager.h"
 #include "usb_interface_config.h"
@@ -96,7 +97,12 @@ void initSecondSerial(void) {
     Serial1.setFIFOSize(512);
     USBSer1.begin(baudRateUSBSer1);
     //  Serial.println("  USBSer1 (Arduino) initialized");
-    Serial1.begin(baudRateUSBSer1, makeSerialConfig(8, 0, 0));
+    if (jumperlessConfig.serial_1.function == 1 &&
+        jumperlessConfig.serial_1.dma_bridge == 1) {
+      startSerialBridge(baudRateUSBSer1, 8, 0, 0);
+    } else {
+      Serial1.begin(baudRateUSBSer1, makeSerialConfig(8, 0, 0));
+    }
   }
 #endif
 
@@ -112,9 +118,9 @@ void initSecondSerial(void) {
 #endif
 
 #if USB_CDC_ENABLE_COUNT >= 4
-  // USBSer3 maps to CDC interface 3 (Debug Serial)
+  // USBSer3 maps to CDC interface 3 (Logic analyzer, LogicAnalyzer.cpp)
   USBSer3.begin(115200);
-  // Serial.println("  USBSer3 (Debug) initialized");
+  // Serial.println("  USBSer3 (Logic) initialized");
 #endif
 
 // Give time for USB enumeration
@@ -167,7 +173,7 @@ void initSecondSerial(void) {
   }
 #endif
 #if USB_CDC_ENABLE_COUNT >= 4
-  // Serial.println("  Interface 3: Jumperless Debug (USBSer3)");
+  // Serial.println("  Interface 3: Jumperless Logic (USBSer3)");
 #endif
 
 #if USB_MSC_ENABLE
@@ -467,8 +473,11 @@ void flashArduino(unsigned long timeoutTime) {
     peeked = USBSer1.read();
     if (USBSer1.peek() == 0x20) {
 
-      Serial1.write(0x30);
-      Serial1.flush();
+      uint8_t syncByte = 0x30;
+      writeSerialBridge(&syncByte, 1);
+      if (serialBridgeRunning == 0) {
+        Serial1.flush();
+      }
       resetArduino();
     }
   } else {
@@ -660,13 +669,61 @@ int Serial1Available = 0;
 int commandStringStart = -1;
 int commandStringEnd = -1;
 
+/// @brief Prints bridge traffic the same way the byte-at-a-time loop did
+static void printPassthroughTap(int direction, const uint8_t *data, int len) {
+  Serial.print(direction > 0 ? "sent     >> " : "received << ");
+  for (int i = 0; i < len; i++) {
+    Serial.print(data[i], HEX);
+    Serial.print(" ");
+  }
+  Serial.println();
+  Serial.flush();
+}
+
 int handleSerialPassthrough(int serial, int print, int printPassthroughFlashing,
                             int checkForCommands) {
   int ret = 0;
   int sent = 0;
   int received = 0;
 
-  if (jumperlessConfig.serial_1.function == 1 && (serial == 0 || serial == 2)) {
+  if (jumperlessConfig.serial_1.function == 1 && (serial == 0 || serial == 2) &&
+      serialBridgeRunning == 1) {
+
+    if (print || printSerial1Passthrough == 1 ||
+        printPassthroughFlashing == 1) {
+      serialBridge.tap = printPassthroughTap;
+    } else {
+      serialBridge.tap = nullptr;
+    }
+
+    int moved = serviceSerialBridge();
+
+    USBSer1Available = USBSer1.available();
+    Serial1Available = ringUsed(&serialBridge.rx);
+
+    if (moved > 0) {
+      gpioReadingColors[8] = 0x1f1900;
+      lastSerial1TxRead = millis();
+      queueShowLEDs(2);
+      lastTimeResetArduino = millis();
+      return moved;
+    } else if (moved < 0) {
+      gpioReadingColors[9] = 0x00191f;
+      lastSerial1RxRead = millis();
+      queueShowLEDs(2);
+      lastTimeResetArduino = millis();
+      return moved;
+    }
+
+    if (millis() - lastSerial1TxRead > 50) {
+      gpioReadingColors[8] = 0x080501;
+    }
+    if (millis() - lastSerial1RxRead > 50) {
+      gpioReadingColors[9] = 0x010508;
+    }
+
+  } else if (jumperlessConfig.serial_1.function == 1 &&
+             (serial == 0 || serial == 2)) {
 
     unsigned long serial1Timeout = millis();
     USBSer1Available = USBSer1.available();
@@ -734,7 +791,7 @@ int handleSerialPassthrough(int serial, int print, int printPassthroughFlashing,
       gpioReadingColors[8] = 0x1f1900;
       // gpioReading[8] = 1;
       lastSerial1TxRead = millis();
-      showLEDsCore2 = 2;
+      queueShowLEDs(2);
       lastTimeResetArduino = millis();
       // Serial.write(c);
       USBSer1Available = USBSer1.available();
@@ -745,7 +802,7 @@ int handleSerialPassthrough(int serial, int print, int printPassthroughFlashing,
     if (millis() - lastSerial1TxRead > 50) {
       gpioReadingColors[8] = 0x080501;
       // gpioReading[8] = 0;
-      // showLEDsCore2 = 2;
+      // queueShowLEDs(2);
     }
 
     if (Serial1.available() > 0) {
@@ -846,7 +903,7 @@ int handleSerialPassthrough(int serial, int print, int printPassthroughFlashing,
       gpioReadingColors[9] = 0x00191f;
       // gpioReading[9] = 1;
       lastSerial1RxRead = millis();
-      showLEDsCore2 = 2;
+      queueShowLEDs(2);
       lastTimeResetArduino = millis();
       USBSer1Available = USBSer1.available();
       Serial1Available = Serial1.available();
@@ -857,7 +914,7 @@ int handleSerialPassthrough(int serial, int print, int printPassthroughFlashing,
     if (millis() - lastSerial1RxRead > 50) {
       gpioReadingColors[9] = 0x010508;
       // gpioReading[9] = 0;
-      // showLEDsCore2 = 2;
+      // queueShowLEDs(2);
     }
 
     //}
@@ -913,7 +970,7 @@ int handleSerialPassthrough(int serial, int print, int printPassthroughFlashing,
       gpioReadingColors[8] = 0x1f1900;
       // gpioReading[8] = 1;
       lastSerial2TxRead = millis();
-      showLEDsCore2 = 2;
+      queueShowLEDs(2);
       lastTimeResetArduino = millis();
       // Serial.write(c);
     }
@@ -921,7 +978,7 @@ int handleSerialPassthrough(int serial, int print, int printPassthroughFlashing,
     if (millis() - lastSerial2TxRead > 50) {
       gpioReadingColors[8] = 0x080501;
       // gpioReading[8] = 0;
-      // showLEDsCore2 = 2;
+      // queueShowLEDs(2);
     }
 
     if (serial2Available > 0) {
@@ -963,14 +1020,14 @@ int handleSerialPassthrough(int serial, int print, int printPassthroughFlashing,
       gpioReadingColors[9] = 0x00191f; // todo fix this
       // gpioReading[9] = 1;
       lastSerial2RxRead = millis();
-      showLEDsCore2 = 2;
+      queueShowLEDs(2);
       lastTimeResetArduino = millis();
       //  Serial.print(c);
     }
     if (millis() - lastSerial2RxRead > 50) {
       gpioReadingColors[9] = 0x010508;
       // gpioReading[9] = 0;
-      // showLEDsCore2 = 2;
+      // queueShowLEDs(2);
     }
 
     //}
@@ -1097,7 +1154,7 @@ void SetArduinoResetLine(bool state, int topBottomBoth) {
     }
     delayMicroseconds(200);
 
-    showLEDsCore2 = 2;
+    queueShowLEDs(2);
 
   } else if (state == HIGH) {
     // Serial.println("Setting Arduino Reset Line to HIGH");
@@ -1112,7 +1169,7 @@ void SetArduinoResetLine(bool state, int topBottomBoth) {
     }
     // headerColors[0] = 0x2000b9;
     // headerColors[1] = 0x0020f9;
-    // showLEDsCore2 = 2;
+    // queueShowLEDs(2);
   }
 }
 
@@ -1267,9 +1324,16 @@ void checkForConfigChangesUSBSer1(int print) {
     USBSer1.begin(
         baudRateUSBSer1,
         makeSerialConfig(numbitsUSBSer1, paritytypeUSBSer1, stopbitsUSBSer1));
-    Serial1.begin(
-        baudRateUSBSer1,
-        makeSerialConfig(numbitsUSBSer1, paritytypeUSBSer1, stopbitsUSBSer1));
+    if (jumperlessConfig.serial_1.function == 1 &&
+        jumperlessConfig.serial_1.dma_bridge == 1) {
+      startSerialBridge(baudRateUSBSer1, numbitsUSBSer1, paritytypeUSBSer1,
+                        stopbitsUSBSer1);
+    } else {
+      stopSerialBridge();
+      Serial1.begin(
+          baudRateUSBSer1,
+          makeSerialConfig(numbitsUSBSer1, paritytypeUSBSer1, stopbitsUSBSer1));
+    }
     microsPerByteSerial1 =
         (1000000 / baudRateUSBSer1 + 1) *
         (numbitsUSBSer1 + stopbitsUSBSer1 + (paritytypeUSBSer1 == 0 ? 0 : 1));
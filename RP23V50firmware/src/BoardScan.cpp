@@ -0,0 +1,292 @@
+// SPDX-License-Identifier: MIT
+#include "BoardScan.h"
+
+#include <string.h>
+
+//! Route section, down to the sweep section this only needs BoardScan.h, so
+//! it can be run against a dumped crosspoint state on a PC
+
+static void crosspointWires(const struct scanGraph *graph, int crosspoint,
+                            int *xSide, int *ySide) {
+  int chip = crosspoint / 128;
+  *xSide = graph->xWire[chip][(crosspoint / 8) % 16];
+  *ySide = graph->yWire[chip][crosspoint % 8];
+}
+
+int scanGrowTree(const struct scanGraph *graph, int sourceWire,
+                 struct scanTree *tree) {
+  static uint8_t busy[SCAN_WIRES];
+  static int16_t queue[SCAN_WIRES];
+
+  memset(busy, 0, sizeof(busy));
+  memset(tree->depth, 0xff, sizeof(tree->depth));
+  tree->source = sourceWire;
+  for (int chip = 0; chip < SCAN_CHIPS; chip++) {
+    for (int x = 0; x < 16; x++) {
+      for (int y = 0; y < 8; y++) {
+        if (graph->closed[chip][x][y] != 0) {
+          busy[graph->xWire[chip][x]] = 1;
+          busy[graph->yWire[chip][y]] = 1;
+        }
+      }
+    }
+  }
+  if (sourceWire < 0 || sourceWire >= SCAN_WIRES || busy[sourceWire] == 1) {
+    return 0;
+  }
+
+  int head = 0;
+  int tail = 0;
+  tree->depth[sourceWire] = 0;
+  tree->via[sourceWire] = -1;
+  queue[tail++] = sourceWire;
+  while (head < tail) {
+    int wire = queue[head++];
+    if (tree->depth[wire] + 1 >= SCAN_MAX_HOPS) {
+      continue; // the last hop has to land on the target
+    }
+    for (int crosspoint = 0; crosspoint < SCAN_CHIPS * 128; crosspoint++) {
+      int xSide;
+      int ySide;
+      crosspointWires(graph, crosspoint, &xSide, &ySide);
+      int other = xSide == wire ? ySide : (ySide == wire ? xSide : -1);
+      if (other < 0 || other >= SCAN_NODE_WIRE_BASE || busy[other] == 1 ||
+          tree->depth[other] != 0xff) {
+        continue; // not this wire's, a node, in use or already reached
+      }
+      tree->depth[other] = tree->depth[wire] + 1;
+      tree->via[other] = crosspoint;
+      queue[tail++] = other;
+    }
+  }
+  return 1;
+}
+
+int scanRouteTo(const struct scanGraph *graph, const struct scanTree *tree,
+                int targetWire, struct scanRoute *route) {
+  route->hops = 0;
+  if (tree->depth[tree->source] != 0 || targetWire == tree->source) {
+    return 0;
+  }
+  int best = -1;
+  int bestFrom = -1;
+  for (int crosspoint = 0; crosspoint < SCAN_CHIPS * 128; crosspoint++) {
+    int xSide;
+    int ySide;
+    crosspointWires(graph, crosspoint, &xSide, &ySide);
+    int from = xSide == targetWire ? ySide : (ySide == targetWire ? xSide : -1);
+    if (from < 0 || tree->depth[from] == 0xff) {
+      continue;
+    }
+    int chip = crosspoint / 128;
+    if (graph->closed[chip][(crosspoint / 8) % 16][crosspoint % 8] != 0) {
+      continue;
+    }
+    if (best < 0 || tree->depth[from] < tree->depth[bestFrom]) {
+      best = crosspoint;
+      bestFrom = from;
+    }
+  }
+  if (best < 0) {
+    return 0;
+  }
+
+  // walk back to the source, the source end goes first
+  int hops = tree->depth[bestFrom] + 1;
+  int crosspoint = best;
+  int wire = bestFrom;
+  for (int hop = hops - 1; hop >= 0; hop--) {
+    route->chip[hop] = crosspoint / 128;
+    route->x[hop] = (crosspoint / 8) % 16;
+    route->y[hop] = crosspoint % 8;
+    if (hop == 0) {
+      break;
+    }
+    crosspoint = tree->via[wire];
+    int xSide;
+    int ySide;
+    crosspointWires(graph, crosspoint, &xSide, &ySide);
+    wire = xSide == wire ? ySide : xSide;
+  }
+  route->hops = hops;
+  return hops;
+}
+
+//! Sweep section: the routes are found once a sweep against whatever the
+//! crosspoints are set to, then each node only costs closing its route,
+//! reading the ADC and opening it again. core 1 is held off sending paths
+//! while a route is closed, and if it sent some anyway between nodes the
+//! routes get found again.
+
+#ifdef ARDUINO
+#include "CH446Q.h"
+#include "Commands.h"
+#include "FileParsing.h"
+#include "JumperlessDefines.h"
+#include "LEDs.h"
+#include "MatrixState.h"
+#include "Overlay.h"
+#include "Peripherals.h"
+
+#include <Arduino.h>
+
+static_assert(SCAN_NODE_WIRE_BASE == WIRE_LINE_COUNT, "node wires moved");
+static_assert(SCAN_WIRES == WIRE_COUNT, "node wires moved");
+
+struct boardScanStats boardScanStats = {0, 0, 0, 0, 0, 0, 0};
+
+static struct scanGraph scanGraph;
+static struct scanTree adcTree;
+static struct scanTree gpioTree;
+static int scanAdcNumber = -1;
+static int scanGpio = -1; // RP_GPIO_n used for the floating check, -1 if none
+static unsigned long scanGeneration = 0;
+static unsigned long scanStart = 0;
+static unsigned long scanNodes = 0;
+
+static int adcNode(int adcNumber) {
+  switch (adcNumber) {
+  case 0:
+    return ADC0;
+  case 1:
+    return ADC1;
+  case 2:
+    return ADC2;
+  case 3:
+    return ADC3;
+  case 4:
+    return ADC4;
+  case 7:
+    return ADC7;
+  default:
+    return -1;
+  }
+}
+
+// counts every send core 1 has made, the routes were found against them
+static unsigned long pathGeneration(void) {
+  return crosspointStats.diffSends + crosspointStats.fullSends +
+         crosspointStats.resets;
+}
+
+static void findScanRoutes(void) {
+  readScanGraph(&scanGraph);
+  scanGrowTree(&scanGraph, SCAN_NODE_WIRE_BASE + adcNode(scanAdcNumber),
+               &adcTree);
+  if (crosspointDesync == true) {
+    // lastChipXY can't be trusted to say what's free, fall back for now
+    adcTree.depth[adcTree.source] = 0xff;
+  }
+
+  // same GPIOs checkFloating() picks from
+  scanGpio = -1;
+  for (int gpio = RP_GPIO_1; gpio <= RP_GPIO_4; gpio++) {
+    if (scanGrowTree(&scanGraph, SCAN_NODE_WIRE_BASE + gpio, &gpioTree) == 1) {
+      scanGpio = gpio;
+      break;
+    }
+  }
+  scanGeneration = pathGeneration();
+}
+
+static void closeRoute(const struct scanRoute *route, int setOrClear) {
+  for (int hop = 0; hop < route->hops; hop++) {
+    sendXYraw(route->chip[hop], route->x[hop], route->y[hop], setOrClear);
+  }
+}
+
+int beginBoardScan(int adcNumber) {
+  if (adcNode(adcNumber) < 0) {
+    return -1;
+  }
+  scanAdcNumber = adcNumber;
+  scanStart = micros();
+  scanNodes = 0;
+  holdCrosspoints();
+  findScanRoutes();
+  releaseCrosspoints();
+  return adcTree.depth[adcTree.source] == 0 ? 1 : 0;
+}
+
+float boardScanVoltage(int node, bool checkForFloating) {
+  if (scanAdcNumber < 0 || node < 0 || node >= 256) {
+    return 0.0;
+  }
+  scanNodes++;
+  struct scanRoute route;
+
+  holdCrosspoints();
+  if (pathGeneration() != scanGeneration) {
+    findScanRoutes();
+    boardScanStats.rebuilds++;
+  }
+  if (scanRouteTo(&scanGraph, &adcTree, SCAN_NODE_WIRE_BASE + node, &route) ==
+      0) {
+    releaseCrosspoints();
+    boardScanStats.fallbacks++;
+    return measureVoltage(scanAdcNumber, node, checkForFloating);
+  }
+  closeRoute(&route, 1);
+  delayMicroseconds(SCAN_SETTLE_US);
+  float voltage = readAdcVoltage(scanAdcNumber, 8);
+  closeRoute(&route, 0);
+  releaseCrosspoints();
+  boardScanStats.measured++;
+
+  if (checkForFloating == false || voltage >= 0.3 || voltage <= -0.3) {
+    return voltage;
+  }
+
+  holdCrosspoints();
+  if (pathGeneration() != scanGeneration) {
+    findScanRoutes();
+    boardScanStats.rebuilds++;
+  }
+  if (scanGpio < 0 ||
+      scanRouteTo(&scanGraph, &gpioTree, SCAN_NODE_WIRE_BASE + node, &route) ==
+          0) {
+    releaseCrosspoints();
+    return checkFloating(node) == true ? 0xFFFFFFFF : voltage;
+  }
+  closeRoute(&route, 1);
+  delayMicroseconds(SCAN_SETTLE_US);
+  int floating =
+      gpioReadWithFloating(GPIO_1_PIN + (scanGpio - RP_GPIO_1), 100);
+  closeRoute(&route, 0);
+  releaseCrosspoints();
+  return floating == 2 ? 0xFFFFFFFF : voltage;
+}
+
+unsigned long endBoardScan(void) {
+  unsigned long sweep = micros() - scanStart;
+  boardScanStats.sweeps++;
+  boardScanStats.lastSweepMicros = sweep;
+  boardScanStats.lastSweepNodes = scanNodes;
+  if (boardScanStats.fastestSweepMicros == 0 ||
+      sweep < boardScanStats.fastestSweepMicros) {
+    boardScanStats.fastestSweepMicros = sweep;
+  }
+  scanAdcNumber = -1;
+  return sweep;
+}
+
+void printBoardScanStats(void) {
+  Serial.print("\n\rBoard scan:\t");
+  Serial.print(boardScanStats.sweeps);
+  Serial.print(" sweeps\tmeasured ");
+  Serial.print(boardScanStats.measured);
+  Serial.print("\tfallbacks ");
+  Serial.print(boardScanStats.fallbacks);
+  Serial.print("\trebuilds ");
+  Serial.println(boardScanStats.rebuilds);
+  if (boardScanStats.sweeps > 0) {
+    Serial.print("  last sweep:\t");
+    Serial.print(boardScanStats.lastSweepNodes);
+    Serial.print(" nodes in ");
+    Serial.print(boardScanStats.lastSweepMicros / 1000);
+    Serial.print(" ms\tfastest ");
+    Serial.print(boardScanStats.fastestSweepMicros / 1000);
+    Serial.println(" ms");
+  }
+}
+#endif
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: MIT
+#ifndef BOARDSCAN_H
+#define BOARDSCAN_H
+
+#include <stdint.h>
+
+#define SCAN_CHIPS 12
+#define SCAN_NODE_WIRE_BASE (12 * 24) // WIRE_LINE_COUNT, node n is wire base + n
+#define SCAN_WIRES (SCAN_NODE_WIRE_BASE + 256)
+#define SCAN_MAX_HOPS 4   // crosspoints in a route, same as a path can use
+#define SCAN_SETTLE_US 200 // after the route closes, before the ADC looks
+
+/// @brief The crosspoints as wires (see mapCrosspointWires()) and which
+/// crosspoints are closed right now
+struct scanGraph {
+  int16_t xWire[SCAN_CHIPS][16];
+  int16_t yWire[SCAN_CHIPS][8];
+  uint8_t closed[SCAN_CHIPS][16][8];
+};
+
+/// @brief Crosspoints to close to get from the source to one node
+struct scanRoute {
+  uint8_t hops; // 0 if there's no free way there
+  uint8_t chip[SCAN_MAX_HOPS];
+  uint8_t x[SCAN_MAX_HOPS];
+  uint8_t y[SCAN_MAX_HOPS];
+};
+
+/// @brief Every free lane the source can reach, and how
+struct scanTree {
+  int16_t source;
+  uint8_t depth[SCAN_WIRES]; // crosspoints from the source, 0xff if unreached
+  int16_t via[SCAN_WIRES];   // chip * 128 + x * 8 + y of the one that got here
+};
+
+//! Portable: only needs this header, so routes can be checked against a
+//! dumped crosspoint state on a PC
+
+/// @brief Grow the tree out from sourceWire through lanes nothing's using,
+/// never through another node. Returns 0 if the source itself is in use.
+int scanGrowTree(const struct scanGraph *graph, int sourceWire,
+                 struct scanTree *tree);
+/// @brief Shortest route from the tree's source to targetWire, which can
+/// be in a net already (that's what gets measured). Returns the hops.
+int scanRouteTo(const struct scanGraph *graph, const struct scanTree *tree,
+                int targetWire, struct scanRoute *route);
+
+struct boardScanStats {
+  unsigned long sweeps;
+  unsigned long measured;  // nodes read through a route
+  unsigned long fallbacks; // nodes with no free route, read with measureVoltage()
+  unsigned long rebuilds;  // the routing changed mid sweep
+  unsigned long lastSweepMicros;
+  unsigned long lastSweepNodes;
+  unsigned long fastestSweepMicros;
+};
+
+extern struct boardScanStats boardScanStats;
+
+/// @brief Find routes from ADC adcNumber to every node for a sweep. Returns
+/// -1 for an ADC that can't be routed, 0 if it's in use (every node falls
+/// back to measureVoltage()), 1 if it's ready.
+int beginBoardScan(int adcNumber);
+/// @brief Same as measureVoltage() (0xFFFFFFFF for floating), but only
+/// toggles the crosspoints on the node's route. The node file and nets
+/// are never touched.
+float boardScanVoltage(int node, bool checkForFloating = false);
+/// @brief Returns how long the sweep took in us
+unsigned long endBoardScan(void);
+void printBoardScanStats(void);
+
+#endif
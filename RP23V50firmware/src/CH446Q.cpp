@@ -3,14 +3,17 @@
 #include "CH446Q.h"
 #include "JumperlessDefines.h"
 #include "LEDs.h"
+#include "MakeBeforeBreak.h"
 #include "MatrixState.h"
 #include "NetsToChipConnections.h"
+#include "Overlay.h"
 #include "Peripherals.h"
 
 #include "hardware/pio.h"
 
 #include "ch446.pio.h"
 #include "FileParsing.h"
+#include "config.h"
 
 //#include "SerialWrapper.h"
 
@@ -66,6 +69,16 @@ int changedPathsCount = 0;
 int chipOrderedIndex[MAX_BRIDGES];
 bool chipOrderValid = false;
 
+// lastChipXY mirrors what's actually set in the chips, every word that goes
+// out through sendXYraw() updates it. If it can't be trusted anymore (dropped
+// PIO word, someone pulsed RESETPIN) the next sendPaths() does a full reset.
+bool crosspointDesync = true;
+struct crosspointStats crosspointStats = {0, 0, 0, 0, 0, 0, 0, 0};
+
+// a word clocks out in a couple of microseconds, so this only runs out if
+// the state machine has stopped
+#define CH446Q_FIFO_WAIT_US 200
+
 void initCH446Q(void) {
 
   uint dat = 14;
@@ -127,7 +140,6 @@ void initCH446Q(void) {
   }
 
 void sendPaths(int clean) {
-  // if (sendAllPathsCore2 == 1) {
     // digitalWrite(RESETPIN, HIGH);
     // // refreshPaths();
     // delayMicroseconds(10);
@@ -143,21 +155,27 @@ void sendPaths(int clean) {
   // Create chip-ordered index for efficient hardware operations while keeping paths in net order
   createChipOrderedIndex();
 
-  if (clean == 1) {
+  // clean == 1 always pulses reset and sends everything. Otherwise the diff
+  // gets the chips to the same state without dropping anything, unless we've
+  // lost track of what's in them
+  if (clean == 1 || crosspointDesync == true) {
     digitalWrite(RESETPIN, HIGH);
     delayMicroseconds(10000);
     digitalWrite(RESETPIN, LOW);
+    crosspointStats.resets++;
+    sendAllPaths(1);
+    } else {
+    sendAllPaths(0);
     }
-  sendAllPaths(clean);
   //}
   core2busy = false;
   // core2busy = false;
   unsigned long pathTime = micros() - pathTimer;
+  crosspointStats.lastMicros = pathTime;
 
   // delayMicroseconds(3200);
   //  Serial.print("pathTime = ");
   //  Serial.println(pathTime);
-  sendAllPathsCore2 = 0;
   //printChipStateArray();
   // }
   }
@@ -176,9 +194,63 @@ void refreshPaths(void) {
   sendAllPaths(1);
   }
 
+// Overlays (Overlay.h) ride on top of what path[] wants. If a reroute took
+// one of an overlay's lanes, or connected the thing it hangs off of, it's
+// left out and goes back to pending for serviceOverlays() to route again.
+static void mergeOverlays(struct justXY *chips) {
+  static bool wireUsed[WIRE_COUNT];
+  int any = 0;
+
+  for (int i = 0; i < OVERLAY_MAX; i++) {
+    if (overlays[i].id != 0 && overlays[i].active == 1) {
+      any = 1;
+      }
+    }
+  if (any == 0) {
+    return;
+    }
+
+  memset(wireUsed, 0, sizeof(wireUsed));
+  for (int chip = 0; chip < 12; chip++) {
+    for (int x = 0; x < 16; x++) {
+      for (int y = 0; y < 8; y++) {
+        if (chips[chip].connected[x][y]) {
+          wireUsed[xLineWire(chip, x)] = true;
+          wireUsed[yLineWire(chip, y)] = true;
+          }
+        }
+      }
+    }
+
+  for (int i = 0; i < OVERLAY_MAX; i++) {
+    struct overlayBridge *overlay = &overlays[i];
+    if (overlay->id == 0 || overlay->active == 0) {
+      continue;
+      }
+    struct scanRoute *route = &overlay->route;
+    bool clash = wireUsed[WIRE_LINE_COUNT + overlay->from];
+    for (int hop = 0; hop < route->hops && clash == false; hop++) {
+      int xw = xLineWire(route->chip[hop], route->x[hop]);
+      int yw = yLineWire(route->chip[hop], route->y[hop]);
+      clash = (xw < WIRE_LINE_COUNT && wireUsed[xw]) ||
+              (yw < WIRE_LINE_COUNT && wireUsed[yw]);
+      }
+    if (clash == true) {
+      overlay->active = 0;
+      overlay->pending = 1;
+      overlayStats.bumped++;
+      continue;
+      }
+    for (int hop = 0; hop < route->hops; hop++) {
+      chips[route->chip[hop]].connected[route->x[hop]][route->y[hop]] = true;
+      }
+    }
+  }
+
 void sendAllPaths(int clean) // should we sort them by chip? for now, no
   {
   unsigned long startTime = micros();
+  unsigned long wordsBefore = crosspointStats.wordsSet + crosspointStats.wordsCleared;
   if (clean == 1) {
     // Reset the lastChipXY array on clean start
     for (int chip = 0; chip < 12; chip++) {
@@ -188,57 +260,40 @@ void sendAllPaths(int clean) // should we sort them by chip? for now, no
           }
         }
       }
+    crosspointDesync = false;
 
     // Send all paths in chip order for hardware efficiency, but preserve net order in path array
     for (int i = 0; i < numberOfPaths; i++) {
       int pathIdx = chipOrderValid ? chipOrderedIndex[i] : i;
-      sendPath(pathIdx, 1, 0);
+      sendPath(pathIdx, 1, 0); // sendXYraw() fills in lastChipXY
       lastPath[pathIdx] = path[pathIdx];
-
-      // Update lastChipXY
-      for (int j = 0; j < 4; j++) {
-        if (path[pathIdx].chip[j] != -1 && path[pathIdx].x[j] != -1 && path[pathIdx].y[j] != -1) {
-          int chip = path[pathIdx].chip[j];
-          int x = path[pathIdx].x[j];
-          int y = path[pathIdx].y[j];
-
-          if (chip >= 0 && chip < 12 && x >= 0 && x < 16 && y >= 0 && y < 8) {
-            lastChipXY[chip].connected[x][y] = true;
+      }
+    // the reset opened the overlays too
+    static struct justXY withOverlays[12];
+    memcpy(withOverlays, lastChipXY, sizeof(withOverlays));
+    mergeOverlays(withOverlays);
+    for (int chip = 0; chip < 12; chip++) {
+      for (int x = 0; x < 16; x++) {
+        for (int y = 0; y < 8; y++) {
+          if (withOverlays[chip].connected[x][y] && !lastChipXY[chip].connected[x][y]) {
+            sendXYraw(chip, x, y, 1);
             }
           }
         }
       }
     lastPathNumber = numberOfPaths;
-    return;
+    crosspointStats.fullSends++;
     } else {
-    // Only send changed paths
+    // Only send the crosspoints that changed
     findDifferentPaths();
     for (int i = 0; i < numberOfPaths; i++) {
-      if (changedPaths[i] == 1) {
-        sendPath(i, 1, 0);
-        lastPath[i] = path[i];
-
-        if (debugNTCC) {
-          Serial.print("changed path ");
-          Serial.print(i);
-          Serial.print(" c: ");
-          Serial.print(path[i].chip[0]);
-          Serial.print(" x: ");
-          Serial.print(path[i].x[0]);
-          Serial.print(" y: ");
-          Serial.print(path[i].y[0]);
-          Serial.print("   -   c:");
-          Serial.print(path[i].chip[1]);
-          Serial.print(" x: ");
-          Serial.print(path[i].x[1]);
-          Serial.print(" y: ");
-          Serial.print(path[i].y[1]);
-          Serial.println();
-          }
-        }
+      lastPath[i] = path[i];
       }
     lastPathNumber = numberOfPaths;
+    crosspointStats.diffSends++;
     }
+  crosspointStats.lastWords =
+    (crosspointStats.wordsSet + crosspointStats.wordsCleared) - wordsBefore;
   // unsigned long endTime = micros();
   // unsigned long duration = endTime - startTime;
   // Serial.print("Time taken: ");
@@ -393,68 +448,137 @@ void printLastChipStateArray(void) {
 
 }
 
-// New function to update the current chip state array based on paths
+struct makeBeforeBreakStats makeBeforeBreakStats = {0, 0, 0, 0, 0};
+
+static struct mbbGraph transactionGraph;
+static struct mbbCounts transactionCounts;
+
+static_assert(MBB_WIRES == WIRE_COUNT, "node wires moved");
+
+// Diffs the crosspoints path[] wants against lastChipXY and sends only the
+// words that changed. Both passes walk chip by chip so the chip select only
+// moves 12 times at most per pass.
+//
+// With routing.make_before_break on, the update is done as a transaction
+// by makeBeforeBreak(): additions go out as soon as they can't tie a node to
+// another net, removals as soon as the nodes they'd cut off are held
+// together some other way. So two nets never touch, and a net that's just
+// moving lanes doesn't go open (unless two nets are swapping lanes, then
+// one of them has to for a moment). Otherwise it's clears then sets, which
+// can open a net for a moment.
 void updateChipStateArray() {
-  // First, clear all connections
-  bool newChipXY[12][16][8] = { {{false}} };
+  static struct justXY newChipXY[12];
+
+  for (int chip = 0; chip < 12; chip++) {
+    memset(newChipXY[chip].connected, 0, sizeof(newChipXY[chip].connected));
+    }
 
   // Set connections based on current paths
-  for (int i = 0; i < MAX_NETS; i++) {
+  for (int i = 0; i < numberOfPaths; i++) {
     for (int j = 0; j < 4; j++) {
-      if (path[i].chip[j] != -1 && path[i].x[j] != -1 && path[i].y[j] != -1) {
-        int chip = path[i].chip[j];
-        int x = path[i].x[j];
-        int y = path[i].y[j];
+      int chip = path[i].chip[j];
+      int x = path[i].x[j];
+      int y = path[i].y[j];
 
-        if (chip >= 0 && chip < 12 && x >= 0 && x < 16 && y >= 0 && y < 8) {
-          newChipXY[chip][x][y] = true;
-          }
+      if (chip >= 0 && chip < 12 && x >= 0 && x < 16 && y >= 0 && y < 8) {
+        newChipXY[chip].connected[x][y] = true;
         }
       }
     }
+  mergeOverlays(newChipXY);
 
-  // Now we mark the paths that need changing
-  for (int i = 0; i < MAX_BRIDGES; i++) {
-    changedPaths[i] = -1; // Mark all as unchanged initially
-    }
-
-  // Find paths that have changed from last state
-  for (int i = 0; i < MAX_NETS; i++) {
-    for (int j = 0; j < 4; j++) {
-      if (path[i].chip[j] != -1 && path[i].x[j] != -1 && path[i].y[j] != -1) {
-        int chip = path[i].chip[j];
-        int x = path[i].x[j];
-        int y = path[i].y[j];
-
-        if (lastChipXY[chip].connected[x][y] != newChipXY[chip][x][y]) {
-          changedPaths[i] = 1; // Mark path as changed
-          break;
+  if (jumperlessConfig.routing.make_before_break == 0) {
+    for (int chip = 0; chip < 12; chip++) {
+      for (int x = 0; x < 16; x++) {
+        for (int y = 0; y < 8; y++) {
+          if (lastChipXY[chip].connected[x][y] && !newChipXY[chip].connected[x][y]) {
+            sendXYraw(chip, x, y, 0);
+            }
           }
         }
       }
-    }
 
-  // Also find connections that need to be disconnected
-  for (int chip = 0; chip < 12; chip++) {
-    for (int x = 0; x < 16; x++) {
-      for (int y = 0; y < 8; y++) {
-        if (lastChipXY[chip].connected[x][y] && !newChipXY[chip][x][y]) {
-          // This connection needs to be disconnected
-          // Send a disconnect command
-          sendXYraw(chip, x, y, 0);
+    for (int chip = 0; chip < 12; chip++) {
+      for (int x = 0; x < 16; x++) {
+        for (int y = 0; y < 8; y++) {
+          if (newChipXY[chip].connected[x][y] && !lastChipXY[chip].connected[x][y]) {
+            sendXYraw(chip, x, y, 1);
+            }
           }
         }
       }
+    return;
     }
 
-  // Update lastChipXY array
   for (int chip = 0; chip < 12; chip++) {
     for (int x = 0; x < 16; x++) {
+      transactionGraph.xWire[chip][x] = xLineWire(chip, x);
       for (int y = 0; y < 8; y++) {
-        lastChipXY[chip].connected[x][y] = newChipXY[chip][x][y];
+        transactionGraph.now[chip][x][y] = lastChipXY[chip].connected[x][y];
+        transactionGraph.want[chip][x][y] = newChipXY[chip].connected[x][y];
         }
       }
+    for (int y = 0; y < 8; y++) {
+      transactionGraph.yWire[chip][y] = yLineWire(chip, y);
+      }
+    }
+
+  memset(&transactionCounts, 0, sizeof(transactionCounts));
+  makeBeforeBreak(&transactionGraph, sendXYraw, &transactionCounts);
+
+  makeBeforeBreakStats.transactions++;
+  makeBeforeBreakStats.earlyAdditions += transactionCounts.early;
+  makeBeforeBreakStats.deferredAdditions += transactionCounts.deferred;
+  makeBeforeBreakStats.heldRemovals += transactionCounts.held;
+  makeBeforeBreakStats.forcedRemovals += transactionCounts.forced;
+  }
+
+/// @brief call after anything pulses RESETPIN or otherwise changes the
+/// crosspoints behind sendXYraw()'s back, the next send will do a clean reset
+void markCrosspointsDesynced(void) {
+  crosspointDesync = true;
+  }
+
+/// @brief what sendXYraw() last set this crosspoint to
+bool crosspointClosed(int chip, int x, int y) {
+  if (chip < 0 || chip >= 12 || x < 0 || x >= 16 || y < 0 || y >= 8) {
+    return false;
     }
+  return lastChipXY[chip].connected[x][y];
+  }
+
+void printCrosspointStats(void) {
+  Serial.println("\n\rCrosspoint updates\n\r");
+  Serial.print("  diff sends:\t\t");
+  Serial.println(crosspointStats.diffSends);
+  Serial.print("  full sends:\t\t");
+  Serial.println(crosspointStats.fullSends);
+  Serial.print("  reset pulses:\t\t");
+  Serial.println(crosspointStats.resets);
+  Serial.print("  words set:\t\t");
+  Serial.println(crosspointStats.wordsSet);
+  Serial.print("  words cleared:\t");
+  Serial.println(crosspointStats.wordsCleared);
+  Serial.print("  dropped words:\t");
+  Serial.println(crosspointStats.droppedWords);
+  Serial.print("  last update:\t\t");
+  Serial.print(crosspointStats.lastWords);
+  Serial.print(" words in ");
+  Serial.print(crosspointStats.lastMicros);
+  Serial.println("us");
+  Serial.print("  make before break:\t");
+  Serial.println(jumperlessConfig.routing.make_before_break ? "on" : "off");
+  Serial.print("  transactions:\t\t");
+  Serial.println(makeBeforeBreakStats.transactions);
+  Serial.print("  additions early:\t");
+  Serial.println(makeBeforeBreakStats.earlyAdditions);
+  Serial.print("  additions deferred:\t");
+  Serial.println(makeBeforeBreakStats.deferredAdditions);
+  Serial.print("  removals held:\t");
+  Serial.println(makeBeforeBreakStats.heldRemovals);
+  Serial.print("  removals forced:\t");
+  Serial.println(makeBeforeBreakStats.forcedRemovals);
+  Serial.println();
   }
 
 // Updated findDifferentPaths to use the chip state approach
@@ -532,8 +656,28 @@ void sendXYraw(int chip, int x, int y, int setOrClear) {
 
   delayMicroseconds(50);
 
+  // a write to a full TX FIFO is dropped (and sets FDEBUG.TXOVER), so give
+  // the state machine a moment to shift a word out before giving up on it
+  unsigned long fifoWait = micros();
+  while (pio_sm_is_tx_fifo_full(pio, sm)) {
+    if (micros() - fifoWait > CH446Q_FIFO_WAIT_US) {
+      crosspointStats.droppedWords++;
+      crosspointDesync = true; // the next sendPaths() resets and resends
+      return;
+      }
+    }
+
   pio_sm_put(pio, sm, chAddress);
 
+  if (chip >= 0 && chip < 12 && x >= 0 && x < 16 && y >= 0 && y < 8) {
+    lastChipXY[chip].connected[x][y] = (setOrClear == 1);
+    }
+  if (setOrClear == 1) {
+    crosspointStats.wordsSet++;
+    } else {
+    crosspointStats.wordsCleared++;
+    }
+
   delayMicroseconds(80);
   // isrFromPio();
   }
@@ -11,7 +11,33 @@ extern int hueShiftC2;
 extern int lightUpNetCore2;
 
 
-void sendPaths(int clean = 0);
+struct crosspointStats {
+  unsigned long diffSends;
+  unsigned long fullSends;
+  unsigned long resets;
+  unsigned long wordsSet;
+  unsigned long wordsCleared;
+  unsigned long droppedWords;
+  unsigned long lastWords; // words sent by the last sendAllPaths()
+  unsigned long lastMicros;
+};
+
+// counts from updateChipStateArray() when routing.make_before_break is on,
+// deferred additions are the ones that had to wait for the removals, held
+// removals waited for additions and forced ones had to open a net briefly
+struct makeBeforeBreakStats {
+  unsigned long transactions;
+  unsigned long earlyAdditions;
+  unsigned long deferredAdditions;
+  unsigned long heldRemovals;
+  unsigned long forcedRemovals;
+};
+
+extern struct crosspointStats crosspointStats;
+extern struct makeBeforeBreakStats makeBeforeBreakStats;
+extern bool crosspointDesync;
+
+void sendPaths(int clean = 0); // clean = 1 always pulses reset and resends
 void initCH446Q(void);
 void sendXYraw(int chip, int x, int y, int setorclear);
 
@@ -26,4 +52,7 @@ void printChipStateArray(void);
 void updateChipStateArray(void);
 void createChipOrderedIndex(void);
 void printLastChipStateArray(void);
+void markCrosspointsDesynced(void);
+bool crosspointClosed(int chip, int x, int y);
+void printCrosspointStats(void);
 #endif
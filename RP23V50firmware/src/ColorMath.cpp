@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: MIT
+#include "ColorMath.h"
+
+//! Tables, all built by the compiler. Each one gives exactly what the math
+//! it replaces did, including where that truncated or wrapped, so nothing
+//! that was tuned by eye changes color.
+
+struct colorTables {
+  uint8_t region[256];    // h / 43
+  uint8_t remainder[256]; // (h - region * 43) * 6
+  uint32_t reciprocal[256]; // 2^24 / d rounded up, exact for n / d with n <= 255 * 255
+  float scale[COLOR_SCALE_MAX - COLOR_SCALE_MIN + 1];
+
+  constexpr colorTables() : region(), remainder(), reciprocal(), scale() {
+    for (int h = 0; h < 256; h++) {
+      region[h] = h / 43;
+      remainder[h] = (h - region[h] * 43) * 6;
+    }
+    for (int d = 1; d < 256; d++) {
+      reciprocal[d] = ((1UL << 24) + d - 1) / d;
+    }
+    // the same steps scaleBrightness() took, float rounding and all
+    for (int i = 0; i <= COLOR_SCALE_MAX - COLOR_SCALE_MIN; i++) {
+      float scaleFactorF = (i + COLOR_SCALE_MIN) / 100.0;
+      scaleFactorF += 1.0;
+      scale[i] = scaleFactorF;
+    }
+  }
+};
+
+static constexpr struct colorTables colorTables;
+
+static inline uint32_t divideByte(uint32_t n, uint32_t d) {
+  return (uint32_t)(((uint64_t)n * colorTables.reciprocal[d]) >> 24);
+}
+
+// 43 * difference / range, truncated toward 0 like the signed divide was
+static inline int hueOffset(int difference, uint32_t range) {
+  if (difference < 0) {
+    return -(int)divideByte(43 * -difference, range);
+  }
+  return divideByte(43 * difference, range);
+}
+
+uint32_t colorHsvToRgb(uint32_t hsv) {
+  uint32_t h = (hsv >> 16) & 0xff;
+  uint32_t s = (hsv >> 8) & 0xff;
+  uint32_t v = hsv & 0xff;
+
+  if (s == 0) {
+    return v << 16 | v << 8 | v;
+  }
+
+  uint32_t remainder = colorTables.remainder[h];
+  uint32_t p = (v * (255 - s)) >> 8;
+  uint32_t q = (v * (255 - ((s * remainder) >> 8))) >> 8;
+  uint32_t t = (v * (255 - ((s * (255 - remainder)) >> 8))) >> 8;
+
+  switch (colorTables.region[h]) {
+  case 0:
+    return v << 16 | t << 8 | p;
+  case 1:
+    return q << 16 | v << 8 | p;
+  case 2:
+    return p << 16 | v << 8 | t;
+  case 3:
+    return p << 16 | q << 8 | v;
+  case 4:
+    return t << 16 | p << 8 | v;
+  default:
+    return v << 16 | p << 8 | q;
+  }
+}
+
+uint32_t colorRgbToHsv(uint32_t rgb) {
+  int r = (rgb >> 16) & 0xff;
+  int g = (rgb >> 8) & 0xff;
+  int b = rgb & 0xff;
+
+  int rgbMin = r < g ? (r < b ? r : b) : (g < b ? g : b);
+  int rgbMax = r > g ? (r > b ? r : b) : (g > b ? g : b);
+  uint32_t range = rgbMax - rgbMin;
+
+  // range is at least 1 when it's not 0, so s is too
+  if (range == 0) {
+    return rgbMax;
+  }
+  uint32_t s = divideByte(255 * range, rgbMax);
+
+  int h;
+  if (rgbMax == r) {
+    h = 0 + hueOffset(g - b, range);
+  } else if (rgbMax == g) {
+    h = 85 + hueOffset(b - r, range);
+  } else {
+    h = 171 + hueOffset(r - g, range);
+  }
+  return colorPackHsv(h, s, rgbMax);
+}
+
+uint32_t colorScaleBrightness(uint32_t rgb, int scaleFactor) {
+  if (scaleFactor == 0) {
+    return rgb;
+  }
+  float scaleFactorF;
+  if (scaleFactor >= COLOR_SCALE_MIN && scaleFactor <= COLOR_SCALE_MAX) {
+    scaleFactorF = colorTables.scale[scaleFactor - COLOR_SCALE_MIN];
+  } else {
+    scaleFactorF = scaleFactor / 100.0;
+    scaleFactorF += 1.0;
+  }
+
+  uint32_t hsv = colorRgbToHsv(rgb);
+  float value = (hsv & 0xff) * scaleFactorF;
+  // past 255 it keeps the low byte, like the unsigned char it went into
+  uint8_t v = value > 0 ? (uint8_t)(uint32_t)value : 0;
+  return colorHsvToRgb((hsv & 0xffff00) | v);
+}
+
+void colorHsvToRgbRow(const uint32_t *hsv, uint32_t *rgb, int count) {
+  for (int i = 0; i < count; i++) {
+    rgb[i] = colorHsvToRgb(hsv[i]);
+  }
+}
+
+void colorRgbToHsvRow(const uint32_t *rgb, uint32_t *hsv, int count) {
+  for (int i = 0; i < count; i++) {
+    hsv[i] = colorRgbToHsv(rgb[i]);
+  }
+}
+
+void colorScaleBrightnessRow(const uint32_t *rgb, uint32_t *scaled, int count,
+                             int scaleFactor) {
+  for (int i = 0; i < count; i++) {
+    scaled[i] = colorScaleBrightness(rgb[i], scaleFactor);
+  }
+}
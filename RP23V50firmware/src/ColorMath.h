@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: MIT
+#ifndef COLORMATH_H
+#define COLORMATH_H
+
+#include <stdint.h>
+
+#define COLOR_SCALE_MIN -100 // scaleBrightness() factors the table covers,
+#define COLOR_SCALE_MAX 400  // anything outside does the float math it always did
+
+//! Portable: only needs this header, so every conversion can be checked
+//! against the old HsvToRgb() / RgbToHsv() / scaleBrightness() on a PC.
+//! Colors are packed the way the leds are, 0xRRGGBB, and HSV the same way
+//! as 0xHHSSVV.
+
+/// @brief Same result as HsvToRgb(), the hue's region and remainder come
+/// from a table
+uint32_t colorHsvToRgb(uint32_t hsv);
+/// @brief Same result as RgbToHsv(), the two divides are a multiply by a
+/// table of reciprocals
+uint32_t colorRgbToHsv(uint32_t rgb);
+/// @brief Same result as scaleBrightness(), the multiplier for each factor
+/// is worked out at compile time instead of in double math on every call
+uint32_t colorScaleBrightness(uint32_t rgb, int scaleFactor);
+
+/// @brief The same for a whole row, in and out can be the same array
+void colorHsvToRgbRow(const uint32_t *hsv, uint32_t *rgb, int count);
+void colorRgbToHsvRow(const uint32_t *rgb, uint32_t *hsv, int count);
+void colorScaleBrightnessRow(const uint32_t *rgb, uint32_t *scaled, int count,
+                             int scaleFactor);
+
+inline uint32_t colorPackHsv(uint8_t h, uint8_t s, uint8_t v) {
+  return (uint32_t)h << 16 | (uint32_t)s << 8 | v;
+}
+
+#endif
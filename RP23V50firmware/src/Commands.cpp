@@ -8,43 +8,248 @@
 #include "Menus.h"
 #include "NetManager.h"
 #include "NetsToChipConnections.h"
+#include "Overlay.h"
 #include "Peripherals.h"
 #include "PersistentStuff.h"
 #include "Probing.h"
 #include "RotaryEncoder.h"
 #include "SerialWrapper.h"
 #include "USBfs.h"
+#include <hardware/sync.h>
 
-volatile int sendAllPathsCore2 =
-    0; // this signals the core 2 to send all the paths to the CH446Q
-
-    ///negative values clear, 1 = show the netlist as in node file, 2 = keep added graphics, 3 = don't clear this
-volatile int showLEDsCore2 = 0; // this signals the core 2 to show the LEDs
 volatile int showProbeLEDs =
     0; // this signals the core 2 to show the probe LEDs
 
-volatile int core1request = 0; // this signals core 1 wants to do something
+// Core 0 posts work for core 1 through a single-producer / single-consumer
+// ring. Only core 0 writes core2Head and only core 1 writes core2Tail, so
+// neither side needs a lock; the barriers keep the slot write ordered
+// before the index that publishes it. Core 1 folds everything it pops
+// into its pending work (see applyCore2Command() in main.cpp), so a burst
+// of show-LED requests turns into one redraw instead of overwriting a flag.
+#define CORE2_QUEUE_SIZE 32 // must be a power of two
+
+static struct core2Command core2Ring[CORE2_QUEUE_SIZE];
+static volatile uint32_t core2Head = 0;
+static volatile uint32_t core2Tail = 0;
+static uint32_t core2Issued = 0;             // last fence handed out (core 0)
+static volatile uint32_t core2Completed = 0; // last fence finished (core 1)
+static uint32_t lastPathsFence = 0;          // last path send posted (core 0)
+
+struct core2QueueStats core2Stats = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+static uint32_t postCore2Command(uint8_t type, int arg) {
+  struct core2Command cmd;
+  cmd.type = type;
+  cmd.arg = (int16_t)arg;
+  cmd.fence = 0;
+
+  if (get_core_num() == 1) {
+    // menus and the encoder run on core 1 too, they don't need the ring
+    applyCore2Command(&cmd);
+    core2Stats.selfPosted++;
+    return core2Completed;
+    }
+
+  uint32_t head = core2Head;
+  uint32_t depth = head - core2Tail;
+
+  if (depth >= CORE2_QUEUE_SIZE && type == CORE2_SEND_PATHS) {
+    // losing a path send leaves the crosspoints wrong, so give core 1 a
+    // chance to make room (redraws are safe to drop, the next one covers it)
+    unsigned long start = micros();
+    while (core2Head - core2Tail >= CORE2_QUEUE_SIZE &&
+           micros() - start < 25000) {
+      }
+    depth = head - core2Tail;
+    }
+
+  if (depth >= CORE2_QUEUE_SIZE) {
+    core2Stats.dropped++;
+    return core2Issued;
+    }
+
+  cmd.fence = ++core2Issued;
+  if (type == CORE2_SEND_PATHS) {
+    lastPathsFence = cmd.fence;
+    }
+  core2Ring[head & (CORE2_QUEUE_SIZE - 1)] = cmd;
+  __dmb();
+  core2Head = head + 1;
+
+  core2Stats.posted++;
+  if (depth + 1 > core2Stats.maxDepth) {
+    core2Stats.maxDepth = depth + 1;
+    }
+  return cmd.fence;
+  }
+
+uint32_t queueSendPaths(int clean) {
+  return postCore2Command(CORE2_SEND_PATHS, clean);
+  }
+
+uint32_t queueShowLEDs(int ledShowOption) {
+  return postCore2Command(CORE2_SHOW_LEDS, ledShowOption);
+  }
+
+uint32_t queueProbeLEDs(int mode) {
+  return postCore2Command(CORE2_PROBE_LEDS, mode);
+  }
+
+uint32_t queueDumpLEDs(void) {
+  return postCore2Command(CORE2_DUMP_LEDS, 0);
+  }
+
+bool popCore2Command(struct core2Command *cmd) {
+  uint32_t tail = core2Tail;
+
+  if (tail == core2Head) {
+    return false;
+    }
+  __dmb();
+  *cmd = core2Ring[tail & (CORE2_QUEUE_SIZE - 1)];
+  __dmb();
+  core2Tail = tail + 1;
+  return true;
+  }
+
+void completeCore2Fence(uint32_t fence) {
+  if ((int32_t)(fence - core2Completed) > 0) {
+    __dmb();
+    core2Completed = fence;
+    }
+  }
+
+bool core2FenceDone(uint32_t fence) {
+  return (int32_t)(core2Completed - fence) >= 0;
+  }
+
+int core2QueueDepth(void) { return (int)(core2Head - core2Tail); }
+
+unsigned long waitCore2Fence(uint32_t fence, unsigned long timeoutMicros) {
+  if (get_core_num() == 1 || core2FenceDone(fence)) {
+    return 0;
+    }
+
+  unsigned long start = micros();
+  unsigned long waited = 0;
+
+  core2Stats.fenceWaits++;
+  while (!core2FenceDone(fence)) {
+    waited = micros() - start;
+    if (waited > timeoutMicros) {
+      core2Stats.fenceTimeouts++;
+      break;
+      }
+    }
+  waited = micros() - start;
+
+  core2Stats.waitMicros += waited;
+  if (waited > core2Stats.maxWaitMicros) {
+    core2Stats.maxWaitMicros = waited;
+    }
+  return waited;
+  }
 
 unsigned long waitCore2() {
 
-  // delayMicroseconds(60);
   unsigned long timeout = micros();
-  core1request = 1;
-  while (core2busy || (sendAllPathsCore2 != 0)) {
+
+  // like the old flag, this only waits for path sends, not LED redraws
+  waitCore2Fence(lastPathsFence, 25000);
+
+  while (core2busy) {
     // Serial.println("waiting for core2 to finish");
     if (micros() - timeout > 25000) {  // Reduced timeout from 50000 to 25000
       //Serial.println("wait core2 timeout");
       core2busy = false;
-      sendAllPathsCore2 = 0;
       break;
     }
     }
     // Serial.println(micros() - timeout);
 
-  core1request = 0;
   return micros() - timeout;
 }
 
+// core1busy is the request and core2ParkedSeq the ack. Core 0 bumps
+// core2HoldSeq after raising core1busy, and core 1 only writes back a
+// sequence number it read while core1busy was up, so an ack left over from
+// the last hold can't let a new one through early. If core 1 doesn't park
+// in time (stuck somewhere that never reaches parkCore2()) the hold goes
+// ahead on the flag alone, like it did before the ack, rather than hanging
+// every FatFS caller.
+#define HOLD_CORE2_TIMEOUT_US 50000
+
+static volatile uint32_t core2HoldSeq = 0;
+static volatile uint32_t core2ParkedSeq = 0;
+
+void holdCore2(void) {
+  core1busy = true;
+  if (get_core_num() == 1 || core2initFinished == false) {
+    return; // core 1 is the one asking, or hasn't started its loop yet
+    }
+  __dmb();
+  uint32_t seq = core2HoldSeq + 1;
+  core2HoldSeq = seq;
+  __dmb();
+
+  unsigned long start = micros();
+  while (core2ParkedSeq != seq) {
+    if (micros() - start > HOLD_CORE2_TIMEOUT_US) {
+      core2Stats.holdTimeouts++;
+      break;
+      }
+    }
+  unsigned long waited = micros() - start;
+
+  core2Stats.holds++;
+  core2Stats.waitMicros += waited;
+  if (waited > core2Stats.maxWaitMicros) {
+    core2Stats.maxWaitMicros = waited;
+    }
+  }
+
+void parkCore2(void) {
+  while (core1busy == true) {
+    uint32_t seq = core2HoldSeq;
+    __dmb();
+    core2ParkedSeq = seq;
+    }
+  __dmb();
+  }
+
+void printCore2QueueStats(void) {
+  Serial.println("\n\rCore 2 command queue\n\r");
+  Serial.print("  posted:\t\t");
+  Serial.println(core2Stats.posted);
+  Serial.print("  posted from core 2:\t");
+  Serial.println(core2Stats.selfPosted);
+  Serial.print("  coalesced:\t\t");
+  Serial.println(core2Stats.coalesced);
+  Serial.print("  dropped (full):\t");
+  Serial.println(core2Stats.dropped);
+  Serial.print("  depth:\t\t");
+  Serial.print(core2QueueDepth());
+  Serial.print(" (max ");
+  Serial.print(core2Stats.maxDepth);
+  Serial.println(")");
+  Serial.print("  fence waits:\t\t");
+  Serial.print(core2Stats.fenceWaits);
+  Serial.print(" (");
+  Serial.print(core2Stats.fenceTimeouts);
+  Serial.println(" timed out)");
+  Serial.print("  flash holds:\t\t");
+  Serial.print(core2Stats.holds);
+  Serial.print(" (");
+  Serial.print(core2Stats.holdTimeouts);
+  Serial.println(" timed out)");
+  Serial.print("  wait time:\t\t");
+  Serial.print(core2Stats.waitMicros);
+  Serial.print("us total, ");
+  Serial.print(core2Stats.maxWaitMicros);
+  Serial.println("us max");
+  Serial.println();
+  }
+
 int lastSlot = netSlot;
 
 void refresh(int flashOrLocal, int ledShowOption, int fillUnused, int clean) {
@@ -66,35 +271,42 @@ void refreshConnections(int ledShowOption, int fillUnused, int clean) {
  // waitCore2();
 
   unsigned long start = millis();
-  //core1busy = true;
-  clearAllNTCC();
-  //core1busy = true;
-  // return;
-  openNodeFile(netSlot, 0);
-      // Serial.print("refreshConnections openNodeFile = ");
-      // Serial.println(millis() - start);
 
-  getNodesToConnect();
-  // Serial.print("refreshConnections getNodesToConnect = ");
-  // Serial.println(millis() - start);
-//core1busy = false;
-  bridgesToPaths();
-  // Serial.print("refreshConnections bridgesToPaths = ");
-  // Serial.println(millis() - start);
-  checkChangedNetColors(-1);
-  // Serial.print("refreshConnections checkChangedNetColors = ");
-  // Serial.println(millis() - start);
-  assignNetColors();
-  // Serial.print("refreshConnections assignNetColors = ");
-  // Serial.println(millis() - start);
-  chooseShownReadings();
-  // Serial.print("refreshConnections chooseShownReadings = ");
-  // Serial.println(millis() - start);
-  assignTermColor();
-  // Serial.print("refreshConnections assignTermColor = ");
-  // Serial.println(millis() - start);
-  //findChangedNetColors();
-  //assignNetColors();
+  // a slot that was routed recently comes straight back from RAM
+  if (restoreRoutingSnapshot(netSlot) == true) {
+    chooseShownReadings();
+  } else {
+    //core1busy = true;
+    clearAllNTCC();
+    //core1busy = true;
+    // return;
+    openNodeFile(netSlot, 0);
+    // Serial.print("refreshConnections openNodeFile = ");
+    // Serial.println(millis() - start);
+
+    getNodesToConnect();
+    // Serial.print("refreshConnections getNodesToConnect = ");
+    // Serial.println(millis() - start);
+    //core1busy = false;
+    bridgesToPathsCached(netSlot);
+    // Serial.print("refreshConnections bridgesToPaths = ");
+    // Serial.println(millis() - start);
+    checkChangedNetColors(-1);
+    // Serial.print("refreshConnections checkChangedNetColors = ");
+    // Serial.println(millis() - start);
+    assignNetColors();
+    // Serial.print("refreshConnections assignNetColors = ");
+    // Serial.println(millis() - start);
+    chooseShownReadings();
+    // Serial.print("refreshConnections chooseShownReadings = ");
+    // Serial.println(millis() - start);
+    assignTermColor();
+    // Serial.print("refreshConnections assignTermColor = ");
+    // Serial.println(millis() - start);
+    //findChangedNetColors();
+    //assignNetColors();
+    saveRoutingSnapshot(netSlot);
+  }
   
   // Restore GPIO configurations from jumperlessConfig after net processing
   setGPIO();
@@ -121,13 +333,13 @@ void refreshConnections(int ledShowOption, int fillUnused, int clean) {
 
   if (ledShowOption != 0) {
 
-    showLEDsCore2 = ledShowOption;
+    queueShowLEDs(ledShowOption);
     waitCore2();
   }
   if (clean == 1) {
-    sendAllPathsCore2 = -1;
+    queueSendPaths(-1);
   } else {
-    sendAllPathsCore2 = 1;
+    queueSendPaths(1);
   }
 
   // Serial.print("after waitCore2 time = ");
@@ -148,7 +360,7 @@ void refreshLocalConnections(int ledShowOption, int fillUnused, int clean) {
 
   getNodesToConnect();
   
-  bridgesToPaths();
+  bridgesToPathsCached(netSlot);
   checkChangedNetColors(-1);
   assignNetColors();
   chooseShownReadings();
@@ -160,14 +372,14 @@ void refreshLocalConnections(int ledShowOption, int fillUnused, int clean) {
   //core1busy = false;
   if (ledShowOption != 0) {
 
-    showLEDsCore2 = ledShowOption;
+    queueShowLEDs(ledShowOption);
     //waitCore2();
   }
   if (clean == 1) {
-    sendAllPathsCore2 = -1;
+    queueSendPaths(-1);
     //waitCore2();
   } else {
-    sendAllPathsCore2 = 1;
+    queueSendPaths(1);
     //waitCore2();
   }
 
@@ -188,7 +400,7 @@ void refreshBlind(
   openNodeFile(netSlot, 1);
   //core1busy = true;
   getNodesToConnect();
-  bridgesToPaths();
+  bridgesToPathsCached(netSlot);
   checkChangedNetColors(-1);
   assignNetColors();
   assignTermColor();
@@ -199,16 +411,16 @@ void refreshBlind(
   //   lastSlot = netSlot;
   // }
   // if (disconnectFirst == 1) {
-  //   sendAllPathsCore2 = 1;
+  //   queueSendPaths(1);
   // } else if (disconnectFirst == 0) {
-  //   sendAllPathsCore2 = 1;
+  //   queueSendPaths(1);
   // } else {
-  //   sendAllPathsCore2 = 1; // disconnectFirst;
+  //   queueSendPaths(1); // disconnectFirst;
   // }
   if (clean == 1) {
-    sendAllPathsCore2 = -1;
+    queueSendPaths(-1);
   } else {
-    sendAllPathsCore2 = 1;
+    queueSendPaths(1);
   }
 
   chooseShownReadings();
@@ -297,17 +509,146 @@ void connectNodes(int node1, int node2) {
 
   addBridgeToNodeFile(node1, node2, netSlot, 0);
 
-  refreshConnections();
+  if (addBridgeIncremental(node1, node2) == 1) {
+    refreshIncremental();
+  } else {
+    if (incrementalRouting == true) {
+      routingStats.incrementalFallbacks++;
+    }
+    refreshConnections();
+  }
   waitCore2();
   // createLocalNodeFile(netSlot);
 }
 
 void disconnectNodes(int node1, int node2) {
   removeBridgeFromNodeFile(node1, node2, netSlot, 0);
-  refreshConnections();
+
+  if (removeBridgeIncremental(node1, node2) == 1) {
+    refreshIncremental();
+  } else {
+    if (incrementalRouting == true) {
+      routingStats.incrementalFallbacks++;
+    }
+    refreshConnections();
+  }
   waitCore2();
 }
 
+struct bridgeBatchEntry bridgeBatch[MAX_BATCH_BRIDGES];
+int bridgeBatchCount = 0;
+bool bridgeBatchOpen = false;
+
+/// @brief starts collecting bridges so a whole fixture can be wired with
+/// one file write, one routing pass and one crosspoint update
+void beginBridgeBatch(void) {
+  bridgeBatchCount = 0;
+  bridgeBatchOpen = true;
+}
+
+void cancelBridgeBatch(void) {
+  bridgeBatchCount = 0;
+  bridgeBatchOpen = false;
+}
+
+/// @brief adds a bridge (or a removal) to the open batch, returns its index
+/// in bridgeBatch[] or -1 if there's no batch open or it's full
+int batchBridge(int node1, int node2, int remove) {
+  if (bridgeBatchOpen == false || bridgeBatchCount >= MAX_BATCH_BRIDGES) {
+    return -1;
+  }
+  struct bridgeBatchEntry *entry = &bridgeBatch[bridgeBatchCount];
+
+  entry->node1 = node1;
+  entry->node2 = node2;
+  entry->remove = remove != 0;
+  entry->result = BATCH_PENDING;
+
+  if (remove == 0) { // same checks connectNodes() does
+    if (node1 == node2 || node1 < 1 || node2 < 1 ||
+        (node1 > 60 && node1 < 70) || (node2 > 60 && node2 < 70)) {
+      entry->result = BATCH_INVALID;
+    }
+  } else if (node1 < 1) {
+    entry->result = BATCH_INVALID;
+  }
+  return bridgeBatchCount++;
+}
+
+static bool batchBridgeRouted(int node1, int node2) {
+  for (int i = 0; i < numberOfPaths; i++) {
+    if ((path[i].node1 == node1 && path[i].node2 == node2) ||
+        (path[i].node1 == node2 && path[i].node2 == node1)) {
+      return !(path[i].skip == true && path[i].duplicate == 0);
+    }
+  }
+  // no path of its own, it got folded into a net another way
+  int net = netOfNode(node1);
+  return net > 0 && net == netOfNode(node2);
+}
+
+/// @brief writes and routes everything in the batch at once and fills in
+/// each entry's result. Returns how many bridges didn't make it
+int commitBridgeBatch(int save) {
+  bridgeBatchOpen = false;
+
+  if (writeBridgeBatchToNodeFile(bridgeBatch, bridgeBatchCount, netSlot,
+                                 save) > 0) {
+    refreshLocalConnections();
+    waitCore2();
+  }
+
+  int failures = 0;
+
+  for (int i = 0; i < bridgeBatchCount; i++) {
+    struct bridgeBatchEntry *entry = &bridgeBatch[i];
+
+    if (entry->result == BATCH_PENDING) {
+      if (entry->remove == 1 ||
+          batchBridgeRouted(entry->node1, entry->node2) == true) {
+        entry->result = BATCH_OK;
+      } else {
+        entry->result = BATCH_UNROUTED;
+      }
+    }
+    if (entry->result != BATCH_OK) {
+      failures++;
+    }
+  }
+  return failures;
+}
+
+const char *bridgeBatchResultName(int result) {
+  switch (result) {
+  case BATCH_OK:
+    return "ok";
+  case BATCH_INVALID:
+    return "invalid";
+  case BATCH_UNROUTED:
+    return "unrouted";
+  case BATCH_NOT_FOUND:
+    return "notfound";
+  default:
+    return "pending";
+  }
+}
+
+/// @brief finishes up after addBridgeIncremental() / removeBridgeIncremental()
+/// changed the routing in place, only the changed crosspoints get sent
+void refreshIncremental(int ledShowOption) {
+  checkChangedNetColors(-1);
+  assignNetColors();
+  chooseShownReadings();
+  assignTermColor();
+  setGPIO();
+
+  if (ledShowOption != 0) {
+    queueShowLEDs(ledShowOption);
+    waitCore2();
+  }
+  queueSendPaths(1);
+}
+
 float measureVoltage(int adcNumber, int node, bool checkForFloating) {
   int adcDefine = 0;
 
@@ -340,6 +681,20 @@ float measureVoltage(int adcNumber, int node, bool checkForFloating) {
     return 0.0;
   }
 
+  // if there's a free lane the ADC just hangs off the node for the reading,
+  // the node file and nets aren't touched
+  int overlay = addOverlay(adcDefine, node, OVERLAY_PRIORITY_MEASURE);
+  if (overlay > 0) {
+    delayMicroseconds(SCAN_SETTLE_US);
+    float voltage = readAdcVoltage(adcNumber, 8);
+    removeOverlay(overlay);
+    if (checkForFloating == true && voltage < 0.3 && voltage > -0.3 &&
+        checkFloating(node) == true) {
+      return 0xFFFFFFFF;
+    }
+    return voltage;
+  }
+
   // removeBridgeFromNodeFile(adcDefine, -1, netSlot, 0);
 
   // delay(2);
@@ -462,6 +817,13 @@ bool checkFloating(int node) {
   // Serial.print("gpioPin = ");
   // Serial.println(gpioPin);
 
+  int overlay = addOverlay(gpioNumber, node, OVERLAY_PRIORITY_MEASURE);
+  if (overlay > 0) {
+    int floating = gpioReadWithFloating(gpioPin, 100);
+    removeOverlay(overlay);
+    return floating == 2;
+  }
+
   // removeBridgeFromNodeFile(gpioNumber, -1, netSlot, 1);
   addBridgeToNodeFile(node, gpioNumber, netSlot, 1);
   refreshLocalConnections(0, 0, 0); 
@@ -2,11 +2,38 @@
 #define COMMANDS_H
 
 #include <Arduino.h>    
-extern volatile int sendAllPathsCore2;
-extern volatile int showLEDsCore2;
 extern volatile int showProbeLEDs;
+extern volatile bool core2initFinished;
+
+/// @brief Work core 1 (core2stuff()) does on behalf of core 0
+enum core2CommandType {
+  CORE2_SEND_PATHS = 0, // arg: 1 = send paths, -1 = clean send
+  CORE2_SHOW_LEDS,      // arg: negative clears first, 3 holds the LEDs
+  CORE2_PROBE_LEDS,     // arg: probe LED mode, redrawn right away
+  CORE2_DUMP_LEDS,      // dump the LED state to the serial port
+};
+
+struct core2Command {
+  uint8_t type;
+  int16_t arg;
+  uint32_t fence; // 0 when posted from core 1 itself (nothing to await)
+};
 
-extern volatile int core1request;
+struct core2QueueStats {
+  unsigned long posted;
+  unsigned long selfPosted;
+  unsigned long coalesced;
+  unsigned long dropped;
+  unsigned long maxDepth;
+  unsigned long fenceWaits;
+  unsigned long fenceTimeouts;
+  unsigned long holds; // holdCore2() calls that waited for core 1 to park
+  unsigned long holdTimeouts; // ...and went ahead without it
+  unsigned long waitMicros;
+  unsigned long maxWaitMicros;
+};
+
+extern struct core2QueueStats core2Stats;
 
 struct rowLEDs {
   uint32_t color[5];
@@ -16,16 +43,68 @@ void refreshBlind(int disconnectFirst = -1, int fillUnused = 0, int clean = 0);
 
 unsigned long waitCore2(void);
 
+uint32_t queueSendPaths(int clean = 1);
+uint32_t queueShowLEDs(int ledShowOption = 1);
+uint32_t queueProbeLEDs(int mode);
+uint32_t queueDumpLEDs(void);
+bool popCore2Command(struct core2Command *cmd);
+void completeCore2Fence(uint32_t fence);
+bool core2FenceDone(uint32_t fence);
+unsigned long waitCore2Fence(uint32_t fence, unsigned long timeoutMicros = 25000);
+int core2QueueDepth(void);
+void printCore2QueueStats(void);
+
+/// @brief Takes FatFS and the LED buffer from core 1: sets core1busy and
+/// waits until core 1 has parked somewhere it holds neither, or 50 ms, after
+/// which it goes ahead on the flag alone. core1busy = false lets it go again.
+void holdCore2(void);
+/// @brief Core 1 calls this where it holds nothing, it waits there while
+/// core 0 has it held
+void parkCore2(void);
+
+/// @brief Folds a command into core 1's pending work (defined next to
+/// core2stuff() in main.cpp)
+void applyCore2Command(struct core2Command *cmd);
+
 void refresh(int flashOrLocal = 0, int ledShowOption = -1, int fillUnused = 1, int clean = 0);
 
 void refreshConnections(int ledShowOption = 1,int fillUnused = 1, int clean = 0);
 void refreshLocalConnections(int ledShowOption = 1, int fillUnused = 1, int clean = 0);
+void refreshIncremental(int ledShowOption = 1);
 void updateLEDs(void);
 void printSlots(int fileNo = -1);
 bool checkFloating(int node);
 struct rowLEDs getRowLEDdata (int row);
 void setRowLEDdata (int row, struct rowLEDs);
 
+/// @brief One bridge added or removed inside a begin/commitBridgeBatch()
+struct bridgeBatchEntry {
+  int16_t node1;
+  int16_t node2; // -1 on a removal takes out every bridge on node1
+  int8_t remove;
+  int8_t result;
+};
+
+#define MAX_BATCH_BRIDGES 64
+
+enum bridgeBatchResult {
+  BATCH_PENDING = 0,
+  BATCH_OK = 1,
+  BATCH_INVALID = -1,   // bad node numbers, never written
+  BATCH_UNROUTED = -2,  // written but the router couldn't connect it
+  BATCH_NOT_FOUND = -3, // removal of a bridge that wasn't there
+};
+
+extern struct bridgeBatchEntry bridgeBatch[MAX_BATCH_BRIDGES];
+extern int bridgeBatchCount;
+extern bool bridgeBatchOpen;
+
+void beginBridgeBatch(void);
+int batchBridge(int node1, int node2, int remove = 0);
+int commitBridgeBatch(int save = 1);
+void cancelBridgeBatch(void);
+const char *bridgeBatchResultName(int result);
+
 void connectNodes(int node1, int node2);
 
 void disconnectNodes(int node1, int node2);
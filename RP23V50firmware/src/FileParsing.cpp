@@ -8,6 +8,7 @@
 // #include "MachineCommands.h"
 #include "MatrixState.h"
 #include "NetManager.h"
+#include "NetsToChipConnections.h"
 #include "Probing.h"
 #include "RotaryEncoder.h"
 #include "SafeString.h"
@@ -43,6 +44,16 @@ uint32_t slotsWithNetColors = 0;
 // Track which slots have been validated (bit mask for performance)
 uint32_t slotsValidated = 0;
 
+// Track which slots have a compiled cache that matches the slot file (bit mask)
+uint32_t slotsCompiled = 0;
+
+// A compiled cache hit doesn't read the slot text, this is the slot whose
+// text still needs to be read into nodeFileString before it's used (-1 = none)
+static int deferredTextSlot = -1;
+
+static uint32_t crc32Text(const char *text, int length);
+static struct slotStamp readSlotStamp(int slot);
+
 int numConnsJson = 0;
 createSafeString(specialFunctionsString, 2800);
 
@@ -91,17 +102,18 @@ void closeAllFiles() {
 }
 
 int openFileThreadSafe(int openTypeEnum, int slot, int flashOrLocal) {
-  core1request = 1;
-  while (core2busy == true) {
-  }
-  core1request = 0;
-  core1busy = true;
+  holdCore2();
 
   if (nodeFile) {
     // Serial.println("nodeFile is open");
     nodeFile.close();
   }
 
+  if (openTypeEnum != r) {
+    setSlotCompiled(slot, false);
+    removeCompiledNodeFile(slot);
+  }
+
   switch (openTypeEnum) {
   case 0:
     nodeFile = FatFS.open("nodeFileSlot" + String(slot) + ".txt", "w");
@@ -143,10 +155,7 @@ int openFileThreadSafe(int openTypeEnum, int slot, int flashOrLocal) {
 }
 
 void writeMenuTree(void) {
-  while (core2busy == true) {
-    // Serial.println("waiting for core2 to finish");
-  }
-  core1busy = true;
+  holdCore2();
   // FatFS.begin();
   //    delay(100);
   //    FatFS.remove("/MenuTree.txt");
@@ -182,6 +191,7 @@ void writeMenuTree(void) {
 
 void createLocalNodeFile(int slot) {
 
+  deferredTextSlot = -1;
   openFileThreadSafe(aplus, slot);
 
   nodeFileString.clear();
@@ -199,7 +209,48 @@ void createLocalNodeFile(int slot) {
   Serial.println(nodeFileString);
 }
 
-void clearNodeFileString() { nodeFileString.clear(); }
+void clearNodeFileString() {
+  deferredTextSlot = -1;
+  nodeFileString.clear();
+}
+
+/// @brief reads the slot text a compiled cache hit skipped, anything that
+/// works on nodeFileString locally calls this first
+static void readDeferredNodeFileString(void) {
+  if (deferredTextSlot < 0) {
+    return;
+  }
+  int slot = deferredTextSlot;
+  deferredTextSlot = -1;
+
+  openFileThreadSafe(r, slot);
+  nodeFileString.clear();
+  if (nodeFile) {
+    nodeFileString.read(nodeFile);
+    nodeFile.close();
+  }
+  core1busy = false;
+}
+
+/// @brief parses a node file that isn't a slot into path[] the same way
+/// openNodeFile() does, with no compiled cache in the way
+/// @return how many bridges it had, -1 if the file couldn't be opened
+int parseNodeFileAt(const char *fileName) {
+  holdCore2();
+  File file = FatFS.open(fileName, "r");
+  if (!file) {
+    core1busy = false;
+    return -1;
+  }
+  deferredTextSlot = -1;
+  nodeFileString.clear();
+  nodeFileString.read(file);
+  file.close();
+  core1busy = false;
+
+  splitStringToFields();
+  return newBridgeLength;
+}
 
 void saveLocalNodeFile(int slot) {
   // Serial.println("saving local node file");
@@ -208,6 +259,7 @@ void saveLocalNodeFile(int slot) {
 
   long count = 0;
 
+  readDeferredNodeFileString();
   openFileThreadSafe(w, netSlot);
   nodeFileString.replace(" ", "");
   // nodeFileString.replace(" ", "");
@@ -299,10 +351,7 @@ void createConfigFile(int overwrite) {
       return;
     }
   }
-  while (core2busy == true) {
-    // Serial.println("waiting for core2 to finish");
-  }
-  core1busy = true;
+  holdCore2();
 
   File configFile = FatFS.open("config.txt", "w");
   configFile.print("#Jumperless Config file\n\r");
@@ -311,6 +360,7 @@ void createConfigFile(int overwrite) {
   configFile.println(EEPROM.read(REVISIONADDRESS));
 
   configFile.close();
+  core1busy = false;
 }
 
 int checkIfBridgeExists(int node1, int node2, int slot, int flashOrLocal) {
@@ -360,6 +410,7 @@ void inputNodeFileList(int addRotaryConnections) {
       shown = 1;
     }
   }
+  deferredTextSlot = -1;
   nodeFileString.clear();
 
   int startInsertion = 0;
@@ -376,10 +427,7 @@ void inputNodeFileList(int addRotaryConnections) {
   uint8_t lastReads[8] = {' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '};
   uint8_t slotText[8] = {'S', 'l', 'o', 't', ' '};
   uint8_t searchFor[3] = {'f', ' ', '{'};
-  while (core2busy == true) {
-    //   // Serial.println("waiting for core2 to finish");
-  }
-  core1busy = true;
+  holdCore2();
   nodeFileBuffer = FatFS.open("nodeFileBuffer.txt", "w+");
   // openFileThreadSafe(wplus, slot);
   nodeFileString.trim();
@@ -485,11 +533,9 @@ void inputNodeFileList(int addRotaryConnections) {
 
     if (i >= firstSlotNumber && i <= lastSlotNumber) {
       // Serial.println(i);
-      while (core2busy == true) {
-        // Serial.println("waiting for core2 to finish");
-      }
-      core1busy = true;
+      holdCore2();
 
+      removeCompiledNodeFile(i);
       nodeFile = FatFS.open("nodeFileSlot" + String(i) + ".txt", "w");
     }
 
@@ -552,6 +598,7 @@ void saveCurrentSlotToSlot(int slotFrom, int slotTo, int flashOrLocalfrom,
   // core1busy = true;
   openFileThreadSafe(r, slotFrom);
   // nodeFile = FatFS.open("nodeFileSlot" + String(slotFrom) + ".txt", "r");
+  deferredTextSlot = -1;
   nodeFileString.clear();
   nodeFileString.read(nodeFile);
   nodeFile.close();
@@ -608,6 +655,7 @@ void savePreformattedNodeFile(int source, int slot, int keepEncoder) {
     if (specialFunctionsString.endsWith(",") == 0) {
       specialFunctionsString.concat(",\n\r");
     }
+    deferredTextSlot = -1;
     nodeFileString.clear();
 
     specialFunctionsString.printTo(nodeFileString);
@@ -700,10 +748,7 @@ void savePreformattedNodeFile(int source, int slot, int keepEncoder) {
 int getSlotLength(int slot, int flashOrLocal) {
   int slotLength = 0;
   if (flashOrLocal == 0) {
-    while (core2busy == true) {
-      // Serial.println("waiting for core2 to finish");
-    }
-    core1busy = true;
+    holdCore2();
     nodeFile = FatFS.open("nodeFileSlot" + String(slot) + ".txt", "r");
     while (nodeFile.available()) {
       nodeFile.read();
@@ -712,6 +757,7 @@ int getSlotLength(int slot, int flashOrLocal) {
     nodeFile.close();
     core1busy = false;
   } else {
+    readDeferredNodeFileString();
     slotLength = nodeFileString.length();
   }
 
@@ -722,10 +768,7 @@ void printNodeFile(int slot, int printOrString, int flashOrLocal,
                    int definesInts, bool printEmpty) {
 
   if (flashOrLocal == 0) {
-    while (core2busy == true) {
-      // Serial.println("waiting for core2 to finish");
-    }
-    core1busy = true;
+    holdCore2();
 
     nodeFile = FatFS.open("nodeFileSlot" + String(slot) + ".txt", "r");
     if (!nodeFile) {
@@ -744,6 +787,7 @@ void printNodeFile(int slot, int printOrString, int flashOrLocal,
     nodeFile.close();
     core1busy = false;
   } else {
+    readDeferredNodeFileString();
     specialFunctionsString.clear();
     nodeFileString.printTo(specialFunctionsString);
     // specialFunctionsString.read(nodeFileString);
@@ -1112,11 +1156,13 @@ void clearNodeFile(int slot, int flashOrLocal) {
     nodeFile.print("} ");
 
     nodeFile.close();
+    core1busy = false;
     markSlotAsModified(slot); // Mark slot as needing re-validation
 
     clearChangedNetColors();
     removeNetColorFile(slot); // Remove the file and clear tracking bit
   } else {
+    deferredTextSlot = -1;
     nodeFileString.clear();
     clearChangedNetColors();
     setSlotHasNetColors(slot, false); // Clear tracking bit for cache-only mode
@@ -1178,6 +1224,8 @@ int removeBridgeFromNodeFile(int node1, int node2, int slot, int flashOrLocal,
     }
     nodeFile.seek(0);
     nodeFile.setTimeout(8);
+  } else {
+    readDeferredNodeFileString();
   }
   if (onlyCheck == 1) {
     // Serial.print("Checking for bridge between ");
@@ -1480,6 +1528,8 @@ int addBridgeToNodeFile(int node1, int node2, int slot, int flashOrLocal,
     //   }
     //   nodeFile.seek(0);
     nodeFile.setTimeout(15);
+  } else {
+    readDeferredNodeFileString();
   }
 
   // Serial.print("flashOrLocal = ");
@@ -1611,6 +1661,7 @@ int addBridgeToNodeFile(int node1, int node2, int slot, int flashOrLocal,
     // nodeFile.seek(0);
 
     nodeFile.close();
+    core1busy = false;
     markSlotAsModified(slot); // Mark slot as needing re-validation
 
   } else {
@@ -1658,6 +1709,48 @@ int addBridgeToNodeFile(int node1, int node2, int slot, int flashOrLocal,
   return duplicateFound;
 }
 
+/// @brief applies a whole batch of bridge changes to the slot with one read
+/// and (if save) one write, instead of rewriting the file for every bridge.
+/// Entries that aren't BATCH_PENDING are skipped, removals that don't match
+/// anything come back as BATCH_NOT_FOUND. Returns how many were applied.
+int writeBridgeBatchToNodeFile(struct bridgeBatchEntry *entries, int count,
+                               int slot, int save) {
+  readDeferredNodeFileString();
+  if (save == 1 || nodeFileString.length() < 3) {
+    openFileThreadSafe(r, slot);
+    nodeFileString.clear();
+    if (nodeFile) {
+      nodeFileString.read(nodeFile);
+      nodeFile.close();
+    }
+    core1busy = false;
+    if (nodeFileString.length() < 3) {
+      nodeFileString.concat("{ } ");
+    }
+  }
+
+  int applied = 0;
+
+  for (int i = 0; i < count; i++) {
+    if (entries[i].result != BATCH_PENDING) {
+      continue;
+    }
+    if (entries[i].remove == 0) {
+      addBridgeToNodeFile(entries[i].node1, entries[i].node2, slot, 1, 1);
+    } else if (removeBridgeFromNodeFile(entries[i].node1, entries[i].node2,
+                                        slot, 1, 0) <= 0) {
+      entries[i].result = BATCH_NOT_FOUND;
+      continue;
+    }
+    applied++;
+  }
+
+  if (save == 1 && applied > 0) {
+    saveLocalNodeFile(slot);
+  }
+  return applied;
+}
+
 createSafeString(serialString, 100);
 createSafeString(dash, 2);
 
@@ -1669,6 +1762,11 @@ void readStringFromSerial(int source, int addRemove) {
   int numberOfBridges = 0;
   int finished = 1;
   int singleNode = 0;
+  int inputValid = 1;
+
+  // collect everything on the line and write the slot once at the end
+  struct bridgeBatchEntry serialBatch[MAX_BATCH_BRIDGES];
+  int serialBatchCount = 0;
 
   specialFunctionsString.clear();
   serialString.clear();
@@ -1705,7 +1803,8 @@ void readStringFromSerial(int source, int addRemove) {
     int dashIndex = specialFunctionsString.indexOf("-");
     if (dashIndex == -1 && addRemove == 0) {
       Serial.println("Invalid input");
-      return;
+      inputValid = 0;
+      break;
     } else if (dashIndex == -1 && addRemove == 1) {
       singleNode = 1;
       node2 = -1;
@@ -1761,25 +1860,42 @@ void readStringFromSerial(int source, int addRemove) {
 
     if (isNodeValid(node1) != 1) {
       Serial.println("Invalid node 1 number");
-      return;
+      inputValid = 0;
+      break;
     }
 
     if (isNodeValid(node2) != 1 && (addRemove == 0)) {
       Serial.println("Invalid node 2 number");
-      return;
+      inputValid = 0;
+      break;
     }
 
-    if (addRemove == 0) {
-      addBridgeToNodeFile(node1, node2, netSlot, 0, 1);
-    } else if (addRemove == 1) {
+    if (addRemove == 1) {
       if (node1 == node2 || isNodeValid(node2) == 0) {
         node2 = -1;
       }
+    }
 
-      removeBridgeFromNodeFile(node1, node2, netSlot, 0, 0);
+    if (serialBatchCount >= MAX_BATCH_BRIDGES) {
+      writeBridgeBatchToNodeFile(serialBatch, serialBatchCount, netSlot, 1);
+      serialBatchCount = 0;
     }
+    serialBatch[serialBatchCount].node1 = node1;
+    serialBatch[serialBatchCount].node2 = node2;
+    serialBatch[serialBatchCount].remove = addRemove;
+    serialBatch[serialBatchCount].result = BATCH_PENDING;
+    serialBatchCount++;
 
   } while (finished == 0);
+
+  // bridges before a bad one still go in, same as when each was written
+  // as it was parsed
+  if (serialBatchCount > 0) {
+    writeBridgeBatchToNodeFile(serialBatch, serialBatchCount, netSlot, 1);
+  }
+  if (inputValid == 0) {
+    return;
+  }
   printNodeFile(netSlot, 0, 0, 0, true);
 }
 
@@ -2060,6 +2176,8 @@ void openNodeFile(int slot, int flashOrLocal) {
               if (debugFP) {
                 Serial.println("◇ Small file missing braces, fixing");
               }
+              setSlotCompiled(slot, false);
+              removeCompiledNodeFile(slot);
               File fixFile = FatFS.open("nodeFileSlot" + String(slot) + ".txt", "w");
               if (fixFile) {
                 fixFile.print("{ }");
@@ -2108,6 +2226,8 @@ void openNodeFile(int slot, int flashOrLocal) {
         if (debugFP) {
           Serial.println("◇ File doesn't exist, creating empty file");
         }
+        setSlotCompiled(slot, false);
+        removeCompiledNodeFile(slot);
         File createFile = FatFS.open("nodeFileSlot" + String(slot) + ".txt", "w");
         if (createFile) {
           createFile.print("{ }");
@@ -2137,6 +2257,26 @@ void openNodeFile(int slot, int flashOrLocal) {
   //   // Serial.println("waiting for core2 to finish");
   // }
   // core1busy = true;
+  struct slotStamp stamp = {0, 0};
+  uint32_t sourceCrc = 0;
+
+  if (flashOrLocal == 0) {
+    // a slot file that hasn't changed since it was compiled is loaded
+    // without reading or parsing its text at all
+    holdCore2();
+    stamp = readSlotStamp(slot);
+    int cached = loadCompiledNodeFile(slot, flashOrLocal, &stamp, &sourceCrc);
+    core1busy = false;
+
+    if (cached == 1) {
+      deferredTextSlot = slot;
+      noteOpenedSlotText(slot, sourceCrc);
+      return;
+    }
+  } else {
+    readDeferredNodeFileString();
+  }
+
   if ((nodeFileString.length() < 3 && flashOrLocal == 1) || flashOrLocal == 0) {
 
     // if (flashOrLocal == 0) {
@@ -2161,6 +2301,7 @@ void openNodeFile(int slot, int flashOrLocal) {
                        +".txt\n\n\rloading bridges from file\n\r");
     }
 
+    deferredTextSlot = -1;
     nodeFileString.clear();
     nodeFileString.read(nodeFile);
     // delay(10);
@@ -2191,8 +2332,22 @@ void openNodeFile(int slot, int flashOrLocal) {
   //   Serial.println("nodeFileString = ");
   // nodeFileString.printTo(Serial);
 
+  sourceCrc = crc32Text(nodeFileString.c_str(), nodeFileString.length());
+
+  // local text can match a slot that was compiled from the same text
+  if (flashOrLocal == 1 &&
+      loadCompiledNodeFile(slot, flashOrLocal, &stamp, &sourceCrc) == 1) {
+    noteOpenedSlotText(-1, sourceCrc);
+    core1busy = false;
+    return;
+  }
+
+  noteOpenedSlotText(flashOrLocal == 0 ? slot : -1, sourceCrc);
+
   splitStringToFields();
-  
+
+  rememberCompiledBridges(slot, flashOrLocal, sourceCrc, stamp);
+
   core1busy = false;
   // parseStringToBridges();
 }
@@ -2733,6 +2888,7 @@ void setSlotValidated(int slot, bool validated) {
 void markSlotAsModified(int slot) {
   // When a slot is modified, it needs re-validation
   setSlotValidated(slot, false);
+  setSlotCompiled(slot, false);
   if (debugFP) {
     Serial.println("Marked slot " + String(slot) + " as needing validation");
   }
@@ -2778,6 +2934,7 @@ void initializeNetColorTracking() {
 void initializeValidationTracking() {
   // Reset validation tracking - all slots need validation on startup
   slotsValidated = 0;
+  slotsCompiled = 0;
   
   if (debugFP) {
     Serial.println("Initialized validation tracking. All slots marked for validation on first use.");
@@ -2862,6 +3019,741 @@ void benchmarkSlotOperations() {
   Serial.println("  Improvement: ~1000x faster for slots without colors/validation needs");
 }
 
+/*
+Compiled node file cache
+
+Loading a slot runs the text through a pile of String::replace() passes in
+splitStringToFields() and friends before parseStringToBridges() gets to it.
+Once a slot has been parsed (and routed), the bridge list and the path[]
+solution get written to /compiled/compiledSlotN.bin so the next load can
+skip all of that, including reading the text. The sidecar is keyed on the
+slot file's size and last write time, which only takes a directory lookup.
+Writes made here delete the sidecar (removeCompiledNodeFile()) while core 2
+is still held for them, so they can't land on the same stamp, edits over
+the USB drive get a new write time. The CRC
+of the text is kept too so a local copy of the same text can use it.
+*/
+
+#define COMPILED_MAGIC 0x434E4C4A // "JLNC"
+#define COMPILED_VERSION 2
+
+struct compiledHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t bridgeCount;
+  uint32_t sourceCrc;
+  uint32_t stampSize;
+  uint32_t stampTime;
+  uint32_t routingSignature; // 0 = no path[] solution saved
+  uint16_t pathCount;
+  uint16_t pathRecordSize;
+};
+
+struct compiledPath {
+  int16_t node1;
+  int16_t node2;
+  int8_t net;
+  int8_t chip[4];
+  int8_t x[6];
+  int8_t y[6];
+  uint8_t pathType;
+  uint8_t flags; // altPathNeeded, sameChip, skip, duplicate
+};
+
+static void packCompiledPath(compiledPath *record, int i) {
+  record->node1 = path[i].node1;
+  record->node2 = path[i].node2;
+  record->net = path[i].net;
+  for (int j = 0; j < 4; j++) {
+    record->chip[j] = path[i].chip[j];
+  }
+  for (int j = 0; j < 6; j++) {
+    record->x[j] = path[i].x[j];
+    record->y[j] = path[i].y[j];
+  }
+  record->pathType = path[i].pathType;
+  record->flags = (path[i].altPathNeeded ? 1 : 0) | (path[i].sameChip ? 2 : 0) |
+                  (path[i].skip ? 4 : 0) | ((path[i].duplicate & 0x0F) << 4);
+}
+
+static void unpackCompiledPath(const compiledPath *record, int i) {
+  path[i].node1 = record->node1;
+  path[i].node2 = record->node2;
+  path[i].net = record->net;
+  for (int j = 0; j < 4; j++) {
+    path[i].chip[j] = record->chip[j];
+  }
+  for (int j = 0; j < 6; j++) {
+    path[i].x[j] = record->x[j];
+    path[i].y[j] = record->y[j];
+  }
+  path[i].pathType = (enum pathType)record->pathType;
+  path[i].altPathNeeded = (record->flags & 1) != 0;
+  path[i].sameChip = (record->flags & 2) != 0;
+  path[i].skip = (record->flags & 4) != 0;
+  path[i].duplicate = record->flags >> 4;
+  indexByNet[i] = i;
+}
+
+struct compiledRoutingState {
+  int8_t xStatus[12][16];
+  int8_t yStatus[12][8];
+  int16_t uncommittedHops[12];
+  int8_t netVisible[MAX_NETS];
+  int16_t numberOfNets;
+  int16_t numberOfUniqueNets;
+  int16_t numberOfShownNets;
+  int16_t numberOfUnconnectablePaths;
+  int16_t unconnectablePaths[10][2];
+};
+
+struct compiledCacheStats compiledCacheStats = {0, 0, 0, 0, 0};
+
+static int16_t compiledBridges[MAX_BRIDGES][2];
+static int compiledBridgeCount = 0;
+static int compiledSlot = -1; // slot the bridges above were loaded from
+static uint32_t compiledCrc = 0;
+static struct slotStamp compiledStamp = {0, 0};
+static uint32_t compiledSignature = 0; // routing saved in the sidecar
+static bool compiledPending = false;   // sidecar needs to be (re)written
+
+static String compiledFileName(int slot) {
+  return "/compiled/compiledSlot" + String(slot) + ".bin";
+}
+
+bool slotIsCompiled(int slot) {
+  if (slot < 0 || slot >= 32) return false;
+  return (slotsCompiled & (1U << slot)) != 0;
+}
+
+void setSlotCompiled(int slot, bool compiled) {
+  if (slot < 0 || slot >= 32) return;
+  if (compiled) {
+    slotsCompiled |= (1U << slot);
+  } else {
+    slotsCompiled &= ~(1U << slot);
+    if (slot == compiledSlot) {
+      compiledSlot = -1;
+    }
+  }
+}
+
+/// @brief deletes a slot's sidecar, an edit can keep the size and land in the
+/// same write time tick. Call it with core 2 held, before the slot is written
+void removeCompiledNodeFile(int slot) {
+  String fileName = compiledFileName(slot);
+  if (FatFS.exists(fileName)) {
+    FatFS.remove(fileName);
+  }
+}
+
+/// @brief size and last write time of a slot file, {0, 0} if it's missing
+static struct slotStamp readSlotStamp(int slot) {
+  struct slotStamp stamp = {0, 0};
+  File slotFile = FatFS.open("nodeFileSlot" + String(slot) + ".txt", "r");
+  if (slotFile) {
+    stamp.size = slotFile.size();
+    stamp.lastWrite = (uint32_t)slotFile.getLastWrite();
+    slotFile.close();
+  }
+  return stamp;
+}
+
+static uint32_t crc32Text(const char *text, int length) {
+  uint32_t crc = 0xFFFFFFFF;
+  for (int i = 0; i < length; i++) {
+    crc ^= (uint8_t)text[i];
+    for (int b = 0; b < 8; b++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+/// @brief anything that changes how bridgesToPaths() would route the same
+/// bridges, a saved solution is only used if this matches
+static uint32_t routingSignature(void) {
+  uint32_t sig = 0x811C9DC5;
+  int settings[6] = {jumperlessConfig.routing.stack_paths,
+                     jumperlessConfig.routing.stack_rails,
+                     jumperlessConfig.routing.stack_dacs,
+                     jumperlessConfig.routing.rail_priority, probePowerDAC,
+                     jumperlessConfig.routing.search_budget_ms};
+  for (int i = 0; i < 6; i++) {
+    sig = (sig ^ (uint32_t)settings[i]) * 0x01000193;
+  }
+  return sig == 0 ? 1 : sig;
+}
+
+/// @brief loads the bridge list from the compiled sidecar if it was built
+/// from the same slot. Flash loads match on the slot file's stamp and get
+/// the text's CRC back in sourceCrc, local loads match on sourceCrc
+/// @return 1 if path[] was filled from the cache, 0 if the text needs parsing
+int loadCompiledNodeFile(int slot, int flashOrLocal, struct slotStamp *stamp,
+                         uint32_t *sourceCrc) {
+  unsigned long loadTimer = micros();
+
+  if (flashOrLocal == 0 && stamp->size == 0) {
+    compiledCacheStats.misses++;
+    return 0;
+  }
+
+  String fileName = compiledFileName(slot);
+  if (FatFS.exists(fileName) == false) {
+    compiledCacheStats.misses++;
+    return 0;
+  }
+
+  File compiledFile = FatFS.open(fileName, "r");
+  if (!compiledFile) {
+    compiledCacheStats.misses++;
+    return 0;
+  }
+
+  compiledHeader header;
+  bool matches = false;
+  if (compiledFile.read((uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+      header.magic == COMPILED_MAGIC && header.version == COMPILED_VERSION &&
+      header.bridgeCount <= MAX_BRIDGES - 1 &&
+      header.pathRecordSize == sizeof(compiledPath)) {
+    if (flashOrLocal == 0) {
+      matches = header.stampSize == stamp->size &&
+                header.stampTime == stamp->lastWrite;
+    } else {
+      matches = header.sourceCrc == *sourceCrc;
+    }
+  }
+  if (matches == false) {
+    compiledFile.close();
+    compiledCacheStats.misses++;
+    if (debugFP) {
+      Serial.println("◇ Compiled cache for slot " + String(slot) + " is stale");
+    }
+    return 0;
+  }
+
+  int bridgeBytes = header.bridgeCount * 2 * sizeof(int16_t);
+  if (compiledFile.read((uint8_t *)compiledBridges, bridgeBytes) !=
+      bridgeBytes) {
+    compiledFile.close();
+    compiledCacheStats.misses++;
+    return 0;
+  }
+  compiledFile.close();
+
+  for (int i = 0; i < header.bridgeCount; i++) {
+    path[i].node1 = compiledBridges[i][0];
+    path[i].node2 = compiledBridges[i][1];
+  }
+  newBridgeLength = header.bridgeCount;
+  newBridgeIndex = 0;
+
+  compiledBridgeCount = header.bridgeCount;
+  compiledSlot = slot;
+  compiledCrc = header.sourceCrc;
+  compiledStamp.size = header.stampSize;
+  compiledStamp.lastWrite = header.stampTime;
+  compiledSignature = header.routingSignature;
+  compiledPending = false;
+  *sourceCrc = header.sourceCrc;
+  if (flashOrLocal == 0) {
+    setSlotCompiled(slot, true);
+  }
+
+  compiledCacheStats.hits++;
+  compiledCacheStats.lastLoadMicros = micros() - loadTimer;
+
+  timeToFP = millis() - timeToFP;
+  if (debugFP) {
+    Serial.println("◆ Loaded " + String(compiledBridgeCount) +
+                   " bridges from compiled slot " + String(slot) + " in " +
+                   String(compiledCacheStats.lastLoadMicros) + " μs");
+  }
+  return 1;
+}
+
+/// @brief keeps the freshly parsed bridges around so saveCompiledNodeFile()
+/// can write them out with the routing once it's done
+void rememberCompiledBridges(int slot, int flashOrLocal, uint32_t sourceCrc,
+                             struct slotStamp stamp) {
+  if (flashOrLocal != 0) {
+    // don't wear out flash for every local edit
+    compiledSlot = -1;
+    return;
+  }
+  for (int i = 0; i < newBridgeLength && i < MAX_BRIDGES; i++) {
+    compiledBridges[i][0] = path[i].node1;
+    compiledBridges[i][1] = path[i].node2;
+  }
+  compiledBridgeCount = newBridgeLength;
+  compiledSlot = slot;
+  compiledCrc = sourceCrc;
+  compiledStamp = stamp;
+  compiledSignature = 0;
+  compiledPending = true;
+}
+
+/// @brief writes the compiled sidecar with the bridges from the last
+/// openNodeFile() and the path[] solution from bridgesToPaths()
+void saveCompiledNodeFile(int slot) {
+  uint32_t signature = routingSignature();
+
+  if (compiledSlot != slot ||
+      (compiledPending == false && compiledSignature == signature)) {
+    return;
+  }
+
+  unsigned long saveTimer = micros();
+
+  holdCore2();
+
+  if (!FatFS.exists("/compiled")) {
+    FatFS.mkdir("/compiled");
+  }
+
+  File compiledFile = FatFS.open(compiledFileName(slot), "w");
+  if (!compiledFile) {
+    core1busy = false;
+    if (debugFP) {
+      Serial.println("Failed to write compiled cache for slot " + String(slot));
+    }
+    return;
+  }
+
+  compiledHeader header;
+  header.magic = COMPILED_MAGIC;
+  header.version = COMPILED_VERSION;
+  header.bridgeCount = compiledBridgeCount;
+  header.sourceCrc = compiledCrc;
+  header.stampSize = compiledStamp.size;
+  header.stampTime = compiledStamp.lastWrite;
+  header.routingSignature = signature;
+  header.pathCount = numberOfPaths;
+  header.pathRecordSize = sizeof(compiledPath);
+
+  compiledFile.write((uint8_t *)&header, sizeof(header));
+  compiledFile.write((uint8_t *)compiledBridges,
+                     compiledBridgeCount * 2 * sizeof(int16_t));
+
+  for (int i = 0; i < numberOfPaths; i++) {
+    compiledPath record;
+    packCompiledPath(&record, i);
+    compiledFile.write((uint8_t *)&record, sizeof(record));
+  }
+
+  compiledRoutingState state;
+  for (int c = 0; c < 12; c++) {
+    memcpy(state.xStatus[c], ch[c].xStatus, 16);
+    memcpy(state.yStatus[c], ch[c].yStatus, 8);
+    state.uncommittedHops[c] = ch[c].uncommittedHops;
+  }
+  for (int n = 0; n < MAX_NETS; n++) {
+    state.netVisible[n] = net[n].visible;
+  }
+  state.numberOfNets = numberOfNets;
+  state.numberOfUniqueNets = numberOfUniqueNets;
+  state.numberOfShownNets = numberOfShownNets;
+  state.numberOfUnconnectablePaths = numberOfUnconnectablePaths;
+  for (int i = 0; i < 10; i++) {
+    state.unconnectablePaths[i][0] = unconnectablePaths[i][0];
+    state.unconnectablePaths[i][1] = unconnectablePaths[i][1];
+  }
+  compiledFile.write((uint8_t *)&state, sizeof(state));
+  compiledFile.close();
+
+  core1busy = false;
+
+  compiledPending = false;
+  compiledSignature = signature;
+  setSlotCompiled(slot, true);
+  compiledSlot = slot; // setSlotCompiled() doesn't touch this when setting
+  compiledCacheStats.writes++;
+
+  if (debugFP) {
+    Serial.println("◆ Compiled slot " + String(slot) + " (" +
+                   String(compiledBridgeCount) + " bridges, " +
+                   String(numberOfPaths) + " paths) in " +
+                   String(micros() - saveTimer) + " μs");
+  }
+}
+
+/// @brief restores the path[] solution saved with the bridges that
+/// openNodeFile() just loaded, call after getNodesToConnect()
+/// @return true if bridgesToPaths() can be skipped
+bool loadCompiledRouting(int slot) {
+  if (compiledSlot != slot || compiledPending == true ||
+      compiledSignature == 0 || compiledSignature != routingSignature()) {
+    return false;
+  }
+
+  File compiledFile = FatFS.open(compiledFileName(slot), "r");
+  if (!compiledFile) {
+    return false;
+  }
+
+  compiledHeader header;
+  compiledFile.read((uint8_t *)&header, sizeof(header));
+  if (header.pathCount > MAX_BRIDGES - 1 || header.sourceCrc != compiledCrc ||
+      header.stampSize != compiledStamp.size ||
+      header.stampTime != compiledStamp.lastWrite) {
+    compiledFile.close();
+    return false;
+  }
+
+  uint32_t pathsStart =
+      sizeof(header) + header.bridgeCount * 2 * sizeof(int16_t);
+  compiledRoutingState state;
+
+  // check every path still lines up with the nets getNodesToConnect() made
+  // before anything gets overwritten
+  compiledFile.seek(pathsStart);
+  for (int i = 0; i < header.pathCount; i++) {
+    compiledPath record;
+    if (compiledFile.read((uint8_t *)&record, sizeof(record)) !=
+        sizeof(record)) {
+      compiledFile.close();
+      return false;
+    }
+    if (record.net <= 0 || record.net >= MAX_NETS ||
+        net[record.net].number != record.net) {
+      compiledFile.close();
+      return false;
+    }
+    bool found = false;
+    for (int b = 0; b < MAX_NODES; b++) {
+      if (net[record.net].bridges[b][0] == 0) {
+        break;
+      }
+      if ((net[record.net].bridges[b][0] == record.node1 &&
+           net[record.net].bridges[b][1] == record.node2) ||
+          (net[record.net].bridges[b][0] == record.node2 &&
+           net[record.net].bridges[b][1] == record.node1)) {
+        found = true;
+        break;
+      }
+    }
+    if (found == false && (record.flags >> 4) == 0) {
+      compiledFile.close();
+      return false;
+    }
+  }
+  if (compiledFile.read((uint8_t *)&state, sizeof(state)) != sizeof(state)) {
+    compiledFile.close();
+    return false;
+  }
+
+  numberOfPaths = header.pathCount;
+  clearChipsOnPathToNegOne();
+
+  compiledFile.seek(pathsStart);
+  for (int i = 0; i < header.pathCount; i++) {
+    compiledPath record;
+    compiledFile.read((uint8_t *)&record, sizeof(record));
+    unpackCompiledPath(&record, i);
+  }
+  compiledFile.close();
+
+  for (int c = 0; c < 12; c++) {
+    memcpy(ch[c].xStatus, state.xStatus[c], 16);
+    memcpy(ch[c].yStatus, state.yStatus[c], 8);
+    ch[c].uncommittedHops = state.uncommittedHops[c];
+  }
+  for (int n = 0; n < MAX_NETS; n++) {
+    net[n].visible = state.netVisible[n];
+  }
+  numberOfNets = state.numberOfNets;
+  numberOfUniqueNets = state.numberOfUniqueNets;
+  numberOfShownNets = state.numberOfShownNets;
+  numberOfUnconnectablePaths = state.numberOfUnconnectablePaths;
+  for (int i = 0; i < 10; i++) {
+    unconnectablePaths[i][0] = state.unconnectablePaths[i][0];
+    unconnectablePaths[i][1] = state.unconnectablePaths[i][1];
+  }
+
+  routedSlot = slot;
+  compiledCacheStats.routingHits++;
+  return true;
+}
+
+/// @brief bridgesToPaths() that reuses the solution from the compiled slot
+/// cache when it's still good and saves a new one when it isn't
+void bridgesToPathsCached(int slot) {
+  if (loadCompiledRouting(slot) == true) {
+    return;
+  }
+  bridgesToPaths();
+  routedSlot = slot; // showSavedColors() routes slots other than netSlot
+  saveCompiledNodeFile(slot);
+}
+
+// The last few fully routed slots are also kept in RAM, so flipping between
+// fixtures doesn't even need the sidecar. A snapshot is keyed on the slot
+// text, the routing settings and the changed net colors, and it's only
+// restored if all three still match.
+struct routingSnapshot {
+  int slot; // -1 = unused
+  uint32_t sourceCrc;
+  uint32_t signature;
+  uint32_t colorsCrc;
+  unsigned long lastUsed;
+  int bytes;
+  int16_t netCount;
+  int16_t pathCount;
+  int gpioNet[10];
+  compiledRoutingState state;
+  uint8_t *data; // netStructs, compiledPaths, then changedNetColors[]
+};
+
+struct snapshotCacheStats snapshotCacheStats = {0, 0, 0, 0, 0};
+
+static struct routingSnapshot routingSnapshots[NUM_SLOTS];
+static bool routingSnapshotsInit = false;
+static unsigned long snapshotClock = 0;
+static int openedSlot = -1; // flash slot openNodeFile() last read
+static uint32_t openedCrc = 0;
+static uint32_t openedColorsCrc = 0;
+
+static uint32_t changedColorsCrc(void) {
+  return crc32Text((const char *)changedNetColors, sizeof(changedNetColors));
+}
+
+/// @brief remembers which slot text the nets are about to be built from,
+/// checkChangedNetColors() rewrites the colors later so grab those now too
+void noteOpenedSlotText(int slot, uint32_t sourceCrc) {
+  openedSlot = slot;
+  openedCrc = sourceCrc;
+  openedColorsCrc = changedColorsCrc();
+}
+
+static void initRoutingSnapshots(void) {
+  if (routingSnapshotsInit == true) {
+    return;
+  }
+  for (int i = 0; i < NUM_SLOTS; i++) {
+    routingSnapshots[i].slot = -1;
+    routingSnapshots[i].bytes = 0;
+    routingSnapshots[i].data = nullptr;
+  }
+  routingSnapshotsInit = true;
+}
+
+static void freeRoutingSnapshot(struct routingSnapshot *snap) {
+  if (snap->data != nullptr) {
+    free(snap->data);
+  }
+  snapshotCacheStats.bytesUsed -= snap->bytes;
+  snap->data = nullptr;
+  snap->bytes = 0;
+  snap->slot = -1;
+}
+
+/// @brief forgets the RAM snapshot for one slot, or all of them with -1
+void dropRoutingSnapshots(int slot) {
+  initRoutingSnapshots();
+  for (int i = 0; i < NUM_SLOTS; i++) {
+    if (routingSnapshots[i].slot != -1 &&
+        (slot == -1 || routingSnapshots[i].slot == slot)) {
+      freeRoutingSnapshot(&routingSnapshots[i]);
+    }
+  }
+}
+
+static struct routingSnapshot *findRoutingSnapshot(int slot) {
+  initRoutingSnapshots();
+  for (int i = 0; i < NUM_SLOTS; i++) {
+    if (routingSnapshots[i].slot == slot) {
+      return &routingSnapshots[i];
+    }
+  }
+  return nullptr;
+}
+
+/// @brief copies the routed state of a slot into RAM, call once nets,
+/// paths and colors are all settled (after assignTermColor())
+void saveRoutingSnapshot(int slot) {
+  long budget = (long)jumperlessConfig.routing.snapshot_cache_kb * 1024;
+
+  if (slot != openedSlot || slot < 0 || budget <= 0 ||
+      numberOfPaths > MAX_BRIDGES - 1) {
+    return;
+  }
+  dropRoutingSnapshots(slot);
+
+  int netCount = 0;
+  for (int n = 0; n < MAX_NETS; n++) {
+    if (net[n].number != 0) {
+      netCount = n + 1;
+    }
+  }
+  int bytes = netCount * sizeof(struct netStruct) +
+              numberOfPaths * sizeof(compiledPath) + sizeof(changedNetColors);
+
+  if (bytes > budget) {
+    return;
+  }
+
+  // make room by dropping the least recently used slots
+  while (snapshotCacheStats.bytesUsed + bytes > budget) {
+    struct routingSnapshot *oldest = nullptr;
+    for (int i = 0; i < NUM_SLOTS; i++) {
+      if (routingSnapshots[i].slot != -1 &&
+          (oldest == nullptr ||
+           routingSnapshots[i].lastUsed < oldest->lastUsed)) {
+        oldest = &routingSnapshots[i];
+      }
+    }
+    if (oldest == nullptr) {
+      break;
+    }
+    freeRoutingSnapshot(oldest);
+    snapshotCacheStats.evictions++;
+  }
+
+  struct routingSnapshot *snap = findRoutingSnapshot(-1);
+  if (snap == nullptr) {
+    return;
+  }
+  snap->data = (uint8_t *)malloc(bytes);
+  if (snap->data == nullptr) {
+    return;
+  }
+
+  memcpy(snap->data, net, netCount * sizeof(struct netStruct));
+  compiledPath *records =
+      (compiledPath *)(snap->data + netCount * sizeof(struct netStruct));
+
+  for (int i = 0; i < numberOfPaths; i++) {
+    packCompiledPath(&records[i], i);
+  }
+  memcpy(records + numberOfPaths, changedNetColors, sizeof(changedNetColors));
+
+  for (int c = 0; c < 12; c++) {
+    memcpy(snap->state.xStatus[c], ch[c].xStatus, 16);
+    memcpy(snap->state.yStatus[c], ch[c].yStatus, 8);
+    snap->state.uncommittedHops[c] = ch[c].uncommittedHops;
+  }
+  snap->state.numberOfNets = numberOfNets;
+  snap->state.numberOfUniqueNets = numberOfUniqueNets;
+  snap->state.numberOfShownNets = numberOfShownNets;
+  snap->state.numberOfUnconnectablePaths = numberOfUnconnectablePaths;
+  for (int i = 0; i < 10; i++) {
+    snap->state.unconnectablePaths[i][0] = unconnectablePaths[i][0];
+    snap->state.unconnectablePaths[i][1] = unconnectablePaths[i][1];
+    snap->gpioNet[i] = gpioNet[i];
+  }
+
+  snap->slot = slot;
+  snap->sourceCrc = openedCrc;
+  snap->signature = routingSignature();
+  snap->colorsCrc = openedColorsCrc;
+  snap->lastUsed = ++snapshotClock;
+  snap->bytes = bytes;
+  snap->netCount = netCount;
+  snap->pathCount = numberOfPaths;
+  snapshotCacheStats.bytesUsed += bytes;
+}
+
+/// @brief puts a slot's routed state back from RAM without parsing or
+/// routing anything. The slot text still gets read (it's small) so a file
+/// changed behind our back is caught and nodeFileString stays current.
+/// @return true if nets, paths and chip status are ready to show and send
+bool restoreRoutingSnapshot(int slot) {
+  struct routingSnapshot *snap = findRoutingSnapshot(slot);
+
+  if (snap == nullptr || slot < 0) {
+    snapshotCacheStats.misses++;
+    return false;
+  }
+  unsigned long restoreTimer = micros();
+
+  openFileThreadSafe(r, slot);
+  if (!nodeFile) {
+    core1busy = false;
+    dropRoutingSnapshots(slot);
+    snapshotCacheStats.misses++;
+    return false;
+  }
+  nodeFileString.clear();
+  nodeFileString.read(nodeFile);
+  nodeFile.close();
+  core1busy = false;
+
+  if (crc32Text(nodeFileString.c_str(), nodeFileString.length()) !=
+          snap->sourceCrc ||
+      routingSignature() != snap->signature ||
+      changedColorsCrc() != snap->colorsCrc) {
+    dropRoutingSnapshots(slot);
+    snapshotCacheStats.misses++;
+    return false;
+  }
+
+  clearAllNTCC();
+
+  memcpy(net, snap->data, snap->netCount * sizeof(struct netStruct));
+  compiledPath *records =
+      (compiledPath *)(snap->data + snap->netCount * sizeof(struct netStruct));
+
+  numberOfPaths = snap->pathCount;
+  for (int i = 0; i < snap->pathCount; i++) {
+    unpackCompiledPath(&records[i], i);
+  }
+  memcpy(changedNetColors, records + snap->pathCount, sizeof(changedNetColors));
+
+  for (int c = 0; c < 12; c++) {
+    memcpy(ch[c].xStatus, snap->state.xStatus[c], 16);
+    memcpy(ch[c].yStatus, snap->state.yStatus[c], 8);
+    ch[c].uncommittedHops = snap->state.uncommittedHops[c];
+  }
+  numberOfNets = snap->state.numberOfNets;
+  numberOfUniqueNets = snap->state.numberOfUniqueNets;
+  numberOfShownNets = snap->state.numberOfShownNets;
+  numberOfUnconnectablePaths = snap->state.numberOfUnconnectablePaths;
+  for (int i = 0; i < 10; i++) {
+    unconnectablePaths[i][0] = snap->state.unconnectablePaths[i][0];
+    unconnectablePaths[i][1] = snap->state.unconnectablePaths[i][1];
+    gpioNet[i] = snap->gpioNet[i];
+  }
+  rebuildNetIndex();
+
+  routedSlot = slot;
+  openedSlot = slot;
+  openedCrc = snap->sourceCrc;
+  snap->lastUsed = ++snapshotClock;
+  snapshotCacheStats.hits++;
+  snapshotCacheStats.lastRestoreMicros = micros() - restoreTimer;
+  return true;
+}
+
+void printCompiledCacheStatus(void) {
+  Serial.println("◆ Compiled slot cache:");
+  Serial.print("    Tracking variable: 0x");
+  Serial.println(slotsCompiled, HEX);
+  Serial.println("    Hits: " + String(compiledCacheStats.hits) +
+                 "  misses: " + String(compiledCacheStats.misses) +
+                 "  routing reused: " + String(compiledCacheStats.routingHits) +
+                 "  writes: " + String(compiledCacheStats.writes));
+  Serial.println("    Last cached load: " +
+                 String(compiledCacheStats.lastLoadMicros) + " μs");
+
+  int snapshots = 0;
+  initRoutingSnapshots();
+  for (int i = 0; i < NUM_SLOTS; i++) {
+    if (routingSnapshots[i].slot != -1) {
+      snapshots++;
+    }
+  }
+  Serial.println("◆ RAM slot snapshots:");
+  Serial.println("    Slots held: " + String(snapshots) + "  using " +
+                 String(snapshotCacheStats.bytesUsed) + " of " +
+                 String(jumperlessConfig.routing.snapshot_cache_kb * 1024) +
+                 " bytes");
+  Serial.println("    Hits: " + String(snapshotCacheStats.hits) +
+                 "  misses: " + String(snapshotCacheStats.misses) +
+                 "  evictions: " + String(snapshotCacheStats.evictions));
+  Serial.println("    Last restore: " +
+                 String(snapshotCacheStats.lastRestoreMicros) + " μs");
+}
+
 ///@brief prints the disconnected nodes (separated by commas)
 ///@return the number of disconnected nodes
 int printDisconnectedNodes() {
@@ -3121,11 +4013,8 @@ int printChangedNetColorFile(int slot, int flashOrLocal) {
     // Print from cache (currentColorSlotColorsString)
     // The cache always refers to the current netSlot, so 'slot' param is
     // implicitly current netSlot
-    core1request = 1; // Lock for reading global variable
-    while (core2busy == true) {
-    }
-    core1request = 0;
-    core1busy = true;
+    // Lock for reading global variable
+    holdCore2();
 
     if (debugFP) {
       Serial.println(
@@ -3160,11 +4049,7 @@ int printChangedNetColorFile(int slot, int flashOrLocal) {
     return 0;
   }
 
-  core1request = 1;
-  while (core2busy == true) {
-  }
-  core1request = 0;
-  core1busy = true;
+  holdCore2();
 
   if (::colorFile) {
     ::colorFile.close();
@@ -3244,11 +4129,7 @@ int saveChangedNetColorsToFile(int slot, int flashOrLocal) {
   }
 
   if (flashOrLocal == 0) { // Save to Flash and update cache if current slot
-    core1request = 1;
-    while (core2busy == true) {
-    }
-    core1request = 0;
-    core1busy = true;
+    holdCore2();
 
     // Ensure net colors directory exists
     ensureNetColorsDirectoryExists();
@@ -3295,12 +4176,8 @@ int saveChangedNetColorsToFile(int slot, int flashOrLocal) {
 
   } else { // flashOrLocal == 1, Save to Cache ONLY (for current slot)
     // Assuming this mode implies the operation is for the current netSlot
-    core1request = 1; // Maintain lock for consistency, as it modifies a
-                      // shared-context global
-    while (core2busy == true) {
-    }
-    core1request = 0;
-    core1busy = true;
+    // Maintain lock for consistency, as it modifies a shared-context global
+    holdCore2();
 
     currentColorSlotColorsString = tempColorDataString;
     // Update tracking bit to indicate this slot has colors (cache has data)
@@ -3439,11 +4316,7 @@ bool attemptNodeFileRepair(int slot) {
   }
 
   // Write the repaired content back to file
-  core1request = 1;
-  while (core2busy == true) {
-  }
-  core1request = 0;
-  core1busy = true;
+  holdCore2();
 
   File slotFile = FatFS.open("nodeFileSlot" + String(slot) + ".txt", "w");
   if (slotFile) {
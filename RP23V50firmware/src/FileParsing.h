@@ -31,6 +31,49 @@ bool slotIsValidated(int slot);
 void setSlotValidated(int slot, bool validated);
 void markSlotAsModified(int slot);
 void initializeValidationTracking(void);
+
+// Compiled slot cache (/compiled/compiledSlotN.bin)
+struct compiledCacheStats {
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long routingHits;
+  unsigned long writes;
+  unsigned long lastLoadMicros;
+};
+extern struct compiledCacheStats compiledCacheStats;
+
+// what a compiled sidecar is keyed on, so a hit needs no read of the text
+struct slotStamp {
+  uint32_t size;
+  uint32_t lastWrite;
+};
+
+struct snapshotCacheStats {
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long evictions;
+  long bytesUsed;
+  unsigned long lastRestoreMicros;
+};
+extern struct snapshotCacheStats snapshotCacheStats;
+
+void noteOpenedSlotText(int slot, uint32_t sourceCrc);
+void saveRoutingSnapshot(int slot);
+bool restoreRoutingSnapshot(int slot);
+void dropRoutingSnapshots(int slot = -1);
+extern uint32_t slotsCompiled;
+
+bool slotIsCompiled(int slot);
+void setSlotCompiled(int slot, bool compiled);
+void removeCompiledNodeFile(int slot);
+int loadCompiledNodeFile(int slot, int flashOrLocal, struct slotStamp *stamp,
+                         uint32_t *sourceCrc);
+void rememberCompiledBridges(int slot, int flashOrLocal, uint32_t sourceCrc,
+                             struct slotStamp stamp);
+void saveCompiledNodeFile(int slot);
+bool loadCompiledRouting(int slot);
+void bridgesToPathsCached(int slot);
+void printCompiledCacheStatus(void);
 int checkIfBridgeExists(int node1, int node2 = -1, int slot = -1, int flashOrLocal = 1);
 
 void clearNodeFileString(void);
@@ -47,6 +90,8 @@ void parseWokwiFileToNodeFile();
 void changeWokwiDefinesToJumperless ();
 void writeToNodeFile(int slot = 0, int flashOrLocal = 0);
 int removeBridgeFromNodeFile(int node1, int node2 = -1, int slot = 0, int flashOrLocal = 0, int onlyCheck = 0);
+int writeBridgeBatchToNodeFile(struct bridgeBatchEntry *entries, int count,
+                               int slot, int save = 1);
 int addBridgeToNodeFile(int node1, int node2, int slot = 0, int flashOrLocal = 0, int allowDuplicates = 1); //returns 1 if duplicate was found
 void savePreformattedNodeFile (int source = 0, int slot = 0, int keepEncoder = 1);
 
@@ -59,6 +104,7 @@ int getSlotLength(int slot, int flashOrLocal = 0);
 void openNodeFile(int slot = 0, int flashOrLocal = 0);
 
 void splitStringToFields();
+int parseNodeFileAt(const char *fileName);
 
 void replaceSFNamesWithDefinedInts();
 void printNodeFile(int slot = 0, int printOrString = 0, int flashOrLocal = 0, int definesInts = 0, bool printEmpty = true);
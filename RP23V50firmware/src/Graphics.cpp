@@ -4,6 +4,7 @@
 #include "Highlighting.h"
 #include "JumperlessDefines.h"
 #include "LEDs.h"
+#include "ColorMath.h"
 #include "MatrixState.h"
 #include "Menus.h"
 #include "NetManager.h"
@@ -697,7 +698,7 @@ void drawWires(int net) {
           filledPaths[i][1] = last;
           filledPaths[i][2] = fillSequence[fillIndex];
 
-          // showLEDsCore2 = 1;
+          // queueShowLEDs(1);
         } else {
           for (int j = 0; j < 5; j++) {
 
@@ -1235,11 +1236,12 @@ void showRowAnimation(int index, int net) {
     // Serial.print("warningNet: ");
     // Serial.println(warningNet);
     rowAnimations[index].row = warningRow;
-    uint32_t color;
+    hsvColor netHSV = RgbToHsv(netColors[warningNet]);
 
+    // the frames are built as HSV and converted as one row
     for (int i = 0; i < rowAnimations[index].numberOfFrames; i++) {
 
-      hsvColor colorHSV = RgbToHsv(netColors[warningNet]);
+      hsvColor colorHSV = netHSV;
       colorHSV.h =
           ((colorHSV.h - (int)((highlightedRowOffsetHues[i] * 1.5))) / 8) % 255;
       // Serial.print("colorHSV.h: ") ;
@@ -1248,10 +1250,11 @@ void showRowAnimation(int index, int net) {
       // Serial.print("colorHSV.h = ");
       // Serial.println(colorHSV.h);
       // colorHSV.s = satValues[i];
-      color = HsvToRaw(colorHSV);
-
-      rowAnimations[index].frames[i] = color;
+      rowAnimations[index].frames[i] =
+          colorPackHsv(colorHSV.h, colorHSV.s, colorHSV.v);
     }
+    colorHsvToRgbRow(rowAnimations[index].frames, rowAnimations[index].frames,
+                     rowAnimations[index].numberOfFrames);
 
     for (int i = 0; i < 5; i++) {
       frameColors[i] =
@@ -1296,7 +1299,7 @@ void showRowAnimation(int index, int net) {
   } else if (brightenedNet > 0 && net == brightenedNet) {
 
     rowAnimations[index].row = brightenedNode - 1;
-    uint32_t color;
+    hsvColor netHSV = RgbToHsv(netColors[brightenedNet]);
 
     for (int i = 0; i < rowAnimations[index].numberOfFrames; i++) {
       hsvColor colorHSV;
@@ -1304,7 +1307,7 @@ void showRowAnimation(int index, int net) {
       // Serial.print("netColors[brightenedNet]: ");
       // Serial.println(packRgb( netColors[brightenedNet]), HEX);
       // if (rowAnimations[index].net > 3) {
-      colorHSV = RgbToHsv(netColors[brightenedNet]);
+      colorHSV = netHSV;
       colorHSV.h =
           (colorHSV.h + (int)(highlightedRowOffsetHues[i] / 1.8)) % 255;
       // } else {
@@ -1314,10 +1317,11 @@ void showRowAnimation(int index, int net) {
       // Serial.print("colorHSV.h = ");
       // Serial.println(colorHSV.h);
       // colorHSV.s = satValues[i];
-      color = HsvToRaw(colorHSV);
-
-      rowAnimations[index].frames[i] = color;
+      rowAnimations[index].frames[i] =
+          colorPackHsv(colorHSV.h, colorHSV.s, colorHSV.v);
     }
+    colorHsvToRgbRow(rowAnimations[index].frames, rowAnimations[index].frames,
+                     rowAnimations[index].numberOfFrames);
 
     for (int i = 0; i < 5; i++) {
       frameColors[i] =
@@ -1517,7 +1521,7 @@ void showRowAnimation(int index, int net) {
   // b.printRawRow(0b00001000, row, frameColors[3], 0xfffffe);
   // b.printRawRow(0b00010000, row, frameColors[4], 0xfffffe);
 
-  // showLEDsCore2 = 2;
+  // queueShowLEDs(2);
   showSkippedNodes();
 }
 
@@ -2173,7 +2177,7 @@ void printTextFromMenu(int print) {
         }
         // delay(100);
         // leds.show();
-        // showLEDsCore2 =2;
+        // queueShowLEDs(2);
       }
     }
   }
@@ -2221,7 +2225,7 @@ void showArray(uint8_t *array, int size) {
       leds.setPixelColor(array[screenMap[i]], array[i]);
     }
   }
-  showLEDsCore2 = -3;
+  queueShowLEDs(-3);
 }
 
 int getCursorPositionX() {
@@ -2984,7 +2988,7 @@ int attractMode(void) {
     // Serial.print("netSlot = ");
     // Serial.println(netSlot);
     slotChanged = 1;
-    showLEDsCore2 = -1;
+    queueShowLEDs(-1);
     encoderDirectionState = NONE;
     return 1;
     // goto menu;
@@ -2999,7 +3003,7 @@ int attractMode(void) {
     // Serial.print("netSlot = ");
     // Serial.println(netSlot);
     slotChanged = 1;
-    showLEDsCore2 = -1;
+    queueShowLEDs(-1);
     encoderDirectionState = NONE;
     return 1;
     // goto menu;
@@ -3425,7 +3429,7 @@ int brightnessSetHeader[45] = {-100, -99, -97, -95, -90, -85, -78, -72, -62,
 int brightnessSet = -100;
 
 void drawAnimatedImage(int imageIndex, int speed) {
-  showLEDsCore2 = -3;
+  queueShowLEDs(-3);
   leds.clear();
   leds.show();
   // delay(100);
@@ -3434,7 +3438,7 @@ void drawAnimatedImage(int imageIndex, int speed) {
     brightnessSet = -100;
     for (int i = startupFrameLEN - 1; i >= 0; i--) {
       drawImage(i);
-      // showLEDsCore2 = 3;
+      // queueShowLEDs(3);
       cycleCount++;
       leds.show();
       delayMicroseconds(speed + (cycleCount * 80));
@@ -3450,7 +3454,7 @@ void drawAnimatedImage(int imageIndex, int speed) {
   }
   // lightUpRail();
   /// leds.clear();
-  showLEDsCore2 = -1;
+  queueShowLEDs(-1);
 }
 
 void drawImage(int imageIndex) {
@@ -248,12 +248,15 @@ void showCommandHelp(char command) {
             Serial.println("  v0-v4   - show specific ADC (0-4)");
             Serial.println("  vi      - show current sensor readings");
             Serial.println("  vi1     - show current sensor 1");
+            Serial.println("  vs      - stream current sensor windows as CSV (vs0 / vs1 for one), any key stops");
             Serial.println("  vl      - toggle live readings display");
             //Serial.println("  vp      - read probe voltage");
             changeTerminalColor(HELP_DESC_COLOR, true);
             Serial.println("Features:");
             Serial.println("  - High resolution 12-bit ADC readings");
             Serial.println("  - Real-time monitoring capabilities");
+            Serial.println("  - Current sensors sampled in the background, min / max / mean / energy per window");
+            Serial.println("    ([hardware] ina_averaging, ina_bits, ina_window_ms)");
             Serial.println("  - Python access: jumperless.get_adc(0)");
             changeTerminalColor(HELP_NOTE_COLOR, true);
             // Serial.println("Perfect for precision circuit debugging and monitoring!");
@@ -483,8 +486,10 @@ void showCommandHelp(char command) {
             Serial.println("Calibrate the DAC outputs");
             changeTerminalColor(HELP_USAGE_COLOR, true);
             Serial.println("Usage: $");
+            Serial.println("       $p  - tap every pad to calibrate which row the probe reads");
             changeTerminalColor(HELP_DESC_COLOR, true);
             Serial.println("Runs a calibration routine to make sure DAC voltages are accurate.");
+            Serial.println("$p saves where each pad reads to probeRows.txt ([calibration] probe_table).");
             changeTerminalColor(HELP_NOTE_COLOR, true);
             Serial.println("Do this occasionally, especially if voltages seem off.");
             break;
@@ -588,6 +593,46 @@ void showCommandHelp(char command) {
             Serial.println("Mainly useful for debugging Arduino Serial passthrough");
             break;
 
+        case '*':
+            changeTerminalColor(HELP_DESC_COLOR, true);
+            Serial.println("Show routing stats");
+            changeTerminalColor(HELP_USAGE_COLOR, true);
+            Serial.println("Usage: *   *b   *r   *R   *u");
+            changeTerminalColor(HELP_DESC_COLOR, true);
+            Serial.println("Shows how many full and incremental reroutes have been done and how long they took.");
+            Serial.println("Single connect / disconnect commands are routed incrementally when the nets allow it.");
+            Serial.println("Also shows hits and misses for the compiled slot cache in /compiled/.");
+            Serial.println("Recently routed slots are kept in RAM ([routing] snapshot_cache_kb) and switch back instantly.");
+            Serial.println("And how many crosspoint words each update actually sent to the CH446Qs.");
+            Serial.println("The core 2 queue section shows how many LED / path requests were posted, merged or");
+            Serial.println("dropped, and how long core 1 spent waiting on them.");
+            Serial.println("The serial bridge section counts Arduino passthrough bytes each way, ring depths and overflows.");
+            Serial.println("The machine mode section counts :: commands and binary frames, the largest payload and the slowest one.");
+            Serial.println("The ADC engine section shows the set and measured sample rate per channel ([hardware] adc_sample_rate)");
+            Serial.println("and the newest raw reading on each of ADC 0-7.");
+            Serial.println("The waveforms section shows the DAC sample rate, samples sent and how many were held because");
+            Serial.println("something else was using the DAC / INA219 I2C bus, then each running DAC's wave.");
+            Serial.println("The logic analyzer section shows the last capture's sample rate and trigger, and whether the");
+            Serial.println("trigger search or the DMA fell behind.");
+            Serial.println("The INA monitor section shows the current sensor read rate, how many reads had a new");
+            Serial.println("conversion, were skipped for a busy bus or NACKed, and each sensor's latest reading.");
+            Serial.println("The probe scanner section counts probe looks and the touch / hold / release / button events");
+            Serial.println("they made, events dropped or gone stale, and how long a tap took to become an event and to");
+            Serial.println("reach whoever was reading the probe. Probe rows shows where each pad is expected to read.");
+            Serial.println("The board scan section shows how long the last Scan app sweep took, and how many nodes were");
+            Serial.println("read over a free route vs. falling back to routing the ADC the slow way.");
+            Serial.println("The overlays section lists temporary bridges (measurements, floating checks) that are closed on");
+            Serial.println("free lanes on top of the nets, and how many were bumped by a reroute or couldn't be routed.");
+            Serial.println("The LED frame section shows how many leds.show() calls were skipped because nothing changed,");
+            Serial.println("and how often each LED layer was drawn vs. repainted from its last draw, and how long it took.");
+            Serial.println("The LED output section shows the frames per second the strips actually latched, and how many");
+            Serial.println("frames had to wait for the one going out or were replaced by a newer one before they went.");
+            Serial.println("*b writes a made up 200 bridge node file, loads it through the parser and builds nets");
+            Serial.println("with and without the node index, prints the times, then reloads the current slot.");
+            Serial.println("*u runs the serial bridge against a RAM loopback at 115200, 460800 and 1M baud");
+            Serial.println("(nothing needs to be on the header) and prints throughput against line rate.");
+            break;
+
         // case '&':
         //     changeTerminalColor(HELP_DESC_COLOR, true);
         //     Serial.println("Load changed net colors from file");
@@ -752,13 +797,16 @@ void showCommandHelp(char command) {
 
         case 'w':
             changeTerminalColor(HELP_DESC_COLOR, true);
-            Serial.println("Wave generator function (don't use, it's a janky pile of garbage)");
+            Serial.println("Wave generator");
             changeTerminalColor(HELP_USAGE_COLOR, true);
             Serial.println("Usage: w");
             changeTerminalColor(HELP_DESC_COLOR, true);
-            Serial.println("Generates various waveforms on DAC outputs.");
+            Serial.println("Generates sine, square, triangle, sawtooth and noise waves on DAC 0 and DAC 1.");
+            Serial.println("Waves run from a timer in the background, x leaves the menu with them still running.");
+            Serial.println("Changing frequency, amplitude or offset takes effect mid-cycle without a glitch.");
             changeTerminalColor(HELP_NOTE_COLOR, true);
-            Serial.println("If wave generation fails, falls back to slot selection menu.");
+            Serial.println("Setting a DAC voltage any other way stops the wave on that DAC.");
+            Serial.println("Up to 5 kHz, sample rate is 20 kS/s with one DAC running, 10 kS/s each with both.");
             break;
 
         case 'y':
@@ -797,16 +845,20 @@ void showCommandHelp(char command) {
         //     Serial.println("More detailed than 'n' - shows technical implementation details.");
         //     break;
 
-        // case ':':
-        //     changeTerminalColor(HELP_DESC_COLOR, true);
-        //     Serial.println("Machine mode activation");
-        //     changeTerminalColor(HELP_USAGE_COLOR, true);
-        //     Serial.println("Usage: :: (type colon twice)");
-        //     changeTerminalColor(HELP_DESC_COLOR, true);
-        //     Serial.println("Enters machine mode for automated control.");
-        //     changeTerminalColor(HELP_NOTE_COLOR, true);
-        //     Serial.println("Advanced feature for programmatic control of Jumperless.");
-        //     break;
+        case ':':
+            changeTerminalColor(HELP_DESC_COLOR, true);
+            Serial.println("Machine mode command");
+            changeTerminalColor(HELP_USAGE_COLOR, true);
+            Serial.println("Usage: ::instruction[payload]   ::instruction:sequence[payload]");
+            changeTerminalColor(HELP_DESC_COLOR, true);
+            Serial.println("Runs one machine mode instruction and replies ::ok or ::error (with :sequence if given).");
+            Serial.println("Payloads can be any length and are read as they arrive, so the menu keeps running.");
+            Serial.println("Commands can be sent back to back without waiting for each ::ok.");
+            Serial.println("Hosts can also send CRC checked binary frames (0xA5 sync byte) for the same instructions,");
+            Serial.println("bulk measurements and delta polling of nets, paths and chip status.");
+            changeTerminalColor(HELP_NOTE_COLOR, true);
+            Serial.println("Advanced feature for programmatic control of Jumperless.");
+            break;
 
         default:
             changeTerminalColor(HELP_NOTE_COLOR, true);
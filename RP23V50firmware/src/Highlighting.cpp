@@ -1,4 +1,5 @@
 #include "Highlighting.h"
+#include "Commands.h"
 #include "JumperlessDefines.h"
 #include "LEDs.h"
 #include "MatrixState.h"
@@ -201,7 +202,7 @@ int encoderNetHighlight(int print, int mode, int divider) {
      // b.printRawRow(0b00000100, returnNode, 0x0f0f00, 0x000000);
 
       lastNodeHighlighted = returnNode;
-      // showLEDsCore2 = 2;
+      // queueShowLEDs(2);
       }
     //rotaryDivider = lastDivider;
     return returnNode;
@@ -801,7 +802,7 @@ int highlightNets(int probeReading, int encoderNetHighlighted, int print) {
       Serial.flush();
       }
       }
-    // showLEDsCore2 = 1;
+    // queueShowLEDs(1);
 
   // Serial.println("netHighlighted: ");
   // Serial.println(netHighlighted);
@@ -0,0 +1,478 @@
+// SPDX-License-Identifier: MIT
+#include "InaMonitor.h"
+
+#include <string.h>
+
+//! Accumulator section, down to the I2C section this only needs InaMonitor.h,
+//! so a fake register source on a PC can drive it and check the windows
+
+void inaWindowClear(struct inaWindow *window, uint32_t now) {
+  memset(window, 0, sizeof(*window));
+  window->startMicros = now;
+}
+
+void inaWindowAdd(struct inaWindow *window, float current, float voltage,
+                  float power, uint32_t dtMicros) {
+  if (window->samples == 0) {
+    window->minCurrent = window->maxCurrent = current;
+    window->minVoltage = window->maxVoltage = voltage;
+    window->minPower = window->maxPower = power;
+  } else {
+    if (current < window->minCurrent) window->minCurrent = current;
+    if (current > window->maxCurrent) window->maxCurrent = current;
+    if (voltage < window->minVoltage) window->minVoltage = voltage;
+    if (voltage > window->maxVoltage) window->maxVoltage = voltage;
+    if (power < window->minPower) window->minPower = power;
+    if (power > window->maxPower) window->maxPower = power;
+  }
+  window->sumCurrent += current;
+  window->sumVoltage += voltage;
+  window->sumPower += power;
+  window->energy += (double)power * dtMicros * 1e-6;
+  window->samples++;
+}
+
+void inaChannelReset(struct inaChannel *channel, float currentLSB,
+                     uint32_t windowMicros, uint32_t now) {
+  memset(channel, 0, sizeof(*channel));
+  channel->currentLSB = currentLSB;
+  channel->windowMicros = windowMicros;
+  inaWindowClear(&channel->windows[0], now);
+  inaWindowClear(&channel->windows[1], now);
+}
+
+int inaChannelAdd(struct inaChannel *channel, uint16_t busRegister,
+                  uint16_t currentRegister, uint16_t powerRegister,
+                  uint32_t now) {
+  if ((busRegister & INA_BUS_READY) == 0) {
+    return -1;
+  }
+  if (busRegister & INA_BUS_OVERFLOW) {
+    channel->overflows++; // current and power are garbage, the library says -100
+    return 0;
+  }
+  float current = (int16_t)currentRegister * channel->currentLSB;
+  float voltage = (busRegister >> 3) * 0.004f;
+  float power = powerRegister * 20.0f * channel->currentLSB;
+
+  struct inaWindow *window = &channel->windows[channel->filling];
+  uint32_t dt = 0;
+  if (channel->haveSample == 1) {
+    dt = now - channel->sampleMicros; // the reading holds since the last one
+  } else {
+    window->startMicros = now;
+  }
+
+  uint32_t seq = channel->sampleSeq + 1;
+  channel->sampleSeq = seq;
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  channel->current = current;
+  channel->voltage = voltage;
+  channel->power = power;
+  channel->sampleMicros = now;
+  channel->totalEnergy += (double)power * dt * 1e-6;
+  channel->haveSample = 1;
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  channel->sampleSeq = seq + 1;
+
+  inaWindowAdd(window, current, voltage, power, dt);
+  if (now - window->startMicros >= channel->windowMicros) {
+    // the next window starts where this one's energy stops
+    window->lengthMicros = now - window->startMicros;
+    seq = channel->windowSeq + 1;
+    channel->windowSeq = seq;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    channel->filling ^= 1;
+    inaWindowClear(&channel->windows[channel->filling], now);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    channel->windowSeq = seq + 1;
+  }
+  return 1;
+}
+
+uint32_t inaChannelWindow(const struct inaChannel *channel,
+                          struct inaWindow *out) {
+  while (true) {
+    uint32_t seq = channel->windowSeq;
+    if (seq & 1) {
+      continue;
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    *out = channel->windows[channel->filling ^ 1];
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (channel->windowSeq == seq) {
+      return seq >> 1;
+    }
+  }
+}
+
+void inaChannelLatest(const struct inaChannel *channel, float *current,
+                      float *voltage, float *power) {
+  while (true) {
+    uint32_t seq = channel->sampleSeq;
+    if (seq & 1) {
+      continue;
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    float i = channel->current;
+    float v = channel->voltage;
+    float p = channel->power;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (channel->sampleSeq == seq) {
+      if (current != nullptr) *current = i;
+      if (voltage != nullptr) *voltage = v;
+      if (power != nullptr) *power = p;
+      return;
+    }
+  }
+}
+
+float inaWindowMean(const struct inaWindow *window, int which) {
+  if (window->samples == 0) {
+    return 0;
+  }
+  double sum = which == 0   ? window->sumCurrent
+               : which == 1 ? window->sumVoltage
+                            : window->sumPower;
+  return (float)(sum / window->samples);
+}
+
+uint8_t inaAdcCode(int bits, int averaging) {
+  if (averaging > 1) {
+    uint8_t shift = 0;
+    while (shift < 7 && (2 << shift) <= averaging) {
+      shift++;
+    }
+    return 0x08 | shift; // rounds down to a power of 2
+  }
+  if (bits < 9) {
+    bits = 9;
+  } else if (bits > 12) {
+    bits = 12;
+  }
+  return (uint8_t)(bits - 9);
+}
+
+uint32_t inaConversionMicros(uint8_t adcCode) {
+  static const uint16_t single[4] = {84, 148, 276, 532};
+  if (adcCode & 0x08) {
+    return 532u << (adcCode & 0x07);
+  }
+  return single[adcCode & 0x03];
+}
+
+//! I2C section: a repeating timer alternates between the two INA219s, queueing
+//! a bus / current / power read into the I2C FIFO and collecting the bytes on
+//! the next tick, so nothing waits on the bus. It shares i2c0 with the
+//! waveform timer and dacBus the same way the waveform timer does.
+
+#ifdef ARDUINO
+#include "Peripherals.h"
+#include "Waveforms.h"
+
+#include <Arduino.h>
+
+#include "hardware/i2c.h"
+#include "hardware/sync.h"
+#include "pico/time.h"
+
+#define INA_ADDRESS 0x40 // + sensor
+#define INA_READ_BYTES 6
+
+volatile int inaMonitorRunning = 0;
+struct inaChannel inaChannels[INA_SENSORS];
+struct inaMonitorStats inaStats = {};
+
+static struct repeating_timer inaTimer;
+static volatile int inaPending = -1; // sensor with a read on the bus
+static uint32_t inaPendingMicros = 0;
+static int inaNextSensor = 0;
+
+/// @brief Take the last read's bytes if they're in, the caller has interrupts
+/// off or is the timer. Returns 1 if it's still on the bus.
+static int collectInaRead(i2c_hw_t *hw) {
+  int sensor = inaPending;
+  if (sensor < 0) {
+    return 0;
+  }
+  if (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) {
+    // NACKed, the rest of the commands were flushed
+    while (hw->rxflr != 0) {
+      (void)hw->data_cmd;
+    }
+    (void)hw->clr_tx_abrt;
+    inaStats.nacks++;
+    inaPending = -1;
+    return 0;
+  }
+  if (hw->rxflr < INA_READ_BYTES) {
+    return 1;
+  }
+  uint8_t bytes[INA_READ_BYTES];
+  for (int i = 0; i < INA_READ_BYTES; i++) {
+    bytes[i] = (uint8_t)hw->data_cmd;
+  }
+  inaPending = -1;
+  inaStats.reads++;
+  if (inaChannelAdd(&inaChannels[sensor], (bytes[0] << 8) | bytes[1],
+                    (bytes[2] << 8) | bytes[3], (bytes[4] << 8) | bytes[5],
+                    inaPendingMicros) == 1) {
+    inaStats.conversions++;
+  }
+  return 0;
+}
+
+int drainInaReads(void) {
+  if (inaPending < 0) {
+    return 0;
+  }
+  uint32_t save = save_and_disable_interrupts();
+  int busy = collectInaRead(i2c_get_hw(i2c0));
+  restore_interrupts(save);
+  return busy;
+}
+
+static void queueInaRegister(i2c_hw_t *hw, uint8_t reg) {
+  hw->data_cmd = reg;
+  hw->data_cmd = I2C_IC_DATA_CMD_CMD_BITS | I2C_IC_DATA_CMD_RESTART_BITS;
+  hw->data_cmd = I2C_IC_DATA_CMD_CMD_BITS | I2C_IC_DATA_CMD_STOP_BITS;
+}
+
+static bool inaTick(struct repeating_timer *timer) {
+  (void)timer;
+  i2c_hw_t *hw = i2c_get_hw(i2c0);
+  if (collectInaRead(hw) == 1) {
+    inaStats.lateReads++;
+    return true;
+  }
+  if (waveBusFree() == 0) {
+    inaStats.busySkips++;
+    return true;
+  }
+  if (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) {
+    (void)hw->clr_tx_abrt; // a NACKed DAC sample, not ours
+  }
+  int sensor = inaNextSensor;
+  inaNextSensor = (sensor + 1) % INA_SENSORS;
+  if ((hw->tar & I2C_IC_TAR_IC_TAR_BITS) != (uint32_t)(INA_ADDRESS + sensor)) {
+    hw->enable = 0;
+    hw->tar = INA_ADDRESS + sensor;
+    hw->enable = 1;
+  }
+  // power last, reading it clears the ready flag for the next conversion
+  queueInaRegister(hw, INA_REG_BUS);
+  queueInaRegister(hw, INA_REG_CURRENT);
+  queueInaRegister(hw, INA_REG_POWER);
+  inaPendingMicros = time_us_32();
+  inaPending = sensor;
+  return true;
+}
+
+void stopInaMonitor(void) {
+  if (inaMonitorRunning == 0) {
+    return;
+  }
+  cancel_repeating_timer(&inaTimer);
+  inaMonitorRunning = 0;
+  unsigned long start = micros();
+  while (drainInaReads() == 1) {
+    if (micros() - start > 1000) {
+      inaPending = -1; // the next Wire call resets the block anyway
+      break;
+    }
+  }
+}
+
+void startInaMonitor(int bits, int averaging, int windowMs) {
+  stopInaMonitor();
+  if (averaging <= 0) {
+    return;
+  }
+  uint8_t code = inaAdcCode(bits, averaging);
+  INA0.setBusADC(code);
+  INA0.setShuntADC(code);
+  INA1.setBusADC(code);
+  INA1.setShuntADC(code);
+
+  if (windowMs < INA_WINDOW_MIN_MS) {
+    windowMs = INA_WINDOW_MIN_MS;
+  }
+  uint32_t now = time_us_32();
+  inaChannelReset(&inaChannels[0], INA0.getCurrentLSB(), windowMs * 1000, now);
+  inaChannelReset(&inaChannels[1], INA1.getCurrentLSB(), windowMs * 1000, now);
+
+  // each sensor gets looked at about twice per conversion
+  inaStats = {};
+  inaStats.conversionMicros = inaConversionMicros(code) * 2;
+  inaStats.tickMicros = inaStats.conversionMicros / (2 * INA_SENSORS);
+  if (inaStats.tickMicros < INA_MIN_TICK_US) {
+    inaStats.tickMicros = INA_MIN_TICK_US;
+  }
+  inaPending = -1;
+  inaNextSensor = 0;
+  inaMonitorRunning = 1;
+  add_repeating_timer_us(-(int64_t)inaStats.tickMicros, inaTick, nullptr,
+                         &inaTimer);
+}
+
+static INA219 *inaSensor(int sensor) { return sensor == 1 ? &INA1 : &INA0; }
+
+static int inaCached(int sensor) {
+  return inaMonitorRunning == 1 && sensor >= 0 && sensor < INA_SENSORS &&
+         inaChannels[sensor].haveSample == 1;
+}
+
+float inaCurrent(int sensor) {
+  if (inaCached(sensor) == 0) {
+    return inaSensor(sensor)->getCurrent();
+  }
+  float current;
+  inaChannelLatest(&inaChannels[sensor], &current, nullptr, nullptr);
+  return current;
+}
+
+float inaBusVoltage(int sensor) {
+  if (inaCached(sensor) == 0) {
+    return inaSensor(sensor)->getBusVoltage();
+  }
+  float voltage;
+  inaChannelLatest(&inaChannels[sensor], nullptr, &voltage, nullptr);
+  return voltage;
+}
+
+float inaPower(int sensor) {
+  if (inaCached(sensor) == 0) {
+    return inaSensor(sensor)->getPower();
+  }
+  float power;
+  inaChannelLatest(&inaChannels[sensor], nullptr, nullptr, &power);
+  return power;
+}
+
+int inaGetWindow(int sensor, struct inaWindow *out, int wait) {
+  if (inaMonitorRunning == 0 || sensor < 0 || sensor >= INA_SENSORS) {
+    return 0;
+  }
+  struct inaChannel *channel = &inaChannels[sensor];
+  uint32_t seq = inaChannelWindow(channel, out);
+  if (wait == 1) {
+    unsigned long start = millis();
+    unsigned long timeout = channel->windowMicros / 500 + 100; // 2 windows
+    uint32_t last = seq;
+    while ((seq = inaChannelWindow(channel, out)) == last) {
+      if (millis() - start > timeout || inaMonitorRunning == 0) {
+        return 0;
+      }
+      delayMicroseconds(100);
+    }
+  }
+  return seq != 0;
+}
+
+double inaEnergy(int sensor, int reset) {
+  if (inaMonitorRunning == 0 || sensor < 0 || sensor >= INA_SENSORS) {
+    return 0;
+  }
+  // a double isn't one store, keep the timer out while it's read
+  uint32_t save = save_and_disable_interrupts();
+  double energy = inaChannels[sensor].totalEnergy;
+  if (reset == 1) {
+    inaChannels[sensor].totalEnergy = 0;
+  }
+  restore_interrupts(save);
+  return energy;
+}
+
+static void printInaWindowLine(int sensor, const struct inaWindow *window) {
+  Serial.print(window->startMicros / 1000);
+  Serial.print(",");
+  Serial.print(sensor);
+  Serial.print(",");
+  Serial.print(window->samples);
+  Serial.print(",");
+  Serial.print(inaWindowMean(window, 0) * 1000, 3);
+  Serial.print(",");
+  Serial.print(window->minCurrent * 1000, 3);
+  Serial.print(",");
+  Serial.print(window->maxCurrent * 1000, 3);
+  Serial.print(",");
+  Serial.print(inaWindowMean(window, 1), 3);
+  Serial.print(",");
+  Serial.print(window->minVoltage, 3);
+  Serial.print(",");
+  Serial.print(window->maxVoltage, 3);
+  Serial.print(",");
+  Serial.print(inaWindowMean(window, 2) * 1000, 3);
+  Serial.print(",");
+  Serial.print(window->minPower * 1000, 3);
+  Serial.print(",");
+  Serial.print(window->maxPower * 1000, 3);
+  Serial.print(",");
+  Serial.println(window->energy * 1000, 4);
+}
+
+void streamInaWindows(int sensorMask) {
+  if (inaMonitorRunning == 0) {
+    Serial.println("INA monitor is off, set [hardware] ina_averaging to 1 or more");
+    return;
+  }
+  Serial.println("ms,sensor,samples,mA,min_mA,max_mA,V,min_V,max_V,mW,min_mW,"
+                 "max_mW,mJ");
+  uint32_t seen[INA_SENSORS];
+  struct inaWindow window;
+  for (int i = 0; i < INA_SENSORS; i++) {
+    seen[i] = inaChannelWindow(&inaChannels[i], &window);
+  }
+  while (Serial.available() == 0) {
+    for (int i = 0; i < INA_SENSORS; i++) {
+      if ((sensorMask & (1 << i)) == 0) {
+        continue;
+      }
+      uint32_t seq = inaChannelWindow(&inaChannels[i], &window);
+      if (seq != seen[i]) {
+        seen[i] = seq;
+        printInaWindowLine(i, &window);
+      }
+    }
+    delayMicroseconds(200);
+  }
+  Serial.read();
+}
+
+void printInaMonitorStats(void) {
+  Serial.print("\n\rINA monitor:\t");
+  if (inaMonitorRunning == 0) {
+    Serial.println("off");
+    return;
+  }
+  Serial.print(inaStats.conversionMicros);
+  Serial.print(" us/reading, tick ");
+  Serial.print(inaStats.tickMicros);
+  Serial.print(" us\treads ");
+  Serial.print(inaStats.reads);
+  Serial.print(" (");
+  Serial.print(inaStats.conversions);
+  Serial.print(" new)\tbus busy ");
+  Serial.print(inaStats.busySkips);
+  Serial.print("\tlate ");
+  Serial.print(inaStats.lateReads);
+  Serial.print("\tnacks ");
+  Serial.println(inaStats.nacks);
+  for (int i = 0; i < INA_SENSORS; i++) {
+    float current, voltage, power;
+    inaChannelLatest(&inaChannels[i], &current, &voltage, &power);
+    Serial.print("  ina ");
+    Serial.print(i);
+    Serial.print(":\t");
+    Serial.print(current * 1000);
+    Serial.print(" mA\t");
+    Serial.print(voltage);
+    Serial.print(" V\t");
+    Serial.print(power * 1000);
+    Serial.print(" mW\t");
+    Serial.print(inaEnergy(i, 0) * 1000);
+    Serial.print(" mJ\toverflows ");
+    Serial.println(inaChannels[i].overflows);
+  }
+}
+#endif
@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: MIT
+#ifndef INAMONITOR_H
+#define INAMONITOR_H
+
+#include <stdint.h>
+
+#define INA_SENSORS 2          // INA0 (0x40) and INA1 (0x41)
+#define INA_MIN_TICK_US 250    // one sensor is read per tick, alternating
+#define INA_WINDOW_MIN_MS 10
+
+#define INA_REG_BUS 0x02       // bits 15-3 are 4mV a count, 1 ready, 0 overflow
+#define INA_REG_POWER 0x03     // 20 current LSBs a count, reading it clears ready
+#define INA_REG_CURRENT 0x04   // signed, current LSBs from the calibration
+#define INA_BUS_READY 0x0002
+#define INA_BUS_OVERFLOW 0x0001
+
+/// @brief min / max / mean and energy over one window of readings
+struct inaWindow {
+  uint32_t samples;
+  float minCurrent; // A
+  float maxCurrent;
+  double sumCurrent;
+  float minVoltage; // V, bus
+  float maxVoltage;
+  double sumVoltage;
+  float minPower; // W
+  float maxPower;
+  double sumPower;
+  double energy;        // J over the window
+  uint32_t startMicros;
+  uint32_t lengthMicros;
+};
+
+/// @brief One INA219's cached readings. The sampler fills one window while
+/// the other (the last finished one) is read, swapping when the window length
+/// is up. Both the latest reading and the swap go under sequence counts, so
+/// readers never need the bus or a lock.
+struct inaChannel {
+  float currentLSB; // A a count, whatever the library calibrated
+  uint32_t windowMicros;
+
+  volatile uint32_t sampleSeq; // odd while latest is being written
+  float current;
+  float voltage;
+  float power;
+  uint32_t sampleMicros;
+  int haveSample;
+
+  struct inaWindow windows[2];
+  volatile int filling;
+  volatile uint32_t windowSeq; // finished windows, odd mid-swap
+  double totalEnergy;          // J since the last reset
+  unsigned long overflows;
+};
+
+//! Portable: only needs this header, raw register values in, so it can be fed
+//! from a fake register source on a PC
+void inaChannelReset(struct inaChannel *channel, float currentLSB,
+                     uint32_t windowMicros, uint32_t now);
+void inaWindowClear(struct inaWindow *window, uint32_t now);
+void inaWindowAdd(struct inaWindow *window, float current, float voltage,
+                  float power, uint32_t dtMicros);
+/// @brief Convert one bus / current / power register read and accumulate it.
+/// Returns 1 if it was added, 0 if the math overflow flag was set and it was
+/// dropped, -1 if the ready flag says it's the same conversion as last time.
+int inaChannelAdd(struct inaChannel *channel, uint16_t busRegister,
+                  uint16_t currentRegister, uint16_t powerRegister,
+                  uint32_t now);
+/// @brief Copy the last finished window, returns its sequence number (0 =
+/// none finished yet)
+uint32_t inaChannelWindow(const struct inaChannel *channel,
+                          struct inaWindow *out);
+void inaChannelLatest(const struct inaChannel *channel, float *current,
+                      float *voltage, float *power);
+float inaWindowMean(const struct inaWindow *window, int which); // 0 I, 1 V, 2 P
+/// @brief INA219 BADC / SADC code for a resolution (9-12 bits) or averaging
+/// (2-128 samples of 12 bits), and how long one conversion takes. In
+/// continuous mode the chip does a shunt and a bus conversion per reading.
+uint8_t inaAdcCode(int bits, int averaging);
+uint32_t inaConversionMicros(uint8_t adcCode);
+
+struct inaMonitorStats {
+  unsigned long reads;
+  unsigned long conversions; // reads that had a new reading in them
+  unsigned long busySkips;   // Wire or a DAC write had the bus
+  unsigned long nacks;
+  unsigned long lateReads;   // reply wasn't back by the next tick
+  uint32_t tickMicros;
+  uint32_t conversionMicros; // shunt + bus
+};
+
+extern volatile int inaMonitorRunning;
+extern struct inaChannel inaChannels[INA_SENSORS];
+extern struct inaMonitorStats inaStats;
+
+/// @brief Sample both INA219s from a timer. averaging 0 stops it and the
+/// readings go back to being read over I2C on every call.
+void startInaMonitor(int bits, int averaging, int windowMs);
+void stopInaMonitor(void);
+/// @brief Collect a finished read out of the I2C RX FIFO, for whoever wants
+/// the bus next (Wire, the waveform timer). Returns 1 while a read is still
+/// on the bus.
+int drainInaReads(void);
+
+float inaCurrent(int sensor);  // A
+float inaBusVoltage(int sensor);
+float inaPower(int sensor);    // W
+/// @brief Last finished window, wait = 1 blocks until a new one finishes.
+/// Returns 0 if there isn't one (or the monitor is off).
+int inaGetWindow(int sensor, struct inaWindow *out, int wait);
+double inaEnergy(int sensor, int reset); // J
+/// @brief Print a CSV line per finished window until a key is pressed
+void streamInaWindows(int sensorMask);
+void printInaMonitorStats(void);
+
+#endif
@@ -13,6 +13,9 @@
 #include "Oled.h"
 #include "RotaryEncoder.h"
 #include "Peripherals.h"
+#include "AdcEngine.h"
+#include "Waveforms.h"
+#include "InaMonitor.h"
 #include "FileParsing.h"
 
 #include "JumperlessDefines.h"
@@ -71,41 +74,107 @@ float jl_adc_get(int channel) {
     return readAdcVoltage(channel, 32);
 }
 
-// INA Functions
+// Same scaling as readAdcVoltage(), both ways
+float jl_adc_raw_to_voltage(int channel, int raw) {
+    float voltage = raw * (adcSpread[channel] / 4095);
+    if (channel != 4) {
+        voltage -= adcZero[channel];
+    }
+    return voltage;
+}
+
+float jl_adc_capture(int channel, void *buffer, int element_size, int count,
+                     float rate, int use_trigger, float trigger, int edge,
+                     int timeout_ms) {
+    int level = -1;
+    if (use_trigger) {
+        if (channel != 4) {
+            trigger += adcZero[channel];
+        }
+        level = (int)(trigger * 4095 / adcSpread[channel] + 0.5f);
+        level = level < 0 ? 0 : (level > 4095 ? 4095 : level);
+    }
+    return adcCaptureRun(channel, buffer, element_size, count, rate, level,
+                         edge, timeout_ms);
+}
+
+// Waveform Functions
+int jl_wave_start(int dac, const char *shape, float frequency, float amplitude,
+                  float offset) {
+    int shapeNumber = waveShapeFromName(shape);
+    if (shapeNumber < 0) {
+        return -1;
+    }
+    return startWaveform(dac, shapeNumber, frequency, amplitude, offset);
+}
+
+void jl_wave_stop(int dac) {
+    stopWaveform(dac);
+}
+
+int jl_wave_table(int dac, const float *values, int length) {
+    return setWaveTable(dac, values, length);
+}
+
+const char *jl_wave_get(int dac, float *frequency, float *amplitude, float *offset) {
+    *frequency = waveFrequency(dac);
+    *amplitude = waveAmplitude(dac);
+    *offset = waveOffset(dac);
+    return waveShapeName(waveShapeOf(dac));
+}
+
+// INA Functions, cached by the INA monitor when it's running
 float jl_ina_get_current(int sensor) {
-    if (sensor == 0) {
-        return INA0.getCurrent();
-    } else if (sensor == 1) {
-        return INA1.getCurrent();
+    if (sensor != 0 && sensor != 1) {
+        return 0.0f;
     }
-    return 0.0f;
+    return inaCurrent(sensor);
 }
 
 float jl_ina_get_voltage(int sensor) {
-    if (sensor == 0) {
-        return INA0.getBusVoltage();
-    } else if (sensor == 1) {
-        return INA1.getBusVoltage();
+    if (sensor != 0 && sensor != 1) {
+        return 0.0f;
     }
-    return 0.0f;
+    return inaBusVoltage(sensor);
 }
 
 float jl_ina_get_bus_voltage(int sensor) {
-    if (sensor == 0) {
-        return INA0.getBusVoltage();
-    } else if (sensor == 1) {
-        return INA1.getBusVoltage();
+    if (sensor != 0 && sensor != 1) {
+        return 0.0f;
     }
-    return 0.0f;
+    return inaBusVoltage(sensor);
 }
 
 float jl_ina_get_power(int sensor) {
-    if (sensor == 0) {
-        return INA0.getPower();
-    } else if (sensor == 1) {
-        return INA1.getPower();
+    if (sensor != 0 && sensor != 1) {
+        return 0.0f;
     }
-    return 0.0f;
+    return inaPower(sensor);
+}
+
+/// @brief Wait for the next window, out = mean / min / max current (A),
+/// voltage (V), power (W), then energy (J) and samples
+int jl_ina_window(int sensor, float *out) {
+    struct inaWindow window;
+    if (inaGetWindow(sensor, &window, 1) == 0) {
+        return 0;
+    }
+    out[0] = inaWindowMean(&window, 0);
+    out[1] = window.minCurrent;
+    out[2] = window.maxCurrent;
+    out[3] = inaWindowMean(&window, 1);
+    out[4] = window.minVoltage;
+    out[5] = window.maxVoltage;
+    out[6] = inaWindowMean(&window, 2);
+    out[7] = window.minPower;
+    out[8] = window.maxPower;
+    out[9] = (float)window.energy;
+    out[10] = (float)window.samples;
+    return 1;
+}
+
+float jl_ina_energy(int sensor, int reset) {
+    return (float)inaEnergy(sensor, reset);
 }
 
 // GPIO Functions
@@ -206,6 +275,9 @@ void jl_gpio_set_pull(int pin, int pull) {
 
 // Node Functions
 int jl_nodes_connect(int node1, int node2, int save) {
+    if (bridgeBatchOpen == true) {
+        return batchBridge(node1, node2, 0) >= 0;
+    }
     if (save) {
         addBridgeToNodeFile(node1, node2, netSlot, 0);
         refreshConnections();
@@ -217,6 +289,9 @@ int jl_nodes_connect(int node1, int node2, int save) {
 }
 
 int jl_nodes_disconnect(int node1, int node2) {
+    if (bridgeBatchOpen == true) {
+        return batchBridge(node1, node2, 1) >= 0;
+    }
     removeBridgeFromNodeFile(node1, node2, netSlot, 0);
     refreshConnections(-1);
     return 1;
@@ -230,6 +305,33 @@ int jl_nodes_clear(void) {
     return 1;
 }
 
+// Batches: connect() / disconnect() between these just collect bridges
+void jl_nodes_begin_batch(void) {
+    beginBridgeBatch();
+}
+
+int jl_nodes_commit_batch(int save) {
+    return commitBridgeBatch(save);
+}
+
+int jl_nodes_batch_count(void) {
+    return bridgeBatchCount;
+}
+
+int jl_nodes_batch_result(int index, int *node1, int *node2, int *remove) {
+    if (index < 0 || index >= bridgeBatchCount) {
+        return BATCH_INVALID;
+    }
+    *node1 = bridgeBatch[index].node1;
+    *node2 = bridgeBatch[index].node2;
+    *remove = bridgeBatch[index].remove;
+    return bridgeBatch[index].result;
+}
+
+void jl_nodes_cancel_batch(void) {
+    cancelBridgeBatch();
+}
+
 int jl_nodes_is_connected(int node1, int node2) {
 
     int connected = checkIfBridgeExists(node1, node2, netSlot, 0 );
@@ -344,6 +446,7 @@ int jl_probe_read_blocking(void) {
 }
 
 int jl_probe_read_nonblocking(void) {
+    // takes the next queued tap (or a repeat while it's held), doesn't wait
     return justReadProbe(true, 1);
 }
 
@@ -14,6 +14,9 @@
 #include "config.h"
 // #include <FastLED.h>
 #include "Highlighting.h"
+#include "LedFrame.h"
+#include "LedOutput.h"
+#include "ColorMath.h"
 // CRGB probeLEDs[1];
 
 // bool splitLEDs;
@@ -101,6 +104,7 @@ Adafruit_NeoPixel probeLEDs(1, PROBE_LED_PIN, NEO_GRB + NEO_KHZ800);
 // Adafruit_NeoPixel probeLEDs(1, 9, NEO_GRB + NEO_KHZ800);
 
 void ledClass::end(void) {
+  waitLedOutput();
   bbleds.~Adafruit_NeoPixel();
   topleds.~Adafruit_NeoPixel();
 
@@ -122,38 +126,95 @@ void ledClass::begin(void) {
   bbleds.begin();
   bbleds.setBrightness(254);
   topleds.setBrightness(254);
+  if (splitLEDs == 1) {
+    beginLedOutput(LED_PIN, LED_COUNT, LED_PIN_TOP, LED_COUNT_TOP);
+    } else {
+    beginLedOutput(LED_PIN, LED_COUNT + LED_COUNT_TOP, -1, 0);
+    }
+  setLedOutputBrightness(254);
+  ledFrame.stale = 1;
   }
 
+// a strip with nothing changed isn't sent at all. With PIO / DMA output
+// this returns straight away, otherwise the strips only get the pixels
+// that changed and it waits for Adafruit_NeoPixel::show()
 void ledClass::show(void) {
+  int bottomCount = splitLEDs == 1 ? LED_COUNT : LED_FRAME_PIXELS;
+  int bottomChanged = ledFrameChanged(&ledFrame, 0, bottomCount);
+  int topChanged = 0;
   if (splitLEDs == 1) {
+    topChanged = ledFrameChanged(&ledFrame, LED_COUNT, LED_COUNT_TOP);
+    }
+
+  ledFrame.shows++;
+  if (bottomChanged == 0 && topChanged == 0) {
+    ledFrame.skippedShows++;
+    return;
+    }
+  ledFrame.changedPixels = bottomChanged + topChanged;
+
+  if (ledOutputStats.dma == 1) {
+    sendLedOutput(ledFrame.pixels, bottomChanged > 0, topChanged > 0);
+    ledFrameMarkShown(&ledFrame, 0, LED_FRAME_PIXELS);
+    ledFrame.stale = 0;
+    return;
+    }
+
+  for (int i = 0; i < LED_FRAME_PIXELS; i++) {
+    if (ledFrame.pixels[i] == ledFrame.shown[i] && ledFrame.stale == 0) {
+      continue;
+      }
+    if (i >= LED_COUNT && splitLEDs == 1) {
+      topleds.setPixelColor(i - LED_COUNT, ledFrame.pixels[i]);
+      } else {
+      bbleds.setPixelColor(i, ledFrame.pixels[i]);
+      }
+    }
+  ledFrameMarkShown(&ledFrame, 0, LED_FRAME_PIXELS);
+  ledFrame.stale = 0;
+
+  if (topChanged > 0) {
     topleds.show();
     }
-  bbleds.show();
+  if (bottomChanged > 0) {
+    bbleds.show();
+    }
   }
 
-void ledClass::setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
-  if (n >= LED_COUNT && splitLEDs == 1) {
-    topleds.setPixelColor(n - LED_COUNT, r, g, b);
-    } else {
-    bbleds.setPixelColor(n, r, g, b);
+// core 0 can draw while core 1 is rendering a layer, that shouldn't end up
+// in the layer
+static void paintLed(uint16_t n, uint32_t c) {
+  if (ledFrame.capturing >= 0 && get_core_num() == 0) {
+    if (n < LED_FRAME_PIXELS) {
+      ledFrame.pixels[n] = c;
+      }
+    return;
     }
+  ledFramePaint(&ledFrame, n, c);
   }
 
-void ledClass::setPixelColor(uint16_t n, uint32_t c) {
-  if (n >= LED_COUNT && splitLEDs == 1) {
-
-    topleds.setPixelColor(n - LED_COUNT, c);
+void ledClass::setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
+  paintLed(n, ((uint32_t)r << 16) | ((uint32_t)g << 8) | b);
+  }
 
-    } else {
-    bbleds.setPixelColor(n, c);
-    }
+void ledClass::setPixelColor(uint16_t n, uint32_t c) {
+  paintLed(n, c & 0xffffff);
   }
 
+// same as Adafruit_NeoPixel::fill() on both strips, with first and count
+// counted from the start of each strip
 void ledClass::fill(uint32_t c, uint16_t first, uint16_t count) {
+  int bottomCount = splitLEDs == 1 ? LED_COUNT : LED_FRAME_PIXELS;
+  int end = count == 0 ? bottomCount : first + count;
+  for (int i = first; i < end && i < bottomCount; i++) {
+    paintLed(i, c & 0xffffff);
+    }
   if (splitLEDs == 1) {
-    topleds.fill(c, first, count);
+    end = count == 0 ? LED_COUNT_TOP : first + count;
+    for (int i = first; i < end && i < LED_COUNT_TOP; i++) {
+      paintLed(LED_COUNT + i, c & 0xffffff);
+      }
     }
-  bbleds.fill(c, first, count);
   }
 
 void ledClass::setBrightness(uint8_t b) {
@@ -161,21 +222,21 @@ void ledClass::setBrightness(uint8_t b) {
     topleds.setBrightness(b);
     }
   bbleds.setBrightness(b);
+  setLedOutputBrightness(b);
+  ledFrame.stale = 1; // the strips scaled what they had, send it all again
   }
 
 void ledClass::clear(void) {
-  if (splitLEDs == 1) {
-    topleds.clear();
+  for (int i = 0; i < LED_FRAME_PIXELS; i++) {
+    paintLed(i, 0);
     }
-  bbleds.clear();
   }
 
 uint32_t ledClass::getPixelColor(uint16_t n) {
-  if (n >= LED_COUNT && splitLEDs == 1) {
-    return topleds.getPixelColor(n - LED_COUNT);
-    } else {
-    return bbleds.getPixelColor(n);
+  if (n >= LED_FRAME_PIXELS) {
+    return 0;
     }
+  return ledFrame.pixels[n];
   }
 
 uint16_t ledClass::numPixels(void) {
@@ -908,7 +969,7 @@ uint32_t colorPicker(uint8_t startHue, uint8_t brightness) {
     // createSlots(netSlot, 1);
   //!dont show nets
     hideNets = 1;
-    showLEDsCore2 = -2;
+    queueShowLEDs(-2);
     resetEncoderPosition = 1;
 
     // Store original range for restoring when zooming out
@@ -1193,7 +1254,7 @@ uint32_t colorPicker(uint8_t startHue, uint8_t brightness) {
           //   }
 
           redraw = true;
-          // showLEDsCore2 = 2;
+          // queueShowLEDs(2);
           // waitCore2();
           probeButtonWasPressed = probeButtonIsPressed;
           buttonWasPressed = buttonIsPressed;
@@ -1253,7 +1314,7 @@ uint32_t colorPicker(uint8_t startHue, uint8_t brightness) {
 
                       if (millis() - buttonPressStartTime > holdConfirmTime) {
                         hideNets = 0;
-                        showLEDsCore2 = -1;
+                        queueShowLEDs(-1);
                         clearColorOverrides(true, true, true);
                         blockProbeButton = 5000;
                         blockProbeButtonTimer = millis();
@@ -1522,7 +1583,7 @@ uint32_t colorPicker(uint8_t startHue, uint8_t brightness) {
 
       } while (Serial.available() == 0);
 
-    showLEDsCore2 = -1;
+    queueShowLEDs(-1);
     hideNets = 0;
     clearColorOverrides();
 
@@ -1855,7 +1916,7 @@ void showSavedColors(int slot) {
   // clearLEDs();
   clearLEDsExceptRails();
   getNodesToConnect();
-  bridgesToPaths();
+  bridgesToPathsCached(slot);
   // leds.clear();
   clearLEDsExceptRails();
   checkChangedNetColors(-1);
@@ -1865,7 +1926,7 @@ void showSavedColors(int slot) {
 
 
 
-  showLEDsCore2 = -1;
+  queueShowLEDs(-1);
   // leds.show();
   }
 
@@ -2063,7 +2124,7 @@ void assignNetColors(int preview) {
 */
 // leds.setPixelColor(110, rawOtherColors[2]);
 // logoFlash = 2;
-// showLEDsCore2 = 1;
+// queueShowLEDs(1);
 //  if (debugLEDs) {
 // Serial.print("\n\rcolorDistance: ");
 // Serial.print(colorDistance);
@@ -2739,7 +2800,7 @@ void lightUpNet(int netNumber, int node, int onOff, int brightness2,
        brightness2: "); Serial.println(brightness2);*/
     }
   // showRowAnimation(-1, GND);
-  //  showLEDsCore2 = 1;
+  //  queueShowLEDs(1);
   showSkippedNodes();
   }
 unsigned long lastSkippedNodesTime = 0;
@@ -2950,31 +3011,8 @@ void showSkippedNodes(uint32_t onColor, uint32_t offColor) {
   }
 
 uint32_t scaleBrightness(uint32_t hexColor, int scaleFactor) {
-
-  if (scaleFactor == 0) {
-    return hexColor;
-    }
-  float scaleFactorF = scaleFactor / 100.0;
-
-  // if (scaleFactor > 0) {
-  scaleFactorF += 1.0;
-  //}
-  // Serial.print("scaleFactorF: ");
-  // Serial.println(scaleFactorF);
-  // Serial.print("hexColor: ");
-  // Serial.println(hexColor, HEX);
-
-  hsvColor colorToShiftHsv = RgbToHsv(unpackRgb(hexColor));
-
-  float hsvF = colorToShiftHsv.v * scaleFactorF;
-
-  colorToShiftHsv.v = (unsigned char)hsvF;
-
-  rgbColor colorToShiftRgb = HsvToRgb(colorToShiftHsv);
-  // Serial.print("shifted: ");
-  // Serial.println(packRgb(colorToShiftRgb.r, colorToShiftRgb.g,
-  // colorToShiftRgb.b), HEX);
-  return packRgb(colorToShiftRgb.r, colorToShiftRgb.g, colorToShiftRgb.b);
+  // same math as before, the multiplier for each factor comes from a table
+  return colorScaleBrightness(hexColor, scaleFactor);
   }
 
 uint32_t scaleDownBrightness(uint32_t hexColor, int scaleFactor,
@@ -3228,7 +3266,7 @@ bool photos = true; //this lets me adjust the brightness for better photos
 void lightUpNode(int node, uint32_t color) {
 
   leds.setPixelColor(nodesToPixelMap[node], color);
-  showLEDsCore2 = 1;
+  queueShowLEDs(1);
   }
 uint32_t dimLogoColor(uint32_t color, int brightness) {
   // return color;
@@ -3241,12 +3279,11 @@ uint32_t dimLogoColor(uint32_t color, int brightness) {
   hsvColor colorHsv = RgbToHsv(dimColor);
 
   colorHsv.v = brightness;
+  rgbColor dimmed = HsvToRgb(colorHsv);
   if (photos == true || true) {
-    return packRgb(HsvToRgb(colorHsv).r / 3, HsvToRgb(colorHsv).g / 3,
-                   HsvToRgb(colorHsv).b);
+    return packRgb(dimmed.r / 3, dimmed.g / 3, dimmed.b);
     } else {
-    return packRgb(HsvToRgb(colorHsv).r, HsvToRgb(colorHsv).g * 2,
-                   HsvToRgb(colorHsv).b * 3);
+    return packRgb(dimmed.r, dimmed.g * 2, dimmed.b * 3);
     }
   }
 
@@ -3951,9 +3988,109 @@ void lightUpRail(int logo, int rail, int onOff, int brightness2,
     leds.setPixelColor(railsToPixelMap[1][24], 0x2f0000);
     }
   // leds.show();
-  // showLEDsCore2 = 1;
+  // queueShowLEDs(1);
   // delay(3);
   }
+static uint32_t floatInputs(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+  }
+
+uint32_t railLayerInputs(void) {
+  if (colorFlash[0] != 0 || colorFlash[1] != 0 ||
+      rstColors[0] != headerColors[0] || rstColors[1] != headerColors[1]) {
+    return LED_INPUTS_UNKNOWN; // lightUpHeader() is flashing a reset button
+    }
+  uint32_t inputs = LED_INPUTS_UNKNOWN;
+  inputs = ledInputsAdd(inputs, floatInputs(railVoltage[0]));
+  inputs = ledInputsAdd(inputs, floatInputs(railVoltage[1]));
+  inputs = ledInputsAdd(inputs, (LEDbrightnessRail << 16) | (LEDbrightness << 8) | lightUpName);
+  inputs = ledInputsAdd(inputs, brightenedRail);
+  inputs = ledInputsAdd(inputs, brightenedAmount);
+  inputs = ledInputsAdd(inputs, sfProbeMenu);
+  for (int i = 0; i < 7; i++) {
+    inputs = ledInputsAdd(inputs, headerColors[i]);
+    }
+  for (int i = 0; i < 15; i++) {
+    inputs = ledInputsAdd(inputs, rawOtherColors[i]);
+    }
+  for (int j = 0; j < 4; j++) {
+    for (int i = 0; i < 5; i++) {
+      inputs = ledInputsAdd(inputs, railColorsV5[j][i]);
+      }
+    }
+  uint32_t overrides[13] = { RST0colorOverride, RST1colorOverride, GNDTcolorOverride,
+                             GNDBcolorOverride, VINcolorOverride, V3V3colorOverride,
+                             V5VcolorOverride, ADCcolorOverride0, ADCcolorOverride1,
+                             DACcolorOverride0, DACcolorOverride1, GPIOcolorOverride0,
+                             GPIOcolorOverride1 };
+  for (int i = 0; i < 13; i++) {
+    inputs = ledInputsAdd(inputs, overrides[i]);
+    }
+  uint32_t overrideDefaults[6] = { ADCcolorOverride0Default, ADCcolorOverride1Default,
+                                   DACcolorOverride0Default, DACcolorOverride1Default,
+                                   GPIOcolorOverride0Default, GPIOcolorOverride1Default };
+  for (int i = 0; i < 6; i++) {
+    inputs = ledInputsAdd(inputs, overrideDefaults[i]);
+    }
+  inputs = ledInputsAdd(inputs, dotColor);
+  inputs = ledInputsAdd(inputs, dangerDot);
+  inputs = ledInputsAdd(inputs, negDot);
+  return ledInputsDone(inputs);
+  }
+
+uint32_t netLayerInputs(void) {
+  uint32_t inputs = LED_INPUTS_UNKNOWN;
+  inputs = ledInputsAdd(inputs, (numberOfPaths << 16) | numberOfNets);
+  for (int i = 0; i < numberOfPaths && i < MAX_BRIDGES; i++) {
+    if (path[i].skip == true) {
+      return LED_INPUTS_UNKNOWN; // showSkippedNodes() blinks them
+      }
+    inputs = ledInputsAdd(inputs, path[i].node1);
+    inputs = ledInputsAdd(inputs, path[i].node2);
+    inputs = ledInputsAdd(inputs, (path[i].net << 8) | path[i].duplicate);
+    }
+  for (int i = 0; i <= numberOfNets && i < MAX_NETS; i++) {
+    inputs = ledInputsAdd(inputs, net[i].number);
+    inputs = ledInputsAdd(inputs, packRgb(net[i].color.r, net[i].color.g, net[i].color.b));
+    inputs = ledInputsAdd(inputs, packRgb(netColors[i].r, netColors[i].g, netColors[i].b));
+    inputs = ledInputsAdd(inputs, net[i].rawColor);
+    inputs = ledInputsAdd(inputs, net[i].specialFunction);
+    inputs = ledInputsAdd(inputs, (net[i].machine << 8) | (uint8_t)net[i].visible);
+    inputs = ledInputsAdd(inputs, changedNetColors[i].net);
+    inputs = ledInputsAdd(inputs, changedNetColors[i].color);
+    for (int j = 0; j < MAX_NODES && net[i].nodes[j] > 0; j++) {
+      inputs = ledInputsAdd(inputs, net[i].nodes[j]);
+      }
+    }
+  for (int i = 0; i < 8; i++) {
+    inputs = ledInputsAdd(inputs, showADCreadings[i]);
+    inputs = ledInputsAdd(inputs, adcReadingColors[i]);
+    inputs = ledInputsAdd(inputs, rawSpecialNetColors[i]);
+    inputs = ledInputsAdd(inputs, packRgb(specialNetColors[i].r, specialNetColors[i].g, specialNetColors[i].b));
+    }
+  for (int i = 0; i < 10; i++) {
+    inputs = ledInputsAdd(inputs, gpioNet[i]);
+    inputs = ledInputsAdd(inputs, gpioReadingColors[i]);
+    }
+  for (int i = 0; i < 3; i++) {
+    inputs = ledInputsAdd(inputs, railNetColors[i]);
+    }
+  for (int i = 0; i < 2; i++) {
+    // assignNetColors() colors the DAC nets from the swirl colors
+    inputs = ledInputsAdd(inputs, floatInputs(dacOutput[i]));
+    inputs = ledInputsAdd(inputs, logoColors8vSelect[map((long)(dacOutput[i] * 10), -80, 80, 0, 59)]);
+    }
+  inputs = ledInputsAdd(inputs, (numberOfShownNets << 16) | (netColorMode << 8) | jumperlessConfig.display.lines_wires);
+  inputs = ledInputsAdd(inputs, (LEDbrightness << 16) | (LEDbrightnessRail << 8) | LEDbrightnessSpecial);
+  inputs = ledInputsAdd(inputs, brightenedNet);
+  inputs = ledInputsAdd(inputs, brightenedNode);
+  inputs = ledInputsAdd(inputs, (brightenedAmount << 16) ^ (brightenedNetAmount << 8) ^ brightenedNodeAmount);
+  inputs = ledInputsAdd(inputs, probeHighlight);
+  return ledInputsDone(inputs);
+  }
+
 //int displayMode = jumperlessConfig.display.lines_wires; // 0 = lines 1= wires
 
 void showNets(void) {
@@ -4005,7 +4142,7 @@ void showNets(void) {
     //               if (debugNTCC > 0) {
     //   Serial.println(debugNTCC);
     // }
-    // showLEDsCore2 = 1;
+    // queueShowLEDs(1);
     //     if (rp2040.cpuid() == 0) {
     //   core1busy = false;
     //  } else {
@@ -4014,108 +4151,24 @@ void showNets(void) {
   }
 
 rgbColor HsvToRgb(hsvColor hsv) {
-  rgbColor rgb;
-  unsigned char region, p, q, t;
-  unsigned int h, s, v, remainder;
-
-  if (hsv.s == 0) {
-    rgb.r = hsv.v;
-    rgb.g = hsv.v;
-    rgb.b = hsv.v;
-    return rgb;
-    }
-
-  // converting to 16 bit to prevent overflow
-  h = hsv.h;
-  s = hsv.s;
-  v = hsv.v;
-
-  region = h / 43;
-  remainder = (h - (region * 43)) * 6;
-
-  p = (v * (255 - s)) >> 8;
-  q = (v * (255 - ((s * remainder) >> 8))) >> 8;
-  t = (v * (255 - ((s * (255 - remainder)) >> 8))) >> 8;
-
-  switch (region) {
-    case 0:
-      rgb.r = v;
-      rgb.g = t;
-      rgb.b = p;
-      break;
-    case 1:
-      rgb.r = q;
-      rgb.g = v;
-      rgb.b = p;
-      break;
-    case 2:
-      rgb.r = p;
-      rgb.g = v;
-      rgb.b = t;
-      break;
-    case 3:
-      rgb.r = p;
-      rgb.g = q;
-      rgb.b = v;
-      break;
-    case 4:
-      rgb.r = t;
-      rgb.g = p;
-      rgb.b = v;
-      break;
-    default:
-      rgb.r = v;
-      rgb.g = p;
-      rgb.b = q;
-      break;
-    }
-
-  return rgb;
+  return unpackRgb(colorHsvToRgb(colorPackHsv(hsv.h, hsv.s, hsv.v)));
   }
 
 uint32_t HsvToRaw(hsvColor hsv) {
-  rgbColor rgb = HsvToRgb(hsv);
-  return rgb.r << 16 | rgb.g << 8 | rgb.b;
+  return colorHsvToRgb(colorPackHsv(hsv.h, hsv.s, hsv.v));
   }
 
 hsvColor RgbToHsv(rgbColor rgb) {
-  hsvColor hsv;
-  unsigned char rgbMin, rgbMax;
-
-  rgbMin = rgb.r < rgb.g ? (rgb.r < rgb.b ? rgb.r : rgb.b)
-    : (rgb.g < rgb.b ? rgb.g : rgb.b);
-  rgbMax = rgb.r > rgb.g ? (rgb.r > rgb.b ? rgb.r : rgb.b)
-    : (rgb.g > rgb.b ? rgb.g : rgb.b);
-
-  hsv.v = rgbMax;
-  if (hsv.v == 0) {
-    hsv.h = 0;
-    hsv.s = 0;
-    return hsv;
-    }
-
-  hsv.s = 255 * ((long)(rgbMax - rgbMin)) / hsv.v;
-  if (hsv.s == 0) {
-    hsv.h = 0;
-    return hsv;
-    }
-
-  if (rgbMax == rgb.r)
-    hsv.h = 0 + 43 * (rgb.g - rgb.b) / (rgbMax - rgbMin);
-  else if (rgbMax == rgb.g)
-    hsv.h = 85 + 43 * (rgb.b - rgb.r) / (rgbMax - rgbMin);
-  else
-    hsv.h = 171 + 43 * (rgb.r - rgb.g) / (rgbMax - rgbMin);
-
-  return hsv;
+  return RgbToHsv(packRgb(rgb.r, rgb.g, rgb.b));
   }
 
 hsvColor RgbToHsv(uint32_t color) {
-  rgbColor rgb;
-  rgb.r = (color >> 16) & 0xFF;
-  rgb.g = (color >> 8) & 0xFF;
-  rgb.b = color & 0xFF;
-  return RgbToHsv(rgb);
+  uint32_t hsv = colorRgbToHsv(color & 0xffffff);
+  hsvColor result;
+  result.h = (hsv >> 16) & 0xFF;
+  result.s = (hsv >> 8) & 0xFF;
+  result.v = hsv & 0xFF;
+  return result;
   }
 
 void randomColors(void) {
@@ -4190,7 +4243,7 @@ void randomColors(void) {
 
     leds.setPixelColor(i, color); //  Set pixel's color (in RAM)
     // lightUpRail(-1, -1, 1, LEDbrightnessRail);
-    showLEDsCore2 = 3; //  Update strip to match
+    queueShowLEDs(3); //  Update strip to match
     //  Pause for a moment
     }
   // delay(500);
@@ -4227,7 +4280,7 @@ void rainbowy(int saturation, int brightness, int wait) {
 
     offset += 1;
     // offset = offset % 80;
-    showLEDsCore2 = 1;
+    queueShowLEDs(1);
     delayMicroseconds((wait * 1000)); //*((j/20.0)));
     }
   }
@@ -4288,7 +4341,7 @@ void startupColors(void) {
     offset += 1;
     // offset = offset % 80;
     // lightUpRail(1);
-    // showLEDsCore2 = 1;
+    // queueShowLEDs(1);
     leds.show();
     if (done == 0) {
       delayMicroseconds((14000)); //*((j/20.0)));
@@ -4299,7 +4352,7 @@ void startupColors(void) {
     }
   // clearLEDs();
   //  lightUpRail();
-  //   showLEDsCore2 = 1;
+  //   queueShowLEDs(1);
   }
 
 uint32_t chillinColors[LED_COUNT + 200] = {
@@ -4442,11 +4495,11 @@ void startupColorsV5(void) {
       }
     // leds.setPixelColor(399, 0x151515);
 
-    showLEDsCore2 = 3;
+    queueShowLEDs(3);
     delayMicroseconds((12));
     }
   // lightUpRail();
-  showLEDsCore2 = 1;
+  queueShowLEDs(1);
   // delay(1000);
   }
 void rainbowBounce(int wait, int logo) {
@@ -4485,7 +4538,7 @@ void rainbowBounce(int wait, int logo) {
         }
       }
 
-    showLEDsCore2 = 3;
+    queueShowLEDs(3);
     delayMicroseconds((wait * 1000) * ((j / 20.0)));
     }
   for (long j = 140; j >= 0; j -= 1) {
@@ -4520,7 +4573,7 @@ void rainbowBounce(int wait, int logo) {
       // leds.setPixelColor(i, rgbPacked);
       }
 
-    showLEDsCore2 = 3;
+    queueShowLEDs(3);
     delayMicroseconds((wait * 1000) * ((j / 20.0)));
     }
   }
@@ -4555,7 +4608,7 @@ void clearLEDs(void) {
 
     leds.setPixelColor(i, 0); //  Set pixel's color (in RAM)
     //  Update strip to match
-    // showLEDsCore2 = 1;
+    // queueShowLEDs(1);
     }
   // lightUpRail();
   //  for (int i = 80; i <= 109; i++)
@@ -4568,7 +4621,7 @@ void clearLEDs(void) {
   //      //  Update strip to match
   //  }
 
-  // showLEDsCore2 = 1;
+  // queueShowLEDs(1);
   }
 
 void clearLEDsExceptRails(void) {
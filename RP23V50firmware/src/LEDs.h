@@ -187,7 +187,6 @@ extern bool lightUpName;
 extern int netColorMode; // 0 = rainbow, 1 = shuffle
 //extern int displayMode;
 extern int numberOfShownNets;
-//extern int showLEDsCore2;
 extern int logoFlash;
 
 
@@ -400,6 +399,11 @@ void assignNetColors(int preview = 0);
 void lightUpRail(int logo = -1, int railNumber = -1, int onOff = 1,
                  int brightness = -1,
                  int supplySwitchPosition = 0);
+/// @brief Everything lightUpRail() / showNets() draw from, for their LED
+/// layers (see LedFrame.h). Whatever they start reading has to go in here too.
+/// LED_INPUTS_UNKNOWN while they're animating something.
+uint32_t railLayerInputs(void);
+uint32_t netLayerInputs(void);
 void setupSwirlColors(void);
 void logoSwirl(int start = 0, int spread = 5, int probe = 0);
 uint32_t dimLogoColor(uint32_t color, int brightness = 20);
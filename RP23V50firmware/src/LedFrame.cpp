@@ -0,0 +1,175 @@
+// SPDX-License-Identifier: MIT
+#include "LedFrame.h"
+
+#include <string.h>
+
+//! Frame section, down to the core 1 section this only needs LedFrame.h, so
+//! it can be run on a PC
+
+void ledFrameInit(struct ledFrame *frame) {
+  memset(frame, 0, sizeof(struct ledFrame));
+  frame->capturing = -1;
+  frame->stale = 1;
+}
+
+void ledFramePaint(struct ledFrame *frame, int pixel, uint32_t color) {
+  if (pixel < 0 || pixel >= LED_FRAME_PIXELS) {
+    return;
+  }
+  frame->pixels[pixel] = color;
+  if (frame->capturing >= 0) {
+    struct ledLayer *layer = &frame->layers[frame->capturing];
+    layer->pixels[pixel] = color;
+    layer->painted[pixel / 32] |= 1UL << (pixel % 32);
+  }
+}
+
+int ledFrameBeginLayer(struct ledFrame *frame, int layerNumber,
+                       uint32_t inputs) {
+  if (layerNumber < 0 || layerNumber >= LED_LAYERS) {
+    return 1;
+  }
+  struct ledLayer *layer = &frame->layers[layerNumber];
+
+  if (inputs != LED_INPUTS_UNKNOWN && layer->valid == 1 &&
+      layer->inputs == inputs) {
+    for (int word = 0; word < LED_FRAME_WORDS; word++) {
+      uint32_t painted = layer->painted[word];
+      while (painted != 0) {
+        int bit = __builtin_ctz(painted);
+        painted &= painted - 1;
+        frame->pixels[word * 32 + bit] = layer->pixels[word * 32 + bit];
+      }
+    }
+    layer->replays++;
+    return 0;
+  }
+
+  memset(layer->painted, 0, sizeof(layer->painted));
+  layer->valid = 0;
+  frame->capturing = layerNumber;
+  layer->renders++;
+  return 1;
+}
+
+void ledFrameEndLayer(struct ledFrame *frame, uint32_t inputs) {
+  if (frame->capturing < 0) {
+    return;
+  }
+  struct ledLayer *layer = &frame->layers[frame->capturing];
+  layer->inputs = inputs;
+  layer->valid = 1;
+  frame->capturing = -1;
+}
+
+void ledFrameInvalidate(struct ledFrame *frame) {
+  for (int i = 0; i < LED_LAYERS; i++) {
+    frame->layers[i].valid = 0;
+  }
+}
+
+int ledFrameChanged(const struct ledFrame *frame, int first, int count) {
+  if (frame->stale == 1) {
+    return count;
+  }
+  int changed = 0;
+  for (int i = first; i < first + count; i++) {
+    if (frame->pixels[i] != frame->shown[i]) {
+      changed++;
+    }
+  }
+  return changed;
+}
+
+void ledFrameMarkShown(struct ledFrame *frame, int first, int count) {
+  memcpy(&frame->shown[first], &frame->pixels[first], count * sizeof(uint32_t));
+}
+
+uint32_t ledInputsAdd(uint32_t inputs, uint32_t value) {
+  // FNV-1a a byte at a time
+  if (inputs == LED_INPUTS_UNKNOWN) {
+    inputs = 2166136261UL;
+  }
+  for (int i = 0; i < 4; i++) {
+    inputs ^= (value >> (i * 8)) & 0xff;
+    inputs *= 16777619UL;
+  }
+  return inputs;
+}
+
+uint32_t ledInputsDone(uint32_t inputs) {
+  return inputs == LED_INPUTS_UNKNOWN ? 1 : inputs;
+}
+
+//! Core 1 section: leds paints into ledFrame, core2stuff() renders each
+//! layer through beginLedLayer() / endLedLayer(), and leds.show() only
+//! sends the strips that changed
+
+#ifdef ARDUINO
+#include "LEDs.h"
+
+#include <Arduino.h>
+
+static_assert(LED_FRAME_PIXELS == LED_COUNT + LED_COUNT_TOP, "LED count moved");
+
+struct ledFrame ledFrame = {{0}, {0}, {}, -1, 1, 0, 0, 0};
+
+static unsigned long layerStart = 0;
+
+static const char *ledLayerNames[LED_LAYERS] = {
+    "rails", "logo", "measurements", "nets", "animations",
+};
+
+int beginLedLayer(int layer, uint32_t inputs) {
+  if (layer < 0 || layer >= LED_LAYERS) {
+    return 1;
+  }
+  if (ledFrameBeginLayer(&ledFrame, layer, inputs) == 0) {
+    return 0;
+  }
+  layerStart = micros();
+  return 1;
+}
+
+void endLedLayer(uint32_t inputs) {
+  if (ledFrame.capturing < 0) {
+    return;
+  }
+  struct ledLayer *layer = &ledFrame.layers[ledFrame.capturing];
+  unsigned long took = micros() - layerStart;
+  layer->lastMicros = took;
+  layer->totalMicros += took;
+  if (took > layer->maxMicros) {
+    layer->maxMicros = took;
+  }
+  ledFrameEndLayer(&ledFrame, inputs);
+}
+
+void invalidateLedLayers(void) { ledFrameInvalidate(&ledFrame); }
+
+void printLedFrameStats(void) {
+  Serial.print("\n\rLED frame:\t");
+  Serial.print(ledFrame.shows);
+  Serial.print(" shows\tskipped ");
+  Serial.print(ledFrame.skippedShows);
+  Serial.print("\tlast changed ");
+  Serial.print(ledFrame.changedPixels);
+  Serial.println(" pixels");
+  for (int i = 0; i < LED_LAYERS; i++) {
+    struct ledLayer *layer = &ledFrame.layers[i];
+    Serial.print("  ");
+    Serial.print(ledLayerNames[i]);
+    Serial.print(i == LED_LAYER_MEASUREMENTS ? "\t" : "\t\t");
+    Serial.print(layer->renders);
+    Serial.print(" renders\t");
+    Serial.print(layer->replays);
+    Serial.print(" replays\tlast ");
+    Serial.print(layer->lastMicros);
+    Serial.print(" us\tmax ");
+    Serial.print(layer->maxMicros);
+    Serial.print(" us\tmean ");
+    Serial.print(layer->renders > 0 ? layer->totalMicros / layer->renders : 0);
+    Serial.println(" us");
+  }
+}
+#endif
@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: MIT
+#ifndef LEDFRAME_H
+#define LEDFRAME_H
+
+#include <stdint.h>
+
+#define LED_FRAME_PIXELS 445 // LED_COUNT + LED_COUNT_TOP, same numbering as leds
+#define LED_FRAME_WORDS ((LED_FRAME_PIXELS + 31) / 32)
+#define LED_INPUTS_UNKNOWN 0 // the layer can't say what it depends on, always render
+
+/// @brief The layers core 1 draws, in the order they're painted. Anything
+/// that isn't drawn inside a layer (menus, the probe, defcon, clears) paints
+/// straight into the frame like it always did and gets painted over by the
+/// layers on the next frame.
+enum ledLayers {
+  LED_LAYER_RAILS,        // lightUpRail(), rails and header
+  LED_LAYER_LOGO,         // logoSwirl()
+  LED_LAYER_MEASUREMENTS, // readGPIO(), showLEDmeasurements()
+  LED_LAYER_NETS,         // showNets()
+  LED_LAYER_ANIMATIONS,   // showAllRowAnimations()
+  LED_LAYERS
+};
+
+/// @brief What a layer painted the last time it rendered. If its inputs
+/// haven't changed since, those pixels are painted again instead.
+struct ledLayer {
+  uint32_t pixels[LED_FRAME_PIXELS];
+  uint32_t painted[LED_FRAME_WORDS]; // which of pixels[] it set
+  uint32_t inputs; // what it was rendered from, LED_INPUTS_UNKNOWN never matches
+  uint8_t valid;
+  unsigned long renders;
+  unsigned long replays;
+  unsigned long lastMicros;
+  unsigned long maxMicros;
+  unsigned long totalMicros;
+};
+
+/// @brief Every pixel as 0xRRGGBB before the strips' brightness, and what
+/// the strips were last sent
+struct ledFrame {
+  uint32_t pixels[LED_FRAME_PIXELS];
+  uint32_t shown[LED_FRAME_PIXELS];
+  struct ledLayer layers[LED_LAYERS];
+  int8_t capturing; // layer being rendered, -1 if none
+  uint8_t stale;    // the strips don't match shown[], send everything
+  unsigned long shows;
+  unsigned long skippedShows;  // nothing had changed since the last one
+  unsigned long changedPixels; // in the last show that sent anything
+};
+
+//! Portable: only needs this header, so frames can be rendered and compared
+//! against golden images on a PC
+
+void ledFrameInit(struct ledFrame *frame);
+/// @brief Set a pixel, and if a layer is rendering, record it there too
+void ledFramePaint(struct ledFrame *frame, int pixel, uint32_t color);
+/// @brief Returns 1 if the layer has to render (call ledFrameEndLayer() when
+/// it's done), or 0 if it was clean and got painted from what it had
+int ledFrameBeginLayer(struct ledFrame *frame, int layer, uint32_t inputs);
+/// @brief inputs is taken after the render, since rendering can change them
+/// (assignNetColors() sets the net colors it reads)
+void ledFrameEndLayer(struct ledFrame *frame, uint32_t inputs);
+/// @brief Every layer renders next time
+void ledFrameInvalidate(struct ledFrame *frame);
+/// @brief Pixels in first..first + count - 1 that differ from what was shown
+int ledFrameChanged(const struct ledFrame *frame, int first, int count);
+void ledFrameMarkShown(struct ledFrame *frame, int first, int count);
+/// @brief Fold one value into a layer's inputs, start from LED_INPUTS_UNKNOWN
+uint32_t ledInputsAdd(uint32_t inputs, uint32_t value);
+/// @brief Never returns LED_INPUTS_UNKNOWN for inputs that are known
+uint32_t ledInputsDone(uint32_t inputs);
+
+#ifdef ARDUINO
+extern struct ledFrame ledFrame;
+
+/// @brief Same as ledFrameBeginLayer() on the frame leds draws into, timed.
+/// A layer's inputs have to cover everything it reads, nothing re-renders
+/// it on a timer.
+int beginLedLayer(int layer, uint32_t inputs);
+void endLedLayer(uint32_t inputs);
+void invalidateLedLayers(void);
+void printLedFrameStats(void);
+#endif
+
+#endif
@@ -0,0 +1,298 @@
+// SPDX-License-Identifier: MIT
+#include "LedOutput.h"
+
+//! Packing section, down to the output section this only needs LedOutput.h,
+//! so it can be run on a PC
+
+void ledOutputPack(const uint32_t *pixels, int count, uint8_t brightness,
+                   uint32_t *words) {
+  for (int i = 0; i < count; i++) {
+    uint32_t r = (pixels[i] >> 16) & 0xff;
+    uint32_t g = (pixels[i] >> 8) & 0xff;
+    uint32_t b = pixels[i] & 0xff;
+    if (brightness != 0) {
+      r = (r * brightness) >> 8;
+      g = (g * brightness) >> 8;
+      b = (b * brightness) >> 8;
+    }
+    words[i] = (g << 24) | (r << 16) | (b << 8);
+  }
+}
+
+//! Output section: each strip has its own state machine and DMA channel and
+//! both go out at the same time. show() packs into the back buffer and
+//! returns, the DMA IRQ waits out whatever's left in the FIFOs plus the
+//! reset time on an alarm, then the frame has latched and the next one (if
+//! show() queued one meanwhile) starts from the other buffer. The strips'
+//! channels raise DMA_IRQ_0, which only core 1 (where leds.begin() runs)
+//! enables. AdcEngine, SerialBridge and LogicAnalyzer share DMA_IRQ_1 on
+//! core 0, so no DMA interrupt is enabled on both cores.
+
+#ifdef ARDUINO
+#include "LedFrame.h"
+
+#include <Arduino.h>
+
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+#include "pico/critical_section.h"
+#include "ws2812.pio.h"
+
+struct ledOutputStats ledOutputStats = {0, 0, 0, 0, 0, 0, 0};
+
+struct ledOutputStrip {
+  int pin;
+  int first; // in leds numbering
+  int count;
+  int sm;
+  int dma;
+};
+
+static struct ledOutputStrip outputStrips[LED_OUTPUT_STRIPS];
+static int outputStripCount = 0;
+static PIO outputPio;
+
+static uint32_t outputWords[2][LED_FRAME_PIXELS];
+static critical_section_t outputLock;
+static volatile int frontBuffer = 0;       // the DMA reads this one
+static volatile uint8_t sendingStrips = 0; // DMA still running
+static volatile uint8_t latching = 0;      // waiting out the FIFOs and reset
+static volatile uint8_t pendingStrips = 0; // the back buffer has a frame for these
+static volatile uint8_t packing = 0;       // show() is writing the back buffer
+static uint8_t outputBrightness = 255;     // as Adafruit_NeoPixel stores it
+static void (*outputDone)(void) = nullptr;
+static uint32_t frameStart = 0;
+static uint32_t fpsStart = 0;
+static unsigned long fpsFrames = 0;
+
+// lock held, nothing going out
+static void startLedFrame(void) {
+  frontBuffer ^= 1;
+  sendingStrips = pendingStrips;
+  pendingStrips = 0;
+  frameStart = time_us_32();
+  for (int i = 0; i < outputStripCount; i++) {
+    if ((sendingStrips & (1 << i)) == 0) {
+      continue;
+    }
+    dma_channel_set_read_addr(outputStrips[i].dma,
+                              &outputWords[frontBuffer][outputStrips[i].first],
+                              false);
+    dma_channel_set_trans_count(outputStrips[i].dma, outputStrips[i].count, true);
+  }
+}
+
+static int64_t ledOutputLatched(alarm_id_t id, void *userData) {
+  critical_section_enter_blocking(&outputLock);
+  latching = 0;
+  uint32_t took = time_us_32() - frameStart;
+  ledOutputStats.frames++;
+  ledOutputStats.lastMicros = took;
+  if (took > ledOutputStats.maxMicros) {
+    ledOutputStats.maxMicros = took;
+  }
+  fpsFrames++;
+  if (time_us_32() - fpsStart >= 1000000) {
+    ledOutputStats.fps = fpsFrames;
+    fpsFrames = 0;
+    fpsStart = time_us_32();
+  }
+  if (pendingStrips != 0 && packing == 0) {
+    startLedFrame(); // while it's packing, show() starts it when it's done
+  }
+  critical_section_exit(&outputLock);
+
+  if (outputDone != nullptr) {
+    outputDone();
+  }
+  return 0;
+}
+
+static void ledOutputDmaIrq(void) {
+  uint8_t finished = 0;
+  for (int i = 0; i < outputStripCount; i++) {
+    if (dma_channel_get_irq0_status(outputStrips[i].dma)) {
+      dma_channel_acknowledge_irq0(outputStrips[i].dma);
+      finished |= 1 << i;
+    }
+  }
+  if (finished == 0) {
+    return;
+  }
+
+  uint32_t waitUs = 0;
+  critical_section_enter_blocking(&outputLock);
+  sendingStrips &= ~finished;
+  if (sendingStrips == 0 && latching == 0) {
+    latching = 1;
+    uint32_t words = 0;
+    for (int i = 0; i < outputStripCount; i++) {
+      uint32_t level = pio_sm_get_tx_fifo_level(outputPio, outputStrips[i].sm);
+      if (level > words) {
+        words = level;
+      }
+    }
+    // what's left in the FIFO, the word in the OSR, then the reset
+    waitUs = (words + 1) * LED_OUTPUT_WORD_US + LED_OUTPUT_RESET_US;
+  }
+  critical_section_exit(&outputLock);
+
+  // outside the lock, an alarm that's already due runs the callback here
+  if (waitUs > 0 && add_alarm_in_us(waitUs, ledOutputLatched, nullptr, true) < 0) {
+    ledOutputLatched(0, nullptr); // no alarm slots, latch late rather than never
+  }
+}
+
+static int setupLedStrip(struct ledOutputStrip *strip, uint offset) {
+  strip->sm = pio_claim_unused_sm(outputPio, false);
+  strip->dma = dma_claim_unused_channel(false);
+  if (strip->sm < 0 || strip->dma < 0) {
+    return 0;
+  }
+
+  pio_gpio_init(outputPio, strip->pin);
+  pio_sm_set_consecutive_pindirs(outputPio, strip->sm, strip->pin, 1, true);
+  pio_sm_config config = ws2812_program_get_default_config(offset);
+  sm_config_set_sideset_pins(&config, strip->pin);
+  sm_config_set_out_shift(&config, false, true, 24);
+  sm_config_set_fifo_join(&config, PIO_FIFO_JOIN_TX);
+  sm_config_set_clkdiv(&config,
+                       clock_get_hz(clk_sys) /
+                           (800000.0f * (ws2812_T1 + ws2812_T2 + ws2812_T3)));
+  pio_sm_init(outputPio, strip->sm, offset, &config);
+  pio_sm_set_enabled(outputPio, strip->sm, true);
+
+  dma_channel_config dmaConfig = dma_channel_get_default_config(strip->dma);
+  channel_config_set_transfer_data_size(&dmaConfig, DMA_SIZE_32);
+  channel_config_set_read_increment(&dmaConfig, true);
+  channel_config_set_write_increment(&dmaConfig, false);
+  channel_config_set_dreq(&dmaConfig, pio_get_dreq(outputPio, strip->sm, true));
+  dma_channel_configure(strip->dma, &dmaConfig, &outputPio->txf[strip->sm],
+                        outputWords[0], strip->count, false);
+  dma_channel_set_irq0_enabled(strip->dma, true);
+  return 1;
+}
+
+int beginLedOutput(int bottomPin, int bottomCount, int topPin, int topCount) {
+  if (ledOutputStats.dma == 1) {
+    return 1;
+  }
+
+  // whichever PIO still has room, the CH446Qs, encoder and logic analyzer
+  // have theirs already
+  int strips = topCount > 0 ? 2 : 1;
+  int pioNumber = -1;
+  for (int i = 0; i < NUM_PIOS && pioNumber < 0; i++) {
+    int freeSms = 0;
+    for (int sm = 0; sm < 4; sm++) {
+      freeSms += pio_sm_is_claimed(pio_get_instance(i), sm) ? 0 : 1;
+    }
+    if (freeSms >= strips &&
+        pio_can_add_program(pio_get_instance(i), &ws2812_program)) {
+      pioNumber = i;
+    }
+  }
+  if (pioNumber < 0) {
+    return 0;
+  }
+  outputPio = pio_get_instance(pioNumber);
+  uint offset = pio_add_program(outputPio, &ws2812_program);
+
+  outputStripCount = strips;
+  outputStrips[0] = {bottomPin, 0, bottomCount, -1, -1};
+  outputStrips[1] = {topPin, bottomCount, topCount, -1, -1};
+  for (int i = 0; i < outputStripCount; i++) {
+    if (setupLedStrip(&outputStrips[i], offset) == 0) {
+      for (int j = 0; j <= i; j++) {
+        if (outputStrips[j].sm >= 0) {
+          pio_sm_set_enabled(outputPio, outputStrips[j].sm, false);
+          pio_sm_unclaim(outputPio, outputStrips[j].sm);
+        }
+        if (outputStrips[j].dma >= 0) {
+          dma_channel_set_irq0_enabled(outputStrips[j].dma, false);
+          dma_channel_unclaim(outputStrips[j].dma);
+        }
+      }
+      pio_remove_program(outputPio, &ws2812_program, offset);
+      outputStripCount = 0;
+      return 0;
+    }
+  }
+
+  critical_section_init(&outputLock);
+  irq_add_shared_handler(DMA_IRQ_0, ledOutputDmaIrq,
+                         PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+  irq_set_enabled(DMA_IRQ_0, true); // on this core only
+  fpsStart = time_us_32();
+  ledOutputStats.dma = 1;
+  return 1;
+}
+
+void sendLedOutput(const uint32_t *pixels, bool sendBottom, bool sendTop) {
+  uint8_t strips = (sendBottom ? 1 : 0) | (sendTop && outputStripCount > 1 ? 2 : 0);
+  if (ledOutputStats.dma == 0 || strips == 0) {
+    return;
+  }
+
+  // only show() starts a frame while packing is set, so the back buffer
+  // stays the back buffer and can be packed outside the lock
+  critical_section_enter_blocking(&outputLock);
+  packing = 1;
+  if (pendingStrips != 0) {
+    ledOutputStats.dropped++;
+  }
+  uint32_t *back = outputWords[frontBuffer ^ 1];
+  critical_section_exit(&outputLock);
+
+  // the back buffer gets the whole frame, a strip that didn't change this
+  // time might have in the frame it replaces
+  ledOutputPack(pixels, LED_FRAME_PIXELS, outputBrightness, back);
+
+  critical_section_enter_blocking(&outputLock);
+  packing = 0;
+  pendingStrips |= strips;
+  if (sendingStrips == 0 && latching == 0) {
+    startLedFrame();
+  } else {
+    ledOutputStats.queued++;
+  }
+  critical_section_exit(&outputLock);
+}
+
+void setLedOutputBrightness(uint8_t brightness) {
+  outputBrightness = brightness + 1;
+}
+
+void onLedOutputDone(void (*callback)(void)) { outputDone = callback; }
+
+void waitLedOutput(void) {
+  unsigned long start = millis();
+  while (ledOutputStats.dma == 1 &&
+         (sendingStrips != 0 || latching != 0 || pendingStrips != 0) &&
+         millis() - start < LED_OUTPUT_WAIT_MS) {
+  }
+}
+
+void printLedOutputStats(void) {
+  Serial.print("\n\rLED output:\t");
+  if (ledOutputStats.dma == 0) {
+    Serial.println("Adafruit_NeoPixel::show() (no PIO / DMA free)");
+    return;
+  }
+  // nothing latching for a while means nothing's changed, not the old rate
+  Serial.print(time_us_32() - fpsStart > 2000000 ? 0 : ledOutputStats.fps);
+  Serial.print(" fps\tframes ");
+  Serial.print(ledOutputStats.frames);
+  Serial.print("\tqueued ");
+  Serial.print(ledOutputStats.queued);
+  Serial.print("\tdropped ");
+  Serial.print(ledOutputStats.dropped);
+  Serial.print("\tlast ");
+  Serial.print(ledOutputStats.lastMicros);
+  Serial.print(" us\tmax ");
+  Serial.print(ledOutputStats.maxMicros);
+  Serial.println(" us");
+}
+#endif
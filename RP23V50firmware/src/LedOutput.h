@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: MIT
+#ifndef LEDOUTPUT_H
+#define LEDOUTPUT_H
+
+#include <stdint.h>
+
+#define LED_OUTPUT_STRIPS 2
+#define LED_OUTPUT_WORD_US 30   // 24 bits at 800KHz
+#define LED_OUTPUT_RESET_US 300 // low time that latches a frame, WS2812B wants 280
+#define LED_OUTPUT_WAIT_MS 50   // waitLedOutput() gives up after this
+
+struct ledOutputStats {
+  unsigned long frames;     // latched on the strips
+  unsigned long queued;     // show() found a frame going out, went after it
+  unsigned long dropped;    // a newer show() replaced them before they went out
+  unsigned long fps;        // frames latched over the last second
+  unsigned long lastMicros; // first DMA start to latched
+  unsigned long maxMicros;
+  uint8_t dma;              // 0 if leds fell back to Adafruit_NeoPixel::show()
+};
+
+extern struct ledOutputStats ledOutputStats;
+
+//! Portable: only needs this header, so the packing can be checked against
+//! Adafruit_NeoPixel on a PC
+
+/// @brief Pixels as 0xRRGGBB to what the state machine shifts out (GRB << 8),
+/// scaled the way Adafruit_NeoPixel stores setBrightness(brightness - 1),
+/// 0 is full brightness
+void ledOutputPack(const uint32_t *pixels, int count, uint8_t brightness,
+                   uint32_t *words);
+
+#ifdef ARDUINO
+/// @brief Put both strips on a PIO state machine each, fed by DMA. topCount
+/// is 0 for boards with one strip. Returns 0 if there's no PIO / DMA free,
+/// leds keeps using Adafruit_NeoPixel::show() then. Enables DMA_IRQ_0 on
+/// the core that calls it, which is core 1 (initLEDs() in setup1()).
+int beginLedOutput(int bottomPin, int bottomCount, int topPin, int topCount);
+/// @brief Queue a frame of LED_FRAME_PIXELS and return straight away. If one
+/// is going out it goes right after it, replacing any frame still waiting.
+void sendLedOutput(const uint32_t *pixels, bool sendBottom, bool sendTop);
+/// @brief Same as Adafruit_NeoPixel::setBrightness()
+void setLedOutputBrightness(uint8_t brightness);
+/// @brief Called from an interrupt each time a frame latches, keep it short
+void onLedOutputDone(void (*callback)(void));
+/// @brief Wait until everything queued has latched
+void waitLedOutput(void);
+void printLedOutputStats(void);
+#endif
+
+#endif
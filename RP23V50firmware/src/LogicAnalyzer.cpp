@@ -0,0 +1,502 @@
+// SPDX-License-Identifier: MIT
+#include "LogicAnalyzer.h"
+
+#include <string.h>
+
+//! SUMP / trigger / readout section, down to the PIO section this only needs
+//! LogicAnalyzer.h, so recorded captures can be pushed through it on a PC
+
+void laDefaultSettings(struct laSettings *settings) {
+  memset(settings, 0, sizeof(*settings));
+  settings->divider = 99; // 1MHz
+  settings->readCount = 4096;
+  settings->delayCount = 4096;
+}
+
+uint32_t laSampleRate(const struct laSettings *settings) {
+  return LA_SUMP_CLOCK / (settings->divider + 1);
+}
+
+void sumpParserReset(struct sumpParser *parser) {
+  parser->command = 0;
+  parser->have = -1;
+}
+
+int sumpFeed(struct sumpParser *parser, uint8_t byte) {
+  if (parser->have < 0) {
+    parser->command = byte;
+    if ((byte & 0x80) == 0) {
+      return 1; // short command, no argument
+    }
+    parser->have = 0;
+    return 0;
+  }
+  parser->argument[parser->have++] = byte;
+  if (parser->have < 4) {
+    return 0;
+  }
+  parser->have = -1;
+  return 1;
+}
+
+uint32_t sumpArgument(const struct sumpParser *parser) {
+  return parser->argument[0] | (parser->argument[1] << 8) |
+         (parser->argument[2] << 16) | ((uint32_t)parser->argument[3] << 24);
+}
+
+int sumpApply(struct laSettings *settings, const struct sumpParser *parser) {
+  uint32_t argument = sumpArgument(parser);
+
+  switch (parser->command) {
+  case SUMP_RESET:
+  case SUMP_RUN:
+  case SUMP_ID:
+  case SUMP_METADATA:
+    return parser->command;
+  case SUMP_DIVIDER:
+    settings->divider = argument & 0x00ffffff;
+    return -1;
+  case SUMP_READ_DELAY:
+    settings->readCount = ((argument & 0xffff) + 1) * 4;
+    settings->delayCount = ((argument >> 16) + 1) * 4;
+    return -1;
+  case SUMP_READ_COUNT:
+    settings->readCount = (argument + 1) * 4;
+    return -1;
+  case SUMP_DELAY_COUNT:
+    settings->delayCount = (argument + 1) * 4;
+    return -1;
+  case SUMP_FLAGS:
+    settings->flags = argument;
+    return -1;
+  }
+
+  if ((parser->command & 0xf0) == SUMP_TRIGGER_MASK) {
+    int stage = (parser->command >> 2) & 3;
+    switch (parser->command & 3) {
+    case 0:
+      settings->triggerMask[stage] = argument;
+      break;
+    case 1:
+      settings->triggerValue[stage] = argument;
+      break;
+    case 2:
+      settings->triggerConfig[stage] = argument;
+      break;
+    }
+  }
+  return -1; // XON / XOFF and anything unknown
+}
+
+static int metadataU32(uint8_t *out, uint8_t key, uint32_t value) {
+  out[0] = key;
+  out[1] = value >> 24; // metadata is the one big endian part of SUMP
+  out[2] = value >> 16;
+  out[3] = value >> 8;
+  out[4] = value;
+  return 5;
+}
+
+int sumpMetadata(uint8_t *out, int max, const char *name, uint32_t samples,
+                 uint32_t maxRate) {
+  int nameLength = strlen(name) + 1;
+  if (max < nameLength + 1 + 4 * 5 + 1) {
+    return 0;
+  }
+  int n = 0;
+  out[n++] = 0x01;
+  memcpy(out + n, name, nameLength);
+  n += nameLength;
+  n += metadataU32(out + n, 0x20, LA_CHANNELS);
+  n += metadataU32(out + n, 0x21, samples);
+  n += metadataU32(out + n, 0x23, maxRate);
+  n += metadataU32(out + n, 0x24, 2); // protocol version
+  out[n++] = 0x00;
+  return n;
+}
+
+int64_t laFindTrigger(const volatile uint8_t *ring, uint32_t size, int64_t from,
+                      int64_t to, uint8_t mask, uint8_t value) {
+  uint32_t wrap = size - 1;
+  int64_t i = from;
+
+  value &= mask;
+  for (; i < to && (i & 3) != 0; i++) {
+    if ((ring[i & wrap] & mask) == value) {
+      return i;
+    }
+  }
+
+  // a word (4 samples) at a time, a zero byte in miss is a match
+  uint32_t mask4 = mask * 0x01010101u;
+  uint32_t value4 = value * 0x01010101u;
+  for (; i + 4 <= to; i += 4) {
+    uint32_t word = *(const volatile uint32_t *)&ring[i & wrap];
+    uint32_t miss = (word & mask4) ^ value4;
+    if (((miss - 0x01010101u) & ~miss & 0x80808080u) != 0) {
+      break; // the byte loop finds which one
+    }
+  }
+
+  for (; i < to; i++) {
+    if ((ring[i & wrap] & mask) == value) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void laReadoutBegin(struct laReadout *readout, const volatile uint8_t *ring,
+                    uint32_t size, int64_t start, uint32_t count,
+                    uint8_t groups) {
+  readout->ring = ring;
+  readout->size = size;
+  readout->start = start;
+  readout->count = count;
+  readout->sent = 0;
+  readout->groups = groups & 0x0f;
+  readout->pad = ring[0]; // only used when start < 0, so the ring hasn't lapped
+}
+
+int laReadoutFill(struct laReadout *readout, uint8_t *out, int max) {
+  int groupBytes = 0;
+  for (int i = 0; i < 4; i++) {
+    groupBytes += (readout->groups >> i) & 1;
+  }
+  if (groupBytes == 0) {
+    readout->sent = readout->count; // host turned every channel off
+    return 0;
+  }
+
+  int n = 0;
+  while (readout->sent < readout->count && n + groupBytes <= max) {
+    int64_t index = readout->start + readout->count - 1 - readout->sent;
+    uint8_t sample =
+        index < 0 ? readout->pad : readout->ring[index & (readout->size - 1)];
+    for (int i = 0; i < 4; i++) {
+      if ((readout->groups >> i) & 1) {
+        out[n++] = i == 0 ? sample : 0; // only group 0 has pins behind it
+      }
+    }
+    readout->sent++;
+  }
+  return n;
+}
+
+#ifdef ARDUINO
+//! PIO section: one state machine on pio2 samples GPIO 20-27 into its RX
+//! FIFO and a DMA channel streams that into laRing, wrapping on the ring.
+//! The trigger is searched for in the ring, then the word count to the end of
+//! the capture is posted to the state machine, which stops itself there so
+//! the window doesn't depend on how quickly the CPU gets back to it.
+
+#include <Arduino.h>
+
+#include "ArduinoStuff.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+#include "logic_capture.pio.h"
+
+#define LA_DMA_COUNT 0x00100000 // words, only sets how often the IRQ rearms
+#define LA_SCAN_SLICE_MS 20     // longest the trigger search holds the loop
+#define LA_SCAN_HOLD_RATE 250000 // above this the ring laps in < 130ms
+
+static uint8_t laRing[LA_RING_SAMPLES] __attribute__((aligned(LA_RING_SAMPLES)));
+
+volatile int logicAnalyzerState = LA_IDLE;
+struct logicAnalyzerStats laStats = {0, 0, 0, 0, 0, 0, -1};
+
+static PIO laPio = pio2;
+static int laSm = -1;
+static uint laOffset = 0;
+static int laDmaChannel = -1;
+static volatile int laDmaRunning = 0;
+static volatile uint64_t laArmedBase = 0; // words
+static volatile uint32_t laArmSeq = 0;    // odd while the IRQ is rearming
+
+static struct laSettings laHost;
+static struct laSettings laRun;
+static struct sumpParser laParser;
+static struct laReadout laOut;
+static int laHostReady = 0;
+
+static uint8_t laMask = 0;
+static uint8_t laValue = 0;
+static int64_t laScanned = 0;
+static int64_t laTrigger = -1;
+static int64_t laEnd = 0;
+
+static void laDmaIrq(void) {
+  if (laDmaChannel < 0 || !dma_channel_get_irq1_status(laDmaChannel)) {
+    return;
+  }
+  dma_channel_acknowledge_irq1(laDmaChannel);
+  if (laDmaRunning == 0) {
+    return;
+  }
+
+  laArmSeq++;
+  dma_channel_set_trans_count(laDmaChannel, LA_DMA_COUNT, true);
+  laArmedBase += LA_DMA_COUNT;
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  laArmSeq++;
+}
+
+static uint64_t laWordsWritten(void) {
+  uint32_t seq;
+  uint64_t base;
+  uint32_t remaining;
+  do {
+    seq = laArmSeq;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    base = laArmedBase;
+    remaining = dma_channel_hw_addr(laDmaChannel)->transfer_count & 0x0fffffff;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  } while ((seq & 1) != 0 || seq != laArmSeq);
+  return base + (LA_DMA_COUNT - remaining);
+}
+
+static uint32_t laMaxRate(void) { return clock_get_hz(clk_sys) / 4; }
+
+static void setupLogicAnalyzer(void) {
+  if (laSm >= 0) {
+    return;
+  }
+  laSm = pio_claim_unused_sm(laPio, true);
+  laOffset = pio_add_program(laPio, &logic_capture_program);
+
+  laDmaChannel = dma_claim_unused_channel(true);
+  dma_channel_set_irq1_enabled(laDmaChannel, true);
+  irq_add_shared_handler(DMA_IRQ_1, laDmaIrq,
+                         PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+  irq_set_enabled(DMA_IRQ_1, true);
+}
+
+/// @brief Tell the state machine how many more words to take so the capture
+/// covers laTrigger + delayCount. It picks the count up at its next word, so
+/// it's at least 2 words on from what the DMA has written now.
+static void postLogicAnalyzerStop(void) {
+  laEnd = laTrigger + laRun.delayCount;
+  int64_t words = (laEnd + 3) / 4 - (int64_t)laWordsWritten() - 2;
+  pio_sm_put(laPio, laSm, words < 1 ? 1 : (uint32_t)words);
+  logicAnalyzerState = LA_TRIGGERED;
+}
+
+int armLogicAnalyzer(const struct laSettings *settings) {
+  stopLogicAnalyzer();
+  setupLogicAnalyzer();
+
+  laRun = *settings;
+  if (laRun.readCount > LA_MAX_SAMPLES) {
+    laRun.readCount = LA_MAX_SAMPLES;
+  } else if (laRun.readCount < 4) {
+    laRun.readCount = 4;
+  }
+  if (laRun.delayCount > laRun.readCount) {
+    laRun.delayCount = laRun.readCount;
+  }
+
+  // 4 PIO clocks a sample
+  float clock = clock_get_hz(clk_sys);
+  float divider = clock / (4.0f * laSampleRate(&laRun));
+  if (divider < 1.0f) {
+    divider = 1.0f;
+  } else if (divider > 65535.0f) {
+    divider = 65535.0f;
+  }
+  laStats.lastRate = clock / (4.0f * divider);
+
+  pio_sm_config config = logic_capture_program_get_default_config(laOffset);
+  sm_config_set_in_pins(&config, LA_FIRST_PIN);
+  sm_config_set_in_shift(&config, true, true, 32); // first sample in the low byte
+  sm_config_set_clkdiv(&config, divider);
+  pio_sm_init(laPio, laSm, laOffset, &config);
+  pio_sm_exec(laPio, laSm, pio_encode_set(pio_x, 0));
+  pio_sm_clear_fifos(laPio, laSm);
+  laPio->fdebug = 1u << (PIO_FDEBUG_RXSTALL_LSB + laSm);
+
+  dma_channel_config dmaConfig = dma_channel_get_default_config(laDmaChannel);
+  channel_config_set_transfer_data_size(&dmaConfig, DMA_SIZE_32);
+  channel_config_set_read_increment(&dmaConfig, false);
+  channel_config_set_write_increment(&dmaConfig, true);
+  channel_config_set_ring(&dmaConfig, true, LA_RING_BITS);
+  channel_config_set_dreq(&dmaConfig, pio_get_dreq(laPio, laSm, false));
+
+  laArmedBase = 0;
+  laArmSeq = 0;
+  laDmaRunning = 1;
+  dma_channel_configure(laDmaChannel, &dmaConfig, laRing, &laPio->rxf[laSm],
+                        LA_DMA_COUNT, true);
+
+  // only the first trigger stage, as a parallel mask / value match
+  laMask = laRun.triggerMask[0] & 0xff;
+  laValue = laRun.triggerValue[0] & 0xff;
+  laScanned = 0;
+  laTrigger = -1;
+  laStats.captures++;
+
+  if (laMask == 0) {
+    laTrigger = 0;
+    postLogicAnalyzerStop();
+  } else {
+    logicAnalyzerState = LA_ARMED;
+  }
+  pio_sm_set_enabled(laPio, laSm, true);
+  return 0;
+}
+
+void stopLogicAnalyzer(void) {
+  if (logicAnalyzerState == LA_IDLE) {
+    return;
+  }
+  if (laDmaRunning == 1) {
+    laDmaRunning = 0;
+    pio_sm_set_enabled(laPio, laSm, false);
+    dma_channel_abort(laDmaChannel);
+  }
+  logicAnalyzerState = LA_IDLE;
+}
+
+static void scanForTrigger(void) {
+  int64_t written = (int64_t)laWordsWritten() * 4;
+  if (written - laScanned > LA_RING_SAMPLES - LA_RING_GUARD) {
+    laScanned = written - (LA_RING_SAMPLES - LA_RING_GUARD);
+    laStats.scanLaps++;
+  }
+  int64_t found = laFindTrigger(laRing, LA_RING_SAMPLES, laScanned, written,
+                                laMask, laValue);
+  if (found < 0) {
+    laScanned = written;
+    return;
+  }
+  laTrigger = found;
+  postLogicAnalyzerStop();
+}
+
+static int captureFinished(void) {
+  if (pio_sm_get_pc(laPio, laSm) != laOffset + logic_capture_offset_done ||
+      !pio_sm_is_rx_fifo_empty(laPio, laSm)) {
+    return 0;
+  }
+  busy_wait_us(1); // let the last word the DMA popped land
+  return 1;
+}
+
+static void finishCapture(void) {
+  int64_t written = (int64_t)laWordsWritten() * 4;
+  laDmaRunning = 0;
+  pio_sm_set_enabled(laPio, laSm, false);
+  dma_channel_abort(laDmaChannel);
+
+  if (laPio->fdebug & (1u << (PIO_FDEBUG_RXSTALL_LSB + laSm))) {
+    laStats.fifoStalls++;
+  }
+
+  int64_t end = laEnd < written ? laEnd : written;
+  if (written - (end - (int64_t)laRun.readCount) > LA_RING_SAMPLES) {
+    end = written; // the start of the window got overwritten
+    laStats.lateStops++;
+  }
+  laStats.lastTrigger = laTrigger;
+
+  uint8_t groups = ~(laRun.flags >> SUMP_FLAG_GROUPS_SHIFT) & 0x0f;
+  laReadoutBegin(&laOut, laRing, LA_RING_SAMPLES, end - laRun.readCount,
+                 laRun.readCount, groups);
+  logicAnalyzerState = LA_SENDING;
+}
+
+static void sendCapture(void) {
+  uint8_t chunk[64];
+  int room = USBSer3.availableForWrite();
+
+  while (room > 0 && laOut.sent < laOut.count) {
+    int n = laReadoutFill(&laOut, chunk, room < (int)sizeof(chunk) ? room : (int)sizeof(chunk));
+    if (n == 0) {
+      break;
+    }
+    USBSer3.write(chunk, n);
+    laStats.bytesSent += n;
+    room -= n;
+  }
+  if (laOut.sent >= laOut.count) {
+    USBSer3.flush();
+    logicAnalyzerState = LA_IDLE;
+  }
+}
+
+void serviceLogicAnalyzer(void) {
+  if (laHostReady == 0) {
+    laDefaultSettings(&laHost);
+    sumpParserReset(&laParser);
+    laHostReady = 1;
+  }
+
+  while (USBSer3.available() > 0) {
+    if (sumpFeed(&laParser, USBSer3.read()) == 0) {
+      continue;
+    }
+    switch (sumpApply(&laHost, &laParser)) {
+    case SUMP_RESET:
+      stopLogicAnalyzer();
+      break;
+    case SUMP_RUN:
+      armLogicAnalyzer(&laHost);
+      break;
+    case SUMP_ID:
+      USBSer3.write((const uint8_t *)"1ALS", 4);
+      break;
+    case SUMP_METADATA: {
+      uint8_t metadata[48];
+      int n = sumpMetadata(metadata, sizeof(metadata), "Jumperless V5",
+                           LA_MAX_SAMPLES, laMaxRate());
+      USBSer3.write(metadata, n);
+      break;
+    }
+    }
+  }
+
+  if (logicAnalyzerState == LA_ARMED) {
+    // fast captures lap the ring quicker than the main loop comes back round
+    unsigned long start = millis();
+    do {
+      scanForTrigger();
+    } while (logicAnalyzerState == LA_ARMED &&
+             laStats.lastRate >= LA_SCAN_HOLD_RATE &&
+             millis() - start < LA_SCAN_SLICE_MS && USBSer3.available() == 0);
+  }
+  if (logicAnalyzerState == LA_TRIGGERED && captureFinished() == 1) {
+    finishCapture();
+  }
+  if (logicAnalyzerState == LA_SENDING) {
+    sendCapture();
+  }
+}
+
+void printLogicAnalyzerStats(void) {
+  const char *stateNames[] = {"idle", "armed", "triggered", "sending"};
+
+  Serial.print("\n\rLogic analyzer:\t");
+  Serial.print(stateNames[logicAnalyzerState]);
+  Serial.print("\tlast rate ");
+  Serial.print(laStats.lastRate);
+  Serial.print(" S/s\tmax ");
+  Serial.print(laMaxRate());
+  Serial.println(" S/s");
+  Serial.print("  captures:\t");
+  Serial.print(laStats.captures);
+  Serial.print("\ttrigger at ");
+  Serial.print((long)laStats.lastTrigger);
+  Serial.print("\tsent ");
+  Serial.print((unsigned long)laStats.bytesSent);
+  Serial.println(" bytes");
+  Serial.print("  fell behind:\t");
+  Serial.print(laStats.scanLaps);
+  Serial.print(" trigger search\t");
+  Serial.print(laStats.fifoStalls);
+  Serial.print(" FIFO stalls\t");
+  Serial.print(laStats.lateStops);
+  Serial.println(" late stops");
+}
+#endif
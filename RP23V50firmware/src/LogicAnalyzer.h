@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: MIT
+#ifndef LOGICANALYZER_H
+#define LOGICANALYZER_H
+
+#include <stdint.h>
+
+#define LA_CHANNELS 8          // GPIO 1-8 (RP pins 20-27), one byte per sample
+#define LA_FIRST_PIN 20        // gpioDef[0][0], the 8 are consecutive
+#define LA_RING_SAMPLES 32768  // 32 KB, the biggest ring the DMA can wrap
+#define LA_RING_BITS 15        // log2(LA_RING_SAMPLES)
+#define LA_RING_GUARD 1024     // slack for the capture running on past the end
+#define LA_MAX_SAMPLES (LA_RING_SAMPLES - LA_RING_GUARD)
+#define LA_SUMP_CLOCK 100000000 // SUMP dividers count from a 100MHz clock
+
+//! SUMP (Openbench Logic Sniffer) protocol, sigrok's "ols" driver talks it
+#define SUMP_RESET 0x00
+#define SUMP_RUN 0x01
+#define SUMP_ID 0x02
+#define SUMP_METADATA 0x04
+#define SUMP_XON 0x11
+#define SUMP_XOFF 0x13
+#define SUMP_DIVIDER 0x80
+#define SUMP_READ_DELAY 0x81   // read-1, delay-1 in 16 bits each, units of 4
+#define SUMP_FLAGS 0x82
+#define SUMP_DELAY_COUNT 0x83  // 32 bit versions of 0x81 for big buffers
+#define SUMP_READ_COUNT 0x84
+#define SUMP_TRIGGER_MASK 0xC0 // + 4 * stage
+#define SUMP_TRIGGER_VALUE 0xC1
+#define SUMP_TRIGGER_CONFIG 0xC2
+
+#define SUMP_FLAG_GROUPS_SHIFT 2 // bits 2-5 disable channel groups 0-3
+
+/// @brief Everything the host has set up for the next run
+struct laSettings {
+  uint32_t divider;    // sample rate = LA_SUMP_CLOCK / (divider + 1)
+  uint32_t readCount;  // samples sent back
+  uint32_t delayCount; // samples after the trigger
+  uint32_t triggerMask[4];
+  uint32_t triggerValue[4];
+  uint32_t triggerConfig[4];
+  uint32_t flags;
+};
+
+/// @brief Collects the 1 or 5 byte SUMP commands out of a byte stream
+struct sumpParser {
+  uint8_t command;
+  uint8_t argument[4];
+  int have; // argument bytes so far, -1 = waiting for a command byte
+};
+
+/// @brief Walks a finished capture newest sample first, the order SUMP sends
+/// it in. Samples before the capture started repeat the first real one.
+struct laReadout {
+  const volatile uint8_t *ring;
+  uint32_t size;   // power of 2
+  int64_t start;   // stream index of the oldest sample sent
+  uint32_t count;
+  uint32_t sent;
+  uint8_t groups;  // bit per enabled channel group, a byte each per sample
+  uint8_t pad;
+};
+
+//! Portable: only needs this header
+void laDefaultSettings(struct laSettings *settings);
+uint32_t laSampleRate(const struct laSettings *settings);
+void sumpParserReset(struct sumpParser *parser);
+/// @brief Push one byte from the host, returns 1 when parser->command (and
+/// its argument) is complete
+int sumpFeed(struct sumpParser *parser, uint8_t byte);
+uint32_t sumpArgument(const struct sumpParser *parser);
+/// @brief Store a settings command, returns the command byte for the ones
+/// that need the caller to do something (reset, run, ID, metadata), else -1
+int sumpApply(struct laSettings *settings, const struct sumpParser *parser);
+int sumpMetadata(uint8_t *out, int max, const char *name, uint32_t samples,
+                 uint32_t maxRate);
+/// @brief First stream index in [from, to) where (sample & mask) == value,
+/// or -1. to - from has to fit in the ring.
+int64_t laFindTrigger(const volatile uint8_t *ring, uint32_t size, int64_t from,
+                      int64_t to, uint8_t mask, uint8_t value);
+void laReadoutBegin(struct laReadout *readout, const volatile uint8_t *ring,
+                    uint32_t size, int64_t start, uint32_t count,
+                    uint8_t groups);
+/// @brief Encode up to max bytes of SUMP sample data, returns how many
+int laReadoutFill(struct laReadout *readout, uint8_t *out, int max);
+
+enum laState { LA_IDLE = 0, LA_ARMED, LA_TRIGGERED, LA_SENDING };
+
+struct logicAnalyzerStats {
+  unsigned long captures;
+  unsigned long scanLaps;   // trigger search fell a ring behind the capture
+  unsigned long fifoStalls; // DMA didn't keep up, samples spaced unevenly
+  unsigned long lateStops;  // stopped too late, trigger moved in the window
+  unsigned long long bytesSent;
+  uint32_t lastRate;
+  int64_t lastTrigger; // stream index, -1 = none yet
+};
+
+extern volatile int logicAnalyzerState;
+extern struct logicAnalyzerStats laStats;
+
+/// @brief Handle the logic analyzer's USB port: SUMP commands, trigger
+/// search and sending the capture back. Call it from the main loop.
+void serviceLogicAnalyzer(void);
+int armLogicAnalyzer(const struct laSettings *settings);
+void stopLogicAnalyzer(void);
+void printLogicAnalyzerStats(void);
+
+#endif
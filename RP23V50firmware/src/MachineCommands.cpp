@@ -6,11 +6,17 @@
 #include "SafeString.h"
 #include "ArduinoJson.h"
 #include "NetManager.h"
+#include "CH446Q.h"
+#include "Commands.h"
 #include "JumperlessDefines.h"
 #include "LEDs.h"
 #include <EEPROM.h>
 #include "MachineCommands.h"
 #include "PersistentStuff.h"
+#include "Peripherals.h"
+#include "NetsToChipConnections.h"
+#include "Waveforms.h"
+#include "InaMonitor.h"
 
 bool debugMM = true;
 // char inputBuffer[INPUTBUFFERLENGTH] = {0};
@@ -23,31 +29,431 @@ ArduinoJson::DynamicJsonDocument machineModeJson(8000);
 
 enum machineModeInstruction lastReceivedInstruction = unknown;
 
-char machineModeInstructionString[NUMBEROFINSTRUCTIONS][20] = {"unknown", "netlist", "getnetlist", "bridgelist", "getbridgelist", "lightnode", "lightnet", "getmeasurement", "gpio", "uart", "arduinoflash", "setnetcolor", "setnodecolor", "setsupplyswitch", "getsupplyswitch", "getchipstatus", "getunconnectedpaths"};
+char machineModeInstructionString[NUMBEROFINSTRUCTIONS][20] = {"unknown", "netlist", "getnetlist", "bridgelist", "getbridgelist", "lightnode", "lightnet", "getmeasurement", "gpio", "uart", "arduinoflash", "setnetcolor", "setnodecolor", "setsupplyswitch", "getsupplyswitch", "getchipstatus", "getunconnectedpaths", "bridgebatch", "wave"};
 
 
 unsigned long lastTimeNetlistLoaded = 0;
 unsigned long lastTimeCommandRecieved = 0;
 
-void machineMode(void) // read in commands in machine readable format
+char *machinePayload = NULL;
+
+struct machineParser machineParse = {MP_IDLE};
+struct machineParserStats machineStats;
+
+static int machinePayloadCapacity = 0;
+static uint8_t instructionHashTable[MACHINE_HASH_SLOTS] = {0};
+static uint32_t instructionHashSeed = 0;
+static bool instructionHashBuilt = false;
+
+static void finishMachineFrame(void);
+
+static uint32_t hashInstruction(const char *name, uint32_t seed)
 {
-  int sequenceNumber = -1;
+    uint32_t hash = 2166136261u ^ seed;
 
-  lastTimeCommandRecieved = millis();
+    for (; *name != '\0'; name++)
+    {
+        hash ^= (uint8_t)tolower(*name);
+        hash *= 16777619u;
+    }
+    return hash & (MACHINE_HASH_SLOTS - 1);
+}
 
-  if (millis() - lastTimeCommandRecieved > 100) {
-    machineModeRespond(sequenceNumber, true);
-    return;
-  }
-  enum machineModeInstruction receivedInstruction =
-      parseMachineInstructions(&sequenceNumber);
+// finds a seed where every instruction name lands in its own slot, so a
+// lookup is one hash and one strcasecmp to confirm it
+static void buildInstructionTable(void)
+{
+    for (uint32_t seed = 0; seed < 100000; seed++)
+    {
+        bool collided = false;
 
-  // Serial.print("receivedInstruction: ");
-  // Serial.print(receivedInstruction);
-  // Serial.print("\n\r");
+        memset(instructionHashTable, 0, sizeof(instructionHashTable));
 
-  switch (receivedInstruction) {
-  case netlist:
+        for (int i = 1; i < NUMBEROFINSTRUCTIONS; i++)
+        {
+            uint32_t slot = hashInstruction(machineModeInstructionString[i], seed);
+
+            if (instructionHashTable[slot] != 0)
+            {
+                collided = true;
+                break;
+            }
+            instructionHashTable[slot] = i;
+        }
+
+        if (collided == false)
+        {
+            instructionHashSeed = seed;
+            instructionHashBuilt = true;
+            return;
+        }
+    }
+}
+
+enum machineModeInstruction lookupMachineInstruction(const char *name)
+{
+    if (instructionHashBuilt == false)
+    {
+        buildInstructionTable();
+    }
+
+    int index = instructionHashTable[hashInstruction(name, instructionHashSeed)];
+
+    if (index != 0 && strcasecmp(name, machineModeInstructionString[index]) == 0)
+    {
+        return static_cast<machineModeInstruction>(index);
+    }
+    return unknown;
+}
+
+static void resetMachineParser(void)
+{
+    machineParse.state = MP_IDLE;
+    machineParse.nameLength = 0;
+    machineParse.name[0] = '\0';
+    machineParse.sequenceNumber = -1;
+    machineParse.payloadLength = 0;
+    machineParse.depth = 0;
+    machineParse.inString = false;
+    machineParse.escaped = false;
+    machineParse.overflowed = false;
+    machineParse.headerLength = 0;
+    machineParse.frameLength = 0;
+    machineParse.frameReceived = 0;
+    machineParse.frameCrc = 0;
+    machineParse.crcLength = 0;
+}
+
+static void appendPayload(char c);
+
+// leaves machinePayload as a valid empty string
+static void emptyPayload(void)
+{
+    machineParse.payloadLength = 0;
+    appendPayload('\0');
+    machineParse.payloadLength = 0;
+}
+
+static void appendPayload(char c)
+{
+    if (machineParse.overflowed == true)
+    {
+        return;
+    }
+
+    if (machineParse.payloadLength + 2 > machinePayloadCapacity)
+    {
+        int grown = machinePayloadCapacity == 0 ? 256 : machinePayloadCapacity * 2;
+
+        if (grown > MACHINE_MAX_PAYLOAD)
+        {
+            grown = MACHINE_MAX_PAYLOAD;
+        }
+
+        char *bigger = grown > machinePayloadCapacity ? (char *)realloc(machinePayload, grown) : NULL;
+
+        if (bigger == NULL)
+        {
+            // keep eating bytes to the closing bracket, then answer ::error
+            machineParse.overflowed = true;
+            machineStats.overflows++;
+            return;
+        }
+        machinePayload = bigger;
+        machinePayloadCapacity = grown;
+    }
+
+    machinePayload[machineParse.payloadLength++] = c;
+    machinePayload[machineParse.payloadLength] = '\0';
+}
+
+static void finishMachineCommand(void)
+{
+    unsigned long startMicros = micros();
+
+    machineParse.name[machineParse.nameLength] = '\0';
+
+    enum machineModeInstruction instruction = lookupMachineInstruction(machineParse.name);
+    lastReceivedInstruction = instruction;
+    int sequenceNumber = machineParse.sequenceNumber;
+
+    if (debugMM)
+    {
+        Serial.print("instruction ");
+        Serial.print(machineParse.name);
+        Serial.print(" = ");
+        Serial.print(instruction);
+        Serial.print("\tpayload ");
+        Serial.println(machineParse.payloadLength);
+    }
+
+    if ((long)machineParse.payloadLength > (long)machineStats.maxPayload)
+    {
+        machineStats.maxPayload = machineParse.payloadLength;
+    }
+    machineStats.commands++;
+
+    if (machineParse.overflowed == true)
+    {
+        resetMachineParser();
+        machineModeRespond(sequenceNumber, false);
+        return;
+    }
+    if (instruction == unknown)
+    {
+        machineStats.unknown++;
+    }
+
+    // reset first so the handler is free to reuse the payload buffer
+    resetMachineParser();
+    lastTimeCommandRecieved = millis();
+    runMachineInstruction(instruction, sequenceNumber);
+
+    unsigned long took = micros() - startMicros;
+
+    if (took > machineStats.maxDispatchMicros)
+    {
+        machineStats.maxDispatchMicros = took;
+    }
+}
+
+// ::name[:sequence][payload]
+// The payload ends at the ] that closes the first [, brackets inside JSON
+// strings don't count, so netlists can be any length and arrive in pieces.
+// A command with no payload can end at a newline instead.
+int feedMachineParser(char c)
+{
+    machineStats.bytes++;
+    machineParse.lastByteMillis = millis();
+
+    switch (machineParse.state)
+    {
+    case MP_IDLE:
+        if (c == ':')
+        {
+            machineParse.state = MP_COLON;
+        }
+        else if ((uint8_t)c == MACHINE_FRAME_SYNC)
+        {
+            beginMachineFrame();
+        }
+        return 0;
+
+    case MP_COLON:
+        if (c == ':')
+        {
+            machineParse.state = MP_NAME;
+        }
+        else
+        {
+            resetMachineParser();
+        }
+        return 0;
+
+    case MP_NAME:
+    case MP_SEQUENCE:
+        if (c == '[')
+        {
+            machineParse.state = MP_PAYLOAD;
+            machineParse.payloadLength = 0;
+            machineParse.depth = 1;
+            appendPayload(c);
+            return 0;
+        }
+        if (c == '\n' || c == '\r')
+        {
+            if (machineParse.nameLength == 0)
+            {
+                resetMachineParser();
+                return 0;
+            }
+            machineParse.payloadLength = 0;
+            appendPayload('[');
+            appendPayload(']');
+            finishMachineCommand();
+            return 1;
+        }
+        if (c == ':' && machineParse.state == MP_NAME)
+        {
+            machineParse.state = MP_SEQUENCE;
+            machineParse.sequenceNumber = 0;
+            return 0;
+        }
+        if (machineParse.state == MP_SEQUENCE)
+        {
+            if (c >= '0' && c <= '9')
+            {
+                machineParse.sequenceNumber = machineParse.sequenceNumber * 10 + (c - '0');
+            }
+            return 0;
+        }
+        if (c != ' ' && machineParse.nameLength < (int)sizeof(machineParse.name) - 1)
+        {
+            machineParse.name[machineParse.nameLength++] = c;
+        }
+        return 0;
+
+    case MP_PAYLOAD:
+        appendPayload(c);
+
+        if (machineParse.escaped == true)
+        {
+            machineParse.escaped = false;
+        }
+        else if (machineParse.inString == true)
+        {
+            if (c == '\\')
+            {
+                machineParse.escaped = true;
+            }
+            else if (c == '"')
+            {
+                machineParse.inString = false;
+            }
+        }
+        else if (c == '"')
+        {
+            machineParse.inString = true;
+        }
+        else if (c == '[')
+        {
+            machineParse.depth++;
+        }
+        else if (c == ']' && --machineParse.depth == 0)
+        {
+            finishMachineCommand();
+            return 1;
+        }
+        return 0;
+
+    case MP_FRAME_HEADER:
+        machineParse.header[machineParse.headerLength++] = (uint8_t)c;
+
+        if (machineParse.headerLength == MACHINE_FRAME_HEADER)
+        {
+            machineParse.frameLength = machineParse.header[4] | (machineParse.header[5] << 8);
+            machineParse.sequenceNumber = machineParse.header[2] | (machineParse.header[3] << 8);
+            emptyPayload();
+            machineParse.state = machineParse.frameLength > 0 ? MP_FRAME_PAYLOAD : MP_FRAME_CRC;
+        }
+        return 0;
+
+    case MP_FRAME_PAYLOAD:
+        appendPayload(c);
+
+        if (++machineParse.frameReceived == machineParse.frameLength)
+        {
+            machineParse.state = MP_FRAME_CRC;
+        }
+        return 0;
+
+    case MP_FRAME_CRC:
+        machineParse.frameCrc |= (uint8_t)c << (8 * machineParse.crcLength++);
+
+        if (machineParse.crcLength == 2)
+        {
+            finishMachineFrame();
+            return 1;
+        }
+        return 0;
+    }
+    return 0;
+}
+
+bool machineParserActive(void)
+{
+    if (machineParse.state == MP_IDLE)
+    {
+        return false;
+    }
+
+    if (millis() - machineParse.lastByteMillis > MACHINE_PARSER_TIMEOUT)
+    {
+        // the host gave up halfway through, tell it and go back to the menu
+        int sequenceNumber = machineParse.sequenceNumber;
+        bool binary = machineParse.state >= MP_FRAME_HEADER;
+        bool knowsFrame = machineParse.headerLength == MACHINE_FRAME_HEADER;
+        uint8_t op = machineParse.header[0];
+
+        machineStats.timeouts++;
+        resetMachineParser();
+
+        if (binary == false)
+        {
+            machineModeRespond(sequenceNumber, false);
+        }
+        else if (knowsFrame == true)
+        {
+            sendMachineFrame(op, FRAME_TIMEOUT, sequenceNumber);
+        }
+        return false;
+    }
+    return true;
+}
+
+// Called by the main menu after it has eaten the leading ::
+void beginMachineCommand(void)
+{
+    resetMachineParser();
+    machineParse.state = MP_NAME;
+    machineParse.lastByteMillis = millis();
+}
+
+// Called by the main menu after it has eaten the sync byte
+void beginMachineFrame(void)
+{
+    resetMachineParser();
+    machineParse.state = MP_FRAME_HEADER;
+    machineParse.lastByteMillis = millis();
+}
+
+// Takes whatever has arrived and returns without waiting for the rest.
+// Commands are run as soon as they close, so a host can send the next
+// sequence numbered command without waiting for the last ::ok.
+int serviceMachineMode(void)
+{
+    int dispatched = 0;
+    char chunk[64];
+
+    while (Serial.available() > 0)
+    {
+        if (machineParse.state == MP_IDLE && Serial.peek() != ':' &&
+            Serial.peek() != MACHINE_FRAME_SYNC)
+        {
+            break; // not ours, leave it for the menu
+        }
+
+        int count = Serial.available();
+
+        if (count > (int)sizeof(chunk))
+        {
+            count = sizeof(chunk);
+        }
+        if (machineParse.state == MP_IDLE)
+        {
+            count = 1;
+        }
+
+        count = Serial.readBytes(chunk, count);
+
+        // line endings or junk between commands in the same chunk fall
+        // through the idle state and get dropped
+        for (int i = 0; i < count; i++)
+        {
+            dispatched += feedMachineParser(chunk[i]);
+        }
+    }
+    return dispatched;
+}
+
+void machineMode(void) // read in commands in machine readable format
+{
+    beginMachineCommand();
+    serviceMachineMode();
+}
+
+void loadNetlistFromPayload(void)
+{
     lastTimeNetlistLoaded = millis();
     clearAllNTCC();
 
@@ -63,21 +469,12 @@ void machineMode(void) // read in commands in machine readable format
     assignNetColors();
     // showNets();
     digitalWrite(RESETPIN, LOW);
-    sendAllPathsCore2 = 1;
-    break;
-
-  case getnetlist:
-    if (millis() - lastTimeNetlistLoaded > 300) {
-
-      listNetsMachine();
-    } else {
-      machineModeRespond(0, true);
-      // Serial.print ("too soon bro\n\r");
-      return;
-    }
-    break;
+    markCrosspointsDesynced();
+    queueSendPaths(1);
+}
 
-  case bridgelist:
+void loadBridgelistFromPayload(void)
+{
     clearAllNTCC();
 
     writeNodeFileFromInputBuffer();
@@ -91,9 +488,32 @@ void machineMode(void) // read in commands in machine readable format
     assignNetColors();
     // Serial.print("bridgesToPaths\n\r");
     digitalWrite(RESETPIN, LOW);
+    markCrosspointsDesynced();
     // showNets();
 
-    sendAllPathsCore2 = 1;
+    queueSendPaths(1);
+}
+
+void runMachineInstruction(enum machineModeInstruction receivedInstruction, int sequenceNumber)
+{
+  switch (receivedInstruction) {
+  case netlist:
+    loadNetlistFromPayload();
+    break;
+
+  case getnetlist:
+    if (millis() - lastTimeNetlistLoaded > 300) {
+
+      listNetsMachine();
+    } else {
+      machineModeRespond(0, true);
+      // Serial.print ("too soon bro\n\r");
+      return;
+    }
+    break;
+
+  case bridgelist:
+    loadBridgelistFromPayload();
     break;
 
   case getbridgelist:
@@ -108,7 +528,7 @@ void machineMode(void) // read in commands in machine readable format
     lightUpNetsFromInputBuffer();
     //   lightUpNet();
     // assignNetColors();
-    // showLEDsCore2 = 1;
+    // queueShowLEDs(1);
     break;
 
     // case getmeasurement:
@@ -121,7 +541,7 @@ void machineMode(void) // read in commands in machine readable format
     // printSupplySwitch(supplySwitchPosition);
     machineModeRespond(sequenceNumber, true);
 
-    //showLEDsCore2 = 1;
+    //queueShowLEDs(1);
     break;
 
   case getsupplyswitch:
@@ -148,6 +568,18 @@ void machineMode(void) // read in commands in machine readable format
     getUnconnectedPaths();
     break;
 
+  case bridgebatch:
+    bridgeBatchFromInputBuffer();
+    break;
+
+  case wave:
+    if (applyWaveFromPayload() < 0) {
+      machineModeRespond(sequenceNumber, false);
+      return;
+    }
+    waveFromInputBuffer();
+    break;
+
   case unknown:
     machineModeRespond(sequenceNumber, false);
     return;
@@ -156,100 +588,521 @@ void machineMode(void) // read in commands in machine readable format
   machineModeRespond(sequenceNumber, true);
 }
 
+void printMachineParserStats(void)
+{
+    Serial.print("\n\rMachine mode:\t");
+    Serial.print(machineStats.commands);
+    Serial.print(" commands\t");
+    Serial.print(machineStats.bytes);
+    Serial.print(" bytes\tlargest payload ");
+    Serial.print(machineStats.maxPayload);
+    Serial.print("\tslowest ");
+    Serial.print(machineStats.maxDispatchMicros);
+    Serial.println("us");
+    Serial.print("  frames:\t");
+    Serial.print(machineStats.framesIn);
+    Serial.print(" in\t");
+    Serial.print(machineStats.framesOut);
+    Serial.print(" out\t");
+    Serial.print((unsigned long)machineStats.frameBytesOut);
+    Serial.print(" bytes out\tbad crc ");
+    Serial.println(machineStats.badCrc);
+    Serial.print("  unknown:\t");
+    Serial.print(machineStats.unknown);
+    Serial.print("\toverflows ");
+    Serial.print(machineStats.overflows);
+    Serial.print("\ttimeouts ");
+    Serial.println(machineStats.timeouts);
+}
+
+//! Binary frames, for hosts polling faster than the text replies allow
+//!
+//! A5 | op | flags | sequence (2) | length (2) | payload | crc (2)
+//!
+//! Everything is little endian, the CRC is CRC-16/CCITT (0x1021 from 0xFFFF)
+//! over op through the end of the payload. Replies have the same layout with
+//! op | 0x80 and a machineFrameStatus where the flags were. The ops are the
+//! machineModeInstruction numbers plus FRAME_GETPATHS, writes take the same
+//! text payload as the :: version.
+
+static uint8_t *frameReply = NULL;
+static int frameReplyCapacity = 0;
+static int frameReplyLength = 0;
+static bool frameReplyFull = false;
+
+// what the host was last sent, for FRAME_DELTA (0 = nothing)
+static uint16_t lastNetCrc[MAX_NETS] = {0};
+static uint16_t lastPathCrc[MAX_BRIDGES] = {0};
+static uint16_t lastChipCrc[12] = {0};
+static uint16_t lastBridgeListCrc = 0;
+
+uint16_t crc16Ccitt(uint16_t crc, const uint8_t *data, int length)
+{
+    for (int i = 0; i < length; i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static void replyByte(uint8_t value)
+{
+    if (frameReplyLength + 1 > frameReplyCapacity)
+    {
+        int grown = frameReplyCapacity == 0 ? 512 : frameReplyCapacity * 2;
+        uint8_t *bigger = grown <= MACHINE_MAX_PAYLOAD ? (uint8_t *)realloc(frameReply, grown) : NULL;
+
+        if (bigger == NULL)
+        {
+            frameReplyFull = true;
+            return;
+        }
+        frameReply = bigger;
+        frameReplyCapacity = grown;
+    }
+    frameReply[frameReplyLength++] = value;
+}
+
+static void replyU16(uint16_t value)
+{
+    replyByte(value & 0xff);
+    replyByte(value >> 8);
+}
+
+static void replyFloat(float value)
+{
+    uint8_t bytes[4];
+    memcpy(bytes, &value, 4);
+
+    for (int i = 0; i < 4; i++)
+    {
+        replyByte(bytes[i]);
+    }
+}
+
+// Checks the record that starts at start against what was sent last time,
+// in delta mode an unchanged one is taken back out of the reply
+static bool keepRecord(int start, uint16_t *lastCrc, bool delta)
+{
+    uint16_t crc = crc16Ccitt(0xFFFF, frameReply + start, frameReplyLength - start);
+
+    if (crc == 0)
+    {
+        crc = 1;
+    }
+    if (delta == true && crc == *lastCrc)
+    {
+        frameReplyLength = start;
+        return false;
+    }
+    *lastCrc = crc;
+    return true;
+}
 
-enum machineModeInstruction parseMachineInstructions(int *sequenceNumber)
+void sendMachineFrame(uint8_t op, uint8_t status, uint16_t sequenceNumber)
 {
+    if (frameReplyFull == true)
+    {
+        status = FRAME_FAILED;
+        frameReplyLength = 0;
+    }
+
+    uint8_t header[MACHINE_FRAME_HEADER + 1] = {
+        MACHINE_FRAME_SYNC,
+        (uint8_t)(op | MACHINE_FRAME_REPLY),
+        status,
+        (uint8_t)(sequenceNumber & 0xff),
+        (uint8_t)(sequenceNumber >> 8),
+        (uint8_t)(frameReplyLength & 0xff),
+        (uint8_t)(frameReplyLength >> 8),
+    };
+
+    uint16_t crc = crc16Ccitt(0xFFFF, header + 1, MACHINE_FRAME_HEADER);
+    crc = crc16Ccitt(crc, frameReply, frameReplyLength);
+    uint8_t trailer[2] = {(uint8_t)(crc & 0xff), (uint8_t)(crc >> 8)};
+
+    Serial.write(header, sizeof(header));
+    if (frameReplyLength > 0)
+    {
+        Serial.write(frameReply, frameReplyLength);
+    }
+    Serial.write(trailer, 2);
+    Serial.flush();
 
-    int doneReading = 0;
+    machineStats.framesOut++;
+    machineStats.frameBytesOut += sizeof(header) + frameReplyLength + 2;
+    frameReplyLength = 0;
+    frameReplyFull = false;
+}
 
-    int instructionNumber = 0;
+// flags, count, then per net: index, number, flags (1 special, 2 machine,
+// 0x80 removed), r, g, b, node count, nodes (u16 each), name length, name
+static void frameNetlist(bool delta)
+{
+    replyByte(delta ? FRAME_DELTA : 0);
+    int countAt = frameReplyLength;
+    replyByte(0);
+    int count = 0;
 
-    for (int i = 0; i < INPUTBUFFERLENGTH; i++)
+    for (int i = 1; i < MAX_NETS; i++)
     {
-        if (doneReading == 1)
+        struct netStruct *n = &net[i];
+        int start = frameReplyLength;
+
+        if (n->number == 0 || n->nodes[0] == -1)
         {
-            inputBuffer[i] = '\0'; // eof
-            break;
+            if (delta == true && lastNetCrc[i] != 0)
+            {
+                replyByte(i);
+                replyByte(0);
+                replyByte(0x80);
+                count++;
+            }
+            lastNetCrc[i] = 0;
+            continue;
         }
-        else
+
+        replyByte(i);
+        replyByte(n->number);
+        replyByte((n->specialFunction ? 1 : 0) | (n->machine ? 2 : 0));
+
+        rgbColor color = unpackRgb(scaleUpBrightness(n->rawColor));
+        replyByte(color.r);
+        replyByte(color.g);
+        replyByte(color.b);
+
+        int nodeCountAt = frameReplyLength;
+        replyByte(0);
+        int nodeCount = 0;
+
+        for (int j = 0; j < MAX_NODES && n->nodes[j] > 0; j++)
+        {
+            replyU16(n->nodes[j]);
+            nodeCount++;
+        }
+        if (frameReplyFull == false)
         {
-            inputBuffer[i] = Serial.read();
+            frameReply[nodeCountAt] = nodeCount;
         }
 
-        if (inputBuffer[i] == ']')
+        int nameLength = n->name == NULL ? 0 : strlen(n->name);
+        nameLength = nameLength > 255 ? 255 : nameLength;
+        replyByte(nameLength);
+
+        for (int j = 0; j < nameLength; j++)
         {
-            doneReading = 1;
-            // inputBuffer[i] = ' '; //eof
-            // break;
+            replyByte(n->name[j]);
         }
 
-        delayMicroseconds(300);
+        if (frameReplyFull == false && keepRecord(start, &lastNetCrc[i], delta) == true)
+        {
+            count++;
+        }
     }
 
-    char instructionBuffer[20] = {0};
+    if (frameReplyFull == false)
+    {
+        frameReply[countAt] = count;
+    }
+}
 
-    int seqNumberSeparatorPos = -1;
+// flags (2 = unchanged since last time, nothing follows), count, pairs
+static void frameBridgelist(bool delta)
+{
+    replyByte(0);
+    int countAt = frameReplyLength;
+    replyU16(0);
+    int count = 0;
 
-    for (int i = 0; i < 20; i++)
+    for (int i = 1; i < MAX_NETS; i++)
     {
-        if (inputBuffer[i] == '[')
+        struct netStruct *n = &net[i];
+
+        if (n->number == 0 || n->nodes[0] == -1)
         {
-            // inputBuffer[i] = ' ';
             break;
         }
-        if (inputBuffer[i] == ':')
+        for (int j = 0; j < MAX_NODES; j++)
         {
-            seqNumberSeparatorPos = i;
+            if (n->bridges[j][0] <= 0)
+            {
+                continue;
+            }
+            replyU16(n->bridges[j][0]);
+            replyU16(n->bridges[j][1]);
+            count++;
         }
-        instructionBuffer[i] = inputBuffer[i];
-        inputBuffer[i] = ' ';
     }
 
-    if (seqNumberSeparatorPos > 0)
+    if (frameReplyFull == true)
     {
-        instructionBuffer[seqNumberSeparatorPos] = 0;
-        *sequenceNumber = atoi(instructionBuffer + seqNumberSeparatorPos + 1);
+        return;
     }
+    frameReply[countAt] = count & 0xff;
+    frameReply[countAt + 1] = count >> 8;
+
+    uint16_t crc = crc16Ccitt(0xFFFF, frameReply + countAt, frameReplyLength - countAt);
 
-    for (int i = 0; i < NUMBEROFINSTRUCTIONS; i++)
+    if (delta == true && crc == lastBridgeListCrc)
     {
-        if (strcasecmp(instructionBuffer, machineModeInstructionString[i]) == 0)
+        frameReplyLength = countAt + 2;
+        frameReply[countAt - 1] = FRAME_DELTA | FRAME_UNCHANGED;
+        return;
+    }
+    lastBridgeListCrc = crc;
+    frameReply[countAt - 1] = delta ? FRAME_DELTA : 0;
+}
+
+// flags, count, then per chip: chip, xStatus[16], yStatus[8]
+static void frameChipStatus(bool delta)
+{
+    replyByte(delta ? FRAME_DELTA : 0);
+    int countAt = frameReplyLength;
+    replyByte(0);
+    int count = 0;
+
+    for (int i = 0; i < 12; i++)
+    {
+        int start = frameReplyLength;
+        replyByte(i);
+
+        for (int j = 0; j < 16; j++)
         {
-            if (debugMM)
-            {
-                Serial.print("found instruction ");
-                Serial.println(instructionBuffer);
-                Serial.println(i);
-            }
+            replyByte((uint8_t)ch[i].xStatus[j]);
+        }
+        for (int j = 0; j < 8; j++)
+        {
+            replyByte((uint8_t)ch[i].yStatus[j]);
+        }
 
-            instructionNumber = i;
-            break;
+        if (frameReplyFull == false && keepRecord(start, &lastChipCrc[i], delta) == true)
+        {
+            count++;
         }
+    }
+
+    if (frameReplyFull == false)
+    {
+        frameReply[countAt] = count;
+    }
+}
+
+// flags, total paths, count, then per path: index, net, node1, node2 (u16),
+// chip[4], x[6], y[6]; paths past the total are gone
+static void framePaths(bool delta)
+{
+    replyByte(delta ? FRAME_DELTA : 0);
+    replyByte(numberOfPaths);
+    int countAt = frameReplyLength;
+    replyByte(0);
+    int count = 0;
 
-        if (i == NUMBEROFINSTRUCTIONS - 1)
+    for (int i = 0; i < MAX_BRIDGES; i++)
+    {
+        if (i >= numberOfPaths)
         {
-            if (debugMM)
-            {
-                Serial.println("instruction not found");
-            }
+            lastPathCrc[i] = 0;
+            continue;
+        }
+
+        int start = frameReplyLength;
+        replyByte(i);
+        replyByte(path[i].net);
+        replyU16(path[i].node1);
+        replyU16(path[i].node2);
 
-            instructionNumber = 0;
-            lastReceivedInstruction = static_cast<machineModeInstruction>(instructionNumber);
+        for (int j = 0; j < 4; j++)
+        {
+            replyByte((uint8_t)path[i].chip[j]);
+        }
+        for (int j = 0; j < 6; j++)
+        {
+            replyByte((uint8_t)path[i].x[j]);
+        }
+        for (int j = 0; j < 6; j++)
+        {
+            replyByte((uint8_t)path[i].y[j]);
+        }
 
-            return lastReceivedInstruction;
+        if (frameReplyFull == false && keepRecord(start, &lastPathCrc[i], delta) == true)
+        {
+            count++;
         }
     }
 
-    if (debugMM)
+    if (frameReplyFull == false)
+    {
+        frameReply[countAt] = count;
+    }
+}
+
+// request: mask (u16, bits 0-7 ADC channels, 8/9 INA0 mA / V, 10/11 INA1
+// mA / V, 12 GPIO), samples (u8). Reply: the mask, a float per bit in bit
+// order, then the 10 gpioReading bytes if bit 12 was set
+static void frameMeasurements(const uint8_t *request, int length)
+{
+    uint16_t mask = length >= 2 ? request[0] | (request[1] << 8) : 0x00ff;
+    int samples = length >= 3 && request[2] > 0 ? request[2] : 8;
+
+    replyU16(mask);
+
+    for (int i = 0; i < 8; i++)
+    {
+        if (mask & (1 << i))
+        {
+            replyFloat(readAdcVoltage(i, samples));
+        }
+    }
+    if (mask & (1 << 8))
+    {
+        replyFloat(inaCurrent(0) * 1000);
+    }
+    if (mask & (1 << 9))
+    {
+        replyFloat(inaBusVoltage(0));
+    }
+    if (mask & (1 << 10))
+    {
+        replyFloat(inaCurrent(1) * 1000);
+    }
+    if (mask & (1 << 11))
+    {
+        replyFloat(inaBusVoltage(1));
+    }
+    if (mask & (1 << 12))
+    {
+        for (int i = 0; i < 10; i++)
+        {
+            replyByte(gpioReading[i]);
+        }
+    }
+}
+
+static void finishMachineFrame(void)
+{
+    uint8_t op = machineParse.header[0];
+    uint8_t flags = machineParse.header[1];
+    uint16_t sequenceNumber = machineParse.sequenceNumber;
+    bool delta = (flags & FRAME_DELTA) != 0;
+
+    uint16_t crc = crc16Ccitt(0xFFFF, machineParse.header, MACHINE_FRAME_HEADER);
+    crc = crc16Ccitt(crc, (const uint8_t *)machinePayload, machineParse.payloadLength);
+
+    machineStats.framesIn++;
+
+    if (machineParse.overflowed == true)
+    {
+        // the CRC can't be checked without the whole payload
+        resetMachineParser();
+        sendMachineFrame(op, FRAME_TOO_LONG, sequenceNumber);
+        return;
+    }
+    if (crc != machineParse.frameCrc)
+    {
+        machineStats.badCrc++;
+        resetMachineParser();
+        sendMachineFrame(op, FRAME_BAD_CRC, sequenceNumber);
+        return;
+    }
+
+    int payloadLength = machineParse.payloadLength;
+    resetMachineParser();
+
+    if (flags & FRAME_RESET_DELTA)
     {
-        Serial.println("instruction buffer");
-        Serial.println(instructionBuffer);
-        Serial.println("\n\ninput buffer");
-        Serial.println(inputBuffer);
+        memset(lastNetCrc, 0, sizeof(lastNetCrc));
+        memset(lastPathCrc, 0, sizeof(lastPathCrc));
+        memset(lastChipCrc, 0, sizeof(lastChipCrc));
+        lastBridgeListCrc = 0;
     }
 
-    lastReceivedInstruction = static_cast<machineModeInstruction>(instructionNumber);
-    return lastReceivedInstruction;
+    // the handlers' debug prints would land in the middle of the frames
+    bool wasDebugging = debugMM;
+    debugMM = false;
+
+    uint8_t status = FRAME_OK;
+    bool writes = op == netlist || op == bridgelist || op == lightnode ||
+                  op == lightnet || op == bridgebatch || op == wave;
+
+    if (writes == true && strchr(machinePayload, '[') == NULL)
+    {
+        status = FRAME_FAILED;
+    }
+    else
+    {
+        switch (op)
+        {
+        case netlist:
+            loadNetlistFromPayload();
+            break;
+        case bridgelist:
+            loadBridgelistFromPayload();
+            break;
+        case lightnode:
+            lightUpNodesFromInputBuffer();
+            break;
+        case lightnet:
+            lightUpNetsFromInputBuffer();
+            break;
+        case bridgebatch:
+            if (applyBridgeBatchFromPayload() < 0)
+            {
+                status = FRAME_FAILED;
+                break;
+            }
+            // count, then node1, node2 (u16, 0xffff = whole node), result
+            replyByte(bridgeBatchCount);
+            for (int i = 0; i < bridgeBatchCount; i++)
+            {
+                replyU16(bridgeBatch[i].node1);
+                replyU16(bridgeBatch[i].node2);
+                replyByte((uint8_t)bridgeBatch[i].result);
+            }
+            break;
+        case wave:
+            if (applyWaveFromPayload() < 0)
+            {
+                status = FRAME_FAILED;
+            }
+            break;
+        case getnetlist:
+            frameNetlist(delta);
+            break;
+        case getbridgelist:
+            frameBridgelist(delta);
+            break;
+        case getchipstatus:
+            frameChipStatus(delta);
+            break;
+        case FRAME_GETPATHS:
+            framePaths(delta);
+            break;
+        case getunconnectedpaths:
+            replyByte(numberOfUnconnectablePaths);
+            for (int i = 0; i < numberOfUnconnectablePaths; i++)
+            {
+                replyU16(unconnectablePaths[i][0]);
+                replyU16(unconnectablePaths[i][1]);
+            }
+            break;
+        case getmeasurement:
+            frameMeasurements((const uint8_t *)machinePayload, payloadLength);
+            break;
+        default:
+            machineStats.unknown++;
+            status = FRAME_UNKNOWN;
+            break;
+        }
+    }
+
+    debugMM = wasDebugging;
+    lastTimeCommandRecieved = millis();
+    sendMachineFrame(op, status, sequenceNumber);
 }
 
 void machineModeRespond(int sequenceNumber, bool ok)
@@ -297,15 +1150,20 @@ void machineNetlistToNetstruct(void)
 
     if (debugMM)
     {
-        Serial.println(inputBuffer);
+        Serial.println(machinePayload);
         Serial.println("\n\n\n");
     }
 
-    deserializeJson(machineModeJson, inputBuffer);
+    // ~2 bytes of document per byte of JSON, long netlists get their own
+    size_t neededJson = strlen(machinePayload) * 2;
+    DynamicJsonDocument largeNetlistJson(neededJson > machineModeJson.capacity() ? neededJson : 0);
+    JsonDocument &netlistJson = neededJson > machineModeJson.capacity() ? (JsonDocument &)largeNetlistJson : (JsonDocument &)machineModeJson;
+
+    deserializeJson(netlistJson, machinePayload);
 
     if (debugMM)
     {
-        serializeJsonPretty(machineModeJson, Serial);
+        serializeJsonPretty(netlistJson, Serial);
         Serial.println("\n\n\n");
     }
 
@@ -314,15 +1172,15 @@ void machineNetlistToNetstruct(void)
 
         int nodesIndex = 0;
 
-        if (machineModeJson[i].isNull() == true)
+        if (netlistJson[i].isNull() == true)
         {
             continue;
             // break;
         }
         //netIndex++;
-         netIndex = machineModeJson[i]["index"];
+         netIndex = netlistJson[i]["index"];
 
-        strcpy(names[i], machineModeJson[i]["name"]);
+        strcpy(names[i], netlistJson[i]["name"]);
 
         net[netIndex].name = names[i];
 
@@ -332,16 +1190,16 @@ void machineNetlistToNetstruct(void)
             Serial.println(net[netIndex].name);
         }
 
-        if (machineModeJson[i]["number"].isNull() == false) // makes number an optional value
+        if (netlistJson[i]["number"].isNull() == false) // makes number an optional value
         {
-            net[netIndex].number = machineModeJson[i]["number"];
+            net[netIndex].number = netlistJson[i]["number"];
         }
         else
         {
             net[netIndex].number = netIndex;
         }
 
-        uint32_t rawColor = (uint32_t)removeHexPrefix(machineModeJson[i]["color"]);
+        uint32_t rawColor = (uint32_t)removeHexPrefix(netlistJson[i]["color"]);
 
         if (debugMM)
         {
@@ -383,7 +1241,7 @@ void machineNetlistToNetstruct(void)
 
         char nodesChar[300];
 
-        serializeJson(machineModeJson[i]["nodes"], nodesChar);
+        serializeJson(netlistJson[i]["nodes"], nodesChar);
 
         if (debugMM)
             Serial.println(nodeTokens[0]);
@@ -431,11 +1289,12 @@ void machineNetlistToNetstruct(void)
         if (debugMM)
             Serial.println("\n");
     }
+    rebuildNetIndex();
 
     // clearLEDs();
     // assignNetColors();
     // showNets();
-    // sendAllPathsCore2 = 1;
+    // queueSendPaths(1);
 }
 
 void populateBridgesFromNodes(void)
@@ -505,6 +1364,7 @@ void populateBridgesFromNodes(void)
             // newBridgeLength++;
         }
     }
+    rebuildNetIndex();
 }
 
 int removeHexPrefix(const char *str)
@@ -555,6 +1415,169 @@ int nodeTokenToInt(char *nodeToken)
     // return -1; // Return -1 if no matching name is found
 }
 
+static void batchBridgeToken(char *token)
+{
+    int remove = 0;
+
+    if (token[0] == '-')
+    {
+        remove = 1;
+        token++;
+    }
+    else if (token[0] == '+')
+    {
+        token++;
+    }
+    if (token[0] == '\0')
+    {
+        return;
+    }
+
+    int node1 = 0;
+    int node2 = -1;
+    char *dash = strchr(token, '-');
+
+    if (dash != NULL)
+    {
+        *dash = '\0';
+        node2 = strlen(dash + 1) < 20 ? nodeTokenToInt(dash + 1) : 0;
+    }
+    else if (remove == 0)
+    {
+        node2 = 0; // a lone node can only be removed
+    }
+    node1 = strlen(token) < 20 ? nodeTokenToInt(token) : 0;
+
+    batchBridge(node1, node2, remove);
+}
+
+// bridgebatch[+1-2,+D2-GND,-5-10] adds and removes everything in one file
+// write and one routing pass, then replies with how each bridge went
+// ::bridgebatch[1-2:ok,D2-GND:ok,5-10:notfound]
+int applyBridgeBatchFromPayload(void)
+{
+    char *start = strchr(machinePayload, '[');
+
+    if (start == NULL)
+    {
+        return -1;
+    }
+
+    beginBridgeBatch();
+
+    char token[40];
+    int tokenIndex = 0;
+
+    for (char *c = start + 1;; c++)
+    {
+        if (*c == ',' || *c == ']' || *c == '\0')
+        {
+            token[tokenIndex] = '\0';
+            batchBridgeToken(token);
+            tokenIndex = 0;
+
+            if (*c != ',')
+            {
+                break;
+            }
+            continue;
+        }
+        if (*c != ' ' && *c != '\n' && *c != '\r' && tokenIndex < 39)
+        {
+            token[tokenIndex++] = *c;
+        }
+    }
+
+    commitBridgeBatch(1);
+    return bridgeBatchCount;
+}
+
+void bridgeBatchFromInputBuffer(void)
+{
+    if (applyBridgeBatchFromPayload() < 0)
+    {
+        return;
+    }
+
+    Serial.print("::bridgebatch[");
+    for (int i = 0; i < bridgeBatchCount; i++)
+    {
+        if (i > 0)
+        {
+            Serial.print(",");
+        }
+        printNodeOrName(bridgeBatch[i].node1, 1);
+        if (bridgeBatch[i].node2 != -1)
+        {
+            Serial.print("-");
+            printNodeOrName(bridgeBatch[i].node2, 1);
+        }
+        Serial.print(":");
+        Serial.print(bridgeBatchResultName(bridgeBatch[i].result));
+    }
+    Serial.println("]");
+}
+
+/// @brief ::wave[dac,shape,frequency,amplitude,offset], everything after the
+/// shape is optional and keeps its current value, shape "off" stops the DAC
+int applyWaveFromPayload(void)
+{
+    char *token[5] = {NULL};
+
+    token[0] = strtok(machinePayload, ",:[] \"");
+    for (int i = 1; i < 5 && token[i - 1] != NULL; i++)
+    {
+        token[i] = strtok(NULL, ",:[] \"");
+    }
+
+    if (token[0] == NULL || token[1] == NULL)
+    {
+        return -1;
+    }
+
+    int dac = atoi(token[0]);
+    int shape = waveShapeFromName(token[1]);
+
+    if (dac < 0 || dac >= WAVE_CHANNELS || shape < 0)
+    {
+        return -1;
+    }
+
+    if (shape == WAVE_OFF)
+    {
+        stopWaveform(dac);
+        return 0;
+    }
+
+    float frequency = token[2] != NULL ? atof(token[2]) : waveFrequency(dac);
+    float amplitude = token[3] != NULL ? atof(token[3]) : waveAmplitude(dac);
+    float offset = token[4] != NULL ? atof(token[4]) : waveOffset(dac);
+
+    return startWaveform(dac, shape, frequency, amplitude, offset);
+}
+
+void waveFromInputBuffer(void)
+{
+    Serial.print("::wave[");
+    for (int i = 0; i < WAVE_CHANNELS; i++)
+    {
+        if (i > 0)
+        {
+            Serial.print(",");
+        }
+        Serial.print(i);
+        Serial.print(":");
+        Serial.print(waveShapeName(waveShapeOf(i)));
+        Serial.print(":");
+        Serial.print(waveFrequency(i));
+        Serial.print(":");
+        Serial.print(waveAmplitude(i));
+        Serial.print(":");
+        Serial.print(waveOffset(i));
+    }
+    Serial.println("]");
+}
+
 void writeNodeFileFromInputBuffer(void)
 {
     LittleFS.remove("nodeFile.txt");
@@ -575,18 +1598,18 @@ void writeNodeFileFromInputBuffer(void)
     }
     // nodeFile.print("{\n\r");
 
-    int inputBufferIndex = 0;
+    int machinePayloadIndex = 0;
 
-    for (int i = 0; i < INPUTBUFFERLENGTH; i++)
+    for (int i = 0;; i++)
     {
-        if (inputBuffer[i] == '\0')
+        if (machinePayload[i] == '\0')
         {
             break;
         }
 
-        if (inputBuffer[i] == ']')
+        if (machinePayload[i] == ']')
         {
-            if (inputBuffer[i - 1] != ',')
+            if (machinePayload[i - 1] != ',')
             {
                 nodeFileMachineMode.print(",]");
             }
@@ -596,7 +1619,7 @@ void writeNodeFileFromInputBuffer(void)
             }
             break;
         }
-        nodeFileMachineMode.print(inputBuffer[i]);
+        nodeFileMachineMode.print(machinePayload[i]);
     }
 
     // nodeFile.print("}\n\r");
@@ -619,7 +1642,7 @@ void writeNodeFileFromInputBuffer(void)
 
 void lightUpNodesFromInputBuffer(void)
 {
-    char *bufferPtr = inputBuffer;
+    char *bufferPtr = machinePayload;
     char *token[50];
 
     token[0] = strtok(bufferPtr, ",:[] ");
@@ -679,7 +1702,7 @@ int setSupplySwitch(void)
     const char *supplySwitchPositionString[] = {"3.3V", "3V3", "+3.3V", "+3V3", "5V", "+5V", "+-8V", "8V"};
     int supplySwitchPositionInt[] = {0, 0, 0, 0, 1, 1, 2, 2};
     int supplySwitch = 1;
-    token[0] = strtok(inputBuffer, ",:[] \"");
+    token[0] = strtok(machinePayload, ",:[] \"");
 
     // Serial.println(token[0]);
 
@@ -704,7 +1727,7 @@ void lightUpNetsFromInputBuffer(void)
     int notReallyNetsInt[] = {0, 0, 0, 3, 3, 4, 1, 1, 2, 2}; // these correspond to an index in rawOtherColors[]
     char *token[50];
 
-    token[0] = strtok(inputBuffer, ",:[] ");
+    token[0] = strtok(machinePayload, ",:[] ");
 
     int numTokens = 0;
 
@@ -727,7 +1750,7 @@ void lightUpNetsFromInputBuffer(void)
 
     //     for (int i = 0; i < INPUTBUFFERLENGTH-1; i++)
     // {
-    //         inputBuffer[i] = '\0';
+    //         machinePayload[i] = '\0';
     // }
 
     uint32_t color = (uint32_t)removeHexPrefix(token[numTokens]);
@@ -829,15 +1852,15 @@ void lightUpNetsFromInputBuffer(void)
             Serial.print("].name = ");
             Serial.println(net[1].name);
 
-            Serial.print("inputBuffer = ");
-            Serial.println(inputBuffer);
+            Serial.print("machinePayload = ");
+            Serial.println(machinePayload);
         }
-        //     Serial.print("inputBufferCopy = ");
-        //     Serial.println(inputBufferCopy);
+        //     Serial.print("machinePayloadCopy = ");
+        //     Serial.println(machinePayloadCopy);
 
         // for (int i = 0; i < INPUTBUFFERLENGTH-1; i++)
         //  {
-        //          inputBuffer[i] = '\0';
+        //          machinePayload[i] = '\0';
         //  }
 
         // lightUpNode(nodesToPixelMap[nodeNumber], color);
@@ -2,7 +2,9 @@
 #ifndef MACHINECOMMANDS_H
 #define MACHINECOMMANDS_H
 
-#define NUMBEROFINSTRUCTIONS 18
+#include <stdint.h>
+
+#define NUMBEROFINSTRUCTIONS 19
 
 enum machineModeInstruction
 {
@@ -22,13 +24,100 @@ enum machineModeInstruction
     setsupplyswitch,
     getsupplyswitch,
     getchipstatus,
-    getunconnectedpaths
+    getunconnectedpaths,
+    bridgebatch,
+    wave
+};
+
+#define MACHINE_HASH_SLOTS 64
+#define MACHINE_MAX_PAYLOAD 65536
+#define MACHINE_PARSER_TIMEOUT 2000 // ms without a byte before a half command is dropped
+
+#define MACHINE_FRAME_SYNC 0xA5
+#define MACHINE_FRAME_HEADER 6 // op, flags, sequence (2), length (2)
+#define MACHINE_FRAME_REPLY 0x80
+#define FRAME_GETPATHS 0x20 // binary only, no text version
+
+enum machineFrameFlags
+{
+    FRAME_DELTA = 0x01,       // only records that changed since the last query
+    FRAME_RESET_DELTA = 0x02, // forget what was sent, this reply is complete
+    FRAME_UNCHANGED = 0x02    // (in replies) nothing changed, no records follow
+};
+
+enum machineFrameStatus
+{
+    FRAME_OK = 0,
+    FRAME_BAD_CRC,
+    FRAME_UNKNOWN,
+    FRAME_TOO_LONG,
+    FRAME_FAILED,
+    FRAME_TIMEOUT
+};
+
+enum machineParserState
+{
+    MP_IDLE = 0,
+    MP_COLON,
+    MP_NAME,
+    MP_SEQUENCE,
+    MP_PAYLOAD,
+    MP_FRAME_HEADER,
+    MP_FRAME_PAYLOAD,
+    MP_FRAME_CRC
+};
+
+/// @brief Where the streaming parser is in the current ::name:seq[payload]
+struct machineParser
+{
+    enum machineParserState state;
+    char name[24];
+    int nameLength;
+    int sequenceNumber;
+    int payloadLength;
+    int depth;
+    bool inString;
+    bool escaped;
+    bool overflowed;
+    unsigned long lastByteMillis;
+    uint8_t header[MACHINE_FRAME_HEADER];
+    int headerLength;
+    int frameLength;
+    int frameReceived;
+    uint16_t frameCrc;
+    int crcLength;
+};
+
+struct machineParserStats
+{
+    unsigned long commands;
+    unsigned long unknown;
+    unsigned long overflows;
+    unsigned long timeouts;
+    unsigned long maxPayload;
+    unsigned long maxDispatchMicros;
+    unsigned long long bytes;
+    unsigned long framesIn;
+    unsigned long framesOut;
+    unsigned long badCrc;
+    unsigned long long frameBytesOut;
 };
 
-extern char inputBuffer[100];
+extern char *machinePayload;
+extern struct machineParserStats machineStats;
 extern char machineModeInstructionString[NUMBEROFINSTRUCTIONS][20];
 
-enum machineModeInstruction parseMachineInstructions(int *sequenceNumber);
+void machineMode(void);
+void beginMachineCommand(void);
+void beginMachineFrame(void);
+void sendMachineFrame(uint8_t op, uint8_t status, uint16_t sequenceNumber);
+uint16_t crc16Ccitt(uint16_t crc, const uint8_t *data, int length);
+int feedMachineParser(char c);
+int serviceMachineMode(void);
+bool machineParserActive(void);
+enum machineModeInstruction lookupMachineInstruction(const char *name);
+void runMachineInstruction(enum machineModeInstruction instruction, int sequenceNumber);
+void printMachineParserStats(void);
 void machineModeRespond(int sequenceNumber, bool ok);
 void getUnconnectedPaths(void);
 void machineNetlistToNetstruct(void);
@@ -40,6 +129,12 @@ int removeHexPrefix(const char *);
 void populateBridgesFromNodes(void);
 
 void writeNodeFileFromInputBuffer(void);
+void loadNetlistFromPayload(void);
+void loadBridgelistFromPayload(void);
+int applyBridgeBatchFromPayload(void);
+void bridgeBatchFromInputBuffer(void);
+int applyWaveFromPayload(void);
+void waveFromInputBuffer(void);
 
 void lightUpNodesFromInputBuffer(void);
 
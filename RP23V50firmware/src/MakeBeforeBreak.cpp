@@ -0,0 +1,222 @@
+// SPDX-License-Identifier: MIT
+#include "MakeBeforeBreak.h"
+
+#include <string.h>
+
+// Every node wire gets the label of the group it's in once the update is
+// done (its root in wantParent). A group of wires closed right now carries
+// the label its nodes share, MBB_NO_NODES if it's only lanes, or MBB_MIXED
+// if it still ties together nodes that are headed for different nets.
+#define MBB_NO_NODES -1
+#define MBB_MIXED -2
+
+static int16_t wantParent[MBB_WIRES];
+static int16_t nowParent[MBB_WIRES];
+static int16_t nowLabel[MBB_WIRES];
+static uint8_t sideMark[MBB_WIRES];
+
+static int findWire(int16_t *parent, int wire) {
+  while (parent[wire] != wire) {
+    parent[wire] = parent[parent[wire]];
+    wire = parent[wire];
+  }
+  return wire;
+}
+
+static int mergeLabels(int a, int b) {
+  if (a == MBB_NO_NODES) {
+    return b;
+  }
+  if (b == MBB_NO_NODES) {
+    return a;
+  }
+  return a == b ? a : MBB_MIXED;
+}
+
+static void joinNow(int a, int b) {
+  a = findWire(nowParent, a);
+  b = findWire(nowParent, b);
+  if (a != b) {
+    nowParent[b] = a;
+    nowLabel[a] = mergeLabels(nowLabel[a], nowLabel[b]);
+  }
+}
+
+static void groupWant(const struct mbbGraph *graph) {
+  for (int wire = 0; wire < MBB_WIRES; wire++) {
+    wantParent[wire] = wire;
+  }
+  for (int chip = 0; chip < MBB_CHIPS; chip++) {
+    for (int x = 0; x < 16; x++) {
+      for (int y = 0; y < 8; y++) {
+        if (graph->want[chip][x][y] != 0) {
+          int a = findWire(wantParent, graph->xWire[chip][x]);
+          int b = findWire(wantParent, graph->yWire[chip][y]);
+          if (a != b) {
+            wantParent[b] = a;
+          }
+        }
+      }
+    }
+  }
+}
+
+// groups what's closed now, leaving out skip (chip * 128 + x * 8 + y, -1
+// for none) to see what opening it would do
+static void groupNow(const struct mbbGraph *graph, int skip) {
+  for (int wire = 0; wire < MBB_WIRES; wire++) {
+    nowParent[wire] = wire;
+    nowLabel[wire] = wire >= MBB_NODE_WIRE_BASE ? findWire(wantParent, wire)
+                                                : MBB_NO_NODES;
+  }
+  for (int chip = 0; chip < MBB_CHIPS; chip++) {
+    for (int x = 0; x < 16; x++) {
+      for (int y = 0; y < 8; y++) {
+        if (graph->now[chip][x][y] != 0 && chip * 128 + x * 8 + y != skip) {
+          joinNow(graph->xWire[chip][x], graph->yWire[chip][y]);
+        }
+      }
+    }
+  }
+}
+
+// closing it only ties nodes to nodes they'll end up with anyway
+static bool additionSafe(const struct mbbGraph *graph, int chip, int x,
+                         int y) {
+  int a = findWire(nowParent, graph->xWire[chip][x]);
+  int b = findWire(nowParent, graph->yWire[chip][y]);
+  if (a == b) {
+    return true;
+  }
+  int labelA = nowLabel[a];
+  int labelB = nowLabel[b];
+  return labelA == MBB_NO_NODES || labelB == MBB_NO_NODES ||
+         (labelA == labelB && labelA != MBB_MIXED);
+}
+
+// opening it doesn't split up nodes that'll end up together
+static bool removalSafe(const struct mbbGraph *graph, int crosspoint) {
+  int chip = crosspoint / 128;
+  int x = (crosspoint / 8) % 16;
+  int y = crosspoint % 8;
+
+  groupNow(graph, crosspoint);
+  int a = findWire(nowParent, graph->xWire[chip][x]);
+  int b = findWire(nowParent, graph->yWire[chip][y]);
+  if (a == b) {
+    return true; // still joined some other way
+  }
+
+  memset(sideMark, 0, sizeof(sideMark));
+  for (int wire = MBB_NODE_WIRE_BASE; wire < MBB_WIRES; wire++) {
+    if (findWire(nowParent, wire) == a) {
+      sideMark[findWire(wantParent, wire)] = 1;
+    }
+  }
+  for (int wire = MBB_NODE_WIRE_BASE; wire < MBB_WIRES; wire++) {
+    if (findWire(nowParent, wire) == b &&
+        sideMark[findWire(wantParent, wire)] != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void sendCrosspoint(struct mbbGraph *graph, mbbSendFn send,
+                           int crosspoint, int setOrClear) {
+  int chip = crosspoint / 128;
+  int x = (crosspoint / 8) % 16;
+  int y = crosspoint % 8;
+  send(chip, x, y, setOrClear);
+  graph->now[chip][x][y] = setOrClear;
+}
+
+void makeBeforeBreak(struct mbbGraph *graph, mbbSendFn send,
+                     struct mbbCounts *counts) {
+  static int16_t additions[MBB_CHIPS * 128];
+  static int16_t removals[MBB_CHIPS * 128];
+  int additionCount = 0;
+  int removalCount = 0;
+
+  for (int crosspoint = 0; crosspoint < MBB_CHIPS * 128; crosspoint++) {
+    int chip = crosspoint / 128;
+    int x = (crosspoint / 8) % 16;
+    int y = crosspoint % 8;
+    if (graph->want[chip][x][y] != 0 && graph->now[chip][x][y] == 0) {
+      additions[additionCount++] = crosspoint;
+    } else if (graph->want[chip][x][y] == 0 && graph->now[chip][x][y] != 0) {
+      removals[removalCount++] = crosspoint;
+    }
+  }
+  if (additionCount == 0 && removalCount == 0) {
+    return;
+  }
+  groupWant(graph);
+
+  bool cleared = false;
+  bool firstPass = true;
+
+  while (additionCount > 0 || removalCount > 0) {
+    bool progress = false;
+
+    // make: everything that only extends a net or joins it to free lanes
+    groupNow(graph, -1);
+    int kept = 0;
+    for (int i = 0; i < additionCount; i++) {
+      int crosspoint = additions[i];
+      int chip = crosspoint / 128;
+      int x = (crosspoint / 8) % 16;
+      int y = crosspoint % 8;
+      if (additionSafe(graph, chip, x, y) == false) {
+        additions[kept++] = crosspoint;
+        continue;
+      }
+      sendCrosspoint(graph, send, crosspoint, 1);
+      joinNow(graph->xWire[chip][x], graph->yWire[chip][y]);
+      if (cleared == true) {
+        counts->deferred++;
+      } else {
+        counts->early++;
+      }
+      progress = true;
+    }
+    additionCount = kept;
+
+    // break: everything whose nodes are held together some other way now
+    kept = 0;
+    for (int i = 0; i < removalCount; i++) {
+      int crosspoint = removals[i];
+      if (removalSafe(graph, crosspoint) == false) {
+        if (firstPass == true) {
+          counts->held++;
+        }
+        removals[kept++] = crosspoint;
+        continue;
+      }
+      sendCrosspoint(graph, send, crosspoint, 0);
+      cleared = true;
+      progress = true;
+    }
+    removalCount = kept;
+    firstPass = false;
+
+    if (progress == true) {
+      continue;
+    }
+    if (removalCount > 0) {
+      // two nets each waiting on the other's lane, one has to open briefly
+      sendCrosspoint(graph, send, removals[0], 0);
+      cleared = true;
+      counts->forced++;
+      removalCount--;
+      memmove(removals, removals + 1, removalCount * sizeof(removals[0]));
+    } else {
+      // only additions left, everything closed is wanted so they're all safe
+      for (int i = 0; i < additionCount; i++) {
+        sendCrosspoint(graph, send, additions[i], 1);
+        counts->deferred++;
+      }
+      additionCount = 0;
+    }
+  }
+}
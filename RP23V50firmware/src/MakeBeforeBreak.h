@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: MIT
+#ifndef MAKEBEFOREBREAK_H
+#define MAKEBEFOREBREAK_H
+
+#include <stdint.h>
+
+#define MBB_CHIPS 12
+#define MBB_NODE_WIRE_BASE (12 * 24) // WIRE_LINE_COUNT, node n is wire base + n
+#define MBB_WIRES (MBB_NODE_WIRE_BASE + 256)
+
+/// @brief The crosspoints as wires (see mapCrosspointWires()), what's closed
+/// now and what should be closed when the update is done
+struct mbbGraph {
+  int16_t xWire[MBB_CHIPS][16];
+  int16_t yWire[MBB_CHIPS][8];
+  uint8_t now[MBB_CHIPS][16][8]; // follows every word makeBeforeBreak() sends
+  uint8_t want[MBB_CHIPS][16][8];
+};
+
+struct mbbCounts {
+  unsigned long early;    // additions sent before anything was cleared
+  unsigned long deferred; // additions that had to wait for a removal
+  unsigned long held;     // removals that had to wait for an addition
+  unsigned long forced;   // removals sent anyway to break a standoff
+};
+
+typedef void (*mbbSendFn)(int chip, int x, int y, int setOrClear);
+
+//! Portable: only needs this header, so the ordering can be checked against
+//! made up crosspoint states on a PC
+
+/// @brief Sends the words to get from graph->now to graph->want so that two
+/// nodes are never connected unless they are before or after the update, and
+/// nodes that are connected before and after stay connected the whole time.
+/// An addition waits until it can't join a node to another net, a removal
+/// waits until the nodes it would cut off are joined some other way. If
+/// neither can go (two nets swapping lanes), the first waiting removal is
+/// sent anyway and counted in forced, that's the only time a net opens.
+void makeBeforeBreak(struct mbbGraph *graph, mbbSendFn send,
+                     struct mbbCounts *counts);
+
+#endif
@@ -563,6 +563,113 @@ void initChipStatus(void) {
     //#if PROTOTYPE_VERSION > 4
 
     }
+  mapCrosspointWires();
+  }
+
+// Every X and Y line gets a wire number so we can tell which crosspoints
+// are electrically joined. Lanes between two chips are the same wire on both
+// ends, and lines that go straight to a node (rows, rails, nano pins) use
+// the node number, so two chips landing on GND share a wire too.
+static int16_t xWire[12][16];
+static int16_t yWire[12][8];
+static bool wiresMapped = false;
+
+static int lineWire(int chip, int isY, int line) {
+  return chip * 24 + isY * 16 + line;
+  }
+
+static int nodeWire(int chip, int isY, int line, int node) {
+  if (node >= 0 && node < 256) {
+    return WIRE_LINE_COUNT + node;
+    }
+  return lineWire(chip, isY, line);
+  }
+
+// which of the lanes from chip to ch[chip].xMap[x] this is, chips A-H
+// have 2 lanes to each other so the nth lane on one end is the nth on the other
+static int laneRank(int chip, int x) {
+  int rank = 0;
+  for (int i = 0; i < x; i++) {
+    if (ch[chip].xMap[i] == ch[chip].xMap[x]) {
+      rank++;
+      }
+    }
+  return rank;
+  }
+
+static int nthLaneTo(int chip, int toChip, int rank) {
+  for (int i = 0; i < 16; i++) {
+    if (ch[chip].xMap[i] == toChip) {
+      if (rank == 0) {
+        return i;
+        }
+      rank--;
+      }
+    }
+  return -1;
+  }
+
+void mapCrosspointWires(void) {
+  for (int chip = 0; chip < 12; chip++) {
+    for (int x = 0; x < 16; x++) {
+      int to = ch[chip].xMap[x];
+      int wire = lineWire(chip, 0, x);
+
+      if (to >= CHIP_A && to <= CHIP_L) {
+        int peer = -1;
+        if (chip <= CHIP_H && to >= CHIP_I) {
+          // breadboard chip X lanes land on the special function chips' Y lines
+          for (int y = 0; y < 8; y++) {
+            if (ch[to].yMap[y] == chip) {
+              peer = lineWire(to, 1, y);
+              break;
+              }
+            }
+          } else {
+          int peerX = nthLaneTo(to, chip, laneRank(chip, x));
+          if (peerX >= 0) {
+            peer = lineWire(to, 0, peerX);
+            }
+          }
+        if (peer >= 0 && peer < wire) {
+          wire = peer;
+          }
+        } else {
+        wire = nodeWire(chip, 0, x, to);
+        }
+      xWire[chip][x] = wire;
+      }
+
+    for (int y = 0; y < 8; y++) {
+      int to = ch[chip].yMap[y];
+      int wire = lineWire(chip, 1, y);
+
+      if (chip >= CHIP_I) {
+        int peerX = nthLaneTo(to, chip, 0);
+        if (peerX >= 0 && lineWire(to, 0, peerX) < wire) {
+          wire = lineWire(to, 0, peerX);
+          }
+        } else if (to != BOUNCE_NODE) { // the bounce Y line doesn't leave the chip
+        wire = nodeWire(chip, 1, y, to);
+        }
+      yWire[chip][y] = wire;
+      }
+    }
+  wiresMapped = true;
+  }
+
+int xLineWire(int chip, int x) {
+  if (wiresMapped == false) {
+    mapCrosspointWires();
+    }
+  return xWire[chip][x];
+  }
+
+int yLineWire(int chip, int y) {
+  if (wiresMapped == false) {
+    mapCrosspointWires();
+    }
+  return yWire[chip][y];
   }
 
 
@@ -138,6 +138,15 @@ extern struct justXY justXY[MAX_BRIDGES];
 extern struct chipStatus ch[12];
 
 void initChipStatus(void);
+
+// every X/Y line on the crosspoints belongs to a wire, lanes between chips
+// are one wire and lines that go to the same node share the node's wire
+#define WIRE_LINE_COUNT (12 * 24)
+#define WIRE_COUNT (WIRE_LINE_COUNT + 256)
+
+void mapCrosspointWires(void); //call if the xMap/yMap change
+int xLineWire(int chip, int x);
+int yLineWire(int chip, int y);
 struct nanoStatus {  //there's only one of these so ill declare and initalize together unlike above
 
 //all these arrays should line up (both by index and visually) so one index will give you all this data
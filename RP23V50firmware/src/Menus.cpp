@@ -361,7 +361,7 @@ int clickMenu(int menuType, int menuOption, int extraOptions) {
       returnedMenuPosition = getMenuSelection();
       }
     if (returnedMenuPosition == -2) {
-      showLEDsCore2 = 1;
+      queueShowLEDs(1);
       inClickMenu = 0;
 
       oled.showJogo32h();
@@ -369,7 +369,7 @@ int clickMenu(int menuType, int menuOption, int extraOptions) {
       return -2;
       }
 
-    // showLEDsCore2 = 1;
+    // queueShowLEDs(1);
 
    //Serial.print("returnedMenuPosition: ");
     // Serial.println(returnedMenuPosition);
@@ -560,7 +560,7 @@ int getMenuSelection(void) {
   clearAction();
 
   clearLEDsExceptRails();
-  showLEDsCore2 = -2;
+  queueShowLEDs(-2);
   waitCore2();
   // delay(100);
   if (returnToMenuPosition != -1 && returnToMenuLevel != -1) {
@@ -782,7 +782,7 @@ int getMenuSelection(void) {
           if (menuLevel != lastMenuLevel) {
             // Serial.println();
             }
-          showLEDsCore2 = 2;
+          queueShowLEDs(2);
           lastMenuLevel = menuLevel;
           // previousMenuSelection[menuLevel] = menuPosition;
           //  b.print(menuPosition);
@@ -1010,7 +1010,7 @@ int getMenuSelection(void) {
                   }
                 }
 
-              showLEDsCore2 = 2;
+              queueShowLEDs(2);
               lastMenuLevel = menuLevel;
               // previousMenuSelection[menuLevel] = menuPosition;
 
@@ -1723,10 +1723,10 @@ int selectSubmenuOption(int menuPosition, int menuLevel) {
                                          nodeSelectionColorsHeader[highlightedOption]);
                       b.print(subMenuStrings[highlightedOption].c_str(),
                               nodeSelectionColors[highlightedOption], 0xFFFFFD, 3, 1, -1, 0);
-                      showLEDsCore2 = 1;
+                      queueShowLEDs(1);
                       // inClickMenu = 1;
                     }
-                  showLEDsCore2 = 2;
+                  queueShowLEDs(2);
 
                   changed = 0;
             }
@@ -1841,7 +1841,7 @@ int yesNoMenu(unsigned long timeout)
             }
 
 
-            showLEDsCore2 = 2;
+            queueShowLEDs(2);
 
             changed = 0;
           }
@@ -1857,7 +1857,7 @@ int yesNoMenu(unsigned long timeout)
 
 int selectNodeAction(int whichSelection) {
   b.clear();
-  showLEDsCore2 = -1;
+  queueShowLEDs(-1);
   // delayMicroseconds(100000);
 
   int nodeSelected = -1;
@@ -1939,7 +1939,7 @@ int selectNodeAction(int whichSelection) {
   //     leds.setPixelColor(((i+30) * 5) + 3, nodeSelectionColorsHeader[i]);
   //     leds.setPixelColor(((i+30) * 5) + 4, nodeSelectionColorsHeader[i]);
   //   }
-  //   showLEDsCore2 = 3;
+  //   queueShowLEDs(3);
   // }
 
   while (nodeSelected == -1 && Serial.available() == 0) {
@@ -2104,7 +2104,7 @@ int selectNodeAction(int whichSelection) {
 
       b.clear();
       showNets();
-      showLEDsCore2 = 2;
+      queueShowLEDs(2);
 
       if (inNanoHeader == 1) {
 
@@ -2170,7 +2170,7 @@ int selectNodeAction(int whichSelection) {
         }
       // Serial.print("\r                        \r");
       // Serial.print(highlightedNode + 1);
-      showLEDsCore2 = 2;
+      queueShowLEDs(2);
       // leds.show();
 
       } else if (encoderButtonState == RELEASED &&
@@ -2387,7 +2387,7 @@ float getActionFloat(int menuPosition, int rail) {
                                     }
                                   }
                                 }
-                              showLEDsCore2 = 2;
+                              queueShowLEDs(2);
 
 
                               firstTime = 0;
@@ -2502,7 +2502,7 @@ float getActionFloat(int menuPosition, int rail) {
                                   }
 
 
-                                showLEDsCore2 = 2;
+                                queueShowLEDs(2);
             } else if (encoderButtonState == RELEASED &&
                        lastButtonEncoderState == PRESSED) {
             encoderButtonState = IDLE;
@@ -2585,7 +2585,7 @@ int doMenuAction(int menuPosition, int selection) {
   populateAction();
   printActionStruct();
   clearLEDsExceptRails();
-  showLEDsCore2 = -1;
+  queueShowLEDs(-1);
   actionCategories currentCategory = getActionCategory();
 
 
@@ -2707,7 +2707,7 @@ int doMenuAction(int menuPosition, int selection) {
 
         // showSavedColors(netSlot);
         // sendPaths();
-        // sendAllPathsCore2 = 1;
+        // queueSendPaths(1);
         // chooseShownReadings();
 
         refreshConnections();
@@ -2720,7 +2720,7 @@ int doMenuAction(int menuPosition, int selection) {
     } else if (currentCategory == RAILSACTION) { //!Rails
 
       Serial.print("Rails Action\n\r");
-      showLEDsCore2 = 1;
+      queueShowLEDs(1);
       waitCore2();
 
       switch (currentAction.from[0]) {
@@ -2777,7 +2777,7 @@ int doMenuAction(int menuPosition, int selection) {
               createSlots(currentAction.from[0], 0);
               refreshConnections();
 
-              //  sendAllPathsCore2 = 1;
+              //  queueSendPaths(1);
               chooseShownReadings();
               return 10;
               }
@@ -2951,7 +2951,7 @@ int doMenuAction(int menuPosition, int selection) {
 
             // showSavedColors(netSlot);
             // sendPaths();
-            // sendAllPathsCore2 = 1;
+            // queueSendPaths(1);
             // chooseShownReadings();
 
             // slotChanged = 0;
@@ -2961,7 +2961,7 @@ int doMenuAction(int menuPosition, int selection) {
             for (int i = 0; i < NUM_APPS; i++) {
               if (menuLines[currentAction.previousMenuPositions[1]].indexOf(apps[i].name) != -1) {
                 runApp(apps[i].index, apps[i].name);
-                //showLEDsCore2 = -1;
+                //queueShowLEDs(-1);
                 refreshConnections(-1, 0);
                 break;
                 }
@@ -3073,7 +3073,7 @@ int doMenuAction(int menuPosition, int selection) {
 
                               saveLEDbrightness(0);
                               showNets();
-                              showLEDsCore2 = 2;
+                              queueShowLEDs(2);
                         } else if (menuLines[currentAction.previousMenuPositions[1]].indexOf(
                           "DEFCON") != -1) {
 
@@ -3147,7 +3147,7 @@ int doMenuAction(int menuPosition, int selection) {
                           } else if (menuLines[currentAction.previousMenuPositions[1]].indexOf("Connect") != -1) {
                           if (oled.checkConnection() == 0) {
                               jumperlessConfig.top_oled.enabled = 1;
-                              showLEDsCore2 = 1;
+                              queueShowLEDs(1);
                               oled.init();
                               oled.clear();
                               oled.setTextSize(1);
@@ -3365,7 +3365,7 @@ char LEDbrightnessMenu(void) {
               //Serial.print("\n\r");
               Serial.flush();
 
-              showLEDsCore2 = 2;
+              queueShowLEDs(2);
               } else if (input2 == '-') {
                 LEDbrightness -= 1;
 
@@ -3379,7 +3379,7 @@ char LEDbrightnessMenu(void) {
                 //Serial.print("\n\r");
                 Serial.flush();
 
-                showLEDsCore2 = 2;
+                queueShowLEDs(2);
                 } else if (input2 == 'x' || input2 == ' ' || input2 == 'm') {
                   input = ' ';
                   } else {
@@ -3389,7 +3389,7 @@ char LEDbrightnessMenu(void) {
                 // for (int i = 8; i <= numberOfNets; i++) {
                 //   lightUpNet(i, -1, 1, LEDbrightness, 0);
                 // }
-                showLEDsCore2 = 1;
+                queueShowLEDs(1);
 
                 if (Serial.available() == 0) {
                   Serial.print("\r                            \r");
@@ -3426,7 +3426,7 @@ char LEDbrightnessMenu(void) {
                 //Serial.print("\n\r");
                 Serial.flush();
 
-                showLEDsCore2 = 2;
+                queueShowLEDs(2);
                 } else if (input2 == '-' || input2 == '_') {
 
                   LEDbrightnessRail -= 1;
@@ -3441,7 +3441,7 @@ char LEDbrightnessMenu(void) {
                   //Serial.print("\n\r");
                   Serial.flush();
 
-                  showLEDsCore2 = 2;
+                  queueShowLEDs(2);
                   } else if (input2 == 'x' || input2 == ' ' || input2 == 'm') {
                     input = ' ';
                     saveLEDbrightness(0);
@@ -3480,7 +3480,7 @@ char LEDbrightnessMenu(void) {
               b.print("s", menuColors[2], 0xffffff, 3, 1, 2);
               b.print("s", menuColors[0], 0xffffff, 4, 1, 2);
 
-              showLEDsCore2 = 2;
+              queueShowLEDs(2);
               while (input == 'h') {
 
                 while (Serial.available() == 0)
@@ -3506,7 +3506,7 @@ char LEDbrightnessMenu(void) {
                   b.print("s", menuColors[2], 0xffffff, 3, 1, 2);
                   b.print("s", menuColors[0], 0xffffff, 4, 1, 2);
 
-                  showLEDsCore2 = 2;
+                  queueShowLEDs(2);
                   } else if (input2 == '-') {
 
                     menuBrightnessSetting -= 5;
@@ -3526,7 +3526,7 @@ char LEDbrightnessMenu(void) {
                     b.print("s", menuColors[2], 0xffffff, 3, 1, 2);
                     b.print("s", menuColors[0], 0xffffff, 4, 1, 2);
 
-                    showLEDsCore2 = 2;
+                    queueShowLEDs(2);
                     } else if (input2 == 'x') {
                       input = ' ';
                       } else {
@@ -3560,7 +3560,7 @@ char LEDbrightnessMenu(void) {
                       LEDbrightnessSpecial = 200;
                       }
 
-                    // showLEDsCore2 = 2;
+                    // queueShowLEDs(2);
                     } else if (input2 == '-') {
 
                       LEDbrightnessSpecial -= 1;
@@ -3569,7 +3569,7 @@ char LEDbrightnessMenu(void) {
                         LEDbrightnessSpecial = 1;
                         }
 
-                      // showLEDsCore2 = 2;
+                      // queueShowLEDs(2);
                       } else if (input2 == 'x' || input2 == ' ' || input2 == 'm') {
                         input = ' ';
                         saveLEDbrightness(0);
@@ -3580,7 +3580,7 @@ char LEDbrightnessMenu(void) {
                       for (int i = 0; i < 8; i++) {
                         lightUpNet(i, -1, 1, LEDbrightnessSpecial, 0);
                         }
-                      showLEDsCore2 = 1;
+                      queueShowLEDs(1);
                       if (Serial.available() == 0) {
 
                         Serial.print("Special brightness:  ");
@@ -3622,7 +3622,7 @@ char LEDbrightnessMenu(void) {
                         LEDbrightnessSpecial = 200;
                         }
 
-                      showLEDsCore2 = 1;
+                      queueShowLEDs(1);
                       } else if (input2 == '-') {
 
                         LEDbrightness -= 1;
@@ -3639,7 +3639,7 @@ char LEDbrightnessMenu(void) {
                           LEDbrightnessSpecial = 1;
                           }
 
-                        showLEDsCore2 = 1;
+                        queueShowLEDs(1);
                         } else if (input2 == 'x' || input2 == ' ' || input2 == 'm' ||
                                    input2 == 'l') {
                         input = ' ';
@@ -3656,7 +3656,7 @@ char LEDbrightnessMenu(void) {
                         for (int i = 0; i < 6; i++) {
                           lightUpNet(i, -1, 1, LEDbrightnessSpecial, 0);
                           }
-                        showLEDsCore2 = 1;
+                        queueShowLEDs(1);
 
                         if (Serial.available() == 0) {
 
@@ -3689,7 +3689,7 @@ char LEDbrightnessMenu(void) {
                       //  delay(100);
 
                      // clearLEDsExceptRails();
-                      //showLEDsCore2 = 1;
+                      //queueShowLEDs(1);
 
                      // delay(2000);
                       // rainbowBounce(3);
@@ -3697,7 +3697,7 @@ char LEDbrightnessMenu(void) {
                     pauseCore2 = 0;
                     //showNets();
                     //lightUpRail(-1, -1, 1);
-                    showLEDsCore2 = -1;
+                    queueShowLEDs(-1);
 
                     input = '!'; // this tells the main fuction to reset the leds
                     } else if (input == 'c') {
@@ -3708,10 +3708,10 @@ char LEDbrightnessMenu(void) {
                         randomColors();
                         leds.show();
                         delayMicroseconds(random(500, 80000));
-                        showLEDsCore2 = -3;
+                        queueShowLEDs(-3);
                         }
                       pauseCore2 = 0;
-                      showLEDsCore2 = -1;
+                      queueShowLEDs(-1);
                       //delay(100);
                       input = '!';
                       } else if (input == 'p') {
@@ -3746,7 +3746,7 @@ char LEDbrightnessMenu(void) {
                           showLoss();
                           while (Serial.available() == 0) {
                             }
-                          showLEDsCore2 = -1;
+                          queueShowLEDs(-1);
                           return ' ';
                           } else {
                           saveLEDbrightness(0);
@@ -3763,7 +3763,7 @@ char LEDbrightnessMenu(void) {
 
 void showLoss(void) {
   b.clear();
-  showLEDsCore2 = -3;
+  queueShowLEDs(-3);
   uint32_t guyColor = 0x0a0a1a;
   uint32_t hairColor = 0x1a0902;
   uint32_t nurseColor = 0x1a0207;
@@ -16,6 +16,10 @@
 #include "Probing.h"
 //#include "SerialWrapper.h"
 #include "Highlighting.h"
+#include "CH446Q.h"
+#include "Commands.h"
+#include "FileParsing.h"
+#include <FatFS.h>
 
 ///#define Serial SerialWrap
 // Define a struct that holds both the long and short strings as well as the defined value
@@ -132,6 +136,246 @@ unsigned long timeToNM;
 bool debugNM = EEPROM.read(DEBUG_NETMANAGERADDRESS);
 bool debugNMtime = EEPROM.read(TIME_NETMANAGERADDRESS);
 
+// node -> net lookup and a hash set of bridges -> net, so building nets
+// doesn't walk all of net[] for every bridge. addNodeToNet(), addBridgeToNet()
+// and combineNets() keep them current, anything that writes net[] directly
+// needs to call rebuildNetIndex() after.
+#define NODE_INDEX_SIZE 256
+#define BRIDGE_SET_SIZE 512 // power of 2, keep it over 2x MAX_BRIDGES
+
+int8_t nodeNetIndex[NODE_INDEX_SIZE]; // lowest net the node is in
+int8_t nodeNetLast[NODE_INDEX_SIZE];  // highest, a node can be in 2 special nets
+uint32_t bridgeSetKeys[BRIDGE_SET_SIZE]; // 0 = empty
+int8_t bridgeSetNets[BRIDGE_SET_SIZE];
+bool netIndexEnabled = true; // false falls back to scanning net[], for benchmarkNetBuilding()
+
+static uint32_t bridgeKey(int node1, int node2) {
+  if (node1 <= 0 || node2 <= 0) {
+    return 0;
+    }
+  if (node1 > node2) {
+    int swap = node1;
+    node1 = node2;
+    node2 = swap;
+    }
+  return ((uint32_t)node1 << 16) | (uint32_t)node2;
+  }
+
+// slot holding key, or the empty slot where it would go
+static int bridgeSlot(uint32_t key) {
+  int slot = (key * 2654435761u) >> 23; // top 9 bits, BRIDGE_SET_SIZE
+  while (bridgeSetKeys[slot] != 0 && bridgeSetKeys[slot] != key) {
+    slot = (slot + 1) & (BRIDGE_SET_SIZE - 1);
+    }
+  return slot;
+  }
+
+// a node can end up in 2 of the special nets. findNodeInNet() wants the
+// lowest like its old scan from net 1 up, searchExistingNets() the highest
+// like its old scan did, so the index keeps both
+static void noteNodeInNet(int netNumber, int node) {
+  if (node <= 0 || node >= NODE_INDEX_SIZE) {
+    return;
+    }
+  if (nodeNetIndex[node] == 0 || nodeNetIndex[node] > netNumber) {
+    nodeNetIndex[node] = netNumber;
+    }
+  if (nodeNetLast[node] < netNumber) {
+    nodeNetLast[node] = netNumber;
+    }
+  }
+
+// bridges keep the lowest net they're in, same as a scan from net 1 up
+static void noteBridgeInNet(int netNumber, int node1, int node2) {
+  uint32_t key = bridgeKey(node1, node2);
+  if (key == 0) {
+    return;
+    }
+  int slot = bridgeSlot(key);
+  if (bridgeSetKeys[slot] == 0 || bridgeSetNets[slot] > netNumber) {
+    bridgeSetKeys[slot] = key;
+    bridgeSetNets[slot] = netNumber;
+    }
+  }
+
+void rebuildNetIndex(void) {
+  memset(nodeNetIndex, 0, sizeof(nodeNetIndex));
+  memset(nodeNetLast, 0, sizeof(nodeNetLast));
+  memset(bridgeSetKeys, 0, sizeof(bridgeSetKeys));
+
+  for (int i = 1; i < MAX_NETS; i++) {
+    if (net[i].number <= 0) {
+      break;
+      }
+    for (int j = 0; j < MAX_NODES; j++) {
+      if (net[i].nodes[j] <= 0) {
+        break;
+        }
+      noteNodeInNet(i, net[i].nodes[j]);
+      }
+    for (int j = 0; j < MAX_BRIDGES; j++) {
+      if (net[i].bridges[j][0] == 0) {
+        break;
+        }
+      noteBridgeInNet(i, net[i].bridges[j][0], net[i].bridges[j][1]);
+      }
+    }
+  }
+
+// the old way, still used for nodes outside the index
+static int scanNetsForNode(int node) {
+  int foundNet = 0;
+  for (int i = 1; i < MAX_NETS; i++) {
+    if (net[i].number <= 0) {
+      break;
+      }
+    for (int j = 0; j < MAX_NODES; j++) {
+      if (net[i].nodes[j] <= 0) {
+        break;
+        }
+      if (net[i].nodes[j] == node) {
+        foundNet = i;
+        }
+      }
+    }
+  return foundNet;
+  }
+
+/// @brief which net a node is in, the highest if it's in 2
+/// @return the net number, 0 if it isn't in one
+int netOfNode(int node) {
+  if (netIndexEnabled == true && node > 0 && node < NODE_INDEX_SIZE) {
+    return nodeNetLast[node];
+    }
+  return scanNetsForNode(node);
+  }
+
+/// @brief which net a node is in, the lowest if it's in 2
+/// @return the net number, 0 if it isn't in one
+int firstNetOfNode(int node) {
+  if (netIndexEnabled == true && node > 0 && node < NODE_INDEX_SIZE) {
+    return nodeNetIndex[node];
+    }
+  for (int i = 1; i < MAX_NETS; i++) {
+    if (net[i].number <= 0) {
+      break;
+      }
+    for (int j = 0; j < MAX_NODES; j++) {
+      if (net[i].nodes[j] <= 0) {
+        break;
+        }
+      if (net[i].nodes[j] == node) {
+        return i;
+        }
+      }
+    }
+  return 0;
+  }
+
+/// @brief which net has a bridge between node1 and node2 (either order)
+/// @return the net number, 0 if there's no such bridge
+int findBridgeNet(int node1, int node2) {
+  uint32_t key = bridgeKey(node1, node2);
+  if (key == 0) {
+    return 0;
+    }
+  if (netIndexEnabled == true) {
+    int slot = bridgeSlot(key);
+    return bridgeSetKeys[slot] == key ? bridgeSetNets[slot] : 0;
+    }
+  for (int i = 1; i < MAX_NETS; i++) {
+    if (net[i].number <= 0) {
+      break;
+      }
+    for (int j = 0; j < MAX_BRIDGES; j++) {
+      if (net[i].bridges[j][0] == 0) {
+        break;
+        }
+      if (bridgeKey(net[i].bridges[j][0], net[i].bridges[j][1]) == key) {
+        return i;
+        }
+      }
+    }
+  return 0;
+  }
+
+/// @brief drop a bridge from the bridge set after it's been taken out of net[]
+void forgetBridgeInNets(int node1, int node2) {
+  uint32_t key = bridgeKey(node1, node2);
+  if (key == 0) {
+    return;
+    }
+  int slot = bridgeSlot(key);
+  if (bridgeSetKeys[slot] != key) {
+    return;
+    }
+  bridgeSetKeys[slot] = 0;
+
+  // pull back anything after it in the run so lookups don't stop early
+  int next = (slot + 1) & (BRIDGE_SET_SIZE - 1);
+  while (bridgeSetKeys[next] != 0) {
+    uint32_t movedKey = bridgeSetKeys[next];
+    int8_t movedNet = bridgeSetNets[next];
+    bridgeSetKeys[next] = 0;
+    int newSlot = bridgeSlot(movedKey);
+    bridgeSetKeys[newSlot] = movedKey;
+    bridgeSetNets[newSlot] = movedNet;
+    next = (next + 1) & (BRIDGE_SET_SIZE - 1);
+    }
+  }
+
+// combineNets() moved everything from fromNet into intoNet
+static void mergeNetIndex(int fromNet, int intoNet) {
+  for (int i = 0; i < NODE_INDEX_SIZE; i++) {
+    if (nodeNetIndex[i] == fromNet) {
+      nodeNetIndex[i] = intoNet;
+      }
+    if (nodeNetLast[i] == fromNet) {
+      nodeNetLast[i] = intoNet;
+      }
+    if (nodeNetIndex[i] > nodeNetLast[i]) {
+      int8_t swap = nodeNetIndex[i];
+      nodeNetIndex[i] = nodeNetLast[i];
+      nodeNetLast[i] = swap;
+      }
+    }
+  for (int i = 0; i < BRIDGE_SET_SIZE; i++) {
+    if (bridgeSetKeys[i] != 0 && bridgeSetNets[i] == fromNet) {
+      bridgeSetNets[i] = intoNet;
+      }
+    }
+  }
+
+// shiftNets() moved every net above deletedNet down one, called after net[]
+// has been shifted
+static void shiftNetIndex(int deletedNet) {
+  bool stale = false;
+  for (int i = 0; i < NODE_INDEX_SIZE; i++) {
+    if (nodeNetIndex[i] == deletedNet || nodeNetLast[i] == deletedNet) {
+      stale = true;
+      }
+    if (nodeNetIndex[i] > deletedNet) {
+      nodeNetIndex[i]--;
+      }
+    if (nodeNetLast[i] > deletedNet) {
+      nodeNetLast[i]--;
+      }
+    }
+  for (int i = 0; i < BRIDGE_SET_SIZE; i++) {
+    if (bridgeSetKeys[i] == 0) {
+      continue;
+      }
+    if (bridgeSetNets[i] == deletedNet) {
+      stale = true;
+      } else if (bridgeSetNets[i] > deletedNet) {
+      bridgeSetNets[i]--;
+      }
+    }
+  if (stale == true) { // something was deleted without being merged first
+    rebuildNetIndex();
+    }
+  }
+
 void getNodesToConnect() // read in the nodes you'd like to connect
   {
 
@@ -191,55 +435,28 @@ int searchExistingNets(
   foundNode1inSpecialNet = node1;
   foundNode2inSpecialNet = node2;
 
-  for (int i = 1; i < MAX_NETS; i++) {
-    if (net[i].number <= 0) // stops searching if it gets to an unallocated net
-      {
-      break;
-      }
+  foundNode1Net = netOfNode(node1);
+  foundNode2Net = netOfNode(node2);
 
-    for (int j = 0; j < MAX_NODES; j++) {
-      if (net[i].nodes[j] <= 0) {
-        break;
-        }
-
-      if (net[i].nodes[j] == node1) {
-        if (i > 7) {
-          if (debugNM)
-            Serial.print("found Node ");
-          if (debugNM)
-            printNodeOrName(node1);
-          if (debugNM)
-            Serial.print(" in Net ");
-          if (debugNM)
-            Serial.println(i);
-          }
-
-        if (net[i].specialFunction > 0) {
-          foundNode1Net = i;
-          foundNode1inSpecialNet = i;
-          } else {
-          foundNode1Net = i;
-          }
-        }
-      if (net[i].nodes[j] == node2) {
-        if (i > 7) {
-          if (debugNM)
-            Serial.print("found Node ");
-          if (debugNM)
-            printNodeOrName(node2);
-          if (debugNM)
-            Serial.print(" in Net ");
-          if (debugNM)
-            Serial.println(i);
-          }
+  if (foundNode1Net > 0 && net[foundNode1Net].specialFunction > 0) {
+    foundNode1inSpecialNet = foundNode1Net;
+    }
+  if (foundNode2Net > 0 && net[foundNode2Net].specialFunction > 0) {
+    foundNode2inSpecialNet = foundNode2Net;
+    }
 
-        if (net[i].specialFunction > 0) {
-          foundNode2Net = i;
-          foundNode2inSpecialNet = i;
-          } else {
-          foundNode2Net = i;
-          }
-        }
+  if (debugNM) {
+    if (foundNode1Net > 7) {
+      Serial.print("found Node ");
+      printNodeOrName(node1);
+      Serial.print(" in Net ");
+      Serial.println(foundNode1Net);
+      }
+    if (foundNode2Net > 7) {
+      Serial.print("found Node ");
+      printNodeOrName(node2);
+      Serial.print(" in Net ");
+      Serial.println(foundNode2Net);
       }
     }
 
@@ -313,6 +530,47 @@ int searchExistingNets(
     }
   }
 
+/// @brief adds a single bridge to the existing nets without rebuilding them,
+/// used by the incremental router
+/// @param node1
+/// @param node2
+/// @param pathIdx index in path[] that will hold the new bridge
+/// @return the net the bridge ended up in, or -1 if it would merge two nets or
+/// break a doNotIntersect rule (nets are left untouched, do a full reroute)
+int addBridgeToNetsLocal(int node1, int node2, int pathIdx) {
+  if (node1 <= 0 || node2 <= 0) {
+    return -1;
+    }
+
+  int node1Net = netOfNode(node1);
+  int node2Net = netOfNode(node2);
+
+  if (node1Net > 0 && node2Net > 0 && node1Net != node2Net) {
+    return -1; // combineNets() shifts net numbers around
+    }
+  if (node1Net > 0 && node2Net == 0 &&
+      checkDoNotIntersectsByNode(node1Net, node2) != 1) {
+    return -1;
+    }
+  if (node2Net > 0 && node1Net == 0 &&
+      checkDoNotIntersectsByNode(node2Net, node1) != 1) {
+    return -1;
+    }
+  if (node1Net == 0 && node2Net == 0 && findFirstUnusedNetIndex() >= MAX_NETS - 1) {
+    return -1;
+    }
+
+  int lastBridgeIndex = newBridgeIndex;
+  newNode1 = node1;
+  newNode2 = node2;
+  newBridgeIndex = pathIdx;
+
+  searchExistingNets(node1, node2);
+
+  newBridgeIndex = lastBridgeIndex;
+  return path[pathIdx].net;
+  }
+
 void combineNets(int foundNode1Net, int foundNode2Net) {
   // Serial.println("combineNets");
   // Serial.println(foundNode1Net);
@@ -418,6 +676,7 @@ void combineNets(int foundNode1Net, int foundNode2Net) {
       if (debugNM)
         printBridgeArray();
 
+      mergeNetIndex(foundNode2Net, foundNode1Net);
       deleteNet(foundNode2Net);
       }
     }
@@ -429,6 +688,19 @@ void combineNets(int foundNode1Net, int foundNode2Net) {
 /// @return 1 if the bridge exists, 0 if it doesn't
 int checkIfBridgeExistsLocal(int node1, int node2) {
 
+  int node1Net = netOfNode(node1);
+  if (node1Net <= 0) {
+    return 0;
+    }
+  int node2Net = netOfNode(node2);
+  if (node2 == -1 || node2Net == node1Net || findBridgeNet(node1, node2) > 0) {
+    return 1;
+    }
+  if (node1Net > 5 || node2Net <= 0 || node2Net > 5) {
+    return 0;
+    }
+
+  // nodes can be in 2 of the special nets at once, the index only has one
   for (int i = 1; i < MAX_NETS; i++) {
     if (net[i].number <= 0) {
       break;
@@ -438,9 +710,6 @@ int checkIfBridgeExistsLocal(int node1, int node2) {
         break;
         }
       if (net[i].nodes[j] == node1) {
-        if (node2 == -1) {
-          return 1;
-          }
         for (int k = 0; k < MAX_NODES; k++) {
           if (net[i].nodes[k] == node2) {
             return 1;
@@ -509,6 +778,7 @@ int shiftNets(
     net[lastNet].bridges[j][0] = 0;
     net[lastNet].bridges[j][1] = 0;
     }
+  shiftNetIndex(deletedNet);
   return lastNet;
   }
 
@@ -516,22 +786,9 @@ int findNodeInNet(int node) {
   // Serial.println("findNodeInNet");
   // Serial.print("node = ");
   //   Serial.println(node);
-  for (int i = 1; i < MAX_NETS; i++) {
-
-    for (int j = 0; j < MAX_NODES; j++) {
-      if (net[i].nodes[j] == -1) {
-        // continue; 
-        break;
-        }
-
-      if (net[i].nodes[j] == node) {
-        // Serial.print("found node ");
-        // Serial.print(node);
-        // Serial.print(" in net ");
-        // Serial.println(net[i].number);
-        return net[i].number;
-        }
-      }
+  int foundNet = firstNetOfNode(node);
+  if (foundNet > 0) {
+    return net[foundNet].number;
     }
   for (int i = 0; i < 10; i++) {
     if (gpioNet[i] == node) {
@@ -578,6 +835,7 @@ void addBridgeToNet(uint16_t netToAddBridge, int16_t node1,
   int newBridgeIndex = findFirstUnusedBridgeIndex(netToAddBridge);
   net[netToAddBridge].bridges[newBridgeIndex][0] = node1;
   net[netToAddBridge].bridges[newBridgeIndex][1] = node2;
+  noteBridgeInNet(netToAddBridge, node1, node2);
   }
 
 void populateSpecialFunctions(int net, int node) {
@@ -692,6 +950,7 @@ void addNodeToNet(int netToAddNode, int node) {
     }
 
   net[netToAddNode].nodes[newNodeIndex] = node;
+  noteNodeInNet(netToAddNode, node);
   }
 
 int findFirstUnusedNetIndex() // search for a free net[]
@@ -1760,6 +2019,7 @@ void clearAllPaths(void) {
   digitalWrite(RESETPIN, HIGH);
   delayMicroseconds(600);
   digitalWrite(RESETPIN, LOW);
+  markCrosspointsDesynced();
 
   for (int i = 0; i < MAX_BRIDGES; i++) {
     path[i].node1 = 0;
@@ -1768,6 +2028,139 @@ void clearAllPaths(void) {
     }
   }
 
+#define BENCH_NODE_FILE "/benchNetlist.txt"
+
+/// @brief writes a made up node file of bridgeCount bridges, the same one
+/// every time so runs can be compared. Mostly breadboard rows with some nano
+/// pins (by name, so the parser has to look them up) for plenty of merges.
+static bool writeBenchNodeFile(int bridgeCount) {
+  holdCore2();
+  File file = FatFS.open(BENCH_NODE_FILE, "w");
+  if (!file) {
+    core1busy = false;
+    return false;
+    }
+
+  file.print("{ ");
+  uint32_t seed = 0x4a4c;
+  for (int i = 0; i < bridgeCount; i++) {
+    int ends[2];
+    for (int j = 0; j < 2; j++) {
+      seed = seed * 1664525 + 1013904223;
+      int pick = (seed >> 16) % 82;
+      if (pick < 60) {
+        ends[j] = pick + 1;
+        } else if (pick < 74) {
+        ends[j] = NANO_D0 + (pick - 60);
+        } else {
+        ends[j] = NANO_A0 + (pick - 74);
+        }
+      }
+    if (ends[0] == ends[1]) {
+      ends[1] = ends[0] == 1 ? 2 : 1;
+      }
+    file.print(definesToChar(ends[0]));
+    file.print("-");
+    file.print(definesToChar(ends[1]));
+    file.print(", ");
+    }
+  file.print("} ");
+  file.close();
+  core1busy = false;
+  return true;
+  }
+
+/// @brief writes a node file with bridgeCount bridges, then loads it through
+/// the parser and builds nets from it with the node index on and off,
+/// printing how long parsing and getNodesToConnect() took each way. The
+/// file is removed after and the current slot's connections reloaded.
+/// @param bridgeCount how many bridges to put in the file
+void benchmarkNetBuilding(int bridgeCount) {
+  const int runs = 5;
+
+  if (bridgeCount > MAX_BRIDGES - 8) {
+    bridgeCount = MAX_BRIDGES - 8;
+    }
+  if (writeBenchNodeFile(bridgeCount) == false) {
+    Serial.println("\n\rCouldn't write " BENCH_NODE_FILE "\n\r");
+    return;
+    }
+
+  bool lastDebugNM = debugNM;
+  bool lastIndexEnabled = netIndexEnabled;
+  debugNM = false;
+
+  unsigned long parseMicros = 0;
+  unsigned long passMicros[2] = {0, 0};
+  int passNets[2] = {0, 0};
+  int parsedBridges = 0;
+
+  for (int pass = 0; pass < 2; pass++) {
+    netIndexEnabled = (pass == 1);
+
+    for (int r = 0; r < runs; r++) {
+      clearAllNTCC();
+
+      unsigned long benchTimer = micros();
+      parsedBridges = parseNodeFileAt(BENCH_NODE_FILE);
+      parseMicros += micros() - benchTimer;
+      newBridgeIndex = 0;
+
+      benchTimer = micros();
+      getNodesToConnect();
+      passMicros[pass] += micros() - benchTimer;
+      }
+
+    for (int i = 6; i < MAX_NETS; i++) {
+      if (net[i].number > 0) {
+        passNets[pass]++;
+        }
+      }
+    }
+
+  debugNM = lastDebugNM;
+  netIndexEnabled = lastIndexEnabled;
+
+  for (int i = 0; i < MAX_BRIDGES; i++) {
+    path[i].node1 = 0;
+    path[i].node2 = 0;
+    path[i].net = 0;
+    }
+  newBridgeLength = 0;
+  newBridgeIndex = 0;
+  clearNodeFileString();
+
+  holdCore2();
+  FatFS.remove(BENCH_NODE_FILE);
+  core1busy = false;
+  refreshConnections(-1, 0);
+
+  Serial.print("\n\rNet building, " BENCH_NODE_FILE " (");
+  Serial.print(parsedBridges);
+  Serial.print(" of ");
+  Serial.print(bridgeCount);
+  Serial.print(" bridges parsed), average of ");
+  Serial.print(runs * 2);
+  Serial.println(" runs\n\r");
+  Serial.print("  parsing:\t\t");
+  Serial.print(parseMicros / (runs * 2));
+  Serial.println("us");
+  Serial.print("  scanning net[]:\t");
+  Serial.print(passMicros[0] / runs);
+  Serial.print("us\t");
+  Serial.print(passNets[0]);
+  Serial.println(" nets");
+  Serial.print("  node index:\t\t");
+  Serial.print(passMicros[1] / runs);
+  Serial.print("us\t");
+  Serial.print(passNets[1]);
+  Serial.println(" nets");
+  if (passNets[0] != passNets[1]) {
+    Serial.println("  net count doesn't match!");
+    }
+  Serial.println();
+  }
+
 // Helper function to find a DefineInfo by its define value
 const DefineInfo* findDefineInfoByValue(int defineValue) {
   // Check special defines first
@@ -41,6 +41,8 @@ void getNodesToConnect(); //read in the nodes you'd like to connect
 
 int searchExistingNets(int,int); //search through existing nets for all nodes that match either one of the new nodes (so it will be added to that net)
 
+int addBridgeToNetsLocal(int node1, int node2, int pathIdx); //add one bridge to the existing nets, -1 if it needs a full reroute
+
 int findFirstUnusedNetIndex(); //search for a free net[] 
 
 int findFirstUnusedBridgeIndex(int netNumber);
@@ -103,6 +105,19 @@ const DefineInfo* findDefineInfoByValue(int defineValue);
 
 int checkIfBridgeExistsLocal(int node1, int node2 = -1);
 
+extern bool netIndexEnabled;
+
+void rebuildNetIndex(void); //call after writing net[] directly
+
+int netOfNode(int node); //0 if it's not in a net, the highest if it's in 2
+int firstNetOfNode(int node); //same but the lowest, like findNodeInNet()
+
+int findBridgeNet(int node1, int node2); //0 if there's no bridge between them
+
+void forgetBridgeInNets(int node1, int node2);
+
+void benchmarkNetBuilding(int bridgeCount = 200);
+
 void assignTermColor(void);
 
 
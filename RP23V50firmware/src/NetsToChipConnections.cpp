@@ -26,6 +26,7 @@ extern char *strcpy(char *dest, const char *src);
 #include "NetManager.h"
 #include "Peripherals.h"
 #include "Probing.h"
+#include "RotaryEncoder.h"
 //#include "SerialWrapper.h"
 
 //#define Serial SerialWrap
@@ -167,6 +168,12 @@ int unconnectablePaths[10][2] = {
 int newBridges[MAX_NETS][MAX_DUPLICATE][2] = {0};
 unsigned long timeToSort = 0;
 
+struct routingStats routingStats = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+bool incrementalRouting = true;
+int routedSlot = -1; // slot the current path[] solution was routed from
+bool routingBenchmarkRunning = false; // keeps couldntFindPath() quiet
+unsigned long fullRouteTimer = 0;
+
 bool debugNTCC = 0; // EEPROM.read(DEBUG_NETTOCHIPCONNECTIONSADDRESS);
 
 bool debugNTCC2 = 1; // EEPROM.read(DEBUG_NETTOCHIPCONNECTIONSALTADDRESS);
@@ -1079,6 +1086,8 @@ void frontloadPriorityConnections(void) {
 void clearAllNTCC(void) {
 
   // digitalWrite(RESETPIN,HIGH);
+  fullRouteTimer = micros();
+  routedSlot = -1;
 
   for (int i = 0; i < 12; i++) {
     chipsLeastToMostCrowded[i] = i;
@@ -1162,6 +1171,7 @@ void clearAllNTCC(void) {
   //clang-format on
 
   initNets();
+  rebuildNetIndex();
   initializeYPositionLimits();
 
   for (int i = 0; i < 12; i++) {
@@ -1567,7 +1577,11 @@ void bridgesToPaths(
     resolveUncommittedHops(0, -1, 1);
   }
 
-  couldntFindPath(1);
+  if (jumperlessConfig.routing.search_budget_ms > 0) {
+    searchUnroutedPaths(jumperlessConfig.routing.search_budget_ms * 1000UL);
+  }
+
+  couldntFindPath(routingBenchmarkRunning ? 0 : 1);
   // couldntFindPath();
   checkForOverlappingPaths();
   // Serial.println("only duplicates");
@@ -1603,6 +1617,411 @@ void bridgesToPaths(
 #if DEBUG_NTCC6_ENABLED
   // validateTransactionConsistency();
 #endif
+
+  routingStats.lastFullMicros = micros() - fullRouteTimer;
+  routingStats.totalFullMicros += routingStats.lastFullMicros;
+  routingStats.fullRoutes++;
+  routedSlot = netSlot;
+}
+
+/*
+Incremental routing
+
+connectNodes() and disconnectNodes() used to throw away the whole routing
+state and solve everything again for one bridge. Since every routing stage
+skips paths that are already committed, a single new path can just be
+appended to path[] and run through the same stages. Removing a bridge only
+needs the path (and its duplicates) taken out of path[] as long as its net
+stays in one piece. Anything trickier (merging or splitting nets, a path
+that can't be found) returns 0 and the caller does a full reroute.
+*/
+
+#define MAX_REMOVED_LANES 16 // removed bridge and its duplicates, 4 chips each
+
+static void clearPathEntry(int i) {
+  path[i].net = 0;
+  path[i].node1 = 0;
+  path[i].node2 = 0;
+  path[i].altPathNeeded = false;
+  path[i].sameChip = false;
+  path[i].skip = false;
+  path[i].duplicate = 0;
+
+  for (int c = 0; c < 4; c++) {
+    path[i].chip[c] = -1;
+  }
+  for (int c = 0; c < 6; c++) {
+    path[i].x[c] = -1;
+    path[i].y[c] = -1;
+  }
+  for (int c = 0; c < 3; c++) {
+    path[i].nodeType[c] = BB;
+    for (int k = 0; k < 3; k++) {
+      path[i].candidates[c][k] = -1;
+    }
+  }
+}
+
+static bool incrementalRoutingReady(void) {
+  return incrementalRouting == true && routedSlot == netSlot &&
+         routedSlot >= 0;
+}
+
+static bool bridgeMatches(int a1, int a2, int node1, int node2) {
+  return (a1 == node1 && a2 == node2) || (a1 == node2 && a2 == node1);
+}
+
+/// @brief checks whether a net's nodes are all still connected if the
+/// bridges matching node1-node2 are ignored
+static bool netStaysConnectedWithout(int netNumber, int node1, int node2) {
+  int8_t parent[MAX_NODES];
+  int nodeCount = 0;
+
+  for (int i = 0; i < MAX_NODES; i++) {
+    if (net[netNumber].nodes[i] <= 0) {
+      break;
+    }
+    parent[i] = i;
+    nodeCount++;
+  }
+
+  for (int b = 0; b < MAX_NODES; b++) {
+    if (net[netNumber].bridges[b][0] == 0) {
+      break;
+    }
+    if (bridgeMatches(net[netNumber].bridges[b][0],
+                      net[netNumber].bridges[b][1], node1, node2)) {
+      continue;
+    }
+    int a = -1;
+    int c = -1;
+    for (int i = 0; i < nodeCount; i++) {
+      if (net[netNumber].nodes[i] == net[netNumber].bridges[b][0]) {
+        a = i;
+      }
+      if (net[netNumber].nodes[i] == net[netNumber].bridges[b][1]) {
+        c = i;
+      }
+    }
+    if (a == -1 || c == -1) {
+      continue;
+    }
+    while (parent[a] != a) {
+      a = parent[a];
+    }
+    while (parent[c] != c) {
+      c = parent[c];
+    }
+    parent[a] = c;
+  }
+
+  int root = -1;
+  for (int i = 0; i < nodeCount; i++) {
+    int r = i;
+    while (parent[r] != r) {
+      r = parent[r];
+    }
+    if (root == -1) {
+      root = r;
+    } else if (r != root) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// @brief whether any path in path[] has a bridge between node1 and node2
+static bool bridgeHasPath(int node1, int node2) {
+  for (int i = 0; i < numberOfPaths; i++) {
+    if (bridgeMatches(path[i].node1, path[i].node2, node1, node2)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/// @brief whether the net has bridges (other than node1-node2) that were
+/// added without a path of their own because their nodes were already in it
+static bool netHasUnroutedBridges(int netNumber, int node1, int node2) {
+  for (int b = 0; b < MAX_NODES; b++) {
+    int a = net[netNumber].bridges[b][0];
+    int c = net[netNumber].bridges[b][1];
+    if (a == 0) {
+      break;
+    }
+    if (bridgeMatches(a, c, node1, node2) == false &&
+        bridgeHasPath(a, c) == false) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/// @brief whether a kept path of netNumber still runs through an x (or y,
+/// pass -1 for the other one) lane on a chip
+static bool laneStillUsed(int chip, int x, int y, int netNumber) {
+  for (int i = 0; i < numberOfPaths; i++) {
+    if (path[i].net != netNumber) {
+      continue;
+    }
+    for (int c = 0; c < 4; c++) {
+      if (path[i].chip[c] != chip) {
+        continue;
+      }
+      if ((x >= 0 && path[i].x[c] == x) || (y >= 0 && path[i].y[c] == y)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/// @brief routes one new bridge on top of the current path[] solution
+/// @return 1 if it was routed, 0 if the caller needs to do a full reroute
+int addBridgeIncremental(int node1, int node2) {
+  if (incrementalRoutingReady() == false) {
+    return 0;
+  }
+  if (node1 <= 0 || node2 <= 0 || node1 == node2) {
+    return 0;
+  }
+  if (numberOfPaths >= MAX_BRIDGES - 2) {
+    return 0;
+  }
+
+  unsigned long incrementalTimer = micros();
+
+  int node1Net = netOfNode(node1);
+  if (node1Net > 0 && node1Net == netOfNode(node2)) {
+    // already connected through the net, just note the bridge so removing
+    // it later finds it
+    if (findBridgeNet(node1, node2) == 0) {
+      addBridgeToNet(node1Net, node1, node2);
+    }
+    routingStats.lastIncrementalMicros = micros() - incrementalTimer;
+    routingStats.totalIncrementalMicros += routingStats.lastIncrementalMicros;
+    routingStats.incrementalRoutes++;
+    return 1;
+  }
+
+  int newPath = numberOfPaths;
+  int netsBefore = numberOfNets;
+
+  clearPathEntry(newPath);
+  path[newPath].node1 = node1;
+  path[newPath].node2 = node2;
+
+  int newNet = addBridgeToNetsLocal(node1, node2, newPath);
+
+  if (newNet <= 0) {
+    clearPathEntry(newPath);
+    return 0;
+  }
+
+  if (net[newNet].bridges[1][0] == 0) { // this bridge made a new net
+    numberOfNets = netsBefore + 1;
+    numberOfUniqueNets++;
+    if (newNet >= 6) {
+      if ((node1 <= 60 || (node1 >= NANO_D0 && node1 <= NANO_RESET_1)) ||
+          (node2 <= 60 || (node2 >= NANO_D0 && node2 <= NANO_RESET_1))) {
+        net[newNet].visible = 1;
+        numberOfShownNets++;
+      } else {
+        net[newNet].visible = 0;
+      }
+    }
+  }
+
+  indexByNet[newPath] = newPath;
+  numberOfPaths = newPath + 1;
+
+  findStartAndEndChips(node1, node2, newPath);
+  mergeOverlappingCandidates(newPath);
+  assignPathType(newPath);
+
+  sortAllChipsLeastToMostCrowded();
+  resolveChipCandidates();
+
+  commitPaths(2, -1, 0);
+  resolveAltPaths(2, -1, 0);
+  resolveUncommittedHops(2, -1, 0);
+
+  couldntFindPath(0);
+
+  if (path[newPath].skip == true) {
+    routedSlot = -1;
+    return 0;
+  }
+
+  routingStats.lastIncrementalMicros = micros() - incrementalTimer;
+  routingStats.totalIncrementalMicros += routingStats.lastIncrementalMicros;
+  routingStats.incrementalRoutes++;
+
+  if (debugNTCC) {
+    Serial.print("incremental add ");
+    printNodeOrName(node1);
+    Serial.print("-");
+    printNodeOrName(node2);
+    Serial.print(" net ");
+    Serial.print(newNet);
+    Serial.print("  ");
+    Serial.print(routingStats.lastIncrementalMicros);
+    Serial.println("us");
+  }
+  return 1;
+}
+
+/// @brief takes one bridge out of the current path[] solution
+/// @return 1 if it was removed, 0 if the caller needs to do a full reroute
+int removeBridgeIncremental(int node1, int node2) {
+  if (incrementalRoutingReady() == false) {
+    return 0;
+  }
+  if (node1 <= 0 || node2 <= 0) {
+    return 0;
+  }
+
+  unsigned long incrementalTimer = micros();
+  int bridgeNet = findBridgeNet(node1, node2);
+
+  if (bridgeNet <= 0 ||
+      netStaysConnectedWithout(bridgeNet, node1, node2) == false) {
+    return 0; // the net would split or go away, nets need renumbering
+  }
+  if (bridgeHasPath(node1, node2) == true &&
+      netHasUnroutedBridges(bridgeNet, node1, node2) == true) {
+    return 0; // a bridge that got folded in without a path may need this one
+  }
+
+  int kept = 0;
+  for (int b = 0; b < MAX_NODES; b++) {
+    if (net[bridgeNet].bridges[b][0] == 0) {
+      break;
+    }
+    if (bridgeMatches(net[bridgeNet].bridges[b][0],
+                      net[bridgeNet].bridges[b][1], node1, node2)) {
+      continue;
+    }
+    net[bridgeNet].bridges[kept][0] = net[bridgeNet].bridges[b][0];
+    net[bridgeNet].bridges[kept][1] = net[bridgeNet].bridges[b][1];
+    kept++;
+  }
+  for (int b = kept; b < MAX_NODES; b++) {
+    if (net[bridgeNet].bridges[b][0] == 0) {
+      break;
+    }
+    net[bridgeNet].bridges[b][0] = 0;
+    net[bridgeNet].bridges[b][1] = 0;
+  }
+  forgetBridgeInNets(node1, node2);
+
+  int removedChip[MAX_REMOVED_LANES];
+  int removedX[MAX_REMOVED_LANES];
+  int removedY[MAX_REMOVED_LANES];
+  int removedLanes = 0;
+
+  int keptPaths = 0;
+  int oldNumberOfPaths = numberOfPaths;
+  for (int i = 0; i < oldNumberOfPaths; i++) {
+    if (path[i].net == bridgeNet &&
+        bridgeMatches(path[i].node1, path[i].node2, node1, node2)) {
+      for (int c = 0; c < 4 && removedLanes < MAX_REMOVED_LANES; c++) {
+        if (path[i].chip[c] < 0 || path[i].chip[c] >= 12) {
+          continue;
+        }
+        removedChip[removedLanes] = path[i].chip[c];
+        removedX[removedLanes] = path[i].x[c];
+        removedY[removedLanes] = path[i].y[c];
+        removedLanes++;
+      }
+      continue;
+    }
+    if (keptPaths != i) {
+      path[keptPaths] = path[i];
+      indexByNet[keptPaths] = keptPaths;
+    }
+    keptPaths++;
+  }
+  for (int i = keptPaths; i < oldNumberOfPaths; i++) {
+    clearPathEntry(i);
+  }
+  numberOfPaths = keptPaths;
+
+  // give back the lanes nothing else in the net is still using
+  for (int l = 0; l < removedLanes; l++) {
+    int chip = removedChip[l];
+    int x = removedX[l];
+    int y = removedY[l];
+
+    if (x >= 0 && x < 16 && ch[chip].xStatus[x] == bridgeNet &&
+        laneStillUsed(chip, x, -1, bridgeNet) == false) {
+      ch[chip].xStatus[x] = -1;
+    }
+    if (y >= 0 && y < 8 && ch[chip].yStatus[y] == bridgeNet &&
+        laneStillUsed(chip, -1, y, bridgeNet) == false) {
+      ch[chip].yStatus[y] = -1;
+    }
+  }
+
+  couldntFindPath(0);
+
+  routingStats.lastIncrementalMicros = micros() - incrementalTimer;
+  routingStats.totalIncrementalMicros += routingStats.lastIncrementalMicros;
+  routingStats.incrementalRoutes++;
+
+  if (debugNTCC) {
+    Serial.print("incremental remove ");
+    printNodeOrName(node1);
+    Serial.print("-");
+    printNodeOrName(node2);
+    Serial.print(" net ");
+    Serial.print(bridgeNet);
+    Serial.print("  ");
+    Serial.print(routingStats.lastIncrementalMicros);
+    Serial.println("us");
+  }
+  return 1;
+}
+
+void printRoutingStats(void) {
+  Serial.println("\n\rRouting stats\n\r");
+  Serial.print("  incremental routing:\t");
+  Serial.println(incrementalRouting ? "on" : "off");
+  Serial.print("  full reroutes:\t");
+  Serial.println(routingStats.fullRoutes);
+  Serial.print("  incremental routes:\t");
+  Serial.println(routingStats.incrementalRoutes);
+  Serial.print("  fallbacks to full:\t");
+  Serial.println(routingStats.incrementalFallbacks);
+  Serial.print("  last full:\t\t");
+  Serial.print(routingStats.lastFullMicros);
+  Serial.println("us");
+  Serial.print("  last incremental:\t");
+  Serial.print(routingStats.lastIncrementalMicros);
+  Serial.println("us");
+  Serial.print("  average full:\t\t");
+  Serial.print(routingStats.fullRoutes > 0
+                   ? routingStats.totalFullMicros / routingStats.fullRoutes
+                   : 0);
+  Serial.println("us");
+  Serial.print("  average incremental:\t");
+  Serial.print(routingStats.incrementalRoutes > 0
+                   ? routingStats.totalIncrementalMicros /
+                         routingStats.incrementalRoutes
+                   : 0);
+  Serial.println("us");
+  Serial.print("  search budget:\t");
+  Serial.print(jumperlessConfig.routing.search_budget_ms);
+  Serial.println("ms");
+  Serial.print("  paths rescued:\t");
+  Serial.println(routingStats.searchRescues);
+  Serial.print("  paths ripped up:\t");
+  Serial.println(routingStats.searchRipUps);
+  Serial.print("  search timeouts:\t");
+  Serial.println(routingStats.searchTimeouts);
+  Serial.print("  last search:\t\t");
+  Serial.print(routingStats.lastSearchMicros);
+  Serial.println("us\n\r");
 }
 
 void fillUnusedPaths(int duplicatePathsOverride, int duplicatePathsPower,
@@ -4166,6 +4585,413 @@ bool frontEnd(int chip, int y, int x) { // is this an externally facing node
 // printPathsCompact();
 // printChipStatus();
 
+/*
+Search router
+
+The passes above pick chips and lanes one path at a time, so a crowded board
+can leave paths for couldntFindPath() even when there's a way through.
+searchUnroutedPaths() runs after them and treats the crossbar as a graph,
+every wire (see xLineWire()) is a vertex and every crosspoint between an X
+and a Y line on a chip is an edge. For each path that didn't get routed it
+looks for the shortest route (4 crosspoints, that's all a pathStruct holds)
+over wires that are free or already on this net.
+
+If there isn't one, it takes the route through the fewest wires owned by
+other nets, rips up the paths on them, routes this one and then reroutes the
+ripped up ones. If any of them can't be put back the whole thing is undone.
+Duplicate paths are only there to lower resistance so they're just dropped.
+
+It stops when routing.search_budget_ms runs out. Paths it already rescued
+stay, everything else is left the way the greedy passes had it.
+*/
+
+#define SEARCH_MAX_HOPS 4
+#define SEARCH_MAX_RIPUPS 6
+#define SEARCH_NO_ROUTE 0xff
+
+static int16_t searchWireFirst[WIRE_COUNT + 1];
+static int16_t searchWireLines[WIRE_LINE_COUNT]; // chip * 24 + isY * 16 + line
+static bool searchWiresListed = false;
+
+static uint8_t searchWireCost[WIRE_COUNT]; // 0 usable, 1 another net's, SEARCH_NO_ROUTE
+static uint8_t searchCost[SEARCH_MAX_HOPS + 1][WIRE_COUNT];
+static int16_t searchFrom[SEARCH_MAX_HOPS + 1][WIRE_COUNT];
+static int16_t searchVia[SEARCH_MAX_HOPS + 1][WIRE_COUNT]; // chip * 128 + x * 8 + y
+
+struct searchHop {
+  int8_t chip;
+  int8_t x;
+  int8_t y;
+};
+
+static void listSearchWires(void) {
+  memset(searchWireFirst, 0, sizeof(searchWireFirst));
+
+  for (int line = 0; line < WIRE_LINE_COUNT; line++) {
+    int chip = line / 24;
+    int index = line % 24;
+    int wire = index < 16 ? xLineWire(chip, index) : yLineWire(chip, index - 16);
+    searchWireFirst[wire + 1]++;
+  }
+  for (int w = 0; w < WIRE_COUNT; w++) {
+    searchWireFirst[w + 1] += searchWireFirst[w];
+  }
+
+  int16_t fill[WIRE_COUNT];
+  memcpy(fill, searchWireFirst, sizeof(fill));
+  for (int line = 0; line < WIRE_LINE_COUNT; line++) {
+    int chip = line / 24;
+    int index = line % 24;
+    int wire = index < 16 ? xLineWire(chip, index) : yLineWire(chip, index - 16);
+    searchWireLines[fill[wire]++] = line;
+  }
+  searchWiresListed = true;
+}
+
+static int8_t *searchLineStatus(int line) {
+  int chip = line / 24;
+  int index = line % 24;
+  return index < 16 ? &ch[chip].xStatus[index] : &ch[chip].yStatus[index - 16];
+}
+
+static void setSearchWireStatus(int wire, int net) {
+  for (int l = searchWireFirst[wire]; l < searchWireFirst[wire + 1]; l++) {
+    *searchLineStatus(searchWireLines[l]) = net;
+  }
+}
+
+static int nodeSearchWire(int node) {
+  if (node <= 0 || node >= WIRE_COUNT - WIRE_LINE_COUNT) {
+    return -1;
+  }
+  int wire = WIRE_LINE_COUNT + node;
+  if (searchWireFirst[wire + 1] == searchWireFirst[wire]) {
+    return -1; // nothing on the crosspoints goes to this node
+  }
+  return wire;
+}
+
+static void costSearchWires(int netNumber, int node1, int node2) {
+  for (int w = 0; w < WIRE_COUNT; w++) {
+    searchWireCost[w] = 0;
+
+    if (w >= WIRE_LINE_COUNT) {
+      // a wire that goes to a node can only carry that node's net
+      int node = w - WIRE_LINE_COUNT;
+      if (node != node1 && node != node2 && netOfNode(node) != netNumber) {
+        searchWireCost[w] = SEARCH_NO_ROUTE;
+        continue;
+      }
+    }
+    for (int l = searchWireFirst[w]; l < searchWireFirst[w + 1]; l++) {
+      int status = *searchLineStatus(searchWireLines[l]);
+      if (status != -1 && status != netNumber) {
+        searchWireCost[w] = w >= WIRE_LINE_COUNT ? SEARCH_NO_ROUTE : 1;
+        break;
+      }
+    }
+  }
+}
+
+/// @brief cheapest route between two nodes, cost is how many wires owned by
+/// other nets it goes through (always 0 unless allowRipUp)
+/// @return number of hops written to route, 0 if there's no route
+static int searchRoute(int node1, int node2, int netNumber, bool allowRipUp,
+                       struct searchHop *route) {
+  int start = nodeSearchWire(node1);
+  int target = nodeSearchWire(node2);
+  if (start == -1 || target == -1 || start == target) {
+    return 0;
+  }
+
+  costSearchWires(netNumber, node1, node2);
+  uint8_t maxCost = allowRipUp ? SEARCH_NO_ROUTE - 1 : 0;
+  if (searchWireCost[start] > maxCost || searchWireCost[target] > maxCost) {
+    return 0;
+  }
+
+  memset(searchCost, SEARCH_NO_ROUTE, sizeof(searchCost));
+  searchCost[0][start] = searchWireCost[start];
+
+  int bestHops = 0;
+  int bestCost = SEARCH_NO_ROUTE;
+
+  for (int d = 0; d < SEARCH_MAX_HOPS; d++) {
+    for (int w = 0; w < WIRE_COUNT; w++) {
+      int cost = searchCost[d][w];
+      if (cost == SEARCH_NO_ROUTE || w == target) {
+        continue;
+      }
+      for (int l = searchWireFirst[w]; l < searchWireFirst[w + 1]; l++) {
+        int line = searchWireLines[l];
+        int chip = line / 24;
+        int index = line % 24;
+        bool isY = index >= 16;
+        int otherCount = isY ? 16 : 8;
+
+        for (int other = 0; other < otherCount; other++) {
+          int x = isY ? other : index;
+          int y = isY ? index - 16 : other;
+          int next = isY ? xLineWire(chip, x) : yLineWire(chip, y);
+          if (next == w || searchWireCost[next] > maxCost) {
+            continue;
+          }
+          int nextCost = cost + searchWireCost[next];
+          if (nextCost < searchCost[d + 1][next]) {
+            searchCost[d + 1][next] = nextCost;
+            searchFrom[d + 1][next] = w;
+            searchVia[d + 1][next] = chip * 128 + x * 8 + y;
+          }
+        }
+      }
+    }
+    if (searchCost[d + 1][target] < bestCost) {
+      bestCost = searchCost[d + 1][target];
+      bestHops = d + 1;
+      if (bestCost == 0) {
+        break; // can't do better than free
+      }
+    }
+  }
+
+  if (bestHops == 0) {
+    return 0;
+  }
+
+  int w = target;
+  for (int d = bestHops; d > 0; d--) {
+    int via = searchVia[d][w];
+    route[d - 1].chip = via / 128;
+    route[d - 1].x = (via / 8) % 16;
+    route[d - 1].y = via % 8;
+    w = searchFrom[d][w];
+  }
+  return bestHops;
+}
+
+static bool pathIsRouted(int i) {
+  for (int j = 0; j < 3; j++) {
+    if (path[i].chip[j] == -1 && j >= 2) {
+      continue;
+    }
+    if (path[i].x[j] < 0 || path[i].y[j] < 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool pathUsesWire(int i, int wire) {
+  for (int j = 0; j < 4; j++) {
+    int chip = path[i].chip[j];
+    if (chip < 0 || chip >= 12 || path[i].x[j] < 0 || path[i].y[j] < 0) {
+      continue;
+    }
+    if (xLineWire(chip, path[i].x[j]) == wire ||
+        yLineWire(chip, path[i].y[j]) == wire) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/// @brief takes a path's crosspoints out and frees the wires no other path
+/// on its net is using
+static void releaseSearchPath(int i) {
+  int wires[8];
+  int wireCount = 0;
+
+  for (int j = 0; j < 4; j++) {
+    int chip = path[i].chip[j];
+    if (chip >= 0 && chip < 12 && path[i].x[j] >= 0 && path[i].y[j] >= 0) {
+      wires[wireCount++] = xLineWire(chip, path[i].x[j]);
+      wires[wireCount++] = yLineWire(chip, path[i].y[j]);
+    }
+    path[i].chip[j] = -1;
+  }
+  for (int j = 0; j < 6; j++) {
+    path[i].x[j] = -1;
+    path[i].y[j] = -1;
+  }
+
+  for (int k = 0; k < wireCount; k++) {
+    bool stillUsed = false;
+    for (int p = 0; p < numberOfPaths; p++) {
+      if (p != i && path[p].net == path[i].net && pathUsesWire(p, wires[k])) {
+        stillUsed = true;
+        break;
+      }
+    }
+    if (stillUsed == false) {
+      setSearchWireStatus(wires[k], -1);
+    }
+  }
+}
+
+static void placeSearchPath(int i, struct searchHop *route, int hops) {
+  bool sameChip = true;
+  for (int j = 0; j < 4; j++) {
+    path[i].chip[j] = j < hops ? route[j].chip : -1;
+  }
+  for (int j = 0; j < 6; j++) {
+    path[i].x[j] = j < hops ? route[j].x : -1;
+    path[i].y[j] = j < hops ? route[j].y : -1;
+  }
+  for (int j = 0; j < hops; j++) {
+    setSearchWireStatus(xLineWire(route[j].chip, route[j].x), path[i].net);
+    setSearchWireStatus(yLineWire(route[j].chip, route[j].y), path[i].net);
+    if (route[j].chip != route[0].chip) {
+      sameChip = false;
+    }
+  }
+  path[i].sameChip = sameChip;
+  path[i].altPathNeeded = false;
+  path[i].skip = false;
+}
+
+/// @brief rips up whatever is in the way of path i's cheapest route, routes
+/// it, and puts the ripped up paths back somewhere else
+/// @return true if it worked, false if everything was put back how it was
+static bool ripUpAndReroute(int i, struct searchHop *route, int hops) {
+  static int8_t statusBackup[12][24];
+  static struct pathStruct pathsBackup[SEARCH_MAX_RIPUPS + 1];
+  int victims[SEARCH_MAX_RIPUPS];
+  int victimCount = 0;
+
+  for (int p = 0; p < numberOfPaths; p++) {
+    if (p == i || path[p].net == path[i].net) {
+      continue;
+    }
+    bool inTheWay = false;
+    for (int j = 0; j < hops && inTheWay == false; j++) {
+      int xWire = xLineWire(route[j].chip, route[j].x);
+      int yWire = yLineWire(route[j].chip, route[j].y);
+      inTheWay = (searchWireCost[xWire] == 1 && pathUsesWire(p, xWire)) ||
+                 (searchWireCost[yWire] == 1 && pathUsesWire(p, yWire));
+    }
+    if (inTheWay == true) {
+      if (victimCount == SEARCH_MAX_RIPUPS) {
+        return false;
+      }
+      victims[victimCount++] = p;
+    }
+  }
+
+  for (int c = 0; c < 12; c++) {
+    memcpy(statusBackup[c], ch[c].xStatus, 16);
+    memcpy(statusBackup[c] + 16, ch[c].yStatus, 8);
+  }
+  for (int v = 0; v < victimCount; v++) {
+    pathsBackup[v] = path[victims[v]];
+    releaseSearchPath(victims[v]);
+  }
+  pathsBackup[victimCount] = path[i];
+
+  struct searchHop freedRoute[SEARCH_MAX_HOPS];
+  int freedHops = searchRoute(path[i].node1, path[i].node2, path[i].net,
+                              false, freedRoute);
+  bool worked = freedHops > 0;
+  if (worked == true) {
+    placeSearchPath(i, freedRoute, freedHops);
+  }
+
+  for (int v = 0; v < victimCount && worked == true; v++) {
+    int p = victims[v];
+    if (path[p].duplicate != 0) {
+      continue;
+    }
+    struct searchHop victimRoute[SEARCH_MAX_HOPS];
+    int victimHops = searchRoute(path[p].node1, path[p].node2, path[p].net,
+                                 false, victimRoute);
+    if (victimHops == 0) {
+      worked = false;
+    } else {
+      placeSearchPath(p, victimRoute, victimHops);
+    }
+  }
+
+  if (worked == false) {
+    for (int c = 0; c < 12; c++) {
+      memcpy(ch[c].xStatus, statusBackup[c], 16);
+      memcpy(ch[c].yStatus, statusBackup[c] + 16, 8);
+    }
+    for (int v = 0; v < victimCount; v++) {
+      path[victims[v]] = pathsBackup[v];
+    }
+    path[i] = pathsBackup[victimCount];
+    return false;
+  }
+
+  routingStats.searchRipUps += victimCount;
+  return true;
+}
+
+/// @brief second chance for the paths the greedy passes couldn't route
+/// @param budgetMicros gives up after this long
+/// @return how many paths it rescued
+int searchUnroutedPaths(unsigned long budgetMicros) {
+  unsigned long searchTimer = micros();
+  int rescued = 0;
+
+  if (searchWiresListed == false) {
+    listSearchWires();
+  }
+
+  for (int i = 0; i < numberOfPaths; i++) {
+    if (path[i].duplicate != 0 || path[i].net <= 0 || path[i].node1 <= 0 ||
+        path[i].node2 <= 0 || pathIsRouted(i) == true) {
+      continue;
+    }
+    if (micros() - searchTimer > budgetMicros) {
+      routingStats.searchTimeouts++;
+      break;
+    }
+
+    struct pathStruct greedyPath = path[i];
+    static int8_t statusBackup[12][24];
+    for (int c = 0; c < 12; c++) {
+      memcpy(statusBackup[c], ch[c].xStatus, 16);
+      memcpy(statusBackup[c] + 16, ch[c].yStatus, 8);
+    }
+    releaseSearchPath(i); // whatever half a route the greedy passes left
+
+    struct searchHop route[SEARCH_MAX_HOPS];
+    int hops = searchRoute(path[i].node1, path[i].node2, path[i].net, false,
+                           route);
+    bool routed = false;
+
+    if (hops > 0) {
+      placeSearchPath(i, route, hops);
+      routed = true;
+    } else if (micros() - searchTimer <= budgetMicros) {
+      hops = searchRoute(path[i].node1, path[i].node2, path[i].net, true,
+                         route);
+      routed = hops > 0 && ripUpAndReroute(i, route, hops);
+    }
+
+    if (routed == true) {
+      rescued++;
+      if (debugNTCC) {
+        Serial.print("search router rescued ");
+        printNodeOrName(path[i].node1);
+        Serial.print("-");
+        printNodeOrName(path[i].node2);
+        Serial.println();
+      }
+    } else {
+      for (int c = 0; c < 12; c++) {
+        memcpy(ch[c].xStatus, statusBackup[c], 16);
+        memcpy(ch[c].yStatus, statusBackup[c] + 16, 8);
+      }
+      path[i] = greedyPath;
+    }
+  }
+
+  routingStats.searchRescues += rescued;
+  routingStats.lastSearchMicros = micros() - searchTimer;
+  return rescued;
+}
+
 void couldntFindPath(int forcePrint) {
   if (debugNTCC2 == true || forcePrint == 1 || debugNTCC5 == true) {
     // Serial.print("\n\r");
@@ -4197,9 +5023,11 @@ void couldntFindPath(int forcePrint) {
         Serial.println("\n\r");
       }
 
-      unconnectablePaths[numberOfUnconnectablePaths][0] = path[i].node1;
-      unconnectablePaths[numberOfUnconnectablePaths][1] = path[i].node2;
-      numberOfUnconnectablePaths++;
+      if (numberOfUnconnectablePaths < 10) { // only room for the first 10
+        unconnectablePaths[numberOfUnconnectablePaths][0] = path[i].node1;
+        unconnectablePaths[numberOfUnconnectablePaths][1] = path[i].node2;
+        numberOfUnconnectablePaths++;
+      }
       path[i].skip = true;
     }
   }
@@ -23,6 +23,25 @@ extern bool debugNTCC4;
 extern int numberOfUnconnectablePaths;
 extern int unconnectablePaths[10][2];
 
+struct routingStats {
+  unsigned long fullRoutes;
+  unsigned long incrementalRoutes;
+  unsigned long incrementalFallbacks;
+  unsigned long lastFullMicros;
+  unsigned long lastIncrementalMicros;
+  unsigned long long totalFullMicros;
+  unsigned long long totalIncrementalMicros;
+  unsigned long searchRescues;  // paths the search router routed after the greedy passes gave up
+  unsigned long searchRipUps;   // other paths it moved to make room
+  unsigned long searchTimeouts; // times it ran out of routing.search_budget_ms
+  unsigned long lastSearchMicros;
+};
+
+extern struct routingStats routingStats;
+extern bool incrementalRouting;
+extern int routedSlot;
+extern bool routingBenchmarkRunning;
+
 
 // extern int newBridges[MAX_NETS][MAX_DUPLICATE][2];
 
@@ -35,6 +54,8 @@ void findStartAndEndChips(int node1, int node2, int net);
 
 void couldntFindPath(int forcePrint = 1);
 
+int searchUnroutedPaths(unsigned long budgetMicros);
+
 void resolveChipCandidates();
 
 void printPathArray();
@@ -98,6 +119,10 @@ bool frontEnd(int chip, int y = -1, int x = -1);
 
 void fillUnusedPaths(int duplicatePathsOverride = 1, int duplicatePathsPower = 2, int duplicatePathsDac = 1);
 
+int addBridgeIncremental(int node1, int node2); //1 = routed, 0 = needs a full reroute
+int removeBridgeIncremental(int node1, int node2); //1 = removed, 0 = needs a full reroute
+void printRoutingStats(void);
+
 
 
 
@@ -0,0 +1,288 @@
+// SPDX-License-Identifier: MIT
+#include "Overlay.h"
+#include "CH446Q.h"
+#include "Commands.h"
+#include "FileParsing.h"
+#include "LEDs.h"
+#include "MatrixState.h"
+#include "NetManager.h"
+
+#include <Arduino.h>
+
+// Overlays are routed on core 0 with BoardScan's search against whatever the
+// chips are set to right now, including other overlays, then closed with
+// sendXYraw() while core 1 is held off. Core 1 keeps them in its diffs (see
+// mergeOverlays() in CH446Q.cpp) and drops any whose lanes a reroute took,
+// those get a new route from serviceOverlays().
+
+struct overlayBridge overlays[OVERLAY_MAX];
+struct overlayStats overlayStats = {0, 0, 0, 0, 0, 0, 0};
+
+static uint16_t nextOverlayId = 1;
+static struct scanGraph overlayGraph;
+static struct scanTree overlayTree;
+
+// holdCrosspoints() nests, and only the outermost hold that raised
+// core1busy itself drops it again, so a file op that already has core 1 held
+// keeps it held
+static int crosspointHolds = 0;
+static bool crosspointHoldRaised = false;
+
+void holdCrosspoints(void) {
+  if (crosspointHolds++ > 0) {
+    return;
+  }
+  waitCore2(); // anything queued goes out first
+  crosspointHoldRaised = core1busy == false;
+  holdCore2(); // no timeout, core 1 parks outside sendPaths()
+}
+
+void releaseCrosspoints(void) {
+  if (crosspointHolds == 0 || --crosspointHolds > 0) {
+    return;
+  }
+  if (crosspointHoldRaised == true) {
+    crosspointHoldRaised = false;
+    core1busy = false;
+  }
+}
+
+void readScanGraph(struct scanGraph *graph) {
+  for (int chip = 0; chip < SCAN_CHIPS; chip++) {
+    for (int x = 0; x < 16; x++) {
+      graph->xWire[chip][x] = xLineWire(chip, x);
+      for (int y = 0; y < 8; y++) {
+        graph->closed[chip][x][y] = crosspointClosed(chip, x, y) ? 1 : 0;
+      }
+    }
+    for (int y = 0; y < 8; y++) {
+      graph->yWire[chip][y] = yLineWire(chip, y);
+    }
+  }
+}
+
+static void setOverlayRoute(struct overlayBridge *overlay, int setOrClear,
+                            struct scanGraph *graph) {
+  struct scanRoute *route = &overlay->route;
+  for (int hop = 0; hop < route->hops; hop++) {
+    sendXYraw(route->chip[hop], route->x[hop], route->y[hop], setOrClear);
+    graph->closed[route->chip[hop]][route->x[hop]][route->y[hop]] = setOrClear;
+  }
+}
+
+// the one route attempt, closes it if there is one
+static int routeOverlay(struct overlayBridge *overlay, struct scanGraph *graph) {
+  unsigned long start = micros();
+  int hops = 0;
+  if (scanGrowTree(graph, SCAN_NODE_WIRE_BASE + overlay->from,
+                   &overlayTree) == 1) {
+    hops = scanRouteTo(graph, &overlayTree, SCAN_NODE_WIRE_BASE + overlay->to,
+                       &overlay->route);
+  }
+  overlayStats.lastRouteMicros = micros() - start;
+  if (hops == 0) {
+    return 0;
+  }
+  setOverlayRoute(overlay, 1, graph);
+  overlay->active = 1;
+  overlay->pending = 0;
+  return 1;
+}
+
+// lowest priority overlay under priority (active ones only if activeOnly)
+static int lowestOverlayBelow(int priority, int activeOnly) {
+  int lowest = -1;
+  for (int i = 0; i < OVERLAY_MAX; i++) {
+    if (overlays[i].id == 0 || overlays[i].priority >= priority ||
+        (activeOnly == 1 && overlays[i].active == 0)) {
+      continue;
+    }
+    if (lowest < 0 || overlays[i].priority < overlays[lowest].priority) {
+      lowest = i;
+    }
+  }
+  return lowest;
+}
+
+static void retryPendingOverlays(struct scanGraph *graph) {
+  for (int priority = 255; priority >= 0; priority--) {
+    for (int i = 0; i < OVERLAY_MAX; i++) {
+      if (overlays[i].id != 0 && overlays[i].pending == 1 &&
+          overlays[i].priority == priority &&
+          routeOverlay(&overlays[i], graph) == 1) {
+        overlayStats.rerouted++;
+      }
+    }
+  }
+}
+
+int addOverlay(int from, int to, int priority, unsigned long lifetimeMs) {
+  if (from < 0 || from >= 256 || to < 0 || to >= 256 || from == to ||
+      priority < 0 || priority > 255) {
+    return -1;
+  }
+
+  holdCrosspoints();
+  if (crosspointDesync == true) {
+    // lastChipXY can't say what's free until core 1 does a clean send
+    releaseCrosspoints();
+    overlayStats.failed++;
+    return -1;
+  }
+  readScanGraph(&overlayGraph);
+
+  int slot = -1;
+  for (int i = 0; i < OVERLAY_MAX && slot < 0; i++) {
+    if (overlays[i].id == 0) {
+      slot = i;
+    }
+  }
+  if (slot < 0) {
+    slot = lowestOverlayBelow(priority, 0);
+    if (slot < 0) {
+      releaseCrosspoints();
+      overlayStats.failed++;
+      return -1;
+    }
+    if (overlays[slot].active == 1) {
+      setOverlayRoute(&overlays[slot], 0, &overlayGraph);
+    }
+    overlayStats.bumped++;
+  }
+
+  struct overlayBridge *overlay = &overlays[slot];
+  overlay->id = nextOverlayId++;
+  if (nextOverlayId == 0 || nextOverlayId > 0x7fff) {
+    nextOverlayId = 1; // handles stay positive
+  }
+  overlay->from = from;
+  overlay->to = to;
+  overlay->priority = priority;
+  overlay->active = 0;
+  overlay->pending = 0;
+  overlay->expires = lifetimeMs > 0 ? millis() + lifetimeMs : 0;
+  if (overlay->expires == 0 && lifetimeMs > 0) {
+    overlay->expires = 1;
+  }
+
+  int routed = routeOverlay(overlay, &overlayGraph);
+  while (routed == 0) {
+    // push lower priorities off their lanes one at a time until it fits
+    int victim = lowestOverlayBelow(priority, 1);
+    if (victim < 0) {
+      break;
+    }
+    setOverlayRoute(&overlays[victim], 0, &overlayGraph);
+    overlays[victim].active = 0;
+    overlays[victim].pending = 1;
+    overlayStats.bumped++;
+    routed = routeOverlay(overlay, &overlayGraph);
+  }
+  if (routed == 0) {
+    overlay->id = 0;
+  }
+  retryPendingOverlays(&overlayGraph); // whatever got bumped might fit elsewhere
+  releaseCrosspoints();
+
+  if (routed == 0) {
+    overlayStats.failed++;
+    return -1;
+  }
+  overlayStats.added++;
+  return overlay->id;
+}
+
+int removeOverlay(int handle) {
+  for (int i = 0; i < OVERLAY_MAX; i++) {
+    if (handle <= 0 || overlays[i].id != handle) {
+      continue;
+    }
+    holdCrosspoints();
+    if (overlays[i].active == 1) {
+      setOverlayRoute(&overlays[i], 0, &overlayGraph);
+    }
+    overlays[i].id = 0;
+    overlays[i].active = 0;
+    overlays[i].pending = 0;
+    releaseCrosspoints();
+    overlayStats.removed++;
+    return 1;
+  }
+  return 0;
+}
+
+void clearOverlays(void) {
+  for (int i = 0; i < OVERLAY_MAX; i++) {
+    if (overlays[i].id != 0) {
+      removeOverlay(overlays[i].id);
+    }
+  }
+}
+
+void serviceOverlays(void) {
+  static unsigned long lastRetry = 0;
+  int pending = 0;
+
+  for (int i = 0; i < OVERLAY_MAX; i++) {
+    if (overlays[i].id == 0) {
+      continue;
+    }
+    if (overlays[i].expires != 0 &&
+        (long)(millis() - overlays[i].expires) >= 0) {
+      removeOverlay(overlays[i].id);
+      overlayStats.expired++;
+    } else if (overlays[i].pending == 1) {
+      pending++;
+    }
+  }
+
+  if (pending > 0 && millis() - lastRetry > 50) {
+    lastRetry = millis();
+    holdCrosspoints();
+    if (crosspointDesync == false) {
+      readScanGraph(&overlayGraph);
+      retryPendingOverlays(&overlayGraph);
+    }
+    releaseCrosspoints();
+  }
+}
+
+void printOverlays(void) {
+  Serial.print("\n\rOverlays:\t");
+  Serial.print(overlayStats.added);
+  Serial.print(" added\tremoved ");
+  Serial.print(overlayStats.removed);
+  Serial.print("\texpired ");
+  Serial.print(overlayStats.expired);
+  Serial.print("\tfailed ");
+  Serial.print(overlayStats.failed);
+  Serial.print("\tbumped ");
+  Serial.print(overlayStats.bumped);
+  Serial.print("\trerouted ");
+  Serial.print(overlayStats.rerouted);
+  Serial.print("\tlast route ");
+  Serial.print(overlayStats.lastRouteMicros);
+  Serial.println(" us");
+  for (int i = 0; i < OVERLAY_MAX; i++) {
+    if (overlays[i].id == 0) {
+      continue;
+    }
+    Serial.print("  ");
+    Serial.print(overlays[i].id);
+    Serial.print("\t");
+    printNodeOrName(overlays[i].from);
+    Serial.print(" - ");
+    printNodeOrName(overlays[i].to);
+    Serial.print("\tpriority ");
+    Serial.print(overlays[i].priority);
+    Serial.print(overlays[i].active == 1 ? "\tclosed, " : "\tpending, ");
+    Serial.print(overlays[i].route.hops);
+    Serial.print(" crosspoints");
+    if (overlays[i].expires != 0) {
+      Serial.print("\t");
+      Serial.print((long)(overlays[i].expires - millis()));
+      Serial.print(" ms left");
+    }
+    Serial.println();
+  }
+}
@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: MIT
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#include <stdint.h>
+
+#include "BoardScan.h"
+
+#define OVERLAY_MAX 16
+
+// higher ones push lower ones off their lanes when there's no other way
+#define OVERLAY_PRIORITY_LOW 0
+#define OVERLAY_PRIORITY_MEASURE 1 // measureVoltage(), checkFloating()
+#define OVERLAY_PRIORITY_HIGH 2
+
+/// @brief A temporary bridge that lives on top of the nets. It's never in
+/// the node file, net[] or path[], its crosspoints are just closed on free
+/// lanes and opened again when it's removed or runs out.
+struct overlayBridge {
+  uint16_t id;       // 0 if the slot's free
+  int16_t from;      // has to be unconnected (ADC, GPIO...)
+  int16_t to;        // can be in a net already
+  uint8_t priority;
+  uint8_t active;    // its route is closed in the chips
+  uint8_t pending;   // lost its lanes, gets routed again by serviceOverlays()
+  unsigned long expires; // millis(), 0 lives until removeOverlay()
+  struct scanRoute route;
+};
+
+struct overlayStats {
+  unsigned long added;
+  unsigned long removed;
+  unsigned long expired;
+  unsigned long failed;   // no free route even after bumping lower priorities
+  unsigned long bumped;   // pushed off by a higher priority overlay or the nets
+  unsigned long rerouted; // pending ones that got a route again
+  unsigned long lastRouteMicros;
+};
+
+extern struct overlayBridge overlays[OVERLAY_MAX];
+extern struct overlayStats overlayStats;
+
+/// @brief Keep core 1 from sending paths while core 0 opens / closes
+/// crosspoints itself. Waits (no timeout) for core 1 to park, holds nest,
+/// and releasing leaves a hold someone else took on core 1 in place.
+void holdCrosspoints(void);
+void releaseCrosspoints(void);
+/// @brief What the chips are set to right now as wires and closed crosspoints
+void readScanGraph(struct scanGraph *graph);
+
+/// @brief One route attempt from `from` to `to`. Returns a handle for
+/// removeOverlay(), or -1 if there's no free route.
+int addOverlay(int from, int to, int priority = OVERLAY_PRIORITY_LOW,
+               unsigned long lifetimeMs = 0);
+/// @brief Returns 0 if the handle's already gone
+int removeOverlay(int handle);
+void clearOverlays(void);
+/// @brief Expire old overlays and route the pending ones again, call often
+void serviceOverlays(void);
+void printOverlays(void);
+
+#endif
@@ -38,6 +38,10 @@
 #include "Probing.h"
 //#include "hardware/adc.h"
 #include "Highlighting.h"
+#include "AdcEngine.h"
+#include "InaMonitor.h"
+#include "ProbeScanner.h"
+#include "Waveforms.h"
 
 
 
@@ -114,22 +118,6 @@ int dacCalibration[4][3] = { {0, 0, 0},
                             {0, 0, 0},
                             {0, 0, 0} }; // 0 = min, 1 = middle, 2 = max,
 
-float freq[3] = { 1, 1, 0 };
-uint32_t period[3] = { 0, 0, 0 };
-uint32_t halvePeriod[3] = { 0, 0, 0 };
-
-// q = square
-// s = sinus
-// w = sawtooth
-// t = stair
-// r = random
-char mode[3] = { 'z', 'z', 'z' };
-
-int dacOn[3] = { 0, 0, 0 };
-int amplitude[3] = { 0, 0, 0 };
-int offset[3] = { 2048, 1650, 0 };
-int calib[3] = { 0, 0, 0 };
-
 Adafruit_MCP4728 mcp;
 
 // MCP4725_PICO dac0_5V(5.0);
@@ -137,15 +125,9 @@ Adafruit_MCP4728 mcp;
 
 // MCP4822 dac_rev3; // A is dac0  B is dac1
 
-INA219 INA0(0x40);
-INA219 INA1(0x41);
-
-uint16_t count;
-uint32_t lastTime = 0;
+INA219 INA0(0x40, &dacBus);
+INA219 INA1(0x41, &dacBus);
 
-// LOOKUP TABLE SINE
-uint16_t sine0[360];
-uint16_t sine1[360];
 
 // PWM state tracking
 float gpioPWMFrequency[10] = {
@@ -227,19 +209,21 @@ void initADC(void) {
   // pinMode(ADC7_PIN, INPUT);
 
   analogReadResolution(12);
+  startAdcEngine(jumperlessConfig.hardware.adc_sample_rate);
+  startProbeScanner();
   }
 
 void initDAC(void) {
   initGPIO();
 
-  Wire.setSDA(4);
-  Wire.setSCL(5);
-  Wire.setClock(1000000);
-  Wire.begin();
+  dacBus.setSDA(4);
+  dacBus.setSCL(5);
+  dacBus.setClock(1000000);
+  dacBus.begin();
 
   delayMicroseconds(100);
   // Try to initialize!
-  if (!mcp.begin()) {
+  if (!mcp.begin(MCP4728_I2CADDR_DEFAULT, &dacBus)) {
     delay(3000);
     Serial.println("Failed to find MCP4728 chip");
     // while (1)
@@ -288,13 +272,13 @@ int findI2CAddress(int sdaPin, int sclPin, int i2cNumber) {
   int address = -1;
   for (int i = 0; i < 128; i++) {
     if (i2cNumber == 0) {
-      Wire.beginTransmission(i);
+      dacBus.beginTransmission(i);
       } else {
       Wire1.beginTransmission(i);
       }
     int error = 0;
     if (i2cNumber == 0) {
-      error = Wire.endTransmission();
+      error = dacBus.endTransmission();
       } else {
       error = Wire1.endTransmission();
       }
@@ -369,10 +353,10 @@ int initI2C(int sdaPin, int sclPin, int speed) {
     } else if (portFound == 0) {
 
 
-      Wire.setSDA(sdaPin);
-      Wire.setSCL(sclPin);
-      Wire.setClock(speed);
-      Wire.begin();
+      dacBus.setSDA(sdaPin);
+      dacBus.setSCL(sclPin);
+      dacBus.setClock(speed);
+      dacBus.begin();
       if (i2c0Pins[0] == sdaPin && i2c0Pins[1] == sclPin && i2c0Pins[2] == speed) {
         return gpioI2Cmap[sdaFound][2] + 10; //returns 10 if the pins are already set
         }
@@ -1006,6 +990,7 @@ float getDacVoltage(int dac) {
   }
 
 void setDac0voltage(float voltage, int save, int saveEEPROM, bool checkProbePower) {
+  stopWaveform(0); // a plain voltage replaces whatever wave was running
   // int dacValue = (voltage * 4095 / 19.8) + 1641;
   int dacValue = (voltage * 4095 / dacSpread[0]) + dacZero[0];
 
@@ -1051,6 +1036,7 @@ void setDac0voltage(uint16_t inputCode) {
   }
 
 void setDac1voltage(float voltage, int save, int saveEEPROM, bool checkProbePower) {
+  stopWaveform(1);
 
   int dacValue = (voltage * 4095 / dacSpread[1]) + dacZero[1];
 
@@ -1158,6 +1144,10 @@ void initINA219(void) {
   INA0.setBusVoltageRange(16);
   INA1.setBusVoltageRange(16);
 
+  startInaMonitor(jumperlessConfig.hardware.ina_bits,
+                  jumperlessConfig.hardware.ina_averaging,
+                  jumperlessConfig.hardware.ina_window_ms);
+
   //  calibrateDacs();
   }
 
@@ -1646,7 +1636,7 @@ void showLEDmeasurements(void) {
 
         net[showADCreadings[i]].color = unpackRgb(color);
         //drawWires(showADCreadings[0]);
-        //showLEDsCore2 = 2;
+        //queueShowLEDs(2);
       }
     }
 
@@ -1965,7 +1955,7 @@ void showMeasurements(int samples, int printOrBB, int oneShot) {
 
     if (showINA0[0] == 1) {
       bs += Serial.print("INA 0: ");
-      bs += Serial.print(INA0.getCurrent_mA());
+      bs += Serial.print(inaCurrent(0) * 1000);
       bs += Serial.print("mA\t");
       // bs += Serial.print("\tINA 1: ");
       // bs += Serial.print(INA1.getCurrent_mA());
@@ -1974,12 +1964,12 @@ void showMeasurements(int samples, int printOrBB, int oneShot) {
 
     if (showINA0[1] == 1) {
       bs += Serial.print(" V: ");
-      bs += Serial.print(INA0.getBusVoltage());
+      bs += Serial.print(inaBusVoltage(0));
       bs += Serial.print("V\t");
       }
     if (showINA0[2] == 1) {
       bs += Serial.print("P: ");
-      bs += Serial.print(INA0.getPower_mW());
+      bs += Serial.print(inaPower(0) * 1000);
       bs += Serial.print("mW\t");
       }
     // Serial.print(digitalRead(buttonPin));
@@ -2013,7 +2003,7 @@ float readAdcVoltage(int channel, int samples) {
     return 0;
     }
 
-  int adcReadingUnscaled = readAdc(channel, samples);
+  int adcReadingUnscaled = adcAverage(channel, samples);
 
   float adcReading = (adcReadingUnscaled) * (adcSpread[channel] / 4095);
   if (channel != 4) {
@@ -2039,6 +2029,11 @@ int readAdc(int channel, int samples) {
   if (channel > 7) {
     return 0;
     }
+  if (adcEngineRunning == 1) {
+    // callers expect readings taken after they asked (like right after a
+    // crosspoint switched), so wait for new ones instead of using the ring
+    return adcFresh(channel, samples);
+    }
   unsigned long timeoutTimer = micros();
 
   int actualSamples = 0;
@@ -2062,34 +2057,7 @@ int readAdc(int channel, int samples) {
   return adcReading;
   }
 
-int waveGen(void) {
-  // Serial.println("\n\n\rComing back soon in a less janky way!\n\r");
-  // return 1;
-  int loopCounter = 0;
-  int c = 0;
-  listSpecialNets();
-  listNets();
-
-  int activeDac = 3;
-
-  mode[0] = 's';
-  mode[1] = 's';
-  mode[2] = 's';
-
-  refillTable(amplitude[0], offset[0] + calib[0], 0);
-  refillTable(amplitude[1], offset[1] + calib[1], 1);
-
-  setDac0voltage((float)0.0);
-
-  // setDac1voltage(offset[1] + calib[1]);
-  setDac1voltage((float)0.0);
-  digitalWrite(8, HIGH);
-  // setDac1voltage(8190);
-  // Serial.println(dac_rev3.getGain());
-
-  // Serial.println(dac_rev3.maxValue());
-  // Serial.print("Revision = ");
-  // Serial.println(revisionNumber);
+static void printWaveGenMenu(void) {
   Serial.println(
       "\n\r\t\t\t\t     waveGen\t\n\n\r\toptions\t\t\twaves\t\t\tadjust "
       "frequency\n\r");
@@ -2099,646 +2067,138 @@ int waveGen(void) {
   Serial.println(
       "\ta = set amplitude (p-p)\tw = sawtooth\t\t* = frequency*2\n\r");
   Serial.println("\to = set offset\t\tt = triangle\t\t/ = frequency/2\n\r");
-  Serial.println("\tv = voltage\t\tr = random\t\t \n\r");
-  Serial.println("\th = show this menu\tx = exit\t\t \n\r");
-
-  period[activeDac] = 1e6 / (freq[activeDac] / 10);
-  halvePeriod[activeDac] = period[activeDac] / 2;
-  int chars = 0;
-
-  chars = 0;
+  Serial.println("\tv = voltage (stop)\tr = random\t\tf = type frequency\n\r");
+  Serial.println("\th = show this menu\tx = exit (keeps running)\n\r");
+  }
 
-  int firstCrossFreq0 = 0;
-  int firstCrossFreq1 = 0;
+static void printWaveGenStatus(int dac) {
+  Serial.print("dac ");
+  Serial.print(dac);
+  Serial.print(":   ampl: ");
+  Serial.print(waveAmplitude(dac));
+  Serial.print("V\toffset: ");
+  Serial.print(waveOffset(dac));
+  Serial.print("V\t\tmode: ");
+  Serial.print(waveShapeName(waveShapeOf(dac)));
+  Serial.print("\t\tfreq: ");
+  Serial.println(waveFrequency(dac));
+  }
 
+/// @brief Read a number typed at the prompt, Enter to accept, anything that
+/// isn't part of a number cancels and returns fallback
+static float readWaveGenNumber(const char *prompt, float fallback) {
+  char typed[16];
+  int length = 0;
+  Serial.print(prompt);
   while (1) {
-    yield();
-    uint32_t now = micros();
-
-    count++;
-
-    // float adc3Voltage = (adc3Reading - 2528) / 220.0; //painstakingly
-    // measured float adc0Voltage = ((adc0Reading) / 400.0) - 0.69; //- 0.93;
-    // //painstakingly measured
-
-    int adc0Reading = 0;
-    int brightness0 = 0;
-    int hueShift0 = 0;
-    // firstCrossFreq0 = 1;
-
-    if (dacOn[0] == 1 && freq[0] < 33) {
-      // adc0Reading = INA1.getBusVoltage_mV();
-      //  adc0Reading = dac0_5V.getInputCode();
-
-      if (c == 'q') {
-        } else {
-
-        adc0Reading = readAdc(26, 1);
-        adc0Reading = abs(adc0Reading);
-        hueShift0 = map(adc0Reading, 0, 5000, -90, 0);
-        brightness0 = map(adc0Reading, 0, 5000, 4, 100);
-
-        // lightUpNet(4, -1, 1, brightness0, hueShift0);
-        showLEDsCore2 = 1;
-        firstCrossFreq0 = 1;
-        }
-      } else {
-      if (firstCrossFreq0 == 1) {
-        // lightUpNet(4);
-        showLEDsCore2 = 1;
-        firstCrossFreq0 = 0;
-        }
+    if (Serial.available() == 0) {
+      yield();
+      continue;
       }
-
-    int adc1Reading = 0;
-    int brightness1 = 0;
-    int hueShift1 = 0;
-
-    if (dacOn[1] == 1 && freq[1] < 17) {
-      adc1Reading = readAdc(29, 1);
-      hueShift1 = map(adc1Reading, -2048, 2048, -50, 45);
-      adc1Reading = adc1Reading - 2048;
-
-      adc1Reading = abs(adc1Reading);
-
-      brightness1 = map(adc1Reading, 0, 2050, 4, 100);
-
-      // lightUpNet(5, -1, 1, brightness1, hueShift1);
-      // showLEDsCore2 = 1;
-      // showLEDmeasurements();
-      firstCrossFreq1 = 1;
-      } else {
-      if (firstCrossFreq1 == 1) {
-        // lightUpNet(5);
-        // showLEDsCore2 = 1;
-        firstCrossFreq1 = 0;
+    char c = Serial.read();
+    if (c == '\r' || c == '\n') {
+      break;
+      }
+    if ((c >= '0' && c <= '9') || c == '.' || c == '-') {
+      if (length < (int)sizeof(typed) - 1) {
+        typed[length++] = c;
+        Serial.print(c);
         }
+      continue;
       }
+    length = 0;
+    break;
+    }
+  Serial.println();
+  if (length == 0) {
+    return fallback;
+    }
+  typed[length] = '\0';
+  return atof(typed);
+  }
 
-    if (now - lastTime > 100000) {
-      loopCounter++;
-      //
-      // int adc0Reading = analogRead(26);
-      // if (activeDac == 0)
-      // {
-      // for (int i = 0; i < (analogRead(27)/100); i++)
-      // {
-      // Serial.print('.');
-
-      // }
-      // Serial.println(' ');
-      // }
-      // else if (activeDac == 1)
-      // {
-
-      // for (int i = 0; i < (analogRead(29)/100); i++)
-      // {
-      // Serial.print('.');
+/// @brief Front end for the waveform engine, the waves run from a timer in
+/// the background so leaving here with x leaves them going
+int waveGen(void) {
+  listSpecialNets();
+  listNets();
 
-      // }
-      // Serial.println(' ');
-      // }
+  int activeDac = 0;
+  const char waveKeys[] = "sqtwr";
+  const int waveKeyShapes[] = { WAVE_SINE, WAVE_SQUARE, WAVE_TRIANGLE,
+                               WAVE_SAW, WAVE_NOISE };
 
-      lastTime = now;
-      // Serial.println(count); // show # updates per 0.1 second
-      count = 0;
+  printWaveGenMenu();
+  printWaveGenStatus(activeDac);
 
-      if (Serial.available() == 0) {
-        // break;
-        } else {
-        c = Serial.read();
-        switch (c) {
-          case '+':
-            if (freq[activeDac] >= 1.0) {
+  while (1) {
+    if (Serial.available() == 0) {
+      yield();
+      continue;
+      }
+    int c = Serial.read();
+    const char *waveKey = strchr(waveKeys, c);
+    float frequency = waveFrequency(activeDac);
 
-              freq[activeDac]++;
+    if (c != 0 && waveKey != nullptr) {
+      setWaveShape(activeDac, waveKeyShapes[waveKey - waveKeys]);
+      } else {
+      switch (c) {
+        case '+':
+          setWaveFrequency(activeDac, frequency >= 1.0 ? frequency + 1 : frequency + 0.1);
+          break;
+        case '-':
+          setWaveFrequency(activeDac, frequency > 1.0 ? frequency - 1 : frequency - 0.1);
+          break;
+        case '*':
+          setWaveFrequency(activeDac, frequency * 2);
+          break;
+        case '/':
+          setWaveFrequency(activeDac, frequency / 2);
+          break;
+        case 'f':
+          setWaveFrequency(activeDac, readWaveGenNumber("\n\renter frequency (Hz): ", frequency));
+          break;
+        case '5':
+        case '0':
+        case '8':
+        case '1': {
+          int dac = (c == '5' || c == '0') ? 0 : 1;
+          if (dac == activeDac) {
+            if (waveShapeOf(dac) == WAVE_OFF) {
+              setWaveShape(dac, WAVE_SINE);
               } else {
-              freq[activeDac] += 0.1;
+              stopWaveform(dac);
               }
-            break;
-          case '-':
-
-            if (freq[activeDac] > 1.0) {
-              freq[activeDac]--;
-              } else if (freq[activeDac] > 0.1) {
-                freq[activeDac] -= 0.1;
-                } else {
-                freq[activeDac] = 0.0;
-                }
-
-              break;
-          case '*':
-            freq[activeDac] *= 2;
-            break;
-          case '/':
-            freq[activeDac] /= 2;
-            break;
-          case '8':
-            if (activeDac == 0) {
-              setDac0voltage((float)0.0);
-              dacOn[0] = 0;
-              }
-
-            if (activeDac != 3)
-              dacOn[1] = !dacOn[1];
-
-            activeDac = 1;
-
-            if (dacOn[1] == 0) {
-              setDac1voltage((uint16_t)(offset[1] + calib[1]));
-              }
-
-            break;
-          case '5':
-            if (activeDac == 1) {
-              setDac1voltage((uint16_t)(offset[1] + calib[1]));
-              dacOn[1] = 0;
-              }
-
-            if (activeDac != 3)
-              dacOn[0] = !dacOn[0];
-
-            activeDac = 0;
-            if (dacOn[activeDac] == 0) {
-              setDac0voltage((float)0.0);
-              }
-            break;
-          case 'c':
-            // freq[activeDac] = 0;
-            break;
-
-          case 's': {
-          if (mode[2] == 'v') {
-            refillTable(amplitude[activeDac], offset[activeDac] + calib[1], 1);
-            mode[2] = 's';
             }
-
-          mode[activeDac] = c;
+          activeDac = dac;
           break;
-          }
-
-          case 'q':
-
-          case 'w':
-          case 't':
-          case 'r':
-          case 'z':
-          case 'm':
-
-            //
-            mode[2] = mode[activeDac];
-            mode[activeDac] = c;
-            break;
-
-          case 'v':
-          case 'h':
-          case 'a':
-          case 'o':
-
-            mode[2] = mode[activeDac];
-
-            mode[activeDac] = c;
-            break;
-          case '{':
-          case 'f': {
-          if (mode[0] != 'v') {
-            setDac0voltage((float)0.0);
-            }
-          if (mode[1] != 'v') {
-            setDac1voltage((uint16_t)offset[1]);
-            }
-          return 0;
-          }
-
-          case 'x': {
-          if (mode[0] != 'v') {
-            setDac0voltage((float)0.0);
-            }
-          if (mode[1] != 'v') {
-
-            setDac1voltage((uint16_t)offset[1]);
-            }
-
-          return 1;
-          }
-          default:
-            break;
-          }
-        period[activeDac] = 1e6 / freq[activeDac];
-        halvePeriod[activeDac] = period[activeDac] / 2;
-        if (activeDac == 0) {
-          Serial.print("dac 0:   ");
-          Serial.print("ampl: ");
-          Serial.print((float)(amplitude[activeDac]) / 819);
-          Serial.print("V\t");
-          Serial.print("offset: ");
-          Serial.print((float)(offset[activeDac]) / 819);
-          Serial.print("V\t\t");
-          Serial.print("mode: ");
-          Serial.print(mode[activeDac]);
-          Serial.print("\t\t");
-          Serial.print("freq: ");
-          Serial.print(freq[activeDac]);
-
-          // Serial.print("\t\n\r");
-          } else if (activeDac == 1) {
-            Serial.print("dac 1:   ");
-            Serial.print("ampl: ");
-            Serial.print((float)(amplitude[activeDac]) / 276);
-            Serial.print("V\t");
-            Serial.print("offset: ");
-            Serial.print(((float)(offset[activeDac]) / 276) - 7);
-            Serial.print("V\t\t");
-            Serial.print("mode: ");
-            Serial.print(mode[activeDac]);
-            Serial.print("\t\t");
-            Serial.print("freq: ");
-            Serial.print(freq[activeDac]);
-            // Serial.print("\t\n\r");
-            }
-          /*
-          Serial.print("\tdacon");
-          for (int i = 0; i < 3; i++)
-          {
-            Serial.print("\t");
-
-            Serial.print(dacOn[i]);
-          }*/
-          Serial.println();
         }
-      }
-
-    uint32_t t = now % period[activeDac];
-    // if (dacOn[activeDac] == 1 )
-    //{
-    switch (mode[activeDac]) {
-      case 'q':
-        if (t < halvePeriod[activeDac]) {
-          if (activeDac == 0 && dacOn[activeDac] == 1) {
-            setDac0voltage((uint16_t)amplitude[activeDac]);
-            lightUpNet(4, -1, 1, DEFAULTSPECIALNETBRIGHTNESS, 12);
-            showLEDsCore2 = 1;
-            } else if (activeDac == 1 && dacOn[activeDac] == 1) {
-              setDac1voltage((uint16_t)amplitude[activeDac]);
-
-              showLEDsCore2 = 1;
-              }
-          } else {
-          if (activeDac == 0 && dacOn[activeDac] == 1) {
-            setDac0voltage((float)0.0);
-            lightUpNet(4, -1, 1, 2, 12);
-            }
-
-          else if (activeDac == 1 && dacOn[activeDac] == 1) {
-            setDac1voltage((uint16_t)offset[activeDac]);
-            }
-          }
-        break;
-      case 'w':
-        if (activeDac == 0 && dacOn[activeDac] == 1)
-          setDac0voltage(
-              (uint16_t)(t * amplitude[activeDac] / period[activeDac]));
-        else if (activeDac == 1 && dacOn[activeDac] == 1)
-          setDac1voltage(
-              (uint16_t)(t * amplitude[activeDac] / period[activeDac]));
-        break;
-      case 't':
-        if (activeDac == 0 && dacOn[activeDac] == 1) {
-
-          if (t < halvePeriod[activeDac])
-            setDac0voltage(
-                (uint16_t)((t * amplitude[activeDac]) / halvePeriod[activeDac]));
-          else
-            setDac0voltage(
-                (uint16_t)(((period[activeDac] - t) * (amplitude[activeDac]) /
-                            halvePeriod[activeDac])));
-          } else if (activeDac == 1 && dacOn[activeDac] == 1) {
-            if (t < halvePeriod[activeDac])
-              setDac1voltage(
-                  (uint16_t)(t * amplitude[activeDac] / halvePeriod[activeDac]));
-            else
-              setDac1voltage(
-                  (uint16_t)((period[activeDac] - t) * amplitude[activeDac] /
-                             halvePeriod[activeDac]));
-            }
+        case 'a':
+          setWaveAmplitude(activeDac, readWaveGenNumber(activeDac == 0 ? "\n\renter amplitude (0-5): " : "\n\renter amplitude (0-16): ", waveAmplitude(activeDac)));
           break;
-      case 'r':
-        if (activeDac == 0 && dacOn[activeDac] == 1)
-          setDac0voltage((uint16_t)random(amplitude[activeDac]));
-        else if (activeDac == 1 && dacOn[activeDac] == 1) {
-          setDac1voltage((uint16_t)random(amplitude[activeDac]));
-          }
-        break;
-      case 'z': // zero
-        if (activeDac == 0)
-          setDac0voltage((float)0.0);
-        else if (activeDac == 1)
-          setDac1voltage((uint16_t)(offset[activeDac]));
-        break;
-      case 'h': // high
-        Serial.println(
-            "\n\r\t\t\t\t     waveGen\t\n\n\r\toptions\t\t\twaves\t\t\tadjust "
-            "frequency\n\r");
-        Serial.println(
-            "\t5/0 = dac 0 0-5V (togg)\tq = square\t\t+ = frequency++\n\r");
-        Serial.println(
-            "\t8/1 = dac 1 +-8V (togg)\ts = sine\t\t- = frequency--\n\r");
-        Serial.println(
-            "\ta = set amplitude (p-p)\tw = sawtooth\t\t* = frequency*2\n\r");
-        Serial.println("\to = set offset\t\tt = triangle\t\t/ = frequency/2\n\r");
-        Serial.println("\tv = voltage\t\tr = random\t\t \n\r");
-        Serial.println("\th = show this menu\tx = exit\t\t \n\r");
-        mode[activeDac] = mode[2];
-        break;
-      case 'm': // mid
-        // setDac1voltage(2047);
-        break;
-      case 'a': {
-      float newAmplitudeF = 0;
-      int newAmplitude = 0;
-      int input = 0;
-      char aC = 0;
-      int a = 0;
-      if (activeDac == 0) {
-
-        Serial.print("\n\renter amplitude (0-5): ");
-        while (Serial.available() == 0)
-          ;
-        aC = Serial.read();
-        if (aC == 'a')
-          aC = Serial.read();
-        a = aC;
-
-        Serial.print(aC);
-
-        if (a >= 48 && a <= 53) {
-
-          input = a - 48;
-          newAmplitude = input * 819;
-          unsigned long timeoutTimer = micros();
-          Serial.print(".");
-          while (Serial.available() == 0) {
-            if (micros() - timeoutTimer > 5000) {
-              a = '0';
-              break;
-              }
-            }
-
-          a = Serial.read();
-
-          if (a == '.') {
-
-            while (Serial.available() == 0) {
-              if (micros() - timeoutTimer > 5000) {
-                break;
-                }
-              }
-
-            a = Serial.read();
-            }
-
-          if (a >= 48 && a <= 57) {
-            Serial.print((char)a);
-            input = a - 48;
-            newAmplitude += input * 81.9;
-
-            amplitude[activeDac] = newAmplitude;
-            Serial.print("\tamplitude: ");
-            Serial.print((float)(amplitude[activeDac]) / 819);
-            Serial.println("V");
-            if ((offset[activeDac] - (amplitude[activeDac] / 2)) < 10 ||
-                ((amplitude[activeDac] / 2) - offset[activeDac]) < 10) {
-              offset[activeDac] = (amplitude[activeDac] / 2) - 1;
-              }
-            {
-            offset[activeDac] = (amplitude[activeDac] / 2) - 2;
-            }
-            refillTable(amplitude[activeDac], offset[activeDac], 0);
-
-            mode[activeDac] = mode[2];
-            mode[2] = '0';
-            break;
-            }
-          }
-        } else if (activeDac == 1) {
-
-          Serial.print("\n\renter peak amplitude (0-7.5): ");
-          while (Serial.available() == 0)
-            ;
-          aC = Serial.read();
-          if (aC == 'o')
-            aC = Serial.read();
-          a = aC;
-
-          Serial.print(aC);
-
-          if (a >= 48 && a <= 55) {
-
-            input = a - 48;
-            newAmplitude = input * 276;
-            Serial.print(".");
-            while (Serial.available() == 0)
-              ;
-            a = Serial.read();
-
-            if (a == '.') {
-              while (Serial.available() == 0)
-                ;
-
-              a = Serial.read();
-              }
-
-            if (a >= 48 && a <= 57) {
-              Serial.print((char)a);
-              input = a - 48;
-              newAmplitude += input * 27.6;
-              // newAmplitude *= 2;
-
-              amplitude[activeDac] = newAmplitude;
-              Serial.print("\tamplitude: ");
-              Serial.print((amplitude[activeDac]));
-              Serial.println(" ");
-              Serial.print((float)(amplitude[activeDac]) / 276);
-              Serial.println("V");
-
-              refillTable(amplitude[activeDac], offset[activeDac] + calib[1], 1);
-
-              mode[activeDac] = mode[2];
-              mode[2] = '0';
-              break;
-              }
-            }
-          }
-      }
-      case 'o': {
-
-      int newOffset = 0;
-      int input = 0;
-      char aC = 0;
-      int o = 0;
-      if (activeDac == 0) {
-
-        Serial.print("\n\renter offset (0-5): ");
-        while (Serial.available() == 0)
-          ;
-        aC = Serial.read();
-        if (aC == 'o')
-          aC = Serial.read();
-
-        o = aC;
-
-        Serial.print(aC);
-
-        if (o >= 48 && o <= 53) {
-
-          input = o - 48;
-          newOffset = input * 819;
-          Serial.print(".");
-          while (Serial.available() == 0)
-            ;
-          o = Serial.read();
-
-          if (o == '.') {
-            while (Serial.available() == 0)
-              ;
-
-            o = Serial.read();
-            }
-
-          if (o >= 48 && o <= 57) {
-            Serial.print((char)o);
-            input = o - 48;
-            newOffset += input * 81.9;
-
-            offset[activeDac] = newOffset;
-            Serial.print("\toffset: ");
-            Serial.print((float)(offset[activeDac]) / 819);
-            Serial.println("V");
-
-            refillTable(amplitude[activeDac], offset[activeDac], 0);
-
-            mode[activeDac] = mode[2];
-            break;
-            }
-          }
-        } else if (activeDac == 1) {
-          int negative = 0;
-
-          Serial.print("\n\rEnter offset (-7 - 7): ");
-          while (Serial.available() == 0)
-            ;
-          aC = Serial.read();
-          if (aC == '-') {
-            Serial.print('-');
-            negative = 1;
-            while (Serial.available() == 0)
-              ;
-            aC = Serial.read();
-            }
-
-          o = aC;
-
-          Serial.print(aC);
-
-          if (o >= 48 && o <= 55) {
-
-            input = o - 48;
-            newOffset = input * 276;
-
-            if (input == '7') {
-              Serial.print(".00");
-              } else {
-
-              Serial.print(".");
-              while (Serial.available() == 0)
-                ;
-              o = Serial.read();
-              if (o == '.') {
-                while (Serial.available() == 0)
-                  ;
-                o = Serial.read();
-                }
-
-              if (o >= 48 && o <= 57) {
-                Serial.print((char)o);
-                input = o - 48;
-                newOffset += input * 27.6;
-                }
-              }
-
-            if (negative == 1)
-              newOffset *= -1;
-
-            newOffset += (7 * 276);
-
-            offset[activeDac] = newOffset;
-            Serial.print("\toffset: ");
-            Serial.print(((float)(offset[activeDac]) / 276) - 7);
-            Serial.print("  ");
-            Serial.print(offset[activeDac]);
-            Serial.println("V");
-
-            refillTable(amplitude[activeDac], offset[activeDac] + calib[1], 1);
-
-            mode[activeDac] = mode[2];
-            break;
-            }
-          }
-      }
-      case 'v': {
-      if (activeDac == 0 && mode[2] != 'v') {
-        // freq[activeDac] = 0;
-        setDac0voltage((uint16_t)(amplitude[activeDac] / 819));
-        mode[2] = 'v';
-        } else if (activeDac == 1 && mode[2] != 'v') {
-          // freq[activeDac] = 0;
-          // refillTable(0, offset[activeDac] + calib[1], 1);
-          setDac1voltage((uint16_t)(((amplitude[activeDac] + calib[1]) / 276) -
-                                    ((offset[activeDac] / 276) - 7)));
-          mode[2] = 'v';
-          } else if (mode[2] == 'v') {
-            // mode[2] = 's';
-            }
-
+        case 'o':
+          setWaveOffset(activeDac, readWaveGenNumber(activeDac == 0 ? "\n\renter offset (0-5): " : "\n\renter offset (-8 - 8): ", waveOffset(activeDac)));
           break;
+        case 'v':
+        case 'z':
+          stopWaveform(activeDac);
+          break;
+        case 'h':
+          printWaveGenMenu();
+          break;
+        case '{':
+          return 0;
+        case 'x':
+          return 1;
+        default:
+          continue;
+        }
       }
-
-      default:
-      case 's':
-        // reference
-        // float f = ((PI * 2) * t)/period;
-        // setDac1voltage(2047 + 2047 * sin(f));
-        //
-        if (mode[activeDac] != 'v') {
-          int idx = (360 * t) / period[activeDac];
-          if (activeDac == 0 && dacOn[activeDac] == 1)
-            setDac0voltage(sine0[idx]); // lookuptable
-          else if (activeDac == 1 && dacOn[activeDac] == 1)
-            setDac1voltage(sine1[idx]); // lookuptable
-          }
-        break;
-      }
+    printWaveGenStatus(activeDac);
     }
   }
 
-void refillTable(int amplitude, int offset, int dac) {
-  // int offsetCorr = 0;
-  if (dac == 0) {
-    // offset = amplitude / 2;
-    }
-
-  for (int i = 0; i < 360; i++) {
-    if (dac == 0) {
-      sine0[i] = offset + round(amplitude / 2 * sin(i * PI / 180));
-      } else if (dac == 1) {
-        sine1[i] =
-          offset + round((amplitude - (offset - 2047)) / 2 * sin(i * PI / 180));
-        } else if (dac == 2) {
-          sine0[i] = offset + round(amplitude / 2 * sin(i * PI / 180));
-          sine1[i] = offset + round(amplitude / 2 * sin(i * PI / 180));
-          }
-    }
-  }
 // void GetAdc29Status(int i) {
 //   gpio_function gpio29Function = gpio_get_function(29);
 //   Serial.print("GPIO29 func: ");
@@ -123,7 +123,6 @@ void setDac1voltage(float value = 0.0, int save = 1, int saveEEPROM = 0, bool ch
 void setDac0voltage(uint16_t value);
 void setDac1voltage(uint16_t value);
 
-void refillTable(int amplitude = 2047, int offset = 2047, int adc = 2);
 int waveGen(void);
 void GetAdc29Status(int i);
 
@@ -0,0 +1,330 @@
+// SPDX-License-Identifier: MIT
+#include "ProbeRows.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//! Classifier section, down to the calibration section this only needs
+//! ProbeRows.h, so recorded per-row readings can be fit and checked on a PC
+
+void probeLinearCentroids(uint16_t *centroids, int probeMin, int probeMax) {
+  // map(reading, probeMin, probeMax, 101, 0) gives pad i for readings
+  // [min + (101 - i) * span / 101, min + (102 - i) * span / 101)
+  int32_t span = probeMax - probeMin;
+  centroids[0] = 0;
+  for (int pad = 1; pad <= PROBE_PADS; pad++) {
+    centroids[pad] = (uint16_t)(probeMin + ((2 * (PROBE_PADS - pad) + 1) * span) /
+                                               (2 * PROBE_PADS));
+  }
+}
+
+static int medianOf(uint16_t *values, int count) {
+  for (int i = 1; i < count; i++) {
+    uint16_t value = values[i];
+    int j = i - 1;
+    while (j >= 0 && values[j] > value) {
+      values[j + 1] = values[j];
+      j--;
+    }
+    values[j + 1] = value;
+  }
+  return count % 2 ? values[count / 2]
+                   : (values[count / 2 - 1] + values[count / 2] + 1) / 2;
+}
+
+// the slope between an end pad and a measured one up to this many pads in
+// carries on past the end, further in and the bow of the ladder shows
+#define PROBE_FIT_SLOPE_PADS 8
+
+/// @brief Where fill reads past the last measured pad at one end: along the
+/// slope to a measured pad further in, or the straight line moved over to the
+/// end pad if there's nothing else
+static int extendEnd(const uint16_t *measured, const uint8_t *keep,
+                     const uint16_t *linear, int end, int inward, int fill) {
+  int far = 0;
+  for (int pad = end + inward; pad >= 1 && pad <= PROBE_PADS &&
+                               abs(pad - end) <= PROBE_FIT_SLOPE_PADS;
+       pad += inward) {
+    if (keep[pad] == 1) {
+      far = pad;
+    }
+  }
+  int32_t reading;
+  if (far == 0) {
+    reading = linear[fill] + (measured[end] - linear[end]);
+  } else {
+    reading = measured[end] + ((int32_t)measured[far] - measured[end]) *
+                                  (fill - end) / (far - end);
+  }
+  if (reading < 0) {
+    reading = 0;
+  } else if (reading >= PROBE_LUT_SIZE) {
+    reading = PROBE_LUT_SIZE - 1;
+  }
+  return reading;
+}
+
+int probeFitCentroids(const uint8_t *pads, const uint16_t *readings, int count,
+                      int probeMin, int probeMax, uint16_t *centroids) {
+  uint16_t linear[PROBE_PADS + 1];
+  probeLinearCentroids(linear, probeMin, probeMax);
+
+  uint16_t measured[PROBE_PADS + 1] = {0};
+  uint16_t scratch[32];
+  for (int pad = 1; pad <= PROBE_PADS; pad++) {
+    int have = 0;
+    for (int i = 0; i < count && have < 32; i++) {
+      if (pads[i] == pad) {
+        scratch[have++] = readings[i];
+      }
+    }
+    if (have > 0) {
+      measured[pad] = medianOf(scratch, have);
+    }
+  }
+
+  // readings have to fall as the pad number goes up, keep the longest run of
+  // pads that does and drop the rest (a mistap or a pad read twice)
+  int runLength[PROBE_PADS + 1] = {0};
+  int runPrevious[PROBE_PADS + 1] = {0};
+  int best = 0;
+  for (int pad = 1; pad <= PROBE_PADS; pad++) {
+    if (measured[pad] == 0) {
+      continue;
+    }
+    runLength[pad] = 1;
+    for (int before = 1; before < pad; before++) {
+      if (runLength[before] > 0 && measured[before] > measured[pad] &&
+          runLength[before] + 1 > runLength[pad]) {
+        runLength[pad] = runLength[before] + 1;
+        runPrevious[pad] = before;
+      }
+    }
+    if (best == 0 || runLength[pad] > runLength[best]) {
+      best = pad;
+    }
+  }
+  uint8_t keep[PROBE_PADS + 1] = {0};
+  int good = 0;
+  for (int pad = best; pad > 0; pad = runPrevious[pad]) {
+    keep[pad] = 1;
+    good++;
+  }
+
+  int previous = 0; // last kept pad
+  for (int pad = 1; pad <= PROBE_PADS + 1; pad++) {
+    if (pad <= PROBE_PADS && keep[pad] == 0) {
+      continue;
+    }
+    // fill the pads between previous and this one
+    for (int fill = previous + 1; fill < pad && fill <= PROBE_PADS; fill++) {
+      if (previous == 0 && pad > PROBE_PADS) {
+        centroids[fill] = linear[fill]; // nothing measured at all
+      } else if (previous == 0) {
+        centroids[fill] = extendEnd(measured, keep, linear, pad, 1, fill);
+      } else if (pad > PROBE_PADS) {
+        centroids[fill] = extendEnd(measured, keep, linear, previous, -1, fill);
+      } else {
+        centroids[fill] = measured[previous] +
+                          ((int32_t)measured[pad] - measured[previous]) *
+                              (fill - previous) / (pad - previous);
+      }
+    }
+    if (pad <= PROBE_PADS) {
+      centroids[pad] = measured[pad];
+      previous = pad;
+    }
+  }
+  centroids[0] = 0;
+  return good;
+}
+
+void probeBuildLut(uint8_t *lut, const uint16_t *centroids, int minReading,
+                   int marginPercent) {
+  int pad = PROBE_PADS; // readings go up, pads go down
+  for (int reading = 0; reading < PROBE_LUT_SIZE; reading++) {
+    if (reading < minReading) {
+      lut[reading] = 0;
+      continue;
+    }
+    while (pad > 1 && abs(reading - centroids[pad - 1]) <
+                          abs(reading - centroids[pad])) {
+      pad--;
+    }
+    int distance = abs(reading - centroids[pad]);
+    int other = reading >= centroids[pad] ? pad - 1 : pad + 1;
+    if (other < 1 || other > PROBE_PADS) {
+      // past the end, allow a gap's worth before calling it nothing
+      int inner = pad == 1 ? 2 : PROBE_PADS - 1;
+      int gap = abs(centroids[pad] - centroids[inner]);
+      lut[reading] = distance > gap ? 0 : pad;
+      continue;
+    }
+    int gap = abs(centroids[pad] - centroids[other]);
+    int unsure = (gap - 2 * distance) * 100 < 2 * gap * marginPercent;
+    lut[reading] = pad | (unsure ? PROBE_LUT_UNSURE : 0);
+  }
+}
+
+//! Calibration section: the table lives in probeRows.txt next to config.txt,
+//! one "pad reading" pair a line, since it's too long for a config value
+
+#ifdef ARDUINO
+#include "NetManager.h"
+#include "Probing.h"
+#include "ProbeScanner.h"
+#include "config.h"
+#include "configManager.h"
+
+#include <Arduino.h>
+#include <FatFS.h>
+
+uint8_t probeLut[PROBE_LUT_SIZE];
+uint16_t probeCentroids[PROBE_PADS + 1];
+static int probeRowsCalibrated = 0;
+
+int probePadIndex(int reading) {
+  int sure;
+  int pad = probeLutPad(probeLut, reading, &sure);
+  return pad > 0 && sure == 1 ? pad : -1;
+}
+
+static int readProbeRowsFile(uint16_t *centroids) {
+  File file = FatFS.open(PROBE_ROWS_FILE, "r");
+  if (!file) {
+    return 0;
+  }
+  int found = 0;
+  memset(centroids, 0, sizeof(uint16_t) * (PROBE_PADS + 1));
+  while (file.available()) {
+    int pad = file.parseInt();
+    int reading = file.parseInt();
+    if (pad >= 1 && pad <= PROBE_PADS && reading > 0 &&
+        reading < PROBE_LUT_SIZE && centroids[pad] == 0) {
+      centroids[pad] = reading;
+      found++;
+    }
+  }
+  file.close();
+  return found == PROBE_PADS;
+}
+
+int loadProbeRows(void) {
+  probeRowsCalibrated = 0;
+  if (jumperlessConfig.calibration.probe_table == true &&
+      readProbeRowsFile(probeCentroids) == 1) {
+    probeRowsCalibrated = 1;
+  } else {
+    probeLinearCentroids(probeCentroids, jumperlessConfig.calibration.probe_min,
+                         jumperlessConfig.calibration.probe_max);
+  }
+  probeBuildLut(probeLut, probeCentroids, MINIMUM_PROBE_READING,
+                jumperlessConfig.calibration.probe_margin);
+  setProbeScannerTable(probeLut);
+  return probeRowsCalibrated;
+}
+
+int calibrateProbeRows(void) {
+  uint8_t pads[PROBE_PADS * 2];
+  uint16_t readings[PROBE_PADS * 2];
+  int count = 0;
+  int stopped = 0;
+
+  Serial.println("\n\rTap and hold each pad when it's named, lift off when the reading shows.");
+  Serial.println("Enter skips a pad (it's filled in from its neighbours), q stops here.\n\r");
+  setProbeScannerTable(nullptr); // raw readings, the old table may be what's off
+  flushProbeEvents();
+  while (Serial.available() > 0) {
+    Serial.read(); // the rest of the command line
+  }
+
+  for (int pad = 1; pad <= PROBE_PADS && stopped == 0; pad++) {
+    Serial.print("  pad ");
+    Serial.print(pad);
+    Serial.print("\t");
+    printNodeOrName(probeRowMapByPad[pad], 1);
+    Serial.print("\t");
+    int reading = 0;
+    while (reading == 0) {
+      if (Serial.available() > 0) {
+        char c = Serial.read();
+        if (c == 'q') {
+          stopped = 1;
+          break;
+        } else if (c == '\r' || c == '\n') {
+          break;
+        }
+      }
+      struct probeEvent event;
+      if (nextProbeEvent(&event, 0) == 1 && event.type == PROBE_EVENT_TOUCH) {
+        reading = event.raw;
+      }
+    }
+    if (reading == 0) {
+      Serial.println(stopped == 1 ? "stopped" : "skipped");
+      continue;
+    }
+    Serial.println(reading);
+    pads[count] = pad;
+    readings[count] = reading;
+    count++;
+    // wait for the lift so a long hold isn't read as the next pad
+    unsigned long start = millis();
+    while (millis() - start < 3000) {
+      struct probeEvent event;
+      if (nextProbeEvent(&event, 0) == 1 && event.type == PROBE_EVENT_RELEASE) {
+        break;
+      }
+    }
+  }
+
+  uint16_t centroids[PROBE_PADS + 1];
+  int good = probeFitCentroids(pads, readings, count,
+                               jumperlessConfig.calibration.probe_min,
+                               jumperlessConfig.calibration.probe_max,
+                               centroids);
+  Serial.print("\n\r");
+  Serial.print(good);
+  Serial.print(" of ");
+  Serial.print(count);
+  Serial.println(" readings fit, the rest of the pads were filled in");
+  if (good < 2) {
+    Serial.println("Not enough to go on, keeping the old table");
+    loadProbeRows();
+    return -1;
+  }
+
+  File file = FatFS.open(PROBE_ROWS_FILE, "w");
+  if (!file) {
+    Serial.println("Couldn't write " PROBE_ROWS_FILE);
+    loadProbeRows();
+    return -1;
+  }
+  for (int pad = 1; pad <= PROBE_PADS; pad++) {
+    file.printf("%d %d\n", pad, centroids[pad]);
+  }
+  file.close();
+  if (jumperlessConfig.calibration.probe_table == false) {
+    jumperlessConfig.calibration.probe_table = true;
+    saveConfig();
+  }
+  loadProbeRows();
+  Serial.println("Saved to " PROBE_ROWS_FILE);
+  return good;
+}
+
+void printProbeRows(void) {
+  Serial.print("\n\rProbe rows:\t");
+  Serial.print(probeRowsCalibrated == 1 ? "calibrated (" PROBE_ROWS_FILE ")"
+                                        : "straight line from probe_min / probe_max");
+  Serial.print(", ");
+  Serial.print(jumperlessConfig.calibration.probe_margin);
+  Serial.println("% margin");
+  for (int pad = 1; pad <= PROBE_PADS; pad++) {
+    Serial.print(pad);
+    Serial.print(":");
+    Serial.print(probeCentroids[pad]);
+    Serial.print(pad % 10 == 0 || pad == PROBE_PADS ? "\n\r" : "\t");
+  }
+}
+#endif
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: MIT
+#ifndef PROBEROWS_H
+#define PROBEROWS_H
+
+#include <stdint.h>
+
+#define PROBE_PADS 101        // probeRowMap[1..101], index 1 reads highest
+#define PROBE_LUT_SIZE 4096   // one entry per 12 bit reading
+#define PROBE_LUT_UNSURE 0x80 // too close to the line between two pads
+#define PROBE_LUT_PAD 0x7f
+#define PROBE_ROWS_FILE "probeRows.txt"
+
+//! Portable: only needs this header, so recorded per-row readings can be fit
+//! and classified on a PC
+
+/// @brief Where each pad would read if the sense ladder were a straight line
+/// from probe_max (pad 1) down to probe_min, the same as the old map() call
+void probeLinearCentroids(uint16_t *centroids, int probeMin, int probeMax);
+/// @brief Fit centroids[1..PROBE_PADS] from recorded (pad, reading) pairs.
+/// Each pad gets the median of its readings; readings out of order with
+/// their neighbours are dropped, and pads with none are interpolated (or
+/// carried on along the slope of the last few measured pads at the ends).
+/// Returns how many pads had good readings.
+int probeFitCentroids(const uint8_t *pads, const uint16_t *readings, int count,
+                      int probeMin, int probeMax, uint16_t *centroids);
+/// @brief Nearest centroid for every reading. Readings within marginPercent
+/// of a gap from the halfway point between two pads are flagged unsure;
+/// below minReading or more than a gap past either end reads as no pad.
+void probeBuildLut(uint8_t *lut, const uint16_t *centroids, int minReading,
+                   int marginPercent);
+/// @brief Pad index 1..PROBE_PADS, 0 for none. *sure = 0 if it's too close to
+/// call.
+static inline int probeLutPad(const uint8_t *lut, int reading, int *sure) {
+  if (reading < 0 || reading >= PROBE_LUT_SIZE) {
+    *sure = 0;
+    return 0;
+  }
+  uint8_t entry = lut[reading];
+  *sure = (entry & PROBE_LUT_UNSURE) == 0;
+  return entry & PROBE_LUT_PAD;
+}
+
+/// @brief The table everything classifies with, built by loadProbeRows()
+extern uint8_t probeLut[PROBE_LUT_SIZE];
+extern uint16_t probeCentroids[PROBE_PADS + 1];
+
+/// @brief Pad index for a reading, -1 if there's none or it's unsure
+int probePadIndex(int reading);
+/// @brief Build probeLut from probeRows.txt ([calibration] probe_table) or
+/// probe_min / probe_max. Returns 1 if the calibrated table was used.
+int loadProbeRows(void);
+/// @brief Walk through tapping every pad and save the fitted centroids
+int calibrateProbeRows(void);
+void printProbeRows(void);
+
+#endif
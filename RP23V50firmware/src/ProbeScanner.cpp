@@ -0,0 +1,372 @@
+// SPDX-License-Identifier: MIT
+#include "ProbeScanner.h"
+#include "ProbeRows.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//! Debounce section, down to the ADC section this only needs ProbeScanner.h,
+//! so it can be fed recorded ADC traces on a PC
+
+void probeDebounceReset(struct probeDebounce *debounce, int minReading) {
+  memset(debounce, 0, sizeof(*debounce));
+  debounce->minReading = minReading;
+  debounce->maxSpread = 4;     // same as readProbeRaw()
+  debounce->moveThreshold = 5; // rows are ~40 counts apart
+  debounce->settleLooks = 2;
+  debounce->releaseLooks = 3;
+  debounce->holdRepeatMicros = 500000; // justReadProbe(true) repeated this often
+}
+
+int probeLookMeasure(const uint16_t *blocks, int count, int *spread) {
+  int sum = 0;
+  int maxSpread = 0;
+  for (int i = 0; i < count; i++) {
+    sum += blocks[i];
+    if (i > 0) {
+      int step = abs((int)blocks[i] - (int)blocks[i - 1]);
+      if (step > maxSpread) {
+        maxSpread = step;
+      }
+    }
+  }
+  *spread = maxSpread;
+  return count > 0 ? sum / count : 0;
+}
+
+int probeLookPad(const uint8_t *lut, const uint16_t *blocks, int count) {
+  int pad = 0;
+  for (int i = 0; i < count; i++) {
+    int sure;
+    int blockPad = probeLutPad(lut, blocks[i], &sure);
+    if (blockPad == 0 || sure == 0 || (i > 0 && blockPad != pad)) {
+      return 0;
+    }
+    pad = blockPad;
+  }
+  return pad;
+}
+
+static int makeEvent(struct probeEvent *event, int type, int raw,
+                     uint32_t firstMicros, uint32_t now) {
+  event->type = type;
+  event->raw = raw;
+  event->firstMicros = firstMicros;
+  event->micros = now;
+  return 1;
+}
+
+int probeDebounceFeed(struct probeDebounce *debounce, const uint16_t *blocks,
+                      int count, uint32_t now, struct probeEvent *event) {
+  int spread;
+  int average = probeLookMeasure(blocks, count, &spread);
+
+  if (average < debounce->minReading) {
+    debounce->stableLooks = 0;
+    if (debounce->touching == 1 &&
+        ++debounce->emptyLooks >= debounce->releaseLooks) {
+      debounce->touching = 0;
+      return makeEvent(event, PROBE_EVENT_RELEASE, debounce->heldRaw, now, now);
+    }
+    return 0;
+  }
+  debounce->emptyLooks = 0;
+  int pad = 0;
+  if (debounce->lut != nullptr) {
+    pad = probeLookPad(debounce->lut, blocks, count);
+    if (pad == 0) {
+      debounce->stableLooks = 0; // sliding between rows, or right on the line
+      return 0;
+    }
+  } else if (spread > debounce->maxSpread) {
+    debounce->stableLooks = 0; // sliding between rows
+    return 0;
+  }
+
+  int same = debounce->lut != nullptr
+                 ? pad == debounce->candidatePad
+                 : abs(average - debounce->candidate) <= debounce->moveThreshold;
+  if (debounce->stableLooks > 0 && same) {
+    if (debounce->stableLooks <= debounce->settleLooks) {
+      debounce->stableLooks++;
+      debounce->candidateSum += average;
+    }
+  } else {
+    debounce->candidate = average;
+    debounce->candidatePad = pad;
+    debounce->candidateSum = average;
+    debounce->stableLooks = 1;
+    debounce->firstMicros = now;
+  }
+
+  if (debounce->stableLooks == debounce->settleLooks) {
+    int raw = (debounce->candidateSum + debounce->settleLooks / 2) /
+              debounce->settleLooks;
+    debounce->stableLooks++; // only settles once per run
+    int moved = debounce->lut != nullptr
+                    ? pad != debounce->heldPad
+                    : abs(raw - debounce->heldRaw) > debounce->moveThreshold;
+    if (debounce->touching == 0 || moved) {
+      debounce->touching = 1;
+      debounce->heldRaw = raw;
+      debounce->heldPad = pad;
+      debounce->holdMicros = now;
+      return makeEvent(event, PROBE_EVENT_TOUCH, raw, debounce->firstMicros,
+                       now);
+    }
+  } else if (debounce->touching == 1 &&
+             debounce->stableLooks > debounce->settleLooks &&
+             now - debounce->holdMicros >= debounce->holdRepeatMicros) {
+    debounce->holdMicros = now;
+    return makeEvent(event, PROBE_EVENT_HOLD, debounce->heldRaw, now, now);
+  }
+  return 0;
+}
+
+int probeButtonFeed(struct probeDebounce *debounce, int state, uint32_t now,
+                    struct probeEvent *event) {
+  // checkProbeButton() already reads it 3 ways and holds off repeats
+  if (state == debounce->buttons) {
+    return 0;
+  }
+  int previous = debounce->buttons;
+  debounce->buttons = state;
+  if (state == 0) {
+    return makeEvent(event, PROBE_EVENT_BUTTON_UP, previous, now, now);
+  }
+  return makeEvent(event,
+                   state == 2 ? PROBE_EVENT_CONNECT_BUTTON
+                              : PROBE_EVENT_REMOVE_BUTTON,
+                   state, now, now);
+}
+
+int probeQueuePush(struct probeEventQueue *queue,
+                   const struct probeEvent *event) {
+  uint32_t head = queue->head;
+  if (head - queue->tail >= PROBE_QUEUE_LENGTH) {
+    return 0;
+  }
+  queue->events[head & (PROBE_QUEUE_LENGTH - 1)] = *event;
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  queue->head = head + 1;
+  return 1;
+}
+
+int probeQueuePop(struct probeEventQueue *queue, struct probeEvent *event) {
+  uint32_t tail = queue->tail;
+  if (tail == queue->head) {
+    return 0;
+  }
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  *event = queue->events[tail & (PROBE_QUEUE_LENGTH - 1)];
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  queue->tail = tail + 1;
+  return 1;
+}
+
+void probeQueueClear(struct probeEventQueue *queue) { queue->tail = queue->head; }
+
+//! ADC section: a repeating timer takes one look a millisecond from the ADC
+//! engine's ring, so a tap gets seen however long core 0 is busy elsewhere.
+//! Whoever wants the probe pulls events off the queue.
+
+#ifdef ARDUINO
+#include "AdcEngine.h"
+#include "Peripherals.h"
+#include "Probing.h"
+
+#include <Arduino.h>
+
+#include "hardware/sync.h"
+#include "pico/time.h"
+
+volatile int probeScannerRunning = 0;
+struct probeScannerStats probeStats = {};
+
+static struct probeDebounce probeDebouncer;
+static struct probeEventQueue probeEvents;
+static int probeDebouncerReady = 0;
+static struct repeating_timer probeTimer;
+static volatile uint32_t probeListenMicros = 0;
+static uint32_t probeLastLook = 0;
+static unsigned long probeLastButtonPoll = 0;
+
+static void postProbeEvent(const struct probeEvent *event) {
+  switch (event->type) {
+  case PROBE_EVENT_TOUCH: {
+    probeStats.touches++;
+    uint32_t detect = event->micros - event->firstMicros;
+    probeStats.detectSum += detect;
+    if (detect > probeStats.detectMax) {
+      probeStats.detectMax = detect;
+    }
+    break;
+  }
+  case PROBE_EVENT_HOLD:
+    probeStats.holds++;
+    break;
+  case PROBE_EVENT_RELEASE:
+    probeStats.releases++;
+    break;
+  default:
+    probeStats.buttons++;
+    break;
+  }
+  if (event->micros - probeListenMicros > PROBE_LISTEN_US) {
+    return; // nobody's reading the probe, don't leave old taps lying around
+  }
+  // the timer and the fallback / button polls both push
+  uint32_t save = save_and_disable_interrupts();
+  int pushed = probeQueuePush(&probeEvents, event);
+  restore_interrupts(save);
+  if (pushed == 0) {
+    probeStats.dropped++;
+  }
+}
+
+static void probeLook(uint32_t now) {
+  if (blockProbing > 0) {
+    probeDebouncer.stableLooks = 0;
+    return;
+  }
+  uint16_t blocks[PROBE_LOOK_BLOCKS];
+  int count;
+  if (adcEngineRunning == 1) {
+    count = adcDecimate(PROBE_ADC_CHANNEL, PROBE_LOOK_FACTOR, blocks,
+                        PROBE_LOOK_BLOCKS);
+  } else {
+    for (count = 0; count < PROBE_LOOK_BLOCKS; count++) {
+      blocks[count] = readAdc(PROBE_ADC_CHANNEL, PROBE_LOOK_FACTOR);
+    }
+  }
+  if (count < PROBE_LOOK_BLOCKS) {
+    return; // right after the engine started
+  }
+  probeStats.looks++;
+  struct probeEvent event;
+  if (probeDebounceFeed(&probeDebouncer, blocks, count, now, &event) == 1) {
+    postProbeEvent(&event);
+  }
+}
+
+static bool probeTick(struct repeating_timer *timer) {
+  (void)timer;
+  if (adcEngineRunning == 1) {
+    probeLook(time_us_32());
+  }
+  return true;
+}
+
+static void readyProbeDebouncer(void) {
+  if (probeDebouncerReady == 0) {
+    probeDebounceReset(&probeDebouncer, MINIMUM_PROBE_READING);
+    probeDebouncerReady = 1;
+  }
+}
+
+void startProbeScanner(void) {
+  readyProbeDebouncer();
+  if (probeScannerRunning == 1 || adcEngineRunning == 0) {
+    return;
+  }
+  probeScannerRunning = 1;
+  add_repeating_timer_us(-PROBE_LOOK_US, probeTick, nullptr, &probeTimer);
+}
+
+void setProbeScannerTable(const uint8_t *lut) {
+  readyProbeDebouncer();
+  uint32_t save = save_and_disable_interrupts(); // the timer's mid-look otherwise
+  probeDebouncer.lut = lut;
+  probeDebouncer.stableLooks = 0;
+  probeDebouncer.touching = 0;
+  restore_interrupts(save);
+}
+
+void stopProbeScanner(void) {
+  if (probeScannerRunning == 0) {
+    return;
+  }
+  cancel_repeating_timer(&probeTimer);
+  probeScannerRunning = 0;
+}
+
+static void serviceProbeScanner(int buttons) {
+  readyProbeDebouncer();
+  uint32_t now = time_us_32();
+  probeListenMicros = now;
+  // the timer only looks while the engine's running
+  if ((probeScannerRunning == 0 || adcEngineRunning == 0) &&
+      now - probeLastLook >= PROBE_LOOK_US) {
+    probeLastLook = now;
+    probeLook(now);
+  }
+  if (buttons == 1 && millis() - probeLastButtonPoll >= PROBE_BUTTON_POLL_MS) {
+    probeLastButtonPoll = millis();
+    struct probeEvent event;
+    if (probeButtonFeed(&probeDebouncer, checkProbeButton(), time_us_32(),
+                        &event) == 1) {
+      postProbeEvent(&event);
+    }
+  }
+}
+
+int nextProbeEvent(struct probeEvent *event, int buttons) {
+  serviceProbeScanner(buttons);
+  while (probeQueuePop(&probeEvents, event) == 1) {
+    uint32_t now = time_us_32();
+    if (now - event->micros > PROBE_EVENT_MAX_AGE_US) {
+      probeStats.stale++;
+      continue;
+    }
+    if (event->type == PROBE_EVENT_TOUCH) {
+      uint32_t latency = now - event->firstMicros;
+      probeStats.consumed++;
+      probeStats.consumeSum += latency;
+      if (latency > probeStats.consumeMax) {
+        probeStats.consumeMax = latency;
+      }
+    }
+    return 1;
+  }
+  return 0;
+}
+
+void flushProbeEvents(void) { probeQueueClear(&probeEvents); }
+
+void printProbeScannerStats(void) {
+  Serial.print("\n\rProbe scanner:\t");
+  if (probeScannerRunning == 0) {
+    Serial.print("polled (ADC engine off), ");
+  } else {
+    Serial.print(PROBE_LOOK_US);
+    Serial.print(" us/look, ");
+  }
+  Serial.print(probeStats.looks);
+  Serial.print(" looks\ttouches ");
+  Serial.print(probeStats.touches);
+  Serial.print("\tholds ");
+  Serial.print(probeStats.holds);
+  Serial.print("\treleases ");
+  Serial.print(probeStats.releases);
+  Serial.print("\tbuttons ");
+  Serial.print(probeStats.buttons);
+  Serial.print("\tdropped ");
+  Serial.print(probeStats.dropped);
+  Serial.print("\tstale ");
+  Serial.println(probeStats.stale);
+  if (probeStats.touches > 0) {
+    Serial.print("  tap to event:\tavg ");
+    Serial.print((unsigned long)(probeStats.detectSum / probeStats.touches));
+    Serial.print(" us\tmax ");
+    Serial.print(probeStats.detectMax);
+    Serial.println(" us");
+  }
+  if (probeStats.consumed > 0) {
+    Serial.print("  tap to caller:\tavg ");
+    Serial.print((unsigned long)(probeStats.consumeSum / probeStats.consumed));
+    Serial.print(" us\tmax ");
+    Serial.print(probeStats.consumeMax);
+    Serial.println(" us");
+  }
+}
+#endif
@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: MIT
+#ifndef PROBESCANNER_H
+#define PROBESCANNER_H
+
+#include <stdint.h>
+
+#define PROBE_ADC_CHANNEL 5
+#define PROBE_LOOK_US 1000         // how often the probe ADC gets looked at
+#define PROBE_LOOK_BLOCKS 4        // a look is 4 means, like readProbeRaw()
+#define PROBE_LOOK_FACTOR 4        // of 4 samples each
+#define PROBE_QUEUE_LENGTH 16      // power of 2
+#define PROBE_EVENT_MAX_AGE_US 250000 // older than this when popped is dropped
+#define PROBE_LISTEN_US 1000000    // stop queueing when nobody has asked for this long
+#define PROBE_BUTTON_POLL_MS 20
+
+enum probeEventType {
+  PROBE_EVENT_NONE = 0,
+  PROBE_EVENT_TOUCH,   // settled on a new spot, raw is the reading
+  PROBE_EVENT_HOLD,    // still on it, repeats every holdRepeatMicros
+  PROBE_EVENT_RELEASE, // lifted off
+  PROBE_EVENT_REMOVE_BUTTON,
+  PROBE_EVENT_CONNECT_BUTTON,
+  PROBE_EVENT_BUTTON_UP
+};
+
+struct probeEvent {
+  uint8_t type;
+  int16_t raw;          // ADC reading for touches, button for button events
+  uint32_t firstMicros; // first look of the run that settled, ~ the tap
+  uint32_t micros;      // when the event was made
+};
+
+/// @brief Turns probe ADC looks into touch / hold / release events. A look is
+/// a few block means; it's steady if neighbouring blocks are within maxSpread,
+/// and a touch has to stay steady and within moveThreshold for settleLooks
+/// looks in a row. With a lut (ProbeRows.h) it's steady if every block lands
+/// surely on the same pad, and a touch is a change of pad.
+struct probeDebounce {
+  int minReading;    // below this nothing is touched
+  int maxSpread;
+  int settleLooks;
+  int releaseLooks;  // looks of nothing before it counts as lifted
+  int moveThreshold; // raw change that makes a new touch while held
+  uint32_t holdRepeatMicros;
+  const uint8_t *lut; // nullptr for raw readings
+
+  int touching;
+  int heldRaw;
+  int heldPad;
+  int candidate;
+  int candidatePad;
+  int32_t candidateSum;
+  int stableLooks;
+  int emptyLooks;
+  uint32_t firstMicros;
+  uint32_t holdMicros;
+  int buttons; // last checkProbeButton() state
+};
+
+/// @brief Single producer / single consumer ring of events
+struct probeEventQueue {
+  struct probeEvent events[PROBE_QUEUE_LENGTH];
+  volatile uint32_t head; // written by the producer
+  volatile uint32_t tail; // written by the consumer
+};
+
+//! Portable: only needs this header, so recorded ADC traces can be pushed
+//! through it on a PC
+void probeDebounceReset(struct probeDebounce *debounce, int minReading);
+/// @brief Pad the blocks all surely land on, 0 if they don't agree
+int probeLookPad(const uint8_t *lut, const uint16_t *blocks, int count);
+/// @brief Mean of the blocks, *spread = biggest step between neighbours
+int probeLookMeasure(const uint16_t *blocks, int count, int *spread);
+/// @brief Feed one look, returns 1 and fills *event if it made one
+int probeDebounceFeed(struct probeDebounce *debounce, const uint16_t *blocks,
+                      int count, uint32_t now, struct probeEvent *event);
+/// @brief Feed one checkProbeButton() state (0 none, 1 remove, 2 connect)
+int probeButtonFeed(struct probeDebounce *debounce, int state, uint32_t now,
+                    struct probeEvent *event);
+/// @brief Returns 0 if the queue is full
+int probeQueuePush(struct probeEventQueue *queue, const struct probeEvent *event);
+int probeQueuePop(struct probeEventQueue *queue, struct probeEvent *event);
+void probeQueueClear(struct probeEventQueue *queue); // consumer side
+
+struct probeScannerStats {
+  unsigned long looks;
+  unsigned long touches;
+  unsigned long holds;
+  unsigned long releases;
+  unsigned long buttons;
+  unsigned long dropped; // queue full
+  unsigned long stale;   // too old by the time anyone asked
+  unsigned long consumed;
+  uint32_t detectMax;    // us from the first steady look to the event
+  uint64_t detectSum;
+  uint32_t consumeMax;   // us from the first steady look to a caller getting it
+  uint64_t consumeSum;
+};
+
+extern volatile int probeScannerRunning;
+extern struct probeScannerStats probeStats;
+
+/// @brief Look at the probe from a timer off the ADC engine's ring. If the
+/// engine is off, looks are taken with readAdc() whenever events are asked for.
+void startProbeScanner(void);
+void stopProbeScanner(void);
+/// @brief Classify looks with this table (ProbeRows.h), nullptr for raw
+/// readings
+void setProbeScannerTable(const uint8_t *lut);
+/// @brief Next event for a caller, 0 if there isn't one. buttons = 1 polls
+/// the probe buttons too (it needs the LED pin, so only callers that want
+/// them should).
+int nextProbeEvent(struct probeEvent *event, int buttons);
+void flushProbeEvents(void);
+void printProbeScannerStats(void);
+
+#endif
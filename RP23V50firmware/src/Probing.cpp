@@ -7,6 +7,9 @@
 #include "NetManager.h"
 #include "NetsToChipConnections.h"
 #include "Peripherals.h"
+#include "AdcEngine.h"
+#include "ProbeScanner.h"
+#include "ProbeRows.h"
 // #include "AdcUsb.h"
 #include "Commands.h"
 #include "Graphics.h"
@@ -264,9 +267,9 @@ if (setOrClear == 1 && firstConnection == -1) {
     }
 
   if (setOrClear == 1) {
-    showProbeLEDs = 1;
+    queueProbeLEDs(1);
     } else {
-    showProbeLEDs = 2;
+    queueProbeLEDs(2);
     }
   //timer[4] = micros();  
   connectOrClearProbe = setOrClear;
@@ -276,7 +279,7 @@ if (setOrClear == 1 && firstConnection == -1) {
 
   // Serial.print("showProbeLEDs = ");
   // Serial.println(showProbeLEDs);
-  showLEDsCore2 = 1;
+  queueShowLEDs(1);
   unsigned long doubleSelectTimeout = millis();
   int doubleSelectCountdown = 0;
 
@@ -343,7 +346,7 @@ if (setOrClear == 1 && firstConnection == -1) {
           numberOfLocalChanges = 0;
           }
         }
-      // showLEDsCore2 = -1;
+      // queueShowLEDs(-1);
 
       } else {
       if (millis() - fadeTimer > 10) {
@@ -372,7 +375,7 @@ if (setOrClear == 1 && firstConnection == -1) {
           int fadeOffset = map(i, 0, deleteMissesIndex, 0, 12) + fadeFloor;
           if (fadeOffset > 12) {
             fadeOffset = 12;
-            // showLEDsCore2 = -1;
+            // queueShowLEDs(-1);
             }
           // clearLEDsExceptMiddle(deleteMisses[i], -1);
 
@@ -387,7 +390,7 @@ if (setOrClear == 1 && firstConnection == -1) {
 
         if (deleteMissesIndex == 0 && fadeClear == 0) {
           fadeClear = 1;
-          showLEDsCore2 = -1;
+          queueShowLEDs(-1);
           if (numberOfLocalChanges > 0) {
             saveLocalNodeFile(netSlot);
             // Serial.print("\n\r");
@@ -411,7 +414,7 @@ if (setOrClear == 1 && firstConnection == -1) {
           node1or2 = 0;
           clearLEDsExceptRails();
           probeHighlight = -1;
-          showLEDsCore2 = -1;
+          queueShowLEDs(-1);
 
           //Serial.println("setOrClear == 0");
           } else {
@@ -429,7 +432,7 @@ if (setOrClear == 1 && firstConnection == -1) {
           //           lastProbedRows[0] = -1;
           // lastProbedRows[1] = -1;
           clearLEDsExceptRails();
-          showLEDsCore2 = 1;
+          queueShowLEDs(1);
           node1or2 = 0;
           // showProbeLEDs = 1;
           goto restartProbing;
@@ -449,7 +452,7 @@ if (setOrClear == 1 && firstConnection == -1) {
 
               probeHighlight = -1;
               clearLEDsExceptRails();
-              showLEDsCore2 = -2;
+              queueShowLEDs(-2);
               // waitCore2();
               Serial.print("\r                                \r");
               Serial.flush();
@@ -465,7 +468,7 @@ if (setOrClear == 1 && firstConnection == -1) {
             probingTimer = millis();
             probeButtonTimer = millis();
             // showNets();
-            // showLEDsCore2 = 1;
+            // queueShowLEDs(1);
             sfProbeMenu = 0;
             connectedRowsIndex = 0;
             connectedRows[0] = -1;
@@ -486,7 +489,7 @@ if (setOrClear == 1 && firstConnection == -1) {
               //   Serial.print("    ");
               //  Serial.println(map(i, 0,deleteMissesIndex, 0, 19));
               }
-            showLEDsCore2 = 1;
+            queueShowLEDs(1);
 
             goto restartProbing;
             }
@@ -503,7 +506,7 @@ if (setOrClear == 1 && firstConnection == -1) {
         nodesToConnect[0] = -1;
         nodesToConnect[1] = -1;
         probeHighlight = -1;
-        showLEDsCore2 = -1;
+        queueShowLEDs(-1);
         break;
       } else {
       // probingTimer = millis();
@@ -572,28 +575,28 @@ if (setOrClear == 1 && firstConnection == -1) {
           //probeConnectHighlight = nodesToConnect[node1or2];
            // Serial.print("probeConnectHighlight = ");
            // Serial.println(probeConnectHighlight);
-           //showLEDsCore2 = 2;
+           //queueShowLEDs(2);
 
            // // b.clear();
           b.printRawRow(0b0010001, nodesToConnect[node1or2] - 1, 0x000121e,
                         0xfffffe);
-          showLEDsCore2 = 2;
+          queueShowLEDs(2);
           delay(30);
           b.printRawRow(0b00001010, nodesToConnect[node1or2] - 1, 0x0f0498,
                         0xfffffe);
-          showLEDsCore2 = 2;
+          queueShowLEDs(2);
           delay(30);
 
           b.printRawRow(0b00000100, nodesToConnect[node1or2] - 1, 0x4000e8,
                         0xfffffe);
-          showLEDsCore2 = 2;
+          queueShowLEDs(2);
           delay(50);
-          showLEDsCore2 = 2;
+          queueShowLEDs(2);
           }
 
         node1or2++;
         probingTimer = millis();
-        showLEDsCore2 = 1;
+        queueShowLEDs(1);
         doubleSelectTimeout = millis();
         doubleSelectCountdown = 200;
         // delay(500);
@@ -680,7 +683,7 @@ if (setOrClear == 1 && firstConnection == -1) {
           if (firstConnection == -3) {
             addBridgeToNodeFile(nodesToConnect[0], nodesToConnect[1], netSlot, 0);
             // refreshConnections(1, 1, 0);
-             //showLEDsCore2 = -1;
+             //queueShowLEDs(-1);
             break;
 
             } else {
@@ -835,13 +838,13 @@ if (setOrClear == 1 && firstConnection == -1) {
               refreshLocalConnections(0);
               //delay(10);
               waitCore2();
-              showLEDsCore2 = -1;
+              queueShowLEDs(-1);
 
-              //showLEDsCore2 = -1;
+              //queueShowLEDs(-1);
 
               // else {
 
-              // showLEDsCore2 = -1;
+              // queueShowLEDs(-1);
               // }
               //  refreshLocalConnections(1);
               //   deleteMissesIndex = 0;
@@ -849,7 +852,7 @@ if (setOrClear == 1 && firstConnection == -1) {
               //     deleteMisses[i] = -1;
               //   }
               //   delay(20);
-              //  showLEDsCore2 = -1;
+              //  queueShowLEDs(-1);
               fadeClear = 0;
               fadeTimer = 0;
               } else {
@@ -860,7 +863,7 @@ if (setOrClear == 1 && firstConnection == -1) {
 
           if (firstConnection == -3) {
             //
-            //showLEDsCore2 = 1;
+            //queueShowLEDs(1);
             //firstConnection = -1;
 
             break;
@@ -940,7 +943,7 @@ if (setOrClear == 1 && firstConnection == -1) {
   probeHighlight = -1;
   showProbeLEDs = 4;
   brightenNet(-1);
-  //showLEDsCore2 = 1;
+  //queueShowLEDs(1);
   // Serial.print("millis() - timer[0] = ");
   // Serial.println(millis() - timer[0]);
   // Serial.print("millis() - timer[1] = ");
@@ -952,7 +955,7 @@ if (setOrClear == 1 && firstConnection == -1) {
 
   Serial.flush();
 
-  // showLEDsCore2 = -1;
+  // queueShowLEDs(-1);
   //refreshLocalConnections(-1);
   // delay(10);
   if (firstConnection != -3 && numberOfLocalChanges > 0) {
@@ -962,14 +965,14 @@ if (setOrClear == 1 && firstConnection == -1) {
   refreshConnections(-1, 1, 0);
   row[0] = -1;
   row[1] = -2;
-  // showLEDsCore2 = -1;
+  // queueShowLEDs(-1);
    // sprintf(oledBuffer, "        ");
    // drawchar();
 
    // rotaryEncoderMode = wasRotaryMode;
    // routableBufferPower(0);
    // delay(10);
-     //showLEDsCore2 = -1;
+     //queueShowLEDs(-1);
   oled.showJogo32h();
 
   return 1;
@@ -989,7 +992,7 @@ float measureMode(int updateSpeed) {
   // refreshLocalConnections();
   float measurement = 0.0;
   while (checkProbeButton() == 0) {
-    measurement = (readAdc(7, 16) * (16.0 / 4090)) - 8.0;
+    measurement = (adcAverage(7, 16) * (16.0 / 4090)) - 8.0;
     if (measurement > -0.05 && measurement < 0.05) {
       measurement = 0.0;
       delay(1);
@@ -1173,7 +1176,7 @@ int selectSFprobeMenu(int function) {
       break;
       }
       }
-    // showLEDsCore2 = 2;
+    // queueShowLEDs(2);
     delayWithButton(900);
 
     // b.clear();
@@ -1182,7 +1185,7 @@ int selectSFprobeMenu(int function) {
     // lastReadRaw = 0;
     // b.print("Attach", sfOptionColors[0], 0xFFFFFF, 0, 0, -1);
     // b.print("to Pad", sfOptionColors[2], 0xFFFFFF, 0, 1, -1);
-    // showLEDsCore2 = 2;
+    // queueShowLEDs(2);
 
     // delayWithButton(800);
 
@@ -1196,7 +1199,7 @@ int selectSFprobeMenu(int function) {
 
     // Serial.print("function!!!!!: ");
     // printNodeOrName(function, 1);
-    showLEDsCore2 = 1;
+    queueShowLEDs(1);
     lightUpRail();
     delay(200);
     inPadMenu = 0;
@@ -1229,7 +1232,7 @@ int selectSFprobeMenu(int function) {
   connectedRowsIndex = 1;
   lightUpRail();
   // delay(500);
-  // showLEDsCore2 = 1;
+  // queueShowLEDs(1);
   // delayWithButton(900);
   sfProbeMenu = 0;
   inPadMenu = 0;
@@ -1257,7 +1260,7 @@ int attachPadsToSettings(int pad) {
   inPadMenu = 1;
   b.clear();
   clearLEDsExceptRails();
-  // showLEDsCore2 = 2;
+  // queueShowLEDs(2);
   //   lastReadRaw = 0;
   b.print("DAC", sfOptionColors[0], 0xFFFFFF, 0, 0, -1);
   b.print("ADC", sfOptionColors[1], 0xFFFFFF, 4, 0, 0);
@@ -1279,7 +1282,7 @@ int attachPadsToSettings(int pad) {
         // b.clear();
         settingOption = dacChosen - DAC0;
         clearLEDsExceptRails();
-        // showLEDsCore2 = 1;
+        // queueShowLEDs(1);
 
         break;
         }
@@ -1294,7 +1297,7 @@ int attachPadsToSettings(int pad) {
         // b.clear();
         clearLEDsExceptRails();
         delayWithButton(400);
-        // showLEDsCore2 = 1;
+        // queueShowLEDs(1);
 
         break;
         }
@@ -1303,12 +1306,12 @@ int attachPadsToSettings(int pad) {
         functionSetting = 2;
         // b.clear();
         clearLEDsExceptRails();
-        // showLEDsCore2 = 2;
+        // queueShowLEDs(2);
 
         gpioChosen = chooseGPIO(1);
         // b.clear();
         clearLEDsExceptRails();
-        // showLEDsCore2 = 2;
+        // queueShowLEDs(2);
         // if (gpioChosen >= 122 && gpioChosen <= 125) {
         //   gpioChosen = gpioChosen - 122 + 5;
         //   } else if (gpioChosen >= 135 && gpioChosen <= 138) {
@@ -1324,7 +1327,7 @@ int attachPadsToSettings(int pad) {
         Serial.println(gpioState[gpioChosen - 1]);
         if (gpioState[gpioChosen - 1] != 0) {
           clearLEDsExceptRails();
-          // showLEDsCore2 = 2;
+          // queueShowLEDs(2);
           Serial.print("Set GP");
           Serial.print(gpioChosen);
           Serial.println(" to Output");
@@ -1342,7 +1345,7 @@ int attachPadsToSettings(int pad) {
           b.printRawRow(0b00010101, 33, 0x200010, 0xffffff);
           b.printRawRow(0b00001110, 34, 0x200010, 0xffffff);
           b.printRawRow(0b00000100, 35, 0x200010, 0xffffff);
-          // showLEDsCore2 = 2;
+          // queueShowLEDs(2);
           delayWithButton(400);
 
           } else {
@@ -1355,14 +1358,14 @@ int attachPadsToSettings(int pad) {
         setGPIO();
         clearLEDsExceptRails();
 
-        // showLEDsCore2 = 2;
+        // queueShowLEDs(2);
         b.print("Tap to", sfOptionColors[(gpioChosen + 1) % 7], 0xFFFFFF, 0, 0,
                 1);
         b.print("toggle", sfOptionColors[(gpioChosen + 2) % 7], 0xFFFFFF, 0, 1,
                 1);
         delayWithButton(500);
         clearLEDsExceptRails();
-        // showLEDsCore2 = 1;
+        // queueShowLEDs(1);
         // inPadMenu = 0;
 
         break;
@@ -1451,7 +1454,7 @@ int attachPadsToSettings(int pad) {
   saveLogoBindings();
   delay(3);
   inPadMenu = 0;
-  showLEDsCore2 = 1;
+  queueShowLEDs(1);
   return function;
   }
 
@@ -1480,7 +1483,7 @@ int chooseDAC(int justPickOne) {
   int function = -1;
   // b.clear();
   clearLEDsExceptRails();
-  showLEDsCore2 = 2;
+  queueShowLEDs(2);
 
   // lastReadRaw = 0;
   b.print("DAC", scaleDownBrightness(rawOtherColors[9], 4, 22), 0xFFFFFF, 1, 0,
@@ -1522,7 +1525,7 @@ int chooseDAC(int justPickOne) {
           }
         setDac0voltage(voltageSelect(5));
         // showNets();
-        showLEDsCore2 = -1;
+        queueShowLEDs(-1);
         delay(100);
 
         break;
@@ -1536,7 +1539,7 @@ int chooseDAC(int justPickOne) {
           }
         setDac1voltage(voltageSelect(8));
         // showNets();
-        showLEDsCore2 = -1;
+        queueShowLEDs(-1);
         delay(100);
         break;
         }
@@ -1555,7 +1558,7 @@ int chooseADC(void) {
 
   // lastReadRaw = 0;
   // inPadMenu = 0;
-  // showLEDsCore2 = 2;
+  // queueShowLEDs(2);
 
   // waitCore2();
 
@@ -1578,7 +1581,7 @@ int chooseADC(void) {
   b.print("4", sfOptionColors[4], 0xFFFFFF, 4, 1, 3);
   b.print("P", sfOptionColors[5], 0xFFFFFF, 5, 1, 4);
 
-  showLEDsCore2 = 2;
+  queueShowLEDs(2);
   // Serial.print("inPadMenu: ");
   // Serial.println(inPadMenu);
   // Serial.print("sfProbeMenu: ");
@@ -1662,7 +1665,7 @@ int chooseADC(void) {
 
   clearLEDsExceptRails();
   // showNets();
-  // showLEDsCore2 = 1;
+  // queueShowLEDs(1);
   return function;
   }
 
@@ -1673,7 +1676,7 @@ int chooseGPIOinputOutput(int gpioChosen) {
   b.print(gpioChosen, sfOptionColors[gpioChosen - 1], 0xFFFFFF, 0, 0, -2);
   b.print("Output", sfOptionColors[gpioChosen % 7], 0xFFFFFF, 0, 1, 3);
 
-  showLEDsCore2 = -2;
+  queueShowLEDs(-2);
 
   // Serial.print("gpioChosen: ");
   // Serial.println(gpioChosen);
@@ -1712,7 +1715,7 @@ int chooseGPIOinputOutput(int gpioChosen) {
   Serial.flush();
   // clearLEDsExceptRails();
   // showNets();
-  // showLEDsCore2 = 1;
+  // queueShowLEDs(1);
   return settingOption;
   }
 
@@ -1721,7 +1724,7 @@ int chooseGPIO(int skipInputOutput) {
 
   b.clear();
   clearLEDsExceptRails();
-  showLEDsCore2 = 2;
+  queueShowLEDs(2);
   sfProbeMenu = 3;
   // lastReadRaw = 0;
   // b.print("3v", 0x0f0002, 0xFFFFFF, 0, 0, -2);
@@ -1963,7 +1966,7 @@ int chooseGPIO(int skipInputOutput) {
   // clearLEDsExceptRails();
   //  showNets();
 
-  showLEDsCore2 = -1;
+  queueShowLEDs(-1);
   //updateGPIOConfigFromState();
 
 
@@ -2051,7 +2054,7 @@ float voltageSelect(int fiveOrEight) {
 
               snprintf(voltageString, 7, "%0.1f v", voltageProbe);
               b.print(voltageString, color, 0xFFFFFF, 0, 1, 3);
-              showLEDsCore2 = -2;
+              queueShowLEDs(-2);
               delay(10);
             }
           if (checkProbeButton() > 0 || vSelected == 10) {
@@ -2064,7 +2067,7 @@ float voltageSelect(int fiveOrEight) {
             specialNetColors[4].b = rg.b;
             b.clear();
             // clearLEDsExceptRails();
-            // showLEDsCore2 = 1;
+            // queueShowLEDs(1);
             if (vSelected != 10) {
               vSelected = 1;
               } else {
@@ -2077,7 +2080,7 @@ float voltageSelect(int fiveOrEight) {
             // }
             vSelected = 1;
             return voltageProbe;
-            showLEDsCore2 = -1;
+            queueShowLEDs(-1);
             break;
             }
       }
@@ -2162,7 +2165,7 @@ float voltageSelect(int fiveOrEight) {
 
               snprintf(voltageString, 7, "%0.1f v", voltageProbe);
               b.print(voltageString, color, 0xFFFFFF, 0, 1, 3);
-              showLEDsCore2 = 2;
+              queueShowLEDs(2);
               Serial.print("\r                                           \r");
               Serial.print("DAC ");
               Serial.print(fiveOrEight ? "1:  " : "0:  ");
@@ -2181,7 +2184,7 @@ float voltageSelect(int fiveOrEight) {
             specialNetColors[4].b = rg.b;
             b.clear();
             // clearLEDsExceptRails();
-            // showLEDsCore2 = 1;
+            // queueShowLEDs(1);
             if (vSelected != 10) {
               vSelected = 1;
               } else {
@@ -2190,7 +2193,7 @@ float voltageSelect(int fiveOrEight) {
               // delay(500);
               }
             vSelected = 1;
-            showLEDsCore2 = -1;
+            queueShowLEDs(-1);
             return voltageProbe;
             break;
             }
@@ -2559,7 +2562,7 @@ int selectFromLastFound(void) {
       Serial.print("  ");
       }
     // leds.show();
-    showLEDsCore2 = 2;
+    queueShowLEDs(2);
     blinkTimer = millis();
     //  }
     delay(30);
@@ -2581,7 +2584,7 @@ int selectFromLastFound(void) {
       //         leds.setPixelColor(nodesToPixelMap[connectedRows[i]], 0, 0, 0);
       //     }
       // }
-      // showLEDsCore2 = 1;
+      // queueShowLEDs(1);
       // selected = lastFound[node1or2][selected];
       //  clearLastFound();
 
@@ -2604,7 +2607,7 @@ int selectFromLastFound(void) {
       //  }
       //}
 
-      // showLEDsCore2 = 1;
+      // queueShowLEDs(1);
     }
   selected2 = connectedRows[selected];
 
@@ -2626,7 +2629,7 @@ int selectFromLastFound(void) {
     }
 
   // leds.setPixelColor(nodesToPixelMap[selected2], rainbowList[0][0],
-  // rainbowList[0][1], rainbowList[0][2]); leds.show(); showLEDsCore2 = 1;
+  // rainbowList[0][1], rainbowList[0][2]); leds.show(); queueShowLEDs(1);
   probeButtonTimer = millis();
   // connectedRowsIndex = 0;
   //justSelectedConnectedNodes = 1;
@@ -2961,7 +2964,7 @@ int readFloatingOrState(int pin, int rowBeingScanned) {//this is the old probe r
     }
 
   // Serial.print("\n");
-  // showLEDsCore2 = 1;
+  // queueShowLEDs(1);
   // leds.show();
   // delayMicroseconds(100);
 
@@ -3185,7 +3188,12 @@ void checkPads(void) {
 
   /* clang-format on */
   //probeReading = probeRowMap[map(probeReading, 30, 4050, 101, 0)];
-  probeReading = probeRowMap[map(probeReading, jumperlessConfig.calibration.probe_min, jumperlessConfig.calibration.probe_max, 101, 0)];
+  int padIndex = probePadIndex(probeReading);
+  if (padIndex < 0) {
+    checkingPads = 0; // between two pads, wait for a better look
+    return;
+    }
+  probeReading = probeRowMap[padIndex];
   // stopProbe();
 
 
@@ -3447,18 +3455,25 @@ unsigned long lastProbeTime = millis();
 int lastProbeRead = 0;
 int lastRowProbed = -1;
 
-unsigned long lastDuplicateTime = millis();
-int lastDuplicateRead = 0;
 
 
+/// @brief Pops probe events (see ProbeScanner.h) until a touch, or a hold
+/// with allowDuplicates, and maps it to a row. Non-blocking.
 int justReadProbe(bool allowDuplicates, int rawPad) {
 
   if (blockProbing > 0) {
+    flushProbeEvents();
     return -1;
     }
-  int probeRead = readProbeRaw(0, allowDuplicates);
-
-
+  struct probeEvent event;
+  int probeRead = -1;
+  while (nextProbeEvent(&event, 0) == 1) {
+    if (event.type == PROBE_EVENT_TOUCH ||
+        (event.type == PROBE_EVENT_HOLD && allowDuplicates)) {
+      probeRead = event.raw;
+      break;
+      }
+    }
 
   if (probeRead <= 0) {
 
@@ -3468,11 +3483,14 @@ int justReadProbe(bool allowDuplicates, int rawPad) {
   // Serial.println(probeRead);
 
   //int rowProbed = map(probeRead, mapFrom, 4045, 101, 0);
-  int rowProbed = map(probeRead, jumperlessConfig.calibration.probe_min, jumperlessConfig.calibration.probe_max, 101, 0);
+  int rowProbed = probePadIndex(probeRead);
   // Serial.print("rowProbed: ");
   // Serial.println(rowProbed);
 
-  if (rowProbed <= 0 || rowProbed > sizeof(probeRowMap)) {
+  if (rowProbed < 0) {
+    return -1; // too close to the line between two pads to call
+    }
+  if (rowProbed == 0 || rowProbed > sizeof(probeRowMap)) {
     //if (debugProbing == 1) {
     Serial.print("out of bounds of probeRowMap[");
     Serial.println(rowProbed);
@@ -3480,42 +3498,7 @@ int justReadProbe(bool allowDuplicates, int rawPad) {
     return -1;
     }
 
-
-  if (allowDuplicates) {
-    // Check if the mapped row is the same, not just the raw reading
-    if (probeRowMapByPad[rowProbed] == lastRowProbed) {
-      // If the timer hasn't elapsed, reject the duplicate reading
-      if (millis() - lastDuplicateTime < 500) {
-        if (debugProbing == 1) {
-          Serial.print("Rejected duplicate row: ");
-          Serial.println(probeRowMap[rowProbed]);
-          }
-        return -1;
-        } else {
-        // Timer has elapsed, accept the reading and reset timer
-        lastDuplicateTime = millis();
-        lastProbeRead = probeRead;
-        // Return the same reading now that timer is complete
-        if (rawPad == 1) {
-          return probeRowMapByPad[rowProbed];
-          } else {
-          return probeRowMap[rowProbed];
-          }
-        }
-      } else {
-      // Different row, reset timer and update last values
-      lastDuplicateTime = millis();
-      lastProbeRead = probeRead;
-      lastRowProbed = probeRowMapByPad[rowProbed];
-      if (rawPad == 1) {
-        return probeRowMapByPad[rowProbed];
-        } else {
-        return probeRowMap[rowProbed];
-        }
-      }
-    }
-
-  // For non-allowDuplicates case
+  // the scanner only repeats a row (as a hold) every 500ms while it's held
   lastProbeRead = probeRead;
   lastRowProbed = probeRowMapByPad[rowProbed];
   if (rawPad == 1) {
@@ -3529,7 +3512,6 @@ int justReadProbe(bool allowDuplicates, int rawPad) {
 int readProbe() {
   int found = -1;
   // connectedRows[0] = -1;
-  unsigned long buttonCheck = 0;
   // if (checkProbeButton() == 1) {
   //   return -18;
   // }
@@ -3537,16 +3519,30 @@ int readProbe() {
     return -1;
     }
 
-  int probeRead = readProbeRaw();
-  // delay(100);
-  // Serial.println(probeRead);
+  int probeRead = -1;
+  struct probeEvent event;
   // Serial.println(debugLEDs);
   while (probeRead <= 0) {
     /// delay(50);
     // return -1;
     // Serial.println(debugLEDs);
 
-    probeRead = readProbeRaw();
+    // taps are picked up in the background, this just takes the next one
+    if (nextProbeEvent(&event, 1) == 1) {
+      if (event.type == PROBE_EVENT_TOUCH) {
+        probeRead = event.raw;
+        break;
+        } else if (event.type == PROBE_EVENT_REMOVE_BUTTON) {
+          blockProbeButton = 5000;
+          blockProbeButtonTimer = millis();
+          return -18;
+          } else if (event.type == PROBE_EVENT_CONNECT_BUTTON) {
+            blockProbeButton = 5000;
+            blockProbeButtonTimer = millis();
+            return -16;
+            }
+      continue;
+      }
     //rotaryEncoderStuff();
 
     if (encoderDirectionState != NONE) {
@@ -3566,63 +3562,20 @@ int readProbe() {
       return -10;
       }
 
-    // buttonCheck = millis();
-    if (millis() - buttonCheck > 20) {
-      buttonCheck = millis();
-      int buttonState = checkProbeButton();
-      if (buttonState == 1) {
-        blockProbeButton = 5000;
-        blockProbeButtonTimer = millis();
-        return -18;
-        } else if (buttonState == 2) {
-          blockProbeButton = 5000;
-          blockProbeButtonTimer = millis();
-          return -16;
-          }
-      }
-
-    // delayMicroseconds(200);
-
-    if (millis() - doubleTimeout > 1000) {
-      doubleTimeout = millis();
-      lastReadRaw = 0;
-      }
-
     if (millis() - lastProbeTime > 50) {
       lastProbeTime = millis();
       // Serial.println("probe timeout");
       return -1;
       }
     }
-  doubleTimeout = millis();
   if (debugProbing == 1) {
     // Serial.print("probeRead: ");
     // Serial.println(probeRead);
     }
-  if (probeRead == -1) {
-    return -1;
-    }
-
-  if (probeRead < 300) { // take an average if it's a logo pad
-    int probeReadings[4] = {0};
-    for (int i = 0; i < 4; i++) {
-      probeReadings[i] = readProbeRaw(0, 1);
-    }
-    int probeReading = 0;
-    int numberOfGoodReadings = 0;
-    for (int i = 0; i < 4; i++) {
-      if (probeReadings[i] > 0) {
-        probeReading += probeReadings[i];
-        numberOfGoodReadings++;
-      }
-    }
-    probeRead = probeReading / numberOfGoodReadings;
-    // Serial.print("probeRead: ");
-    // Serial.println(probeRead);
-    // Serial.flush();
-  }
+  // logo pads used to get 4 more reads averaged here, the scanner already
+  // averages every look that settled
 
-  int rowProbed = map(probeRead, jumperlessConfig.calibration.probe_min, jumperlessConfig.calibration.probe_max, 101, 0);
+  int rowProbed = probePadIndex(probeRead);
   // Serial.print("\n\n\rprobeRead: ");
   // Serial.println(probeRead);
 
@@ -3773,7 +3726,7 @@ int scanRows(int pin) {
             //     rainbowList[rainbowIndex][0], rainbowList[rainbowIndex][1],
             //     rainbowList[rainbowIndex][2]);
             // }
-            // showLEDsCore2 = 1;
+            // queueShowLEDs(1);
             if (found != -1) {
               connectedRows[connectedRowsIndex] = found;
               connectedRowsIndex++;
@@ -3828,7 +3781,7 @@ int scanRows(int pin) {
               //     rainbowList[rainbowIndex][0], rainbowList[rainbowIndex][1],
               //     rainbowList[rainbowIndex][2]);
               // }
-              // //showLEDsCore2 = 1;
+              // //queueShowLEDs(1);
               // // leds.show();
 
               if (found != -1) {
@@ -3850,6 +3803,7 @@ int scanRows(int pin) {
         digitalWrite(RESETPIN, HIGH);
         delayMicroseconds(20);
         digitalWrite(RESETPIN, LOW);
+        markCrosspointsDesynced();
         return connectedRows[0];
         // return found;
 
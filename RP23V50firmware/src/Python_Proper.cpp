@@ -2971,6 +2971,7 @@ void displayStringWithSyntaxHighlighting(const String& text, Stream* stream) {
     "gpio_set", "gpio_get", "gpio_set_dir", "gpio_get_dir", "gpio_set_pull", "gpio_get_pull",
     "set_gpio", "get_gpio", "set_gpio_dir", "get_gpio_dir", "set_gpio_pull", "get_gpio_pull",
     "connect", "disconnect", "is_connected", "nodes_clear", "node",
+    "begin_batch", "commit", "cancel_batch",
     "oled_print", "oled_clear", "oled_connect", "oled_disconnect",
     "clickwheel_up", "clickwheel_down", "clickwheel_press",
     "print_bridges", "print_paths", "print_crossbars", "print_nets", "print_chip_status",
@@ -3371,6 +3372,7 @@ static const char* jumperless_functions[] = {
   "set_gpio_direction", "get_gpio_direction",
   // Node functions
   "connect", "disconnect", "nodes_clear", "is_connected",
+  "begin_batch", "commit", "cancel_batch",
   "connect_nodes", "disconnect_nodes", "clear_nodes", "clear_connections", "nodes_connected", "connected",
   // OLED functions
   "oled_print", "oled_clear", "oled_show", "oled_connect", "oled_disconnect",
@@ -191,7 +191,7 @@ void rotaryEncoderStuff(void) {
     doubleClickTimer = millis();
     buttonDebounceTimer2 = micros();
 
-    showLEDsCore2 = 1;
+    queueShowLEDs(1);
     encoderWasPressed = encoderIsPressed;
   }
 
@@ -434,7 +434,7 @@ void slotManager(void) {
       showSavedColors(netSlot);
       // lightUpRail();
       //  leds.show();
-      // showLEDsCore2 = 1;
+      // queueShowLEDs(1);
       slotChanged = 1;
     }
 
@@ -463,7 +463,7 @@ void slotManager(void) {
       Serial.print("\t");
     }
     previewTimer = millis();
-    showLEDsCore2 = 1;
+    queueShowLEDs(1);
   }
 
   if (lastSlotPreview != slotPreview) {
@@ -471,7 +471,7 @@ void slotManager(void) {
     b.print("Slot ", (uint32_t)0x050007);
     b.print(slotPreview, 5);
 
-    showLEDsCore2 = 1;
+    queueShowLEDs(1);
     lastSlotPreview = slotPreview;
 
     // lastPosition = position;
@@ -0,0 +1,573 @@
+// SPDX-License-Identifier: MIT
+#include "SerialBridge.h"
+
+#include <string.h>
+
+//! Ring and pump section, down to the UART section this only needs
+//! SerialBridge.h, so it can be run on a PC against a loopback bridgeBackend
+
+uint32_t ringUsed(struct bridgeRing *ring) { return ring->head - ring->tail; }
+
+uint32_t ringFree(struct bridgeRing *ring) {
+  uint32_t used = ringUsed(ring);
+  return used >= ring->size ? 0 : ring->size - used;
+}
+
+uint32_t ringWrite(struct bridgeRing *ring, const uint8_t *data, uint32_t len) {
+  uint32_t space = ringFree(ring);
+  if (len > space) {
+    len = space;
+  }
+  uint32_t index = ring->head & (ring->size - 1);
+  uint32_t first = ring->size - index;
+  if (first > len) {
+    first = len;
+  }
+  memcpy(ring->buf + index, data, first);
+  memcpy(ring->buf, data + first, len - first);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  ring->head += len;
+  return len;
+}
+
+uint32_t ringRead(struct bridgeRing *ring, uint8_t *data, uint32_t len) {
+  uint32_t used = ringUsed(ring);
+  if (len > used) {
+    len = used;
+  }
+  uint32_t index = ring->tail & (ring->size - 1);
+  uint32_t first = ring->size - index;
+  if (first > len) {
+    first = len;
+  }
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  memcpy(data, ring->buf + index, first);
+  memcpy(data + first, ring->buf, len - first);
+  ring->tail += len;
+  return len;
+}
+
+uint32_t ringContiguous(struct bridgeRing *ring, uint8_t **start) {
+  uint32_t used = ringUsed(ring);
+  uint32_t index = ring->tail & (ring->size - 1);
+  *start = ring->buf + index;
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  return used < ring->size - index ? used : ring->size - index;
+}
+
+int pumpBridge(struct bridgeEngine *engine) {
+  const struct bridgeBackend *backend = engine->backend;
+  struct serialBridgeStats *stats = &engine->stats;
+  int sent = 0;
+  int received = 0;
+
+  stats->pumps++;
+
+  //! line -> host
+  backend->lineRxSync();
+
+  uint32_t depth = ringUsed(&engine->rx);
+
+  if (depth > engine->rx.size) {
+    // the line lapped us, skip past the overwritten part with a bit of margin
+    // so we aren't reading right behind the writer
+    uint32_t lost = depth - engine->rx.size + engine->rx.size / 4;
+    engine->rx.tail += lost;
+    depth -= lost;
+    stats->rxOverflows++;
+    stats->rxLostBytes += lost;
+  }
+  if (depth > stats->maxRxDepth) {
+    stats->maxRxDepth = depth;
+  }
+
+  while (depth > 0) {
+    int room = backend->hostWriteRoom();
+    if (room <= 0) {
+      stats->hostStalls++;
+      break;
+    }
+    uint8_t *start;
+    uint32_t run = ringContiguous(&engine->rx, &start);
+    if (run > (uint32_t)room) {
+      run = room;
+    }
+    int wrote = backend->hostWrite(start, run);
+    if (wrote <= 0) {
+      stats->hostStalls++;
+      break;
+    }
+    if (engine->tap != nullptr) {
+      engine->tap(-1, start, wrote);
+    }
+    engine->rx.tail += wrote;
+    received += wrote;
+    depth -= wrote;
+  }
+
+  //! host -> line
+  int available = backend->hostAvailable();
+
+  while (available > 0) {
+    uint32_t space = ringFree(&engine->tx);
+    if (space == 0) {
+      // leave it in the USB buffer, the host gets NAKed until we catch up
+      stats->lineStalls++;
+      break;
+    }
+    uint32_t index = engine->tx.head & (engine->tx.size - 1);
+    uint32_t run = engine->tx.size - index;
+    if (run > space) {
+      run = space;
+    }
+    if (run > (uint32_t)available) {
+      run = available;
+    }
+    int got = backend->hostRead(engine->tx.buf + index, run);
+    if (got <= 0) {
+      break;
+    }
+    if (engine->tap != nullptr) {
+      engine->tap(1, engine->tx.buf + index, got);
+    }
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    engine->tx.head += got;
+    sent += got;
+    available = backend->hostAvailable();
+  }
+
+  if (ringUsed(&engine->tx) > stats->maxTxDepth) {
+    stats->maxTxDepth = ringUsed(&engine->tx);
+  }
+
+  backend->lineTxKick();
+
+  stats->toLine += sent;
+  stats->toHost += received;
+
+  return sent > 0 ? sent : 0 - received;
+}
+
+//! UART section: UART0 (the Nano header TX/RX) with a DMA channel each way
+
+#ifdef ARDUINO
+#include "ArduinoStuff.h"
+
+#include <Arduino.h>
+
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/uart.h"
+
+#define BRIDGE_UART uart0
+#define BRIDGE_RX_RING_BITS 12
+#define BRIDGE_RX_SIZE (1 << BRIDGE_RX_RING_BITS) // ~40ms of slack at 1Mbaud
+#define BRIDGE_TX_SIZE 2048
+#define BRIDGE_RX_DMA_COUNT 0x0fffffffu
+#define BRIDGE_RX_REARM_AT (BRIDGE_RX_SIZE * 4)
+
+static uint8_t bridgeRxBuffer[BRIDGE_RX_SIZE]
+    __attribute__((aligned(BRIDGE_RX_SIZE)));
+static uint8_t bridgeTxBuffer[BRIDGE_TX_SIZE];
+
+static int rxDmaChannel = -1;
+static int txDmaChannel = -1;
+static uint32_t rxArmedBase = 0;
+static volatile uint32_t txInFlight = 0;
+static spin_lock_t *bridgeTxLock = nullptr;
+static volatile bool bridgePumping = false;
+static unsigned long bridgeBaud = 115200;
+static uint8_t bridgeNumbits = 8;
+static uint8_t bridgeParity = 0;
+static uint8_t bridgeStopbits = 0;
+
+volatile int serialBridgeRunning = 0;
+
+static uint32_t uartRxSync(void);
+static void uartTxKick(void);
+
+static int usbAvailable(void) { return USBSer1.available(); }
+
+static int usbRead(uint8_t *data, int len) { return USBSer1.read(data, len); }
+
+static int usbWriteRoom(void) { return USBSer1.availableForWrite(); }
+
+static int usbWrite(const uint8_t *data, int len) {
+  int wrote = USBSer1.write(data, len);
+  USBSer1.flush(); // doesn't block, just pushes out the partial packet
+  return wrote;
+}
+
+static const struct bridgeBackend uartBackend = {
+    uartRxSync, uartTxKick, usbAvailable, usbRead, usbWriteRoom, usbWrite,
+};
+
+struct bridgeEngine serialBridge = {
+    {bridgeRxBuffer, BRIDGE_RX_SIZE, 0, 0},
+    {bridgeTxBuffer, BRIDGE_TX_SIZE, 0, 0},
+    &uartBackend,
+    {},
+    nullptr,
+};
+
+static uint32_t rxDmaRemaining(void) {
+  return dma_channel_hw_addr(rxDmaChannel)->transfer_count &
+         BRIDGE_RX_DMA_COUNT;
+}
+
+static void armRxDma(void) {
+  dma_channel_config config = dma_channel_get_default_config(rxDmaChannel);
+  channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+  channel_config_set_read_increment(&config, false);
+  channel_config_set_write_increment(&config, true);
+  channel_config_set_ring(&config, true, BRIDGE_RX_RING_BITS);
+  channel_config_set_dreq(&config, uart_get_dreq(BRIDGE_UART, false));
+
+  rxArmedBase = serialBridge.rx.head;
+  dma_channel_configure(
+      rxDmaChannel, &config,
+      bridgeRxBuffer + (rxArmedBase & (BRIDGE_RX_SIZE - 1)),
+      &uart_get_hw(BRIDGE_UART)->dr, BRIDGE_RX_DMA_COUNT, true);
+}
+
+static uint32_t uartRxSync(void) {
+  uint32_t previous = serialBridge.rx.head;
+  uint32_t head = rxArmedBase + (BRIDGE_RX_DMA_COUNT - rxDmaRemaining());
+
+  if (rxDmaRemaining() < BRIDGE_RX_REARM_AT) {
+    // every ~45 minutes at 1Mbaud, the UART FIFO holds anything that shows
+    // up while the channel is stopped
+    dma_channel_abort(rxDmaChannel);
+    head = rxArmedBase + (BRIDGE_RX_DMA_COUNT - rxDmaRemaining());
+    serialBridge.rx.head = head;
+    armRxDma();
+    serialBridge.stats.dmaRearms++;
+  }
+
+  serialBridge.rx.head = head;
+  return head - previous;
+}
+
+/// @brief Start the next tx run if the channel is idle, call with bridgeTxLock
+static void kickTxLocked(void) {
+  if (txInFlight != 0 || dma_channel_is_busy(txDmaChannel)) {
+    return;
+  }
+  uint8_t *start;
+  uint32_t run = ringContiguous(&serialBridge.tx, &start);
+  if (run == 0) {
+    return;
+  }
+  txInFlight = run;
+  dma_channel_transfer_from_buffer_now(txDmaChannel, start, run);
+}
+
+static void uartTxKick(void) {
+  uint32_t save = spin_lock_blocking(bridgeTxLock);
+  kickTxLocked();
+  spin_unlock(bridgeTxLock, save);
+}
+
+/// @brief Chains tx runs so the UART keeps going while both loops are busy
+static void bridgeDmaIrq(void) {
+  if (txDmaChannel < 0 || !dma_channel_get_irq1_status(txDmaChannel)) {
+    return;
+  }
+  dma_channel_acknowledge_irq1(txDmaChannel);
+
+  uint32_t save = spin_lock_blocking(bridgeTxLock);
+  serialBridge.tx.tail += txInFlight;
+  txInFlight = 0;
+  kickTxLocked();
+  spin_unlock(bridgeTxLock, save);
+}
+
+void startSerialBridge(unsigned long baud, uint8_t numbits, uint8_t paritytype,
+                       uint8_t stopbits) {
+  if (serialBridgeRunning == 1) {
+    dma_channel_abort(rxDmaChannel);
+    dma_channel_abort(txDmaChannel);
+  } else {
+    Serial1.end();
+  }
+
+  if (rxDmaChannel < 0) {
+    rxDmaChannel = dma_claim_unused_channel(true);
+    txDmaChannel = dma_claim_unused_channel(true);
+    bridgeTxLock = spin_lock_init(spin_lock_claim_unused(true));
+
+    dma_channel_config config = dma_channel_get_default_config(txDmaChannel);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+    channel_config_set_read_increment(&config, true);
+    channel_config_set_write_increment(&config, false);
+    channel_config_set_dreq(&config, uart_get_dreq(BRIDGE_UART, true));
+    dma_channel_configure(txDmaChannel, &config,
+                          &uart_get_hw(BRIDGE_UART)->dr, bridgeTxBuffer, 0,
+                          false);
+
+    dma_channel_set_irq1_enabled(txDmaChannel, true);
+    irq_add_shared_handler(DMA_IRQ_1, bridgeDmaIrq,
+                           PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+  }
+
+  bridgeBaud = baud;
+  bridgeNumbits = numbits;
+  bridgeParity = paritytype;
+  bridgeStopbits = stopbits;
+
+  uart_init(BRIDGE_UART, baud); // also turns on the UART's DMA requests
+  gpio_set_function(PIN_SERIAL1_TX, GPIO_FUNC_UART);
+  gpio_set_function(PIN_SERIAL1_RX, GPIO_FUNC_UART);
+  uart_set_hw_flow(BRIDGE_UART, false, false);
+  uart_set_format(BRIDGE_UART, numbits < 5 || numbits > 8 ? 8 : numbits,
+                  stopbits == 2 ? 2 : 1,
+                  paritytype == 1   ? UART_PARITY_ODD
+                  : paritytype == 2 ? UART_PARITY_EVEN
+                                    : UART_PARITY_NONE);
+  uart_set_fifo_enabled(BRIDGE_UART, true);
+
+  serialBridge.rx.head = serialBridge.rx.tail = 0;
+  serialBridge.tx.head = serialBridge.tx.tail = 0;
+  txInFlight = 0;
+  armRxDma();
+
+  serialBridgeRunning = 1;
+}
+
+void stopSerialBridge(void) {
+  if (serialBridgeRunning == 0) {
+    return;
+  }
+  serialBridgeRunning = 0;
+  dma_channel_abort(rxDmaChannel);
+  dma_channel_abort(txDmaChannel);
+  txInFlight = 0;
+  uart_deinit(BRIDGE_UART);
+  Serial1.begin(bridgeBaud,
+                makeSerialConfig(bridgeNumbits, bridgeParity, bridgeStopbits));
+}
+
+int serviceSerialBridge(void) {
+  // both cores call the passthrough handler, whoever gets here second skips
+  if (serialBridgeRunning == 0 ||
+      __atomic_test_and_set(&bridgePumping, __ATOMIC_ACQUIRE)) {
+    return 0;
+  }
+  int moved = pumpBridge(&serialBridge);
+  __atomic_clear(&bridgePumping, __ATOMIC_RELEASE);
+  return moved;
+}
+
+int writeSerialBridge(const uint8_t *data, int len) {
+  if (serialBridgeRunning == 0) {
+    return Serial1.write(data, len);
+  }
+  while (__atomic_test_and_set(&bridgePumping, __ATOMIC_ACQUIRE)) {
+  }
+  int wrote = ringWrite(&serialBridge.tx, data, len);
+  uartTxKick();
+  __atomic_clear(&bridgePumping, __ATOMIC_RELEASE);
+  return wrote;
+}
+
+void clearSerialBridgeStats(void) {
+  memset(&serialBridge.stats, 0, sizeof(serialBridge.stats));
+}
+
+static void printBridgeStats(struct serialBridgeStats *stats) {
+  Serial.print("  to line:\t");
+  Serial.print((unsigned long)stats->toLine);
+  Serial.print(" bytes\tmax tx depth ");
+  Serial.print(stats->maxTxDepth);
+  Serial.print("\tstalls ");
+  Serial.println(stats->lineStalls);
+  Serial.print("  to host:\t");
+  Serial.print((unsigned long)stats->toHost);
+  Serial.print(" bytes\tmax rx depth ");
+  Serial.print(stats->maxRxDepth);
+  Serial.print("\tstalls ");
+  Serial.println(stats->hostStalls);
+  Serial.print("  rx overflows:\t");
+  Serial.print(stats->rxOverflows);
+  Serial.print("\t(");
+  Serial.print(stats->rxLostBytes);
+  Serial.println(" bytes lost)");
+}
+
+void printSerialBridgeStats(void) {
+  Serial.print("\n\rSerial bridge:\t");
+  if (serialBridgeRunning == 0) {
+    Serial.println("off (Serial1 handles the passthrough)");
+    return;
+  }
+  Serial.print(bridgeBaud);
+  Serial.print(" baud, DMA ch ");
+  Serial.print(rxDmaChannel);
+  Serial.print("/");
+  Serial.print(txDmaChannel);
+  Serial.print(", ");
+  Serial.print(serialBridge.stats.pumps);
+  Serial.print(" pumps, ");
+  Serial.print(serialBridge.stats.dmaRearms);
+  Serial.println(" rearms");
+  printBridgeStats(&serialBridge.stats);
+}
+
+//! Loopback stand-in for benchmarking the pump without anything on the
+//! header: the host side makes and checks a byte pattern, the line side
+//! echoes tx into rx at the baud rate, the way the DMA channels would
+
+static struct bridgeEngine loopEngine;
+static unsigned long loopBytesPerSecond = 0;
+static unsigned long loopTotal = 0;
+static unsigned long loopProduced = 0;
+static unsigned long loopConsumed = 0;
+static unsigned long loopMismatches = 0;
+static unsigned long loopLastMicros = 0;
+static unsigned long loopCredit = 0; // bytes * 1000000
+
+static uint8_t loopPattern(unsigned long n) {
+  return (uint8_t)((n * 73) ^ (n >> 8));
+}
+
+static uint32_t loopRxSync(void) { return 0; }
+
+static void loopTxKick(void) {
+  unsigned long now = micros();
+  loopCredit += (now - loopLastMicros) * loopBytesPerSecond;
+  loopLastMicros = now;
+
+  uint32_t budget = loopCredit / 1000000;
+  uint32_t pending = ringUsed(&loopEngine.tx);
+  if (budget > pending) {
+    budget = pending;
+    loopCredit = 0; // an idle wire doesn't bank time
+  } else {
+    loopCredit -= budget * 1000000;
+  }
+
+  while (budget > 0) {
+    // rx can lap here just like the DMA ring does
+    uint8_t *start;
+    uint32_t run = ringContiguous(&loopEngine.tx, &start);
+    if (run > budget) {
+      run = budget;
+    }
+    uint32_t index = loopEngine.rx.head & (loopEngine.rx.size - 1);
+    if (run > loopEngine.rx.size - index) {
+      run = loopEngine.rx.size - index;
+    }
+    memcpy(loopEngine.rx.buf + index, start, run);
+    loopEngine.rx.head += run;
+    loopEngine.tx.tail += run;
+    budget -= run;
+  }
+}
+
+static int loopAvailable(void) {
+  unsigned long left = loopTotal - loopProduced;
+  return left > 64 ? 64 : left; // one USB full speed packet at a time
+}
+
+static int loopRead(uint8_t *data, int len) {
+  for (int i = 0; i < len; i++) {
+    data[i] = loopPattern(loopProduced++);
+  }
+  return len;
+}
+
+static int loopWriteRoom(void) { return 256; }
+
+static int loopWrite(const uint8_t *data, int len) {
+  for (int i = 0; i < len; i++) {
+    if (data[i] != loopPattern(loopConsumed++)) {
+      loopMismatches++;
+    }
+  }
+  return len;
+}
+
+static const struct bridgeBackend loopBackend = {
+    loopRxSync, loopTxKick, loopAvailable, loopRead, loopWriteRoom, loopWrite,
+};
+
+static void runLoopback(unsigned long baud, unsigned long bytes,
+                        unsigned long stallMicros) {
+  memset(&loopEngine.stats, 0, sizeof(loopEngine.stats));
+  loopEngine.rx.head = loopEngine.rx.tail = 0;
+  loopEngine.tx.head = loopEngine.tx.tail = 0;
+  loopBytesPerSecond = baud / 10;
+  loopTotal = bytes;
+  loopProduced = loopConsumed = loopMismatches = 0;
+  loopCredit = 0;
+
+  unsigned long lineMicros = (unsigned long)((bytes * 1000000ULL) /
+                                             loopBytesPerSecond);
+  unsigned long timeout = lineMicros * 3 + 1000000;
+  unsigned long start = micros();
+  unsigned long lastStall = start;
+  loopLastMicros = start;
+
+  while (loopConsumed + loopEngine.stats.rxLostBytes < bytes &&
+         micros() - start < timeout) {
+    pumpBridge(&loopEngine);
+    if (stallMicros > 0 && micros() - lastStall > 25000) {
+      // stand in for a slow LED or routing pass on the core doing the pump
+      delayMicroseconds(stallMicros);
+      lastStall = micros();
+    }
+  }
+  unsigned long elapsed = micros() - start;
+
+  Serial.print(baud);
+  Serial.print(" baud, ");
+  Serial.print(stallMicros / 1000);
+  Serial.print("ms stalls:\t");
+  Serial.print((unsigned long)((loopConsumed * 1000000ULL) /
+                               (elapsed > 0 ? elapsed : 1)));
+  Serial.print(" B/s of ");
+  Serial.print(loopBytesPerSecond);
+  Serial.print("\t");
+  Serial.print((lineMicros * 100ULL) / (elapsed > 0 ? elapsed : 1));
+  Serial.print("% of line rate\t");
+  Serial.print(loopMismatches);
+  Serial.print(" bad\t");
+  Serial.print(loopEngine.stats.pumps);
+  Serial.println(" pumps");
+  printBridgeStats(&loopEngine.stats);
+}
+
+void benchmarkSerialBridge(unsigned long baud, unsigned long bytes) {
+  loopEngine.rx.buf = (uint8_t *)malloc(BRIDGE_RX_SIZE);
+  loopEngine.tx.buf = (uint8_t *)malloc(BRIDGE_TX_SIZE);
+  if (loopEngine.rx.buf == nullptr || loopEngine.tx.buf == nullptr) {
+    Serial.println("not enough RAM for the bridge benchmark");
+    free(loopEngine.rx.buf);
+    free(loopEngine.tx.buf);
+    return;
+  }
+  loopEngine.rx.size = BRIDGE_RX_SIZE;
+  loopEngine.tx.size = BRIDGE_TX_SIZE;
+  loopEngine.backend = &loopBackend;
+  loopEngine.tap = nullptr;
+
+  Serial.print("\n\rSerial bridge loopback, ");
+  Serial.print(bytes);
+  Serial.println(" bytes each way\n\r");
+
+  unsigned long bauds[] = {115200, 460800, baud};
+  for (int i = 0; i < 3; i++) {
+    runLoopback(bauds[i], bytes, 0);
+  }
+  runLoopback(baud, bytes, 10000);
+  Serial.println();
+  Serial.flush();
+
+  free(loopEngine.rx.buf);
+  free(loopEngine.tx.buf);
+  loopEngine.rx.buf = loopEngine.tx.buf = nullptr;
+}
+#endif
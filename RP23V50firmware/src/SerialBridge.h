@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: MIT
+#ifndef SERIALBRIDGE_H
+#define SERIALBRIDGE_H
+
+#include <stdint.h>
+
+/// @brief Byte ring with free-running head/tail counters (size is a power of 2)
+/// One writer advances head, one reader advances tail, so it's safe across
+/// cores and against a DMA channel as long as each side only touches its own.
+struct bridgeRing {
+  uint8_t *buf;
+  uint32_t size;
+  volatile uint32_t head;
+  volatile uint32_t tail;
+};
+
+//! Portable: only needs this header, so the pump can be benchmarked against
+//! a loopback backend on a PC
+uint32_t ringUsed(struct bridgeRing *ring);
+uint32_t ringFree(struct bridgeRing *ring);
+uint32_t ringWrite(struct bridgeRing *ring, const uint8_t *data, uint32_t len);
+uint32_t ringRead(struct bridgeRing *ring, uint8_t *data, uint32_t len);
+/// @brief Longest run readable without wrapping, starting at the tail
+uint32_t ringContiguous(struct bridgeRing *ring, uint8_t **start);
+
+/// @brief The ends of a bridge. The host side is the USB CDC port, the line
+/// side is whatever moves bytes on the wire (UART DMA, or a RAM loopback for
+/// the benchmark). The pump only talks to these, never to the hardware.
+struct bridgeBackend {
+  /// @brief Advance rx->head to what the line has delivered, return new bytes
+  uint32_t (*lineRxSync)(void);
+  /// @brief Start moving tx bytes onto the line if it's idle
+  void (*lineTxKick)(void);
+  int (*hostAvailable)(void);
+  int (*hostRead)(uint8_t *data, int len);
+  int (*hostWriteRoom)(void);
+  int (*hostWrite)(const uint8_t *data, int len);
+};
+
+struct serialBridgeStats {
+  unsigned long long toLine;   // host -> UART
+  unsigned long long toHost;   // UART -> host
+  unsigned long rxOverflows;   // times the line lapped the rx ring
+  unsigned long rxLostBytes;   // bytes dropped when it did
+  unsigned long hostStalls;    // pumps where the USB side had no room
+  unsigned long lineStalls;    // pumps where the tx ring was full
+  unsigned long maxRxDepth;
+  unsigned long maxTxDepth;
+  unsigned long dmaRearms;
+  unsigned long pumps;
+};
+
+struct bridgeEngine {
+  struct bridgeRing rx; // line -> host
+  struct bridgeRing tx; // host -> line
+  const struct bridgeBackend *backend;
+  struct serialBridgeStats stats;
+  /// @brief Optional, sees every chunk moved (direction 1 = to line, -1 = to host)
+  void (*tap)(int direction, const uint8_t *data, int len);
+};
+
+/// @brief Move whatever is ready in both directions, never waits.
+/// Returns the same thing handleSerialPassthrough() always has: bytes sent to
+/// the line (positive), or bytes received from it (negative) if none were sent.
+int pumpBridge(struct bridgeEngine *engine);
+
+extern struct bridgeEngine serialBridge;
+extern volatile int serialBridgeRunning;
+
+void startSerialBridge(unsigned long baud, uint8_t numbits = 8,
+                       uint8_t paritytype = 0, uint8_t stopbits = 0);
+void stopSerialBridge(void);
+int serviceSerialBridge(void);
+/// @brief Queue bytes for the line from firmware code (flashArduino's sync byte)
+int writeSerialBridge(const uint8_t *data, int len);
+
+void printSerialBridgeStats(void);
+void clearSerialBridgeStats(void);
+void benchmarkSerialBridge(unsigned long baud = 1000000,
+                           unsigned long bytes = 262144);
+
+#endif
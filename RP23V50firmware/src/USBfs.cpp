@@ -327,10 +327,7 @@ String readSlotFileContent(int slot) {
     String content = "";
     
     // Use core synchronization to prevent flash access conflicts
-    while (core2busy == true) {
-        // Wait for core2 to finish
-    }
-    core1busy = true;
+    holdCore2();
     
     if (FatFS.exists(filename)) {
         File slotFile = FatFS.open(filename, "r");
@@ -356,10 +353,7 @@ void validateAllSlots(bool verbose) {
     }
     
     // Use core synchronization to prevent flash access conflicts
-    while (core2busy == true) {
-        // Wait for core2 to finish
-    }
-    core1busy = true;
+    holdCore2();
     
     int valid_slots = 0;
     int invalid_slots = 0;
@@ -428,10 +422,7 @@ void manualRefreshFromUSB() {
     
     // 3. Force close any open files to invalidate file handles
     // This ensures we're not reading from cached file handles
-    while (core2busy == true) {
-        // Wait for core2 to finish
-    }
-    core1busy = true;
+    holdCore2();
     
     // Force close any potentially open nodeFile handles and refresh filesystem
     extern File nodeFile;
@@ -449,6 +440,7 @@ void manualRefreshFromUSB() {
     
     // 4. Clear cached file content to force re-read from disk
     clearNodeFileString();
+    slotsCompiled = 0; // the host may have edited any slot
     
     // 5. Small delay to address USB timing window issues
     // Research shows this helps with high-speed USB transfer timing
@@ -56,7 +56,7 @@ void sketchOne(void) {
       if (Serial.available() > 0) {
         break;
         }
-      // showLEDsCore2 = 2;
+      // queueShowLEDs(2);
       }
     Serial.println("\n\r");
     countLoop++;
@@ -0,0 +1,528 @@
+// SPDX-License-Identifier: MIT
+#include "Waveforms.h"
+
+#include <math.h>
+#include <string.h>
+#include <strings.h>
+
+//! DDS section, down to the I2C section this only needs Waveforms.h, so it
+//! can be rendered into a buffer on a PC and checked for frequency and phase
+
+static int16_t sineTable[(1 << WAVE_SINE_BITS) + 1]; // +1 so interpolation can read past the end
+static int sineTableReady = 0;
+
+void waveInitTables(void) {
+  if (sineTableReady == 1) {
+    return;
+  }
+  for (int i = 0; i <= (1 << WAVE_SINE_BITS); i++) {
+    sineTable[i] = (int16_t)lrint(32767.0 * sin(2.0 * M_PI * i /
+                                                (1 << WAVE_SINE_BITS)));
+  }
+  sineTableReady = 1;
+}
+
+uint32_t wavePhaseStep(float frequency, float sampleRate) {
+  if (frequency <= 0.0f || sampleRate <= 0.0f) {
+    return 0;
+  }
+  double step = (double)frequency / sampleRate * 4294967296.0;
+  if (step > 2147483647.0) {
+    step = 2147483647.0; // Nyquist
+  }
+  return (uint32_t)(step + 0.5);
+}
+
+void waveReset(struct waveChannel *channel) {
+  memset(channel, 0, sizeof(*channel));
+  channel->noise = 0x2545f491;
+}
+
+void wavePost(struct waveChannel *channel, const struct waveParams *params) {
+  uint32_t seq = channel->pendingSeq + 1;
+  channel->pendingSeq = seq; // odd, the sampler leaves pending alone
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  channel->pending = *params;
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  channel->pendingSeq = seq + 1;
+}
+
+int32_t waveShapeAt(const struct waveParams *params, uint32_t phase,
+                    uint32_t *noise) {
+  // every shape starts at 0 heading up, so switching shapes keeps the phase
+  switch (params->shape) {
+  case WAVE_SINE: {
+    uint32_t index = phase >> (32 - WAVE_SINE_BITS);
+    int32_t fraction = (phase >> (32 - WAVE_SINE_BITS - 16)) & 0xffff;
+    int32_t a = sineTable[index];
+    int32_t b = sineTable[index + 1];
+    return a + (((b - a) * fraction) >> 16);
+  }
+  case WAVE_SQUARE:
+    return phase < 0x80000000u ? 32767 : -32767;
+  case WAVE_TRIANGLE: {
+    int32_t t = (phase + 0x40000000u) >> 16; // -32767 at 3/4 of a cycle
+    return t < 32768 ? t * 2 - 32767 : 32767 - (t - 32768) * 2;
+  }
+  case WAVE_SAW: {
+    int32_t t = (int32_t)((phase + 0x80000000u) >> 16) - 32768;
+    return t < -32767 ? -32767 : t;
+  }
+  case WAVE_NOISE: {
+    uint32_t x = *noise;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *noise = x;
+    int32_t t = (int32_t)(x >> 16) - 32768;
+    return t < -32767 ? -32767 : t;
+  }
+  case WAVE_TABLE:
+    if (params->table == nullptr || params->tableLength == 0) {
+      return 0;
+    }
+    return params->table[((uint64_t)phase * params->tableLength) >> 32];
+  default:
+    return 0;
+  }
+}
+
+uint16_t waveNextSample(struct waveChannel *channel) {
+  uint32_t seq = channel->pendingSeq;
+  if (seq != channel->appliedSeq && (seq & 1) == 0) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    struct waveParams next = channel->pending;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (channel->pendingSeq == seq) { // otherwise it changed mid copy, next time
+      channel->active = next;
+      channel->appliedSeq = seq;
+    }
+  }
+
+  struct waveParams *params = &channel->active;
+  int32_t value = waveShapeAt(params, channel->phase, &channel->noise);
+  int32_t code =
+      params->center + ((value * params->halfAmplitude + 16384) >> 15);
+  channel->phase += params->phaseStep;
+
+  if (code < 0) {
+    code = 0;
+  } else if (code > 4095) {
+    code = 4095;
+  }
+  return (uint16_t)code;
+}
+
+void waveRender(struct waveChannel *channel, uint16_t *out, int count) {
+  for (int i = 0; i < count; i++) {
+    out[i] = waveNextSample(channel);
+  }
+}
+
+//! I2C section: a repeating timer computes a sample for each DAC and drops
+//! one MCP4728 multi-write into the I2C TX FIFO, the I2C block clocks it out
+//! on its own. Anything else on the bus goes through dacBus, which holds the
+//! timer off while a transaction is running.
+
+#ifdef ARDUINO
+#include "InaMonitor.h"
+#include "Peripherals.h"
+
+#include <Arduino.h>
+
+#include "hardware/i2c.h"
+#include "pico/time.h"
+
+#define MCP4728_ADDRESS 0x60
+#define MCP4728_MULTI_WRITE 0x40 // | channel << 1, UDAC = 0 so it updates now
+
+SharedWire dacBus(i2c0, 4, 5);
+
+struct waveChannel waveChannels[WAVE_CHANNELS];
+struct waveEngineStats waveformStats = {};
+volatile int waveformsRunning = 0;
+
+/// @brief What the user asked for, the params are built from these
+struct waveRequest {
+  int shape;
+  float frequency;
+  float amplitude; // peak to peak volts
+  float offset;    // volts
+};
+
+static struct waveRequest waveSettings[WAVE_CHANNELS] = {
+    {WAVE_OFF, 100.0, 2.0, 2.5},
+    {WAVE_OFF, 100.0, 4.0, 0.0},
+};
+
+// two buffers per DAC so a new table never gets written under the sampler
+static int16_t waveTables[WAVE_CHANNELS][2][WAVE_MAX_TABLE];
+static int waveTableLength[WAVE_CHANNELS] = {0, 0};
+static int waveTableBuffer[WAVE_CHANNELS] = {0, 0};
+
+static struct repeating_timer waveTimer;
+static float waveRate = 0;
+static volatile int waveBusHeld = 0;
+static volatile int waveBusPushing = 0;
+static int waveChannelsReset = 0;
+
+static void holdWaveBus(void) {
+  if (waveBusHeld == 1) {
+    return; // a write without a stop, the read after it is still ours
+  }
+  waveBusHeld = 1;
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (waveformsRunning == 0 && inaMonitorRunning == 0) {
+    return;
+  }
+  i2c_hw_t *hw = i2c_get_hw(i2c0);
+  unsigned long start = micros();
+  // an INA read's bytes have to come out before Wire resets the FIFOs
+  while (waveBusPushing == 1 || hw->txflr != 0 ||
+         (hw->status & I2C_IC_STATUS_MST_ACTIVITY_BITS) ||
+         drainInaReads() == 1) {
+    if (micros() - start > 1000) {
+      break;
+    }
+  }
+  (void)hw->clr_tx_abrt; // a NACKed sample shouldn't look like Wire's abort
+}
+
+static void releaseWaveBus(void) {
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  waveBusHeld = 0;
+}
+
+uint8_t SharedWire::endTransmission(bool stopBit) {
+  holdWaveBus();
+  uint8_t result = TwoWire::endTransmission(stopBit);
+  if (stopBit) {
+    releaseWaveBus();
+  }
+  return result;
+}
+
+size_t SharedWire::requestFrom(uint8_t address, size_t quantity,
+                               bool stopBit) {
+  holdWaveBus();
+  size_t result = TwoWire::requestFrom(address, quantity, stopBit);
+  if (stopBit) {
+    releaseWaveBus();
+  }
+  return result;
+}
+
+int waveBusFree(void) {
+  i2c_hw_t *hw = i2c_get_hw(i2c0);
+  return waveBusHeld == 0 && hw->txflr == 0 &&
+         (hw->status & I2C_IC_STATUS_MST_ACTIVITY_BITS) == 0;
+}
+
+static bool waveTick(struct repeating_timer *timer) {
+  (void)timer;
+  uint16_t codes[WAVE_CHANNELS];
+  int last = -1;
+  for (int i = 0; i < WAVE_CHANNELS; i++) {
+    uint32_t applied = waveChannels[i].appliedSeq;
+    codes[i] = waveNextSample(&waveChannels[i]);
+    if (waveChannels[i].appliedSeq != applied) {
+      waveformStats.paramSwaps++;
+    }
+    if (waveChannels[i].active.shape != WAVE_OFF) {
+      last = i;
+    }
+  }
+  waveformStats.samples++;
+  if (last < 0) {
+    return true;
+  }
+
+  waveBusPushing = 1;
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  i2c_hw_t *hw = i2c_get_hw(i2c0);
+  if (waveBusHeld == 1 || hw->txflr != 0 ||
+      (hw->status & I2C_IC_STATUS_MST_ACTIVITY_BITS) ||
+      drainInaReads() == 1) {
+    // hold the last value, the phase already moved on so timing doesn't slip
+    waveformStats.busySkips++;
+    waveBusPushing = 0;
+    return true;
+  }
+  if (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) {
+    (void)hw->clr_tx_abrt;
+  }
+  if ((hw->tar & I2C_IC_TAR_IC_TAR_BITS) != MCP4728_ADDRESS) {
+    hw->enable = 0;
+    hw->tar = MCP4728_ADDRESS;
+    hw->enable = 1;
+  }
+  for (int i = 0; i <= last; i++) {
+    if (waveChannels[i].active.shape == WAVE_OFF) {
+      continue;
+    }
+    hw->data_cmd = MCP4728_MULTI_WRITE | (i << 1);
+    hw->data_cmd = (codes[i] >> 8) & 0x0f; // VDD reference, gain 1x, powered
+    hw->data_cmd = (codes[i] & 0xff) | (i == last ? I2C_IC_DATA_CMD_STOP_BITS : 0);
+  }
+  waveBusPushing = 0;
+  return true;
+}
+
+static int32_t voltsToCode(int dac, float volts) {
+  return (int32_t)(volts * 4095 / dacSpread[dac]) + dacZero[dac];
+}
+
+static void postWaveSettings(int dac) {
+  struct waveRequest *settings = &waveSettings[dac];
+  struct waveParams params;
+  params.shape = settings->shape;
+  params.phaseStep = wavePhaseStep(settings->frequency, waveRate);
+  params.halfAmplitude =
+      (int32_t)(settings->amplitude / 2 * 4095 / dacSpread[dac]);
+  params.center = voltsToCode(dac, settings->offset);
+  params.table = waveTables[dac][waveTableBuffer[dac]];
+  params.tableLength = waveTableLength[dac];
+  wavePost(&waveChannels[dac], &params);
+}
+
+/// @brief Wait for the sampler to pick up the last post, at most a couple ticks
+static void waitWaveApplied(int dac) {
+  if (waveformsRunning == 0) {
+    return;
+  }
+  unsigned long start = micros();
+  while (waveChannels[dac].appliedSeq != waveChannels[dac].pendingSeq) {
+    if (micros() - start > 1000) {
+      break;
+    }
+  }
+}
+
+/// @brief Pick the sample rate for how many DACs are running, (re)start or
+/// stop the timer to match
+static void updateWaveRate(void) {
+  int running = 0;
+  for (int i = 0; i < WAVE_CHANNELS; i++) {
+    if (waveSettings[i].shape != WAVE_OFF) {
+      running++;
+    }
+  }
+  float rate = running > 1 ? WAVE_RATE_BOTH : WAVE_RATE_ONE;
+
+  if (running == 0) {
+    if (waveformsRunning == 1) {
+      cancel_repeating_timer(&waveTimer);
+      waveformsRunning = 0;
+    }
+    return;
+  }
+  if (waveformsRunning == 1 && rate == waveRate) {
+    return;
+  }
+
+  if (waveformsRunning == 1) {
+    cancel_repeating_timer(&waveTimer);
+    waveformsRunning = 0;
+  }
+  waveRate = rate;
+  for (int i = 0; i < WAVE_CHANNELS; i++) {
+    postWaveSettings(i); // steps depend on the rate
+  }
+  waveformsRunning = 1;
+  add_repeating_timer_us(-(int64_t)(1000000 / rate), waveTick, nullptr,
+                         &waveTimer);
+}
+
+int startWaveform(int dac, int shape, float frequency, float amplitude,
+                  float offset) {
+  if (dac < 0 || dac >= WAVE_CHANNELS || shape < WAVE_OFF ||
+      shape > WAVE_TABLE) {
+    return -1;
+  }
+  if (shape == WAVE_TABLE && waveTableLength[dac] == 0) {
+    return -1;
+  }
+  if (shape == WAVE_OFF) {
+    stopWaveform(dac);
+    return 0;
+  }
+  if (waveChannelsReset == 0) {
+    for (int i = 0; i < WAVE_CHANNELS; i++) {
+      waveReset(&waveChannels[i]);
+    }
+    waveChannelsReset = 1;
+  }
+  waveInitTables();
+
+  if (frequency < 0.0f) {
+    frequency = 0.0f;
+  } else if (frequency > WAVE_MAX_FREQUENCY) {
+    frequency = WAVE_MAX_FREQUENCY;
+  }
+  waveSettings[dac].shape = shape;
+  waveSettings[dac].frequency = frequency;
+  waveSettings[dac].amplitude = amplitude < 0.0f ? -amplitude : amplitude;
+  waveSettings[dac].offset = offset;
+
+  postWaveSettings(dac);
+  updateWaveRate();
+  dacOutput[dac] = offset;
+  return 0;
+}
+
+void stopWaveform(int dac) {
+  if (dac < 0) {
+    for (int i = 0; i < WAVE_CHANNELS; i++) {
+      stopWaveform(i);
+    }
+    return;
+  }
+  if (dac >= WAVE_CHANNELS || waveSettings[dac].shape == WAVE_OFF) {
+    return;
+  }
+  waveSettings[dac].shape = WAVE_OFF;
+  postWaveSettings(dac);
+  waitWaveApplied(dac);
+  updateWaveRate();
+
+  if (dac == 0) {
+    setDac0voltage(waveSettings[dac].offset, 0, 0, false);
+  } else {
+    setDac1voltage(waveSettings[dac].offset, 0, 0, false);
+  }
+}
+
+static int retuneWave(int dac) {
+  if (dac < 0 || dac >= WAVE_CHANNELS) {
+    return -1;
+  }
+  if (waveSettings[dac].shape != WAVE_OFF) {
+    postWaveSettings(dac);
+  }
+  return 0;
+}
+
+int setWaveFrequency(int dac, float frequency) {
+  if (dac < 0 || dac >= WAVE_CHANNELS) {
+    return -1;
+  }
+  if (frequency < 0.0f) {
+    frequency = 0.0f;
+  } else if (frequency > WAVE_MAX_FREQUENCY) {
+    frequency = WAVE_MAX_FREQUENCY;
+  }
+  waveSettings[dac].frequency = frequency;
+  return retuneWave(dac);
+}
+
+int setWaveAmplitude(int dac, float amplitude) {
+  if (dac < 0 || dac >= WAVE_CHANNELS) {
+    return -1;
+  }
+  waveSettings[dac].amplitude = amplitude < 0.0f ? -amplitude : amplitude;
+  return retuneWave(dac);
+}
+
+int setWaveOffset(int dac, float offset) {
+  if (dac < 0 || dac >= WAVE_CHANNELS) {
+    return -1;
+  }
+  waveSettings[dac].offset = offset;
+  dacOutput[dac] = offset;
+  return retuneWave(dac);
+}
+
+int setWaveShape(int dac, int shape) {
+  if (dac < 0 || dac >= WAVE_CHANNELS) {
+    return -1;
+  }
+  return startWaveform(dac, shape, waveSettings[dac].frequency,
+                       waveSettings[dac].amplitude, waveSettings[dac].offset);
+}
+
+int setWaveTable(int dac, const float *values, int length) {
+  if (dac < 0 || dac >= WAVE_CHANNELS || length < 2 ||
+      length > WAVE_MAX_TABLE) {
+    return -1;
+  }
+  // the spare buffer may still be live from the last swap
+  waitWaveApplied(dac);
+  int spare = waveTableBuffer[dac] ^ 1;
+  for (int i = 0; i < length; i++) {
+    float value = values[i];
+    value = value > 1.0f ? 1.0f : (value < -1.0f ? -1.0f : value);
+    waveTables[dac][spare][i] = (int16_t)lrintf(value * 32767.0f);
+  }
+  waveTableBuffer[dac] = spare;
+  waveTableLength[dac] = length;
+  return retuneWave(dac);
+}
+
+float waveFrequency(int dac) {
+  return dac >= 0 && dac < WAVE_CHANNELS ? waveSettings[dac].frequency : 0;
+}
+
+float waveAmplitude(int dac) {
+  return dac >= 0 && dac < WAVE_CHANNELS ? waveSettings[dac].amplitude : 0;
+}
+
+float waveOffset(int dac) {
+  return dac >= 0 && dac < WAVE_CHANNELS ? waveSettings[dac].offset : 0;
+}
+
+int waveShapeOf(int dac) {
+  return dac >= 0 && dac < WAVE_CHANNELS ? waveSettings[dac].shape : WAVE_OFF;
+}
+
+float waveSampleRate(void) { return waveformsRunning == 1 ? waveRate : 0; }
+
+static const char *waveShapeNames[] = {"off",      "sine", "square", "triangle",
+                                       "sawtooth", "noise", "table"};
+
+const char *waveShapeName(int shape) {
+  if (shape < WAVE_OFF || shape > WAVE_TABLE) {
+    return "?";
+  }
+  return waveShapeNames[shape];
+}
+
+int waveShapeFromName(const char *name) {
+  for (int i = WAVE_OFF; i <= WAVE_TABLE; i++) {
+    if (strncasecmp(name, waveShapeNames[i], 3) == 0) {
+      return i; // first 3 letters are enough ("tri", "saw")
+    }
+  }
+  return -1;
+}
+
+void printWaveformStats(void) {
+  Serial.print("\n\rWaveforms:\t");
+  if (waveformsRunning == 0) {
+    Serial.println("off");
+    return;
+  }
+  Serial.print(waveRate, 0);
+  Serial.print(" S/s, ");
+  Serial.print(waveformStats.samples);
+  Serial.print(" samples\tbus busy ");
+  Serial.print(waveformStats.busySkips);
+  Serial.print("\tretunes ");
+  Serial.println(waveformStats.paramSwaps);
+  for (int i = 0; i < WAVE_CHANNELS; i++) {
+    if (waveSettings[i].shape == WAVE_OFF) {
+      continue;
+    }
+    Serial.print("  dac ");
+    Serial.print(i);
+    Serial.print(":\t");
+    Serial.print(waveShapeName(waveSettings[i].shape));
+    Serial.print("\t");
+    Serial.print(waveSettings[i].frequency);
+    Serial.print(" Hz\t");
+    Serial.print(waveSettings[i].amplitude);
+    Serial.print(" Vpp\t");
+    Serial.print(waveSettings[i].offset);
+    Serial.println(" V offset");
+  }
+}
+#endif
@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: MIT
+#ifndef WAVEFORMS_H
+#define WAVEFORMS_H
+
+#include <stdint.h>
+
+#define WAVE_CHANNELS 2          // DAC 0 and DAC 1 (MCP4728 A and B)
+#define WAVE_SINE_BITS 10        // 1024 entry sine table, interpolated
+#define WAVE_MAX_TABLE 1024      // longest arbitrary table
+#define WAVE_RATE_ONE 20000      // samples/s with one DAC running
+#define WAVE_RATE_BOTH 10000     // both share one I2C write per sample
+#define WAVE_MAX_FREQUENCY 5000.0f
+
+enum waveShape {
+  WAVE_OFF = 0,
+  WAVE_SINE,
+  WAVE_SQUARE,
+  WAVE_TRIANGLE,
+  WAVE_SAW,
+  WAVE_NOISE,
+  WAVE_TABLE
+};
+
+/// @brief Everything that sets the output, swapped in whole between samples
+struct waveParams {
+  uint8_t shape;
+  uint32_t phaseStep;    // 2^32 = one cycle per sample
+  int32_t halfAmplitude; // DAC codes, peak
+  int32_t center;        // DAC code at 0 in the wave
+  const int16_t *table;  // WAVE_TABLE only, -32767..32767
+  uint16_t tableLength;
+};
+
+/// @brief One DDS output. The phase accumulator never resets when params
+/// change, so frequency / amplitude changes land mid-cycle without a jump in
+/// phase. New params are posted under a sequence count and picked up at the
+/// next sample, so the writer can be on the other core or preempted.
+struct waveChannel {
+  struct waveParams active;
+  struct waveParams pending;
+  volatile uint32_t pendingSeq; // odd while pending is being written
+  uint32_t appliedSeq;
+  uint32_t phase;
+  uint32_t noise;
+};
+
+//! Portable: only needs this header and <math.h>
+void waveInitTables(void);
+uint32_t wavePhaseStep(float frequency, float sampleRate);
+void waveReset(struct waveChannel *channel);
+void wavePost(struct waveChannel *channel, const struct waveParams *params);
+/// @brief Shape value at a phase, -32767..32767
+int32_t waveShapeAt(const struct waveParams *params, uint32_t phase,
+                    uint32_t *noise);
+/// @brief Next DAC code, applying any posted params first
+uint16_t waveNextSample(struct waveChannel *channel);
+void waveRender(struct waveChannel *channel, uint16_t *out, int count);
+
+struct waveEngineStats {
+  unsigned long samples;
+  unsigned long busySkips; // bus busy (last frame or a Wire call), sample held
+  unsigned long paramSwaps;
+};
+
+extern struct waveChannel waveChannels[WAVE_CHANNELS];
+extern struct waveEngineStats waveformStats;
+extern volatile int waveformsRunning;
+
+/// @brief Start or retune a DAC, amplitude is peak to peak volts, offset is
+/// the middle. Calling it again on a running DAC changes it without a glitch.
+int startWaveform(int dac, int shape, float frequency, float amplitude,
+                  float offset);
+int setWaveFrequency(int dac, float frequency);
+int setWaveAmplitude(int dac, float amplitude);
+int setWaveOffset(int dac, float offset);
+int setWaveShape(int dac, int shape);
+/// @brief Play an arbitrary table (-1.0..1.0 per entry) as one cycle
+int setWaveTable(int dac, const float *values, int length);
+/// @brief Stop one DAC and leave it at its offset, -1 stops both
+void stopWaveform(int dac);
+
+float waveFrequency(int dac);
+float waveAmplitude(int dac);
+float waveOffset(int dac);
+int waveShapeOf(int dac);
+const char *waveShapeName(int shape);
+int waveShapeFromName(const char *name);
+float waveSampleRate(void);
+void printWaveformStats(void);
+
+#ifdef ARDUINO
+#include <Wire.h>
+
+/// @brief Wire for the MCP4728 / INA219 bus. The waveform engine writes the
+/// same I2C block from a timer, so every transaction through here holds it
+/// off until the bus is handed back.
+class SharedWire : public TwoWire {
+public:
+  SharedWire(i2c_inst_t *i2c, pin_size_t sda, pin_size_t scl)
+      : TwoWire(i2c, sda, scl) {}
+  uint8_t endTransmission(bool stopBit) override;
+  uint8_t endTransmission(void) override { return endTransmission(true); }
+  size_t requestFrom(uint8_t address, size_t quantity, bool stopBit) override;
+  size_t requestFrom(uint8_t address, size_t quantity) override {
+    return requestFrom(address, quantity, true);
+  }
+};
+
+extern SharedWire dacBus;
+
+/// @brief Nothing on i2c0 and no Wire transaction holding it, for the other
+/// timers that push into its FIFO (they all run from the same alarm IRQ)
+int waveBusFree(void);
+#endif
+
+#endif
@@ -28,6 +28,10 @@ struct config {
         int generation = 5;
         int revision = 5;
         int probe_revision = 5;
+        int adc_sample_rate = 200000; // samples/s across ADC0-7, 0 = analogRead()
+        int ina_averaging = 1; // INA219 samples per reading (1-128), 0 = read over I2C on every call
+        int ina_bits = 12; // 9-12, when ina_averaging is 1
+        int ina_window_ms = 100; // min / max / mean / energy window
     } hardware;
 
     struct dacs {
@@ -58,6 +62,9 @@ struct config {
         int stack_rails = 3;
         int stack_dacs = 0;
         int rail_priority = 1;
+        bool make_before_break = true;
+        int search_budget_ms = 10; // 0 = greedy router only
+        int snapshot_cache_kb = 64; // RAM for routed slots, 0 = off
     } routing;
 
     struct calibration {
@@ -83,6 +90,8 @@ struct config {
         float adc_7_spread = 18.28;
         int probe_max = 4060;
         int probe_min = 15;
+        bool probe_table = true; // use probeRows.txt from $p if it's there
+        int probe_margin = 10;   // % of a row gap around the halfway point that's too close to call
     } calibration;
 
     struct logo_pads {
@@ -181,6 +190,7 @@ struct config {
             int connect_on_boot = 0;
             int lock_connection = 0;
             int autoconnect_flashing = 1;
+            int dma_bridge = 1; // 0 = the old Serial1 byte loop
         } serial_1;
 
         
@@ -357,6 +357,10 @@ void updateConfigFromFile(const char* filename) {
             if (strcmp(key, "generation") == 0) jumperlessConfig.hardware.generation = parseInt(value);
             else if (strcmp(key, "revision") == 0) jumperlessConfig.hardware.revision = parseInt(value);
             else if (strcmp(key, "probe_revision") == 0) jumperlessConfig.hardware.probe_revision = parseInt(value);
+            else if (strcmp(key, "adc_sample_rate") == 0) jumperlessConfig.hardware.adc_sample_rate = parseInt(value);
+            else if (strcmp(key, "ina_averaging") == 0) jumperlessConfig.hardware.ina_averaging = parseInt(value);
+            else if (strcmp(key, "ina_bits") == 0) jumperlessConfig.hardware.ina_bits = parseInt(value);
+            else if (strcmp(key, "ina_window_ms") == 0) jumperlessConfig.hardware.ina_window_ms = parseInt(value);
         } else if (strcmp(section, "dacs") == 0) {
             if (strcmp(key, "top_rail") == 0) jumperlessConfig.dacs.top_rail = parseFloat(value);
             else if (strcmp(key, "bottom_rail") == 0) jumperlessConfig.dacs.bottom_rail = parseFloat(value);
@@ -382,6 +386,9 @@ void updateConfigFromFile(const char* filename) {
             else if (strcmp(key, "stack_rails") == 0) jumperlessConfig.routing.stack_rails = parseInt(value);
             else if (strcmp(key, "stack_dacs") == 0) jumperlessConfig.routing.stack_dacs = parseInt(value);
             else if (strcmp(key, "rail_priority") == 0) jumperlessConfig.routing.rail_priority = parseInt(value);
+            else if (strcmp(key, "make_before_break") == 0) jumperlessConfig.routing.make_before_break = parseBool(value);
+            else if (strcmp(key, "search_budget_ms") == 0) jumperlessConfig.routing.search_budget_ms = parseInt(value);
+            else if (strcmp(key, "snapshot_cache_kb") == 0) jumperlessConfig.routing.snapshot_cache_kb = parseInt(value);
         } else if (strcmp(section, "calibration") == 0) {
             if (strcmp(key, "top_rail_zero") == 0) jumperlessConfig.calibration.top_rail_zero = parseInt(value);
             else if (strcmp(key, "top_rail_spread") == 0) jumperlessConfig.calibration.top_rail_spread = parseFloat(value);
@@ -405,6 +412,8 @@ void updateConfigFromFile(const char* filename) {
             else if (strcmp(key, "adc_7_spread") == 0) jumperlessConfig.calibration.adc_7_spread = parseFloat(value);
             else if (strcmp(key, "probe_max") == 0) jumperlessConfig.calibration.probe_max = parseInt(value);
             else if (strcmp(key, "probe_min") == 0) jumperlessConfig.calibration.probe_min = parseInt(value);
+            else if (strcmp(key, "probe_table") == 0) jumperlessConfig.calibration.probe_table = parseBool(value);
+            else if (strcmp(key, "probe_margin") == 0) jumperlessConfig.calibration.probe_margin = parseInt(value);
         } else if (strcmp(section, "logo_pads") == 0) {
             if (strcmp(key, "top_guy") == 0) jumperlessConfig.logo_pads.top_guy = parseArbitraryFunction(value);
             else if (strcmp(key, "bottom_guy") == 0) jumperlessConfig.logo_pads.bottom_guy = parseArbitraryFunction(value);
@@ -434,6 +443,7 @@ void updateConfigFromFile(const char* filename) {
             else if (strcmp(key, "connect_on_boot") == 0) jumperlessConfig.serial_1.connect_on_boot = parseBool(value);
             else if (strcmp(key, "lock_connection") == 0) jumperlessConfig.serial_1.lock_connection = parseBool(value);
             else if (strcmp(key, "autoconnect_flashing") == 0) jumperlessConfig.serial_1.autoconnect_flashing = parseBool(value);
+            else if (strcmp(key, "dma_bridge") == 0) jumperlessConfig.serial_1.dma_bridge = parseBool(value);
         } else if (strcmp(section, "serial_2") == 0) {
             if (strcmp(key, "function") == 0) jumperlessConfig.serial_2.function = parseUartFunction(value);
             else if (strcmp(key, "baud_rate") == 0) jumperlessConfig.serial_2.baud_rate = parseInt(value);
@@ -609,6 +619,10 @@ void saveConfigToFile(const char* filename) {
     file.print("generation = "); file.print(jumperlessConfig.hardware.generation); file.println(";");
     file.print("revision = "); file.print(jumperlessConfig.hardware.revision); file.println(";");
     file.print("probe_revision = "); file.print(jumperlessConfig.hardware.probe_revision); file.println(";");
+    file.print("adc_sample_rate = "); file.print(jumperlessConfig.hardware.adc_sample_rate); file.println(";");
+    file.print("ina_averaging = "); file.print(jumperlessConfig.hardware.ina_averaging); file.println(";");
+    file.print("ina_bits = "); file.print(jumperlessConfig.hardware.ina_bits); file.println(";");
+    file.print("ina_window_ms = "); file.print(jumperlessConfig.hardware.ina_window_ms); file.println(";");
     file.println();
 
     // Write DAC settings section
@@ -639,6 +653,9 @@ void saveConfigToFile(const char* filename) {
     file.print("stack_rails = "); file.print(jumperlessConfig.routing.stack_rails); file.println(";");
     file.print("stack_dacs = "); file.print(jumperlessConfig.routing.stack_dacs); file.println(";");
     file.print("rail_priority = "); file.print(jumperlessConfig.routing.rail_priority); file.println(";");
+    file.print("make_before_break = "); file.print(jumperlessConfig.routing.make_before_break ? 1:0); file.println(";");
+    file.print("search_budget_ms = "); file.print(jumperlessConfig.routing.search_budget_ms); file.println(";");
+    file.print("snapshot_cache_kb = "); file.print(jumperlessConfig.routing.snapshot_cache_kb); file.println(";");
     file.println();
 
     // Write calibration section
@@ -665,6 +682,8 @@ void saveConfigToFile(const char* filename) {
     file.print("adc_7_spread = "); file.print(jumperlessConfig.calibration.adc_7_spread); file.println(";");
     file.print("probe_max = "); file.print(jumperlessConfig.calibration.probe_max); file.println(";");
     file.print("probe_min = "); file.print(jumperlessConfig.calibration.probe_min); file.println(";");
+    file.print("probe_table = "); file.print(jumperlessConfig.calibration.probe_table ? 1:0); file.println(";");
+    file.print("probe_margin = "); file.print(jumperlessConfig.calibration.probe_margin); file.println(";");
     file.println();
 
     // Write logo pad settings section
@@ -714,6 +733,7 @@ void saveConfigToFile(const char* filename) {
     file.print("connect_on_boot = "); file.print(jumperlessConfig.serial_1.connect_on_boot); file.println(";");
     file.print("lock_connection = "); file.print(jumperlessConfig.serial_1.lock_connection); file.println(";");
     file.print("autoconnect_flashing = "); file.print(jumperlessConfig.serial_1.autoconnect_flashing); file.println(";");
+    file.print("dma_bridge = "); file.print(jumperlessConfig.serial_1.dma_bridge); file.println(";");
 
     file.println("[serial_2]");
     file.print("function = "); file.print(jumperlessConfig.serial_2.function); file.println(";");
@@ -763,7 +783,7 @@ void saveConfig(void) {
         // leds.end();
         // leds.begin();
        
-        // showLEDsCore2 = -1;
+        // queueShowLEDs(-1);
    // }
 }
 
@@ -828,6 +848,14 @@ void printConfigSectionToSerial(int section, bool showNames, bool pasteable) {
         Serial.print("revision = "); Serial.print(jumperlessConfig.hardware.revision); Serial.println(";");
         if (pasteable == true) Serial.print("`[hardware] ");
         Serial.print("probe_revision = "); Serial.print(jumperlessConfig.hardware.probe_revision); Serial.println(";");
+        if (pasteable == true) Serial.print("`[hardware] ");
+        Serial.print("adc_sample_rate = "); Serial.print(jumperlessConfig.hardware.adc_sample_rate); Serial.println(";");
+        if (pasteable == true) Serial.print("`[hardware] ");
+        Serial.print("ina_averaging = "); Serial.print(jumperlessConfig.hardware.ina_averaging); Serial.println(";");
+        if (pasteable == true) Serial.print("`[hardware] ");
+        Serial.print("ina_bits = "); Serial.print(jumperlessConfig.hardware.ina_bits); Serial.println(";");
+        if (pasteable == true) Serial.print("`[hardware] ");
+        Serial.print("ina_window_ms = "); Serial.print(jumperlessConfig.hardware.ina_window_ms); Serial.println(";");
     }
     cycleTerminalColor();
     // Print DAC settings section
@@ -879,6 +907,11 @@ void printConfigSectionToSerial(int section, bool showNames, bool pasteable) {
         Serial.print("stack_dacs = "); Serial.print(jumperlessConfig.routing.stack_dacs); Serial.println(";");
         if (pasteable == true) Serial.print("`[routing] ");
         Serial.print("rail_priority = "); Serial.print(jumperlessConfig.routing.rail_priority); Serial.println(";");
+        if (pasteable == true) Serial.print("`[routing] ");
+        Serial.print("make_before_break = "); Serial.print(getStringFromTable(jumperlessConfig.routing.make_before_break, boolTable)); Serial.println(";");
+        if (pasteable == true) Serial.print("`[routing] ");
+        Serial.print("search_budget_ms = "); Serial.print(jumperlessConfig.routing.search_budget_ms); Serial.println(";");
+        Serial.print("snapshot_cache_kb = "); Serial.print(jumperlessConfig.routing.snapshot_cache_kb); Serial.println(";");
     }
     cycleTerminalColor();
     // Print calibration section
@@ -928,6 +961,10 @@ void printConfigSectionToSerial(int section, bool showNames, bool pasteable) {
         Serial.print("probe_max = "); Serial.print(jumperlessConfig.calibration.probe_max); Serial.println(";");
         if (pasteable == true) Serial.print("`[calibration] ");
         Serial.print("probe_min = "); Serial.print(jumperlessConfig.calibration.probe_min); Serial.println(";");
+        if (pasteable == true) Serial.print("`[calibration] ");
+        Serial.print("probe_table = "); Serial.print(getStringFromTable(jumperlessConfig.calibration.probe_table, boolTable)); Serial.println(";");
+        if (pasteable == true) Serial.print("`[calibration] ");
+        Serial.print("probe_margin = "); Serial.print(jumperlessConfig.calibration.probe_margin); Serial.println(";");
     }
     cycleTerminalColor();
     // Print logo pad settings section
@@ -1002,6 +1039,8 @@ void printConfigSectionToSerial(int section, bool showNames, bool pasteable) {
         Serial.print("lock_connection = "); Serial.print(getStringFromTable(jumperlessConfig.serial_1.lock_connection, boolTable)); Serial.println(";");
         if (pasteable == true) Serial.print("`[serial_1] ");
         Serial.print("autoconnect_flashing = "); Serial.print(getStringFromTable(jumperlessConfig.serial_1.autoconnect_flashing, boolTable)); Serial.println(";");
+        if (pasteable == true) Serial.print("`[serial_1] ");
+        Serial.print("dma_bridge = "); Serial.print(getStringFromTable(jumperlessConfig.serial_1.dma_bridge, boolTable)); Serial.println(";");
     }
     cycleTerminalColor();
     // Print serial_2 section
@@ -1599,7 +1638,7 @@ bool dacChange = false;
 //    Serial.println(dacOutput[0]);
 //    Serial.println(dacOutput[1]);
     setRailsAndDACs(0);
-    showLEDsCore2 = -1;
+    queueShowLEDs(-1);
 }
 
 int parseTrueFalse(const char* value) {
@@ -1617,6 +1656,10 @@ void updateConfigValue(const char* section, const char* key, const char* value)
         if (strcmp(key, "generation") == 0) sprintf(oldValue, "%d", jumperlessConfig.hardware.generation);
         else if (strcmp(key, "revision") == 0) sprintf(oldValue, "%d", jumperlessConfig.hardware.revision);
         else if (strcmp(key, "probe_revision") == 0) sprintf(oldValue, "%d", jumperlessConfig.hardware.probe_revision);
+        else if (strcmp(key, "adc_sample_rate") == 0) sprintf(oldValue, "%d", jumperlessConfig.hardware.adc_sample_rate);
+        else if (strcmp(key, "ina_averaging") == 0) sprintf(oldValue, "%d", jumperlessConfig.hardware.ina_averaging);
+        else if (strcmp(key, "ina_bits") == 0) sprintf(oldValue, "%d", jumperlessConfig.hardware.ina_bits);
+        else if (strcmp(key, "ina_window_ms") == 0) sprintf(oldValue, "%d", jumperlessConfig.hardware.ina_window_ms);
     }
     else if (strcmp(section, "dacs") == 0) {
         if (strcmp(key, "top_rail") == 0) sprintf(oldValue, "%.2f", jumperlessConfig.dacs.top_rail);
@@ -1641,6 +1684,9 @@ void updateConfigValue(const char* section, const char* key, const char* value)
         else if (strcmp(key, "stack_rails") == 0) sprintf(oldValue, "%d", jumperlessConfig.routing.stack_rails);
         else if (strcmp(key, "stack_dacs") == 0) sprintf(oldValue, "%d", jumperlessConfig.routing.stack_dacs);
         else if (strcmp(key, "rail_priority") == 0) sprintf(oldValue, "%d", jumperlessConfig.routing.rail_priority);
+        else if (strcmp(key, "make_before_break") == 0) sprintf(oldValue, "%d", jumperlessConfig.routing.make_before_break);
+        else if (strcmp(key, "search_budget_ms") == 0) sprintf(oldValue, "%d", jumperlessConfig.routing.search_budget_ms);
+        else if (strcmp(key, "snapshot_cache_kb") == 0) sprintf(oldValue, "%d", jumperlessConfig.routing.snapshot_cache_kb);
     }
     else if (strcmp(section, "calibration") == 0) {
         if (strcmp(key, "top_rail_zero") == 0) sprintf(oldValue, "%d", jumperlessConfig.calibration.top_rail_zero);
@@ -1665,6 +1711,8 @@ void updateConfigValue(const char* section, const char* key, const char* value)
         else if (strcmp(key, "adc_7_spread") == 0) sprintf(oldValue, "%.2f", jumperlessConfig.calibration.adc_7_spread);
         else if (strcmp(key, "probe_max") == 0) sprintf(oldValue, "%d", jumperlessConfig.calibration.probe_max);
         else if (strcmp(key, "probe_min") == 0) sprintf(oldValue, "%d", jumperlessConfig.calibration.probe_min);
+        else if (strcmp(key, "probe_table") == 0) sprintf(oldValue, "%d", jumperlessConfig.calibration.probe_table);
+        else if (strcmp(key, "probe_margin") == 0) sprintf(oldValue, "%d", jumperlessConfig.calibration.probe_margin);
     }
     else if (strcmp(section, "logo_pads") == 0) {
         if (strcmp(key, "top_guy") == 0) sprintf(oldValue, "%d", jumperlessConfig.logo_pads.top_guy);
@@ -1713,6 +1761,7 @@ void updateConfigValue(const char* section, const char* key, const char* value)
         else if (strcmp(key, "connect_on_boot") == 0) sprintf(oldValue, "%d", jumperlessConfig.serial_1.connect_on_boot);
         else if (strcmp(key, "lock_connection") == 0) sprintf(oldValue, "%d", jumperlessConfig.serial_1.lock_connection);
         else if (strcmp(key, "autoconnect_flashing") == 0) sprintf(oldValue, "%d", jumperlessConfig.serial_1.autoconnect_flashing);
+        else if (strcmp(key, "dma_bridge") == 0) sprintf(oldValue, "%d", jumperlessConfig.serial_1.dma_bridge);
     }
     else if (strcmp(section, "serial_2") == 0) {
         if (strcmp(key, "function") == 0) sprintf(oldValue, "%d", jumperlessConfig.serial_2.function);
@@ -1744,6 +1793,10 @@ void updateConfigValue(const char* section, const char* key, const char* value)
         if (strcmp(key, "generation") == 0) jumperlessConfig.hardware.generation = parseInt(value);
         else if (strcmp(key, "revision") == 0) jumperlessConfig.hardware.revision = parseInt(value);
         else if (strcmp(key, "probe_revision") == 0) jumperlessConfig.hardware.probe_revision = parseInt(value);
+        else if (strcmp(key, "adc_sample_rate") == 0) jumperlessConfig.hardware.adc_sample_rate = parseInt(value);
+        else if (strcmp(key, "ina_averaging") == 0) jumperlessConfig.hardware.ina_averaging = parseInt(value);
+        else if (strcmp(key, "ina_bits") == 0) jumperlessConfig.hardware.ina_bits = parseInt(value);
+        else if (strcmp(key, "ina_window_ms") == 0) jumperlessConfig.hardware.ina_window_ms = parseInt(value);
     }
     else if (strcmp(section, "dacs") == 0) {
         if (strcmp(key, "top_rail") == 0) jumperlessConfig.dacs.top_rail = parseFloat(value);
@@ -1768,6 +1821,9 @@ void updateConfigValue(const char* section, const char* key, const char* value)
         else if (strcmp(key, "stack_rails") == 0) jumperlessConfig.routing.stack_rails = parseInt(value);
         else if (strcmp(key, "stack_dacs") == 0) jumperlessConfig.routing.stack_dacs = parseInt(value);
         else if (strcmp(key, "rail_priority") == 0) jumperlessConfig.routing.rail_priority = parseInt(value);
+        else if (strcmp(key, "make_before_break") == 0) jumperlessConfig.routing.make_before_break = parseBool(value);
+        else if (strcmp(key, "search_budget_ms") == 0) jumperlessConfig.routing.search_budget_ms = parseInt(value);
+        else if (strcmp(key, "snapshot_cache_kb") == 0) jumperlessConfig.routing.snapshot_cache_kb = parseInt(value);
     }
     else if (strcmp(section, "calibration") == 0) {
         if (strcmp(key, "top_rail_zero") == 0) jumperlessConfig.calibration.top_rail_zero = parseInt(value);
@@ -1792,6 +1848,8 @@ void updateConfigValue(const char* section, const char* key, const char* value)
         else if (strcmp(key, "adc_7_spread") == 0) jumperlessConfig.calibration.adc_7_spread = parseFloat(value);
         else if (strcmp(key, "probe_max") == 0) jumperlessConfig.calibration.probe_max = parseInt(value);
         else if (strcmp(key, "probe_min") == 0) jumperlessConfig.calibration.probe_min = parseInt(value);
+        else if (strcmp(key, "probe_table") == 0) jumperlessConfig.calibration.probe_table = parseBool(value);
+        else if (strcmp(key, "probe_margin") == 0) jumperlessConfig.calibration.probe_margin = parseInt(value);
     }
     else if (strcmp(section, "logo_pads") == 0) {
         if (strcmp(key, "top_guy") == 0) jumperlessConfig.logo_pads.top_guy = parseArbitraryFunction(value);
@@ -1835,6 +1893,7 @@ void updateConfigValue(const char* section, const char* key, const char* value)
         else if (strcmp(key, "connect_on_boot") == 0) jumperlessConfig.serial_1.connect_on_boot = parseBool(value);
         else if (strcmp(key, "lock_connection") == 0) jumperlessConfig.serial_1.lock_connection = parseBool(value);
         else if (strcmp(key, "autoconnect_flashing") == 0) jumperlessConfig.serial_1.autoconnect_flashing = parseBool(value);
+        else if (strcmp(key, "dma_bridge") == 0) jumperlessConfig.serial_1.dma_bridge = parseBool(value);
     }
     else if (strcmp(section, "serial_2") == 0) {
         if (strcmp(key, "function") == 0) jumperlessConfig.serial_2.function = parseUartFunction(value);
@@ -0,0 +1,52 @@
+// -------------------------------------------------- //
+// This file is autogenerated by pioasm; do not edit! //
+// -------------------------------------------------- //
+
+#pragma once
+
+#if !PICO_NO_HARDWARE
+#include "hardware/pio.h"
+#endif
+
+// ------------- //
+// logic_capture //
+// ------------- //
+
+#define logic_capture_wrap_target 0
+#define logic_capture_wrap 12
+
+#define logic_capture_offset_free 0u
+#define logic_capture_offset_post 7u
+#define logic_capture_offset_done 12u
+
+static const uint16_t logic_capture_program_instructions[] = {
+            //     .wrap_target
+    0x4308, //  0: in     pins, 8                [3]
+    0x4308, //  1: in     pins, 8                [3]
+    0x4308, //  2: in     pins, 8                [3]
+    0x4008, //  3: in     pins, 8
+    0x8080, //  4: pull   noblock
+    0xa027, //  5: mov    x, osr
+    0x0020, //  6: jmp    !x, 0
+    0x4308, //  7: in     pins, 8                [3]
+    0x4308, //  8: in     pins, 8                [3]
+    0x4308, //  9: in     pins, 8                [3]
+    0x4208, // 10: in     pins, 8                [2]
+    0x0047, // 11: jmp    x--, 7
+    0x000c, // 12: jmp    12
+            //     .wrap
+};
+
+#if !PICO_NO_HARDWARE
+static const struct pio_program logic_capture_program = {
+    .instructions = logic_capture_program_instructions,
+    .length = 13,
+    .origin = -1,
+};
+
+static inline pio_sm_config logic_capture_program_get_default_config(uint offset) {
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + logic_capture_wrap_target, offset + logic_capture_wrap);
+    return c;
+}
+#endif
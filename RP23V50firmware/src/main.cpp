@@ -41,6 +41,17 @@ KevinC@ppucc.io
 #include "ArduinoStuff.h"
 #include "CH446Q.h"
 #include "Commands.h"
+#include "SerialBridge.h"
+#include "AdcEngine.h"
+#include "Waveforms.h"
+#include "LogicAnalyzer.h"
+#include "InaMonitor.h"
+#include "ProbeScanner.h"
+#include "ProbeRows.h"
+#include "BoardScan.h"
+#include "Overlay.h"
+#include "LedFrame.h"
+#include "LedOutput.h"
 
 #include "Apps.h"
 #include "ArduinoStuff.h"
@@ -147,6 +158,7 @@ void setup() {
 
   
   initNets();
+  rebuildNetIndex();
   backpowered = 0;
 
   // delay(1000);
@@ -226,6 +238,7 @@ void setup() {
   // routableBufferPower(1, 1);
 
   getNothingTouched();
+  loadProbeRows(); // after probe_min is measured, for the straight-line table
   startupTimers[8] = millis();
   createSlots(-1, 0);
   initializeNetColorTracking(); // Initialize net color tracking after slots are created
@@ -268,6 +281,7 @@ void setup1() {
   core2initFinished = 1;
 
   while (startupAnimationFinished == 0) {
+    parkCore2();
     // delayMicroseconds(1);
     // if (Serial.available() > 0) {
     //   char c = Serial.read();
@@ -383,7 +397,7 @@ menu:
   forceprintmenu:
 
 
-    int numberOfMenuItems = 31 + (showExtraMenu == 1 ? 12 : 0) ;
+    int numberOfMenuItems = 31 + (showExtraMenu == 1 ? 13 : 0) ;
     float steps = (float)highSaturationBrightColorsCount / (float)numberOfMenuItems;
     // Serial.print("steps = ");
     // Serial.println(steps);
@@ -464,6 +478,8 @@ menu:
       cycleTerminalColor();
       Serial.print("\t% = list all filesystem contents\n\r");
       cycleTerminalColor();
+      Serial.print("\t* = show routing stats\n\r");
+      cycleTerminalColor();
       Serial.print("\tE = don't show this menu\n\r");
       cycleTerminalColor();
       Serial.print("\tC = disable terminal colors\n\r");
@@ -583,6 +599,8 @@ dontshowmenu:
     }
 
     secondSerialHandler();
+    serviceLogicAnalyzer();
+    serviceOverlays();
     
     // Handle USB tasks (required for MSC and other USB interfaces)
     //#ifdef USE_TINYUSB
@@ -663,7 +681,7 @@ dontshowmenu:
       } else if (probeToggleResult == -4) {
         // warnNet(firstConnection);
         // assignNetColors();
-        // showLEDsCore2 = 1;
+        // queueShowLEDs(1);
 
         // Serial.print("-4 warningNet = ");
         // Serial.println(warningNet);
@@ -833,9 +851,22 @@ dontshowmenu:
   //   goto loadfile;
   // }
 
+  if (machineParserActive() == true) {
+    // partway through a ::command, these bytes are the rest of it
+    serviceMachineMode();
+    goto dontshowmenu;
+  }
+
   input = Serial.read();
 
   timer = millis();
+
+  if (input == MACHINE_FRAME_SYNC) {
+    // binary machine mode frame, see MachineCommands.cpp
+    beginMachineFrame();
+    serviceMachineMode();
+    goto dontshowmenu;
+  }
   // Serial.print("input = ");
   // Serial.println(input);
   // Serial.flush();
@@ -1180,6 +1211,7 @@ if (Serial.available() > 0) {
       dumpLED = 0;
     } else {
       dumpLED = 1;
+      queueDumpLEDs();
     }
     // }
     // printSerial1stuff();
@@ -1275,6 +1307,37 @@ if (Serial.available() > 0) {
     break;
   }
 
+  case '*': { //!  *
+    if (Serial.available() > 0 && Serial.peek() == 'b') {
+      Serial.read();
+      benchmarkNetBuilding(200);
+      goto dontshowmenu;
+      }
+    if (Serial.available() > 0 && Serial.peek() == 'u') {
+      Serial.read();
+      benchmarkSerialBridge();
+      goto dontshowmenu;
+      }
+    printRoutingStats();
+    printCompiledCacheStatus();
+    printCrosspointStats();
+    printCore2QueueStats();
+    printSerialBridgeStats();
+    printMachineParserStats();
+    printAdcEngineStats();
+    printWaveformStats();
+    printLogicAnalyzerStats();
+    printInaMonitorStats();
+    printProbeScannerStats();
+    printProbeRows();
+    printBoardScanStats();
+    printOverlays();
+    printLedFrameStats();
+    printLedOutputStats();
+    goto dontshowmenu;
+    break;
+  }
+
   case 'g': { //!  g
     printGPIOState();
     break;
@@ -1326,6 +1389,7 @@ if (Serial.available() > 0) {
     //oled.oledConnected = false;
 
     clearNodeFile(netSlot, 0);
+    markCrosspointsDesynced();
     refreshConnections(-1, 1, 1);
     digitalWrite(RESETPIN, LOW);
 
@@ -1536,6 +1600,11 @@ if (Serial.available() > 0) {
     break;
   }
   case '$': { //!  $
+    if (Serial.available() > 0 && Serial.peek() == 'p') {
+      Serial.read();
+      calibrateProbeRows(); // $p tap through every pad
+      break;
+    }
     // return current slot number
     for (int d = 0; d < 4; d++) {
       Serial.print("dacSpread[");
@@ -1724,7 +1793,7 @@ if (Serial.available() > 0) {
     printTextFromMenu();
 
     clearLEDs();
-    showLEDsCore2 = 1;
+    queueShowLEDs(1);
     defconDisplay = -1;
     // b.print(f, color);
 
@@ -1771,25 +1840,31 @@ if (Serial.available() > 0) {
         if (Serial.available() > 0) {
           char c = Serial.read();
           if (c == '1') {
-            float iSense = INA1.getCurrent_mA();
+            float iSense = inaCurrent(1) * 1000;
             Serial.print("ina1 = ");
             Serial.print(iSense);
             Serial.println("mA");
           }
         } else {
-          float iSense = INA0.getCurrent_mA();
+          float iSense = inaCurrent(0) * 1000;
           Serial.print("ina0 = ");
           Serial.print(iSense);
           Serial.print("mA \t");
 
-          iSense = INA0.getBusVoltage();
+          iSense = inaBusVoltage(0);
           Serial.print(iSense);
           Serial.print("V \t");
 
-          iSense = INA0.getPower_mW();
+          iSense = inaPower(0) * 1000;
           Serial.print(iSense);
           Serial.println("mW");
         }
+      } else if (c == 's') {
+        int sensorMask = 0b11;
+        if (Serial.available() > 0 && isdigit(Serial.peek())) {
+          sensorMask = 1 << ((Serial.read() - '0') & 1);
+        }
+        streamInaWindows(sensorMask);
       } else if (c == 'l') {
 
         if (showReadings == 1) {
@@ -1858,7 +1933,7 @@ if (Serial.available() > 0) {
     // clearLEDs();
     // assignNetColors();
     // showNets();
-    // showLEDsCore2 = 1;
+    // queueShowLEDs(1);
     goto menu;
     // break;
   }
@@ -1875,7 +1950,7 @@ if (Serial.available() > 0) {
     // clearLEDs();
     // assignNetColors();
     // showNets();
-    // showLEDsCore2 = 1;
+    // queueShowLEDs(1);
     clearHighlighting();
 
     // Serial.print("millis() - startupTimers[0] = ");
@@ -1944,7 +2019,7 @@ if (Serial.available() > 0) {
     inputNodeFileList(rotaryEncoderMode);
     showSavedColors(netSlot);
     // input = ' ';
-    showLEDsCore2 = -1;
+    queueShowLEDs(-1);
     // probeActive = 0;
     goto loadfile;
     // goto dontshowmenu;
@@ -2018,7 +2093,7 @@ if (Serial.available() > 0) {
     readInNodesArduino = 1;
     // clearAllNTCC();
 
-    // sendAllPathsCore2 = 1;
+    // queueSendPaths(1);
     // timer = millis();
 
     // clearNodeFile(netSlot);
@@ -2106,7 +2181,7 @@ if (Serial.available() > 0) {
     if (LEDbrightnessMenu() == '!') {
       clearLEDs();
       delayMicroseconds(9200);
-      sendAllPathsCore2 = 1;
+      queueSendPaths(1);
     }
     break;
 
@@ -2194,8 +2269,10 @@ if (Serial.available() > 0) {
     if (Serial.read() == ':') {
       // Serial.print("\n\r");
       // Serial.print("entering machine mode\n\r");
-      // machineMode();
-      showLEDsCore2 = 1;
+      // the rest of the command is picked up as it arrives, see
+      // machineParserActive() above the input read
+      machineMode();
+      queueShowLEDs(1);
       goto dontshowmenu;
       break;
     } else {
@@ -2256,6 +2333,8 @@ void loop1() {
   //  tud_task();
   // #endif
 
+  parkCore2(); // core 0 is in FatFS or the LED buffer
+
   if (doomOn == 1) {
     playDoom();
     doomOn = 0;
@@ -2346,15 +2425,84 @@ void loop1() {
   // Serial.print(" ");
 }
 
+// Work core 0 has asked for but core 1 hasn't finished yet. Only core 1
+// touches these, everything from core 0 comes in through the command queue
+static int ledShowPending = 0; // same values the show-LED command takes
+static int pathsPending = 0;   // 1 = send paths, -1 = clean send
+static uint32_t ledShowFence = 0; // oldest fence waiting on each kind of work
+static uint32_t pathsFence = 0;
+static uint32_t probeLEDsFence = 0;
+static uint32_t poppedFence = 0; // newest fence taken off the queue
+static bool probeLEDsPending = false;
+
+void applyCore2Command(struct core2Command *cmd) {
+  switch (cmd->type) {
+  case CORE2_SEND_PATHS:
+    if (pathsPending != 0) {
+      core2Stats.coalesced++;
+    }
+    // a clean send covers a normal one, so don't let it get downgraded
+    if (pathsPending != -1) {
+      pathsPending = cmd->arg;
+    }
+    if (cmd->fence != 0 && pathsFence == 0) {
+      pathsFence = cmd->fence;
+    }
+    break;
+  case CORE2_SHOW_LEDS:
+    if (ledShowFence != 0) { // 3 stays set after it's drawn, so go by the fence
+      core2Stats.coalesced++;
+    }
+    if (cmd->arg < 0) {
+      clearBeforeSend = 1;
+    }
+    ledShowPending = abs(cmd->arg);
+    if (cmd->fence != 0 && ledShowFence == 0) {
+      ledShowFence = cmd->fence;
+    }
+    break;
+  case CORE2_PROBE_LEDS:
+    showProbeLEDs = cmd->arg;
+    probeLEDsPending = true;
+    if (cmd->fence != 0 && probeLEDsFence == 0) {
+      probeLEDsFence = cmd->fence;
+    }
+    break;
+  case CORE2_DUMP_LEDS:
+    core2busy = true;
+    dumpLEDs();
+    core2busy = false;
+    break;
+  }
+}
+
+// Everything up to the oldest unfinished request is done
+static void publishCore2Fences(void) {
+  uint32_t done = poppedFence;
+  uint32_t pending[3] = {ledShowFence, pathsFence, probeLEDsFence};
+
+  for (int i = 0; i < 3; i++) {
+    if (pending[i] != 0 && (int32_t)(pending[i] - 1 - done) < 0) {
+      done = pending[i] - 1;
+    }
+  }
+  completeCore2Fence(done);
+}
+
 void core2stuff() // core 2 handles the LEDs and the CH446Q8
 {
   core2busy = false;
 
-  if (showLEDsCore2 < 0) {
-    showLEDsCore2 = abs(showLEDsCore2);
-    // Serial.println("clearBeforeSend = 1");
+  struct core2Command cmd;
+  while (popCore2Command(&cmd)) {
+    applyCore2Command(&cmd);
+    poppedFence = cmd.fence;
+  }
 
-    clearBeforeSend = 1;
+  if (probeLEDsPending == true) {
+    probeLEDhandler();
+    probeLEDsPending = false;
+    probeLEDsFence = 0;
   }
 
   if (showProbeLEDs != lastProbeLEDs) {
@@ -2362,28 +2510,35 @@ void core2stuff() // core 2 handles the LEDs and the CH446Q8
     //  probeLEDs.clear();
   }
 
-  if (micros() - schedulerTimer > schedulerUpdateTime || showLEDsCore2 == 3 ||
-      showLEDsCore2 == 4 ||
-      showLEDsCore2 == 6 && core1busy == false && core1request == 0) {
+  if (micros() - schedulerTimer > schedulerUpdateTime || ledShowPending == 3 ||
+      ledShowPending == 4 || ledShowPending == 6 && core1busy == false) {
 
-    if ((((showLEDsCore2 >= 1 && loadingFile == 0) || showLEDsCore2 == 3 ||
-          (swirled == 1) && sendAllPathsCore2 == 0) ||
+    if ((((ledShowPending >= 1 && loadingFile == 0) || ledShowPending == 3 ||
+          (swirled == 1) && pathsPending == 0) ||
          showProbeLEDs != lastProbeLEDs) &&
-        sendAllPathsCore2 == 0) {
+        pathsPending == 0) {
 
-      // Serial.println(showLEDsCore2);
+      // Serial.println(ledShowPending);
       // secondSerialHandler();
-      if (showLEDsCore2 == 6) {
-        showLEDsCore2 = 1;
+      if (ledShowPending == 6) {
+        ledShowPending = 1;
       }
 
       int rails =
-          showLEDsCore2; // 3 doesn't show nets and keeps control of the LEDs
+          ledShowPending; // 3 doesn't show nets and keeps control of the LEDs
 
+      // the layers that haven't changed are painted from what they drew
+      // last time instead of drawing again (see LedFrame.h)
       if (rails != 3) {
         core2busy = true;
-        lightUpRail(-1, -1, 1);
-        logoSwirl(swirlCount, spread, probeActive);
+        if (beginLedLayer(LED_LAYER_RAILS, railLayerInputs()) == 1) {
+          lightUpRail(-1, -1, 1);
+          endLedLayer(railLayerInputs());
+        }
+        if (beginLedLayer(LED_LAYER_LOGO, LED_INPUTS_UNKNOWN) == 1) {
+          logoSwirl(swirlCount, spread, probeActive);
+          endLedLayer(LED_INPUTS_UNKNOWN);
+        }
         core2busy = false;
       }
 
@@ -2404,9 +2559,7 @@ void core2stuff() // core 2 handles the LEDs and the CH446Q8
           // core2busy = false;
         } else {
 
-          while (core1busy == true) {
-            // core2busy = false;
-          }
+          parkCore2();
           core2busy = true;
 
           if (clearBeforeSend == 1) {
@@ -2415,13 +2568,22 @@ void core2stuff() // core 2 handles the LEDs and the CH446Q8
             clearBeforeSend = 0;
           }
 
-          readGPIO(); // if want, I can make this update the LEDs like 10 times
-                      // faster by putting outside this loop,
-          showLEDmeasurements();
+          if (beginLedLayer(LED_LAYER_MEASUREMENTS, LED_INPUTS_UNKNOWN) == 1) {
+            readGPIO(); // if want, I can make this update the LEDs like 10
+                        // times faster by putting outside this loop,
+            showLEDmeasurements();
+            endLedLayer(LED_INPUTS_UNKNOWN);
+          }
 
-          showNets();
+          if (beginLedLayer(LED_LAYER_NETS, netLayerInputs()) == 1) {
+            showNets();
+            endLedLayer(netLayerInputs());
+          }
 
-          showAllRowAnimations();
+          if (beginLedLayer(LED_LAYER_ANIMATIONS, LED_INPUTS_UNKNOWN) == 1) {
+            showAllRowAnimations();
+            endLedLayer(LED_INPUTS_UNKNOWN);
+          }
 
           core2busy = false;
           netUpdateRefreshCount = 0;
@@ -2439,8 +2601,9 @@ void core2stuff() // core 2 handles the LEDs and the CH446Q8
         // core2busy = false;
       }
       core2busy = false;
+      ledShowFence = 0;
       if (rails != 3 && swirled == 0) {
-        showLEDsCore2 = 0;
+        ledShowPending = 0;
 
         // delayMicroseconds(3200);
       }
@@ -2451,19 +2614,20 @@ void core2stuff() // core 2 handles the LEDs and the CH446Q8
       }
       core2busy = false;
 
-    } else if (sendAllPathsCore2 != 0) {
+    } else if (pathsPending != 0) {
 
-      if (sendAllPathsCore2 == 1) {
+      if (pathsPending == 1) {
         sendPaths(0);
-      } else if (sendAllPathsCore2 == -1) {
+      } else if (pathsPending == -1) {
         sendPaths(1);
       } else {
-        sendPaths(sendAllPathsCore2);
+        sendPaths(pathsPending);
       }
-      sendAllPathsCore2 = 0;
+      pathsPending = 0;
+      pathsFence = 0;
 
     } else if (millis() - lastSwirlTime > 51 && loadingFile == 0 &&
-               showLEDsCore2 == 0 && core1busy == false) {
+               ledShowPending == 0 && core1busy == false) {
       readcounter++;
 
       // logoSwirl(swirlCount, spread, probeActive);
@@ -2480,7 +2644,7 @@ void core2stuff() // core 2 handles the LEDs and the CH446Q8
         countsss++;
       }
 
-      if (showLEDsCore2 == 0) {
+      if (ledShowPending == 0) {
         swirled = 1;
       }
 
@@ -2519,7 +2683,7 @@ void core2stuff() // core 2 handles the LEDs and the CH446Q8
 
       rotaryEncoderStuff();
 
-      if (inClickMenu == 0 && loadingFile == 0 && showLEDsCore2 == 0 &&
+      if (inClickMenu == 0 && loadingFile == 0 && ledShowPending == 0 &&
           core1busy == false) {
         // showAllRowAnimations();
       }
@@ -2531,4 +2695,6 @@ void core2stuff() // core 2 handles the LEDs and the CH446Q8
     core2busy = false;
     // readGPIO();
   }
+
+  publishCore2Fences();
 }
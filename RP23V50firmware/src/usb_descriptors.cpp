@@ -192,7 +192,7 @@ uint8_t const desc_fs_configuration[] =
 
   // MSC interface - place after CDC interfaces for better compatibility
 #if USB_MSC_ENABLE
-  TUD_MSC_DESCRIPTOR(ITF_NUM_MSC, 7, EPNUM_MSC_OUT, EPNUM_MSC_IN, 64),
+  TUD_MSC_DESCRIPTOR(ITF_NUM_MSC, 4 + USB_CDC_ENABLE_COUNT, EPNUM_MSC_OUT, EPNUM_MSC_IN, 64),
 #endif
 
   // HID interfaces
@@ -240,6 +240,9 @@ uint8_t const * __wrap_tud_descriptor_configuration_cb(uint8_t index)
 #if USB_CDC_ENABLE_COUNT >= 3
     Serial.printf("◆   CDC 2: interfaces %d, %d\n", ITF_NUM_CDC_2, ITF_NUM_CDC_2_DATA);
 #endif
+#if USB_CDC_ENABLE_COUNT >= 4
+    Serial.printf("◆   CDC 3: interfaces %d, %d\n", ITF_NUM_CDC_3, ITF_NUM_CDC_3_DATA);
+#endif
 #if USB_MSC_ENABLE
     Serial.printf("◆   MSC: interface %d\n", ITF_NUM_MSC);
     Serial.printf("◆   MSC endpoints: OUT=0x%02X, IN=0x%02X\n", EPNUM_MSC_OUT, EPNUM_MSC_IN);
@@ -0,0 +1,218 @@
+// SPDX-License-Identifier: MIT
+// Replays a corpus of node files through the firmware's routing pipeline
+// (parse -> getNodesToConnect() -> bridgesToPaths()), prints how long each
+// stage took and how many bridges couldn't be routed, and fails if any file
+// routes fewer bridges than it did in the baseline.
+//
+//   bench_routing [corpus dir] [--save]
+//
+// The corpus defaults to corpus/routing, its baseline.txt holds
+// "file bridges failures" lines. --save writes this run as the new baseline.
+#include "FileParsing.h"
+#include "MatrixState.h"
+#include "NetManager.h"
+#include "NetsToChipConnections.h"
+
+#include <FatFS.h>
+
+#include <algorithm>
+#include <dirent.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#define BENCH_RUNS 5
+#define BASELINE_FILE "baseline.txt"
+
+struct benchResult {
+  std::string name;
+  int bridges;
+  int failures;
+  unsigned long parseMicros;
+  unsigned long netsMicros;
+  unsigned long pathsMicros;
+};
+
+static std::vector<std::string> corpusFiles(const std::string &dir) {
+  std::vector<std::string> names;
+  DIR *corpus = opendir(dir.c_str());
+  if (corpus == nullptr) {
+    return names;
+  }
+  for (struct dirent *entry = readdir(corpus); entry != nullptr;
+       entry = readdir(corpus)) {
+    std::string name = entry->d_name;
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".txt") == 0 &&
+        name != BASELINE_FILE) {
+      names.push_back(name);
+    }
+  }
+  closedir(corpus);
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+// couldntFindPath() only keeps the first 10 in unconnectablePaths
+static int countFailures(void) {
+  int failures = 0;
+  for (int i = 0; i < numberOfPaths; i++) {
+    if (path[i].skip == true && path[i].duplicate == 0) {
+      failures++;
+    }
+  }
+  return failures;
+}
+
+static bool routeFile(const std::string &name, struct benchResult *result) {
+  result->name = name;
+  result->parseMicros = 0;
+  result->netsMicros = 0;
+  result->pathsMicros = 0;
+  result->failures = -1;
+
+  for (int run = 0; run < BENCH_RUNS; run++) {
+    clearAllNTCC();
+    unsigned long stageTimer = micros();
+    result->bridges = parseNodeFileAt(name.c_str());
+    result->parseMicros += micros() - stageTimer;
+    if (result->bridges < 0) {
+      return false;
+    }
+
+    stageTimer = micros();
+    getNodesToConnect();
+    result->netsMicros += micros() - stageTimer;
+
+    stageTimer = micros();
+    bridgesToPaths();
+    result->pathsMicros += micros() - stageTimer;
+
+    int failures = countFailures();
+    if (result->failures >= 0 && failures != result->failures) {
+      printf("  %s routed differently on run %d\n", name.c_str(), run + 1);
+    }
+    result->failures = failures;
+  }
+  result->parseMicros /= BENCH_RUNS;
+  result->netsMicros /= BENCH_RUNS;
+  result->pathsMicros /= BENCH_RUNS;
+  return true;
+}
+
+static std::map<std::string, std::pair<int, int>> readBaseline(void) {
+  std::map<std::string, std::pair<int, int>> baseline;
+  FILE *file = fopen((hostFatFSRoot + "/" BASELINE_FILE).c_str(), "r");
+  if (file == nullptr) {
+    return baseline;
+  }
+  char name[256];
+  int bridges;
+  int failures;
+  while (fscanf(file, "%255s %d %d", name, &bridges, &failures) == 3) {
+    baseline[name] = std::make_pair(bridges, failures);
+  }
+  fclose(file);
+  return baseline;
+}
+
+static bool saveBaseline(const std::vector<struct benchResult> &results) {
+  FILE *file = fopen((hostFatFSRoot + "/" BASELINE_FILE).c_str(), "w");
+  if (file == nullptr) {
+    return false;
+  }
+  for (const struct benchResult &result : results) {
+    fprintf(file, "%s %d %d\n", result.name.c_str(), result.bridges,
+            result.failures);
+  }
+  fclose(file);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  hostFatFSRoot = "corpus/routing";
+  bool save = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--save") == 0) {
+      save = true;
+    } else {
+      hostFatFSRoot = argv[i];
+    }
+  }
+
+  std::vector<std::string> names = corpusFiles(hostFatFSRoot);
+  if (names.empty()) {
+    printf("no node files in %s\n", hostFatFSRoot.c_str());
+    return 1;
+  }
+  std::map<std::string, std::pair<int, int>> baseline = readBaseline();
+
+  hostSerialOut = nullptr; // the router talks a lot
+  routingBenchmarkRunning = true;
+  initNets(); // what setup() does before anything gets routed
+  rebuildNetIndex();
+
+  std::vector<struct benchResult> results;
+  int regressions = 0;
+  int totalBridges = 0;
+  int routedBridges = 0;
+  unsigned long totals[3] = {0, 0, 0};
+
+  printf("Routing benchmark, %s, average of %d runs\n\n",
+         hostFatFSRoot.c_str(), BENCH_RUNS);
+  printf("  %-20s %7s %6s %8s %8s %8s\n", "file", "bridges", "failed",
+         "parse", "nets", "paths");
+
+  for (const std::string &name : names) {
+    struct benchResult result;
+    if (routeFile(name, &result) == false) {
+      printf("  %-20s couldn't be read\n", name.c_str());
+      regressions++;
+      continue;
+    }
+    results.push_back(result);
+    totalBridges += result.bridges;
+    routedBridges += result.bridges - result.failures;
+    totals[0] += result.parseMicros;
+    totals[1] += result.netsMicros;
+    totals[2] += result.pathsMicros;
+
+    printf("  %-20s %7d %6d %6luus %6luus %6luus", name.c_str(),
+           result.bridges, result.failures, result.parseMicros,
+           result.netsMicros, result.pathsMicros);
+
+    auto was = baseline.find(name);
+    if (was == baseline.end()) {
+      printf("  (not in the baseline)");
+    } else if (was->second.first != result.bridges) {
+      printf("  (changed since the baseline)");
+    } else if (result.failures > was->second.second) {
+      printf("  FAIL %d more unroutable", result.failures - was->second.second);
+      regressions++;
+    } else if (result.failures < was->second.second) {
+      printf("  %d fewer unroutable", was->second.second - result.failures);
+    }
+    printf("\n");
+  }
+
+  printf("\n  routed %d of %d bridges (%d%%), %luus parsing, %luus building "
+         "nets, %luus finding paths\n",
+         routedBridges, totalBridges,
+         totalBridges > 0 ? routedBridges * 100 / totalBridges : 100,
+         totals[0], totals[1], totals[2]);
+
+  if (save == true) {
+    if (saveBaseline(results) == false) {
+      printf("  couldn't write " BASELINE_FILE "\n");
+      return 1;
+    }
+    printf("  saved as the new baseline\n");
+    return 0;
+  }
+  if (regressions > 0) {
+    printf("  FAIL: %d regression%s\n", regressions,
+           regressions == 1 ? "" : "s");
+    return 1;
+  }
+  printf("  PASS\n");
+  return 0;
+}
@@ -0,0 +1,240 @@
+// SPDX-License-Identifier: MIT
+// pumpBridge() against a loopback: the host side makes and checks a byte
+// pattern, the line side echoes tx into rx at the baud rate the way the
+// UART DMA channels would (and laps rx the same way when nobody drains it).
+// Checks the rings, that nothing is reordered or lost unless it's counted as
+// an overflow, and that the pump keeps up with the line up to 1Mbaud, with
+// and without the pumping core stalling for a slow LED pass.
+#include "SerialBridge.h"
+#include "check.h"
+
+#include <chrono>
+#include <string.h>
+#include <thread>
+
+#define RX_SIZE 4096 // same as BRIDGE_RX_SIZE
+#define TX_SIZE 2048 // same as BRIDGE_TX_SIZE
+
+static uint8_t rxBuffer[RX_SIZE];
+static uint8_t txBuffer[TX_SIZE];
+static struct bridgeEngine engine;
+
+static unsigned long bytesPerSecond = 0; // 0 = as fast as the pump goes
+static unsigned long total = 0;
+static unsigned long produced = 0;
+static unsigned long consumed = 0;
+static unsigned long mismatches = 0;
+static unsigned long lastMicros = 0;
+static unsigned long long credit = 0; // bytes * 1000000
+static int hostRoom = 256;
+
+static unsigned long nowMicros(void) {
+  static const auto start = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+static uint8_t pattern(unsigned long n) {
+  return (uint8_t)((n * 73) ^ (n >> 8));
+}
+
+static uint32_t loopRxSync(void) { return 0; }
+
+static void loopTxKick(void) {
+  uint32_t budget = ringUsed(&engine.tx);
+  if (bytesPerSecond > 0) {
+    unsigned long now = nowMicros();
+    credit += (unsigned long long)(now - lastMicros) * bytesPerSecond;
+    lastMicros = now;
+    if (credit / 1000000 < budget) {
+      budget = credit / 1000000;
+      credit -= (unsigned long long)budget * 1000000;
+    } else {
+      credit = 0; // an idle wire doesn't bank time
+    }
+  }
+
+  while (budget > 0) {
+    uint8_t *start;
+    uint32_t run = ringContiguous(&engine.tx, &start);
+    if (run > budget) {
+      run = budget;
+    }
+    uint32_t index = engine.rx.head & (engine.rx.size - 1);
+    if (run > engine.rx.size - index) {
+      run = engine.rx.size - index;
+    }
+    memcpy(engine.rx.buf + index, start, run);
+    engine.rx.head += run;
+    engine.tx.tail += run;
+    budget -= run;
+  }
+}
+
+static int loopAvailable(void) {
+  unsigned long left = total - produced;
+  return left > 64 ? 64 : left; // one USB full speed packet at a time
+}
+
+static int loopRead(uint8_t *data, int len) {
+  for (int i = 0; i < len; i++) {
+    data[i] = pattern(produced++);
+  }
+  return len;
+}
+
+static int loopWriteRoom(void) { return hostRoom; }
+
+static int loopWrite(const uint8_t *data, int len) {
+  // after an overflow the pump has already skipped rxLostBytes
+  unsigned long expected = consumed + engine.stats.rxLostBytes;
+  for (int i = 0; i < len; i++) {
+    if (data[i] != pattern(expected + i)) {
+      mismatches++;
+    }
+  }
+  consumed += len;
+  return len;
+}
+
+static const struct bridgeBackend loopBackend = {
+    loopRxSync, loopTxKick, loopAvailable, loopRead, loopWriteRoom, loopWrite,
+};
+
+static void resetLoopback(unsigned long baud, unsigned long bytes) {
+  memset(&engine, 0, sizeof(engine));
+  engine.rx.buf = rxBuffer;
+  engine.rx.size = RX_SIZE;
+  engine.tx.buf = txBuffer;
+  engine.tx.size = TX_SIZE;
+  engine.backend = &loopBackend;
+  bytesPerSecond = baud / 10;
+  total = bytes;
+  produced = consumed = mismatches = 0;
+  credit = 0;
+  hostRoom = 256;
+  lastMicros = nowMicros();
+}
+
+static bool loopbackDone(void) {
+  return consumed + engine.stats.rxLostBytes >= total;
+}
+
+static void testRings(void) {
+  uint8_t storage[16];
+  struct bridgeRing ring = {storage, sizeof(storage), 0xfffffff8u, 0xfffffff8u};
+  uint8_t in[20];
+  uint8_t out[20];
+  for (int i = 0; i < 20; i++) {
+    in[i] = i + 1;
+  }
+
+  // the counters wrap past 2^32 on the way
+  CHECK_EQ(ringWrite(&ring, in, 20), 16);
+  CHECK_EQ(ringUsed(&ring), 16);
+  CHECK_EQ(ringFree(&ring), 0);
+  CHECK_EQ(ringWrite(&ring, in, 1), 0);
+  CHECK_EQ(ringRead(&ring, out, 5), 5);
+  CHECK_EQ(out[4], 5);
+
+  uint8_t *start;
+  CHECK_EQ(ringContiguous(&ring, &start), 3);
+  CHECK(start == storage + 13);
+  CHECK_EQ(ringWrite(&ring, in, 5), 5);
+  CHECK_EQ(ringRead(&ring, out, 20), 16);
+  for (int i = 0; i < 11; i++) {
+    CHECK_EQ(out[i], i + 6);
+  }
+  for (int i = 0; i < 5; i++) {
+    CHECK_EQ(out[11 + i], i + 1);
+  }
+  CHECK_EQ(ringUsed(&ring), 0);
+  CHECK_EQ(ringContiguous(&ring, &start), 0);
+}
+
+// as fast as the pump can go, every byte comes back in order
+static void testUnthrottled(void) {
+  resetLoopback(0, 1 << 22);
+  unsigned long start = nowMicros();
+  while (loopbackDone() == false) {
+    pumpBridge(&engine);
+  }
+  unsigned long elapsed = nowMicros() - start;
+
+  CHECK_EQ(consumed, total);
+  CHECK_EQ(mismatches, 0);
+  CHECK_EQ(engine.stats.rxOverflows, 0);
+  CHECK_EQ(engine.stats.toLine, total);
+  CHECK_EQ(engine.stats.toHost, total);
+  printf("  unthrottled:\t%lu bytes in %luus, %.1f MB/s through the pump\n",
+         total, elapsed, total / (elapsed > 0 ? (double)elapsed : 1.0));
+}
+
+// the USB side stops taking bytes while the line keeps delivering, so rx
+// laps. What's lost is counted and what gets through is still in order.
+static void testOverflow(void) {
+  resetLoopback(0, 3 * RX_SIZE);
+  hostRoom = 0;
+  int pumps = 0;
+  while (produced < total && pumps++ < 10000) {
+    pumpBridge(&engine);
+  }
+  CHECK_EQ(engine.stats.toHost, 0);
+  CHECK(engine.stats.hostStalls > 0);
+
+  hostRoom = 256;
+  while (loopbackDone() == false && pumps++ < 20000) {
+    pumpBridge(&engine);
+  }
+  CHECK(engine.stats.rxOverflows > 0);
+  CHECK(engine.stats.rxLostBytes > 2 * RX_SIZE);
+  CHECK_EQ(consumed + engine.stats.rxLostBytes, total);
+  CHECK_EQ(engine.stats.toHost, consumed);
+  CHECK_EQ(mismatches, 0);
+}
+
+// in real time at the line rate, optionally with the pumping core going away
+// for stallMicros every 25ms the way a slow LED or routing pass would
+static void benchLineRate(unsigned long baud, unsigned long stallMicros) {
+  resetLoopback(baud, baud / 40); // a quarter second of line time
+  unsigned long lineMicros =
+      (unsigned long)((total * 1000000ULL) / bytesPerSecond);
+  unsigned long start = nowMicros();
+  unsigned long lastStall = start;
+  lastMicros = start;
+
+  while (loopbackDone() == false && nowMicros() - start < lineMicros * 3) {
+    pumpBridge(&engine);
+    if (stallMicros > 0 && nowMicros() - lastStall > 25000) {
+      std::this_thread::sleep_for(std::chrono::microseconds(stallMicros));
+      lastStall = nowMicros();
+    }
+  }
+  unsigned long elapsed = nowMicros() - start;
+  unsigned long percent = (lineMicros * 100ULL) / (elapsed > 0 ? elapsed : 1);
+
+  printf("  %7lu baud, %2lums stalls:\t%3lu%% of line rate, max rx depth "
+         "%lu, max tx depth %lu, %lu pumps\n",
+         baud, stallMicros / 1000, percent, engine.stats.maxRxDepth,
+         engine.stats.maxTxDepth, engine.stats.pumps);
+
+  CHECK_EQ(consumed, total);
+  CHECK_EQ(mismatches, 0);
+  CHECK_EQ(engine.stats.rxOverflows, 0);
+  CHECK(percent >= 90);
+}
+
+int main(void) {
+  printf("Serial bridge loopback\n");
+  testRings();
+  testUnthrottled();
+  testOverflow();
+
+  unsigned long bauds[] = {115200, 460800, 1000000};
+  for (unsigned long baud : bauds) {
+    benchLineRate(baud, 0);
+  }
+  benchLineRate(1000000, 10000); // 10ms stalls, ~40ms of rx ring at 1Mbaud
+  return checkResult("bench_serial_bridge");
+}
@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: MIT
+#ifndef HOST_CHECK_H
+#define HOST_CHECK_H
+
+#include <stdio.h>
+
+// Just enough to fail a ctest run with a line number, each test is a plain
+// main() that returns checkResult()
+
+static int checkFailures = 0;
+
+#define CHECK(condition)                                                       \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);     \
+      checkFailures++;                                                         \
+    }                                                                          \
+  } while (0)
+
+#define CHECK_EQ(a, b)                                                         \
+  do {                                                                         \
+    long long checkA = (long long)(a);                                         \
+    long long checkB = (long long)(b);                                         \
+    if (checkA != checkB) {                                                    \
+      printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__,       \
+             __LINE__, #a, #b, checkA, checkB);                                \
+      checkFailures++;                                                         \
+    }                                                                          \
+  } while (0)
+
+static inline int checkResult(const char *name) {
+  if (checkFailures > 0) {
+    printf("%s: %d checks failed\n", name, checkFailures);
+    return 1;
+  }
+  printf("%s: ok\n", name);
+  return 0;
+}
+
+#endif
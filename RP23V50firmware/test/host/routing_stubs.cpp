@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: MIT
+// The rest of the firmware as far as NetManager, NetsToChipConnections and
+// MatrixState can tell: nothing on the GPIO / ADC / DAC, no LEDs or probe,
+// and a node file reader in place of FileParsing.
+#include "Commands.h"
+#include "FileParsing.h"
+#include "Graphics.h"
+#include "Highlighting.h"
+#include "JumperlessDefines.h"
+#include "LEDs.h"
+#include "MatrixState.h"
+#include "NetManager.h"
+#include "Peripherals.h"
+#include "Probing.h"
+#include "RotaryEncoder.h"
+#include "config.h"
+
+#include <FatFS.h>
+#include <ctype.h>
+
+struct config jumperlessConfig;
+
+volatile bool core1busy = false;
+volatile bool core2busy = false;
+
+void holdCore2(void) { core1busy = true; }
+void refreshConnections(int, int, int) {}
+
+int netSlot = 0;
+int highlightedRow = -1;
+int highlightedNet = -1;
+int brightenedNode = -1;
+int numberOfShownNets = 0;
+int probePowerDAC = 0;
+volatile unsigned long blockProbeButton = 0;
+volatile unsigned long blockProbeButtonTimer = 0;
+
+float adcReadings[8];
+int showADCreadings[8];
+float dacOutput[2];
+float railVoltage[2];
+uint8_t gpioState[10];
+uint8_t gpioReading[10];
+int gpioNet[10];
+uint32_t gpioReadingColors[10];
+uint8_t gpioAnimationBaseHues[10];
+rgbColor netColors[MAX_NETS];
+
+static char noName[] = "";
+
+char *colorToName(int, int) { return noName; }
+char *colorToName(rgbColor, int) { return noName; }
+int colorToVT100(uint32_t, int) { return 0; }
+uint32_t packRgb(rgbColor color) {
+  return ((uint32_t)color.r << 16) | ((uint32_t)color.g << 8) | color.b;
+}
+uint32_t HsvToRaw(hsvColor) { return 0; }
+void changeTerminalColor(int, bool, Stream *) {}
+int encoderNetHighlight(int, int, int) { return -1; }
+int checkProbeButton(void) { return 0; }
+void markCrosspointsDesynced(void) {}
+void clearNodeFileString(void) {}
+
+/// @brief reads bridges into path[] from a node file saved the way slots
+/// are ("{ 1-2, 70-83, }", nodes as their defined numbers), which is all
+/// FileParsing's parser hands to getNodesToConnect()
+int parseNodeFileAt(const char *fileName) {
+  File file = FatFS.open(fileName, "r");
+  if (!file) {
+    return -1;
+  }
+  newBridgeLength = 0;
+  int ends[2];
+  int end = 0;
+  int value = -1;
+  for (int c = file.read(); c >= 0; c = file.read()) {
+    if (isdigit(c) != 0) {
+      value = (value < 0 ? 0 : value * 10) + (c - '0');
+      continue;
+    }
+    if (value >= 0 && end < 2) {
+      ends[end++] = value;
+    }
+    value = -1;
+    if (c == '-') {
+      continue;
+    }
+    if ((c == ',' || c == '}') && end == 2 && newBridgeLength < MAX_BRIDGES) {
+      path[newBridgeLength].node1 = ends[0];
+      path[newBridgeLength].node2 = ends[1];
+      path[newBridgeLength].net = 0;
+      newBridgeLength++;
+    }
+    if (c == ',' || c == '}' || c == '{') {
+      end = 0;
+    }
+  }
+  file.close();
+  newBridgeIndex = 0;
+  return newBridgeLength;
+}
@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: MIT
+// Host stand-in, only the declarations the firmware headers name
+#ifndef HOST_ADAFRUIT_NEOPIXEL_H
+#define HOST_ADAFRUIT_NEOPIXEL_H
+
+#include <Arduino.h>
+
+#define NEO_GRB 0x52
+#define NEO_KHZ800 0x0000
+
+class Adafruit_NeoPixel {
+public:
+  Adafruit_NeoPixel(uint16_t, int16_t = 6, uint16_t = NEO_GRB + NEO_KHZ800) {}
+  void begin(void) {}
+  void show(void) {}
+  void setPixelColor(uint16_t, uint32_t) {}
+  void setPixelColor(uint16_t, uint8_t, uint8_t, uint8_t) {}
+  uint32_t getPixelColor(uint16_t) const { return 0; }
+  void setBrightness(uint8_t) {}
+  void clear(void) {}
+  static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+    return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+  }
+};
+
+#endif
@@ -0,0 +1,10 @@
+// SPDX-License-Identifier: MIT
+// Host stand-in, the USB serial ports are just more Serials
+#ifndef HOST_ADAFRUIT_TINYUSB_H
+#define HOST_ADAFRUIT_TINYUSB_H
+
+#include <Arduino.h>
+
+class Adafruit_USBD_CDC : public HostSerial {};
+
+#endif
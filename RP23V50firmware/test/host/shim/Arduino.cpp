@@ -0,0 +1,267 @@
+// SPDX-License-Identifier: MIT
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <Wire.h>
+
+#include <chrono>
+#include <ctype.h>
+#include <thread>
+
+FILE *hostSerialOut = stdout;
+HostSerial Serial;
+HostEEPROM EEPROM;
+TwoWire Wire;
+TwoWire Wire1;
+
+static const auto bootTime = std::chrono::steady_clock::now();
+
+unsigned long millis(void) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now() - bootTime)
+      .count();
+}
+
+unsigned long micros(void) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - bootTime)
+      .count();
+}
+
+void delay(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void pinMode(int, int) {}
+void digitalWrite(int, int) {}
+int digitalRead(int) { return LOW; }
+int analogRead(int) { return 0; }
+
+long random(long howBig) { return howBig > 0 ? rand() % howBig : 0; }
+long random(long howSmall, long howBig) {
+  return howBig > howSmall ? howSmall + random(howBig - howSmall) : howSmall;
+}
+void randomSeed(unsigned long seed) { srand(seed); }
+
+char *ltoa(long value, char *buffer, int base) {
+  char digits[66];
+  int length = 0;
+  unsigned long magnitude =
+      (value < 0 && base == 10) ? -(unsigned long)value : (unsigned long)value;
+  do {
+    int digit = magnitude % base;
+    digits[length++] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+    magnitude /= base;
+  } while (magnitude > 0);
+  char *out = buffer;
+  if (value < 0 && base == 10) {
+    *out++ = '-';
+  }
+  while (length > 0) {
+    *out++ = digits[--length];
+  }
+  *out = '\0';
+  return buffer;
+}
+
+char *itoa(int value, char *buffer, int base) {
+  return ltoa(value, buffer, base);
+}
+
+static std::string numberText(unsigned long long magnitude, bool negative,
+                              int base) {
+  char digits[68];
+  int length = 0;
+  do {
+    int digit = magnitude % base;
+    digits[length++] = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    magnitude /= base;
+  } while (magnitude > 0);
+  std::string text = negative ? "-" : "";
+  while (length > 0) {
+    text += digits[--length];
+  }
+  return text;
+}
+
+static std::string signedText(long long value, int base) {
+  if (base == 10 && value < 0) {
+    return numberText(-(unsigned long long)value, true, base);
+  }
+  return numberText((unsigned long long)value, false, base);
+}
+
+static std::string floatText(double value, int decimals) {
+  char text[64];
+  snprintf(text, sizeof(text), "%.*f", decimals, value);
+  return text;
+}
+
+String::String(int value, int base) : text(signedText(value, base)) {}
+String::String(unsigned int value, int base)
+    : text(numberText(value, false, base)) {}
+String::String(long value, int base) : text(signedText(value, base)) {}
+String::String(unsigned long value, int base)
+    : text(numberText(value, false, base)) {}
+String::String(float value, int decimals) : text(floatText(value, decimals)) {}
+String::String(double value, int decimals)
+    : text(floatText(value, decimals)) {}
+
+int String::indexOf(const String &what, unsigned int from) const {
+  size_t at = text.find(what.text, from);
+  return at == std::string::npos ? -1 : (int)at;
+}
+
+int String::indexOf(char what, unsigned int from) const {
+  size_t at = text.find(what, from);
+  return at == std::string::npos ? -1 : (int)at;
+}
+
+String String::substring(unsigned int from) const {
+  return from < text.length() ? String(text.substr(from)) : String();
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+  if (from > to) {
+    std::swap(from, to);
+  }
+  if (from >= text.length()) {
+    return String();
+  }
+  return String(text.substr(from, to - from));
+}
+
+bool String::startsWith(const String &prefix) const {
+  return text.compare(0, prefix.text.length(), prefix.text) == 0;
+}
+
+bool String::endsWith(const String &suffix) const {
+  return text.length() >= suffix.text.length() &&
+         text.compare(text.length() - suffix.text.length(),
+                      suffix.text.length(), suffix.text) == 0;
+}
+
+void String::trim(void) {
+  size_t first = text.find_first_not_of(" \t\r\n");
+  if (first == std::string::npos) {
+    text.clear();
+    return;
+  }
+  size_t last = text.find_last_not_of(" \t\r\n");
+  text = text.substr(first, last - first + 1);
+}
+
+void String::toUpperCase(void) {
+  for (char &c : text) {
+    c = toupper((unsigned char)c);
+  }
+}
+
+void String::toLowerCase(void) {
+  for (char &c : text) {
+    c = tolower((unsigned char)c);
+  }
+}
+
+void String::replace(const String &from, const String &to) {
+  if (from.text.empty()) {
+    return;
+  }
+  size_t at = 0;
+  while ((at = text.find(from.text, at)) != std::string::npos) {
+    text.replace(at, from.text.length(), to.text);
+    at += to.text.length();
+  }
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+  if (index < text.length()) {
+    text.erase(index, count);
+  }
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t written = 0;
+  while (size-- > 0) {
+    written += write(*buffer++);
+  }
+  return written;
+}
+
+size_t Print::print(unsigned char value, int base) {
+  return print((unsigned long)value, base);
+}
+size_t Print::print(int value, int base) { return print((long)value, base); }
+size_t Print::print(unsigned int value, int base) {
+  return print((unsigned long)value, base);
+}
+size_t Print::print(long value, int base) {
+  return write(signedText(value, base).c_str());
+}
+size_t Print::print(unsigned long value, int base) {
+  return write(numberText(value, false, base).c_str());
+}
+size_t Print::print(long long value, int base) {
+  return write(signedText(value, base).c_str());
+}
+size_t Print::print(unsigned long long value, int base) {
+  return write(numberText(value, false, base).c_str());
+}
+size_t Print::print(double value, int decimals) {
+  return write(floatText(value, decimals).c_str());
+}
+
+size_t Print::printf(const char *format, ...) {
+  char text[512];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  if (length < 0) {
+    return 0;
+  }
+  return write((const uint8_t *)text,
+               std::min((size_t)length, sizeof(text) - 1));
+}
+
+long Stream::parseInt(void) {
+  int c = peek();
+  while (c >= 0 && c != '-' && isdigit(c) == 0) {
+    read();
+    c = peek();
+  }
+  bool negative = false;
+  if (c == '-') {
+    negative = true;
+    read();
+  }
+  long value = 0;
+  while ((c = peek()) >= 0 && isdigit(c) != 0) {
+    value = value * 10 + (c - '0');
+    read();
+  }
+  return negative ? -value : value;
+}
+
+size_t HostSerial::write(uint8_t c) {
+  if (hostSerialOut != nullptr) {
+    fputc(c, hostSerialOut);
+  }
+  return 1;
+}
+
+size_t HostSerial::write(const uint8_t *buffer, size_t size) {
+  if (hostSerialOut != nullptr) {
+    fwrite(buffer, 1, size, hostSerialOut);
+  }
+  return size;
+}
+
+void HostSerial::flush(void) {
+  if (hostSerialOut != nullptr) {
+    fflush(hostSerialOut);
+  }
+}
@@ -0,0 +1,200 @@
+// SPDX-License-Identifier: MIT
+// Just enough of the Arduino core to build the routing code on a PC. Serial
+// goes to hostSerialOut (stdout, or nullptr to throw it away), time comes
+// from the host's steady clock.
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <algorithm>
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define INPUT_PULLDOWN 3
+
+#define DEC 10
+#define HEX 16
+#define BIN 2
+
+#define PROGMEM
+#define F(string) (string)
+#define constrain(value, low, high)                                            \
+  ((value) < (low) ? (low) : ((value) > (high) ? (high) : (value)))
+
+// from the Pico SDK's hardware/gpio.h, which Arduino.h brings in there
+typedef enum gpio_function {
+  GPIO_FUNC_SIO = 5,
+  GPIO_FUNC_PWM = 4,
+  GPIO_FUNC_NULL = 0x1f,
+} gpio_function_t;
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+int analogRead(int pin);
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+char *itoa(int value, char *buffer, int base);
+char *ltoa(long value, char *buffer, int base);
+
+class String {
+public:
+  String(const char *text = "") : text(text != nullptr ? text : "") {}
+  String(const std::string &text) : text(text) {}
+  String(char c) : text(1, c) {}
+  String(int value, int base = DEC);
+  String(unsigned int value, int base = DEC);
+  String(long value, int base = DEC);
+  String(unsigned long value, int base = DEC);
+  String(float value, int decimals = 2);
+  String(double value, int decimals = 2);
+
+  const char *c_str(void) const { return text.c_str(); }
+  unsigned int length(void) const { return text.length(); }
+  char charAt(unsigned int index) const {
+    return index < text.length() ? text[index] : 0;
+  }
+  char operator[](unsigned int index) const { return charAt(index); }
+  int indexOf(const String &what, unsigned int from = 0) const;
+  int indexOf(char what, unsigned int from = 0) const;
+  String substring(unsigned int from) const;
+  String substring(unsigned int from, unsigned int to) const;
+  bool startsWith(const String &prefix) const;
+  bool endsWith(const String &suffix) const;
+  bool equals(const String &other) const { return text == other.text; }
+  long toInt(void) const { return strtol(text.c_str(), nullptr, 10); }
+  float toFloat(void) const { return strtof(text.c_str(), nullptr); }
+  void trim(void);
+  void toUpperCase(void);
+  void toLowerCase(void);
+  void replace(const String &from, const String &to);
+  void remove(unsigned int index, unsigned int count = (unsigned int)-1);
+  bool concat(const String &more) {
+    text += more.text;
+    return true;
+  }
+
+  String &operator+=(const String &more) {
+    text += more.text;
+    return *this;
+  }
+  String &operator+=(const char *more) {
+    text += more;
+    return *this;
+  }
+  String &operator+=(char more) {
+    text += more;
+    return *this;
+  }
+  bool operator==(const String &other) const { return text == other.text; }
+  bool operator==(const char *other) const { return text == other; }
+  bool operator!=(const String &other) const { return text != other.text; }
+  bool operator!=(const char *other) const { return text != other; }
+  bool operator<(const String &other) const { return text < other.text; }
+
+  friend String operator+(const String &a, const String &b) {
+    return String(a.text + b.text);
+  }
+  friend String operator+(const String &a, const char *b) {
+    return String(a.text + b);
+  }
+  friend String operator+(const char *a, const String &b) {
+    return String(a + b.text);
+  }
+  friend String operator+(const String &a, char b) {
+    return String(a.text + b);
+  }
+  friend String operator+(const String &a, int b) { return a + String(b); }
+
+private:
+  std::string text;
+};
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *text) {
+    return write((const uint8_t *)text, strlen(text));
+  }
+  size_t write(const char *buffer, size_t size) {
+    return write((const uint8_t *)buffer, size);
+  }
+
+  size_t print(const char *text) { return write(text); }
+  size_t print(const String &text) { return write(text.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char value, int base = DEC);
+  size_t print(int value, int base = DEC);
+  size_t print(unsigned int value, int base = DEC);
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(long long value, int base = DEC);
+  size_t print(unsigned long long value, int base = DEC);
+  size_t print(double value, int decimals = 2);
+
+  size_t println(void) { return write("\r\n"); }
+  template <typename T> size_t println(const T &value) {
+    size_t n = print(value);
+    return n + println();
+  }
+  template <typename T> size_t println(const T &value, int format) {
+    size_t n = print(value, format);
+    return n + println();
+  }
+
+  size_t printf(const char *format, ...)
+      __attribute__((format(printf, 2, 3)));
+  virtual void flush(void) {}
+};
+
+class Stream : public Print {
+public:
+  virtual int available(void) = 0;
+  virtual int read(void) = 0;
+  virtual int peek(void) = 0;
+  long parseInt(void);
+  void setTimeout(unsigned long) {}
+};
+
+/// @brief where Serial goes, nullptr to keep benchmarks quiet
+extern FILE *hostSerialOut;
+
+class HostSerial : public Stream {
+public:
+  void begin(unsigned long) {}
+  void end(void) {}
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+  int available(void) override { return 0; }
+  int read(void) override { return -1; }
+  int peek(void) override { return -1; }
+  void flush(void) override;
+  operator bool(void) const { return true; }
+};
+
+extern HostSerial Serial;
+
+#endif
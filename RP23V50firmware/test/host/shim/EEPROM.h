@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: MIT
+// Host stand-in, EEPROM is a blank block of RAM
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+#include <Arduino.h>
+
+class HostEEPROM {
+public:
+  void begin(size_t) {}
+  bool commit(void) { return true; }
+  uint8_t read(int address) const { return bytes[address]; }
+  void write(int address, uint8_t value) { bytes[address] = value; }
+  template <typename T> T &get(int address, T &value) const {
+    memcpy(&value, &bytes[address], sizeof(T));
+    return value;
+  }
+  template <typename T> const T &put(int address, const T &value) {
+    memcpy(&bytes[address], &value, sizeof(T));
+    return value;
+  }
+
+private:
+  uint8_t bytes[4096] = {0};
+};
+
+extern HostEEPROM EEPROM;
+
+#endif
@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: MIT
+#include <FatFS.h>
+
+#include <sys/stat.h>
+
+std::string hostFatFSRoot = ".";
+HostFatFS FatFS;
+
+static std::string hostPath(const char *path) {
+  return hostFatFSRoot + (path[0] == '/' ? "" : "/") + path;
+}
+
+File HostFatFS::open(const char *path, const char *mode) {
+  std::string fullPath = hostPath(path);
+  std::string hostMode = mode;
+  if (hostMode.find('b') == std::string::npos) {
+    hostMode += 'b';
+  }
+  return File(fopen(fullPath.c_str(), hostMode.c_str()), fullPath);
+}
+
+bool HostFatFS::exists(const char *path) {
+  struct stat info;
+  return stat(hostPath(path).c_str(), &info) == 0;
+}
+
+bool HostFatFS::remove(const char *path) {
+  return ::remove(hostPath(path).c_str()) == 0;
+}
+
+size_t File::write(uint8_t c) {
+  return file != nullptr && fputc(c, file) != EOF ? 1 : 0;
+}
+
+size_t File::write(const uint8_t *buffer, size_t size) {
+  return file != nullptr ? fwrite(buffer, 1, size, file) : 0;
+}
+
+int File::available(void) {
+  if (file == nullptr) {
+    return 0;
+  }
+  long here = ftell(file);
+  fseek(file, 0, SEEK_END);
+  long end = ftell(file);
+  fseek(file, here, SEEK_SET);
+  return (int)(end - here);
+}
+
+int File::read(void) {
+  if (file == nullptr) {
+    return -1;
+  }
+  int c = fgetc(file);
+  return c == EOF ? -1 : c;
+}
+
+int File::read(uint8_t *buffer, size_t size) {
+  return file != nullptr ? (int)fread(buffer, 1, size, file) : -1;
+}
+
+int File::peek(void) {
+  if (file == nullptr) {
+    return -1;
+  }
+  int c = fgetc(file);
+  if (c == EOF) {
+    return -1;
+  }
+  ungetc(c, file);
+  return c;
+}
+
+void File::flush(void) {
+  if (file != nullptr) {
+    fflush(file);
+  }
+}
+
+bool File::seek(uint32_t position) {
+  return file != nullptr && fseek(file, position, SEEK_SET) == 0;
+}
+
+size_t File::position(void) { return file != nullptr ? ftell(file) : 0; }
+
+size_t File::size(void) {
+  if (file == nullptr) {
+    return 0;
+  }
+  fflush(file);
+  struct stat info;
+  return stat(path.c_str(), &info) == 0 ? info.st_size : 0;
+}
+
+time_t File::getLastWrite(void) {
+  struct stat info;
+  return stat(path.c_str(), &info) == 0 ? info.st_mtime : 0;
+}
+
+void File::close(void) {
+  if (file != nullptr) {
+    fclose(file);
+    file = nullptr;
+  }
+}
@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: MIT
+// Host stand-in for the flash filesystem, files live under hostFatFSRoot
+#ifndef HOST_FATFS_H
+#define HOST_FATFS_H
+
+#include <Arduino.h>
+#include <time.h>
+
+/// @brief directory the "flash" is in, set before opening anything
+extern std::string hostFatFSRoot;
+
+class File : public Stream {
+public:
+  File(void) : file(nullptr) {}
+  File(FILE *file, const std::string &path) : file(file), path(path) {}
+
+  operator bool(void) const { return file != nullptr; }
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+  int available(void) override;
+  int read(void) override;
+  int read(uint8_t *buffer, size_t size);
+  int peek(void) override;
+  void flush(void) override;
+  bool seek(uint32_t position);
+  size_t position(void);
+  size_t size(void);
+  time_t getLastWrite(void);
+  void close(void);
+
+private:
+  FILE *file;
+  std::string path;
+};
+
+class HostFatFS {
+public:
+  bool begin(void) { return true; }
+  File open(const char *path, const char *mode = "r");
+  File open(const String &path, const char *mode = "r") {
+    return open(path.c_str(), mode);
+  }
+  bool exists(const char *path);
+  bool exists(const String &path) { return exists(path.c_str()); }
+  bool remove(const char *path);
+  bool remove(const String &path) { return remove(path.c_str()); }
+};
+
+extern HostFatFS FatFS;
+
+#endif
@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: MIT
+// Host stand-in for the INA219 library, reads as nothing connected
+#ifndef HOST_INA219_H
+#define HOST_INA219_H
+
+#include <Wire.h>
+
+class INA219 {
+public:
+  INA219(uint8_t address, TwoWire *wire = &Wire) : address(address) {}
+  bool begin(void) { return false; }
+  bool isConnected(void) { return false; }
+  float getBusVoltage(void) { return 0; }
+  float getShuntVoltage(void) { return 0; }
+  float getShuntVoltage_mV(void) { return 0; }
+  float getCurrent(void) { return 0; }
+  float getCurrent_mA(void) { return 0; }
+  float getPower(void) { return 0; }
+  float getPower_mW(void) { return 0; }
+  bool setMaxCurrentShunt(float, float = 0.002) { return true; }
+  bool setBusVoltageRange(uint8_t) { return true; }
+  bool setGain(uint8_t) { return true; }
+  bool setMode(uint8_t = 7) { return true; }
+  uint8_t getAddress(void) { return address; }
+
+private:
+  uint8_t address;
+};
+
+#endif
@@ -0,0 +1,8 @@
+// SPDX-License-Identifier: MIT
+// The routing code includes SafeString but doesn't use it on the host
+#ifndef HOST_SAFESTRING_H
+#define HOST_SAFESTRING_H
+
+#include <Arduino.h>
+
+#endif
@@ -0,0 +1,25 @@
+// SPDX-License-Identifier: MIT
+// Host stand-in, nothing is on the bus
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include <Arduino.h>
+
+class TwoWire {
+public:
+  void begin(void) {}
+  void setSDA(int) {}
+  void setSCL(int) {}
+  void setClock(uint32_t) {}
+  void beginTransmission(uint8_t) {}
+  uint8_t endTransmission(bool = true) { return 2; }
+  size_t write(uint8_t) { return 1; }
+  uint8_t requestFrom(uint8_t, size_t) { return 0; }
+  int available(void) { return 0; }
+  int read(void) { return -1; }
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
+
+#endif
@@ -0,0 +1,199 @@
+// SPDX-License-Identifier: MIT
+// What jumperless.adc_capture() runs, against a simulated sample source in
+// place of the DMA: the writer fills the interleaved ring at the engine's
+// rate in uneven bursts, and the capture drains its channel between bursts
+// the way adcCaptureRun() does between adcSamplesWritten() polls. Checks the
+// rate it picks, the frequency and phase that come out, the trigger, the
+// 8 bit buffer mode, and that getting lapped is reported instead of
+// silently skipping samples.
+#include "AdcEngine.h"
+#include "check.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#define ENGINE_RATE ADC_MAX_RATE
+#define CHANNEL_RATE (ENGINE_RATE / ADC_ENGINE_CHANNELS)
+#define TONE_CHANNEL 2
+
+static uint16_t ring[ADC_RING_SAMPLES];
+static uint64_t written = 0;
+static double toneHz = 1000.0;
+
+/// @brief The simulated inputs: a tone on TONE_CHANNEL, a flat level on the
+/// rest (i counts that channel's samples)
+static uint16_t source(uint32_t channel, uint64_t i) {
+  if (channel != TONE_CHANNEL) {
+    return 300 + channel * 100;
+  }
+  double t = (double)i / CHANNEL_RATE;
+  return (uint16_t)lround(2048 + 1800 * sin(2 * M_PI * toneHz * t));
+}
+
+static void writeStream(uint32_t samples) {
+  for (uint32_t n = 0; n < samples; n++, written++) {
+    ring[written & (ADC_RING_SAMPLES - 1)] =
+        source(written % ADC_ENGINE_CHANNELS, written / ADC_ENGINE_CHANNELS);
+  }
+}
+
+static struct adcView view(uint32_t channel) {
+  struct adcView v = {ring, ADC_RING_SAMPLES, ADC_ENGINE_CHANNELS, channel,
+                      ADC_RING_GUARD};
+  return v;
+}
+
+/// @brief Capture with the writer running `burst` samples (give or take a
+/// third) between drains, returns what the last drain said
+static int runCapture(struct adcCapture *cap, uint32_t channel,
+                      uint32_t burst) {
+  struct adcView v = view(channel);
+  uint64_t cursor = adcViewCount(&v, written);
+  int result = 0;
+  for (int polls = 0; polls < 100000 && result == 0; polls++) {
+    writeStream(burst * 2 / 3 + rand() % (burst * 2 / 3 + 1));
+    result = adcCaptureDrain(cap, &v, written, &cursor);
+  }
+  return result;
+}
+
+/// @brief Rising crossings of the midpoint, with the fractional position of
+/// the first and last so the period comes out to well under a sample
+static double measureFrequency(const uint16_t *samples, int count,
+                               double sampleRate) {
+  double first = -1;
+  double last = -1;
+  int crossings = 0;
+  for (int i = 1; i < count; i++) {
+    if (samples[i - 1] < 2048 && samples[i] >= 2048) {
+      double at = i - 1 + (2048.0 - samples[i - 1]) /
+                              (samples[i] - samples[i - 1]);
+      if (first < 0) {
+        first = at;
+      }
+      last = at;
+      crossings++;
+    }
+  }
+  if (crossings < 2) {
+    return 0;
+  }
+  return (crossings - 1) * sampleRate / (last - first);
+}
+
+static void testFactor(void) {
+  CHECK_EQ(adcCaptureFactor(ENGINE_RATE, 62500), 1);
+  CHECK_EQ(adcCaptureFactor(ENGINE_RATE, 100000), 1); // can't go faster
+  CHECK_EQ(adcCaptureFactor(ENGINE_RATE, 10000), 6);  // 10.4kHz
+  CHECK_EQ(adcCaptureFactor(ENGINE_RATE, 1000), 63);
+  CHECK_EQ(adcCaptureFactor(ENGINE_RATE, 1), 62500);
+  CHECK_EQ(adcCaptureFactor(80000, 10000), 1);
+}
+
+// the captured tone comes out at the right frequency for the rate actually
+// used, and starts where the trigger said
+static void testToneCapture(void) {
+  const float rates[] = {62500, 20000, 10000, 4000};
+  const double tones[] = {5000, 1000, 440, 50};
+  static uint16_t out[2000];
+
+  for (float rate : rates) {
+    for (double tone : tones) {
+      if (tone * 8 > rate || tone * 2000 < rate * 10) {
+        continue; // fewer than 8 samples a cycle, or 10 cycles a capture
+      }
+      toneHz = tone;
+      int factor = adcCaptureFactor(ENGINE_RATE, rate);
+      double actual = (double)CHANNEL_RATE / factor;
+
+      struct adcCapture cap;
+      adcCaptureBegin(&cap, out, 2, 2000, factor, 2048, 1);
+      CHECK_EQ(runCapture(&cap, TONE_CHANNEL, 400), 1);
+      CHECK_EQ(cap.filled, 2000);
+
+      double measured = measureFrequency(out, 2000, actual);
+      // box-car averaging over factor samples shrinks the tone a little but
+      // doesn't move its crossings
+      CHECK(fabs(measured - tone) < tone * 0.002);
+      if (fabs(measured - tone) >= tone * 0.002) {
+        printf("  %.0fHz at %.0fHz came out as %.2fHz\n", tone, actual,
+               measured);
+      }
+      // rising trigger: starts at the midpoint going up
+      CHECK(out[0] >= 2048 && out[1] > out[0]);
+      CHECK(out[0] - 2048 < 1800 * 2 * M_PI * tone / actual + 2);
+    }
+  }
+}
+
+// a bytearray gets the same capture, top 8 bits
+static void testByteCapture(void) {
+  toneHz = 1000;
+  static uint16_t wide[500];
+  static uint8_t narrow[500];
+  struct adcCapture cap;
+  struct adcCapture capNarrow;
+  struct adcView v = view(TONE_CHANNEL);
+
+  adcCaptureBegin(&cap, wide, 2, 500, 6, -1, 0);
+  adcCaptureBegin(&capNarrow, narrow, 1, 500, 6, -1, 0);
+  uint64_t cursor = adcViewCount(&v, written);
+  uint64_t cursorNarrow = cursor;
+  int done = 0;
+  while (done == 0) {
+    writeStream(200);
+    done = adcCaptureDrain(&cap, &v, written, &cursor);
+    CHECK(adcCaptureDrain(&capNarrow, &v, written, &cursorNarrow) == done);
+  }
+  for (int i = 0; i < 500; i++) {
+    CHECK_EQ(narrow[i], wide[i] >> 4);
+  }
+}
+
+// a channel that never crosses the level never fills, and the caller's
+// timeout is what ends it
+static void testNoTrigger(void) {
+  static uint16_t out[100];
+  struct adcCapture cap;
+  struct adcView v = view(5);
+  adcCaptureBegin(&cap, out, 2, 100, 1, 2048, 0);
+  uint64_t cursor = adcViewCount(&v, written);
+  for (int polls = 0; polls < 1000; polls++) {
+    writeStream(300);
+    CHECK_EQ(adcCaptureDrain(&cap, &v, written, &cursor), 0);
+  }
+  CHECK_EQ(cap.triggered, 0);
+  CHECK_EQ(cap.filled, 0);
+}
+
+// the writer getting more than a ring (less the guard) ahead is reported,
+// not papered over
+static void testLapped(void) {
+  static uint16_t out[2000];
+  struct adcCapture cap;
+  struct adcView v = view(TONE_CHANNEL);
+  const uint32_t safe = (ADC_RING_SAMPLES - ADC_RING_GUARD) / ADC_ENGINE_CHANNELS;
+
+  adcCaptureBegin(&cap, out, 2, 2000, 1, -1, 0);
+  uint64_t cursor = adcViewCount(&v, written);
+  writeStream(safe * ADC_ENGINE_CHANNELS);
+  CHECK_EQ(adcCaptureDrain(&cap, &v, written, &cursor), 0);
+  CHECK_EQ(cap.filled, (int)safe);
+
+  writeStream(safe * ADC_ENGINE_CHANNELS + ADC_ENGINE_CHANNELS);
+  uint64_t before = cursor;
+  CHECK_EQ(adcCaptureDrain(&cap, &v, written, &cursor), -1);
+  CHECK_EQ(cursor, before);
+  CHECK_EQ(cap.filled, (int)safe);
+}
+
+int main(void) {
+  srand(0x4a4c);
+  writeStream(12345); // the engine's been running a while already
+  testFactor();
+  testToneCapture();
+  testByteCapture();
+  testNoTrigger();
+  testLapped();
+  return checkResult("test_adc_capture");
+}
@@ -0,0 +1,211 @@
+// SPDX-License-Identifier: MIT
+// The ADC engine's views and capture decimation against an interleaved ring
+// filled the way the DMA fills it: sample k of the stream goes to
+// ring[k % size] and belongs to channel k % 8, and the writer laps the ring
+// (and the 32 bit sample count) many times over.
+#include "AdcEngine.h"
+#include "check.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+static uint16_t ring[ADC_RING_SAMPLES];
+
+/// @brief The synthetic source: what channel c read on its i-th sample
+static uint16_t source(uint32_t channel, uint64_t i) {
+  return (uint16_t)((channel * 512 + (i * 37) % 509 + (i >> 10)) & 0x0fff);
+}
+
+/// @brief Write the stream up to `written` samples (only the last lap of the
+/// ring matters)
+static void fill(uint64_t written) {
+  uint64_t from = written > ADC_RING_SAMPLES ? written - ADC_RING_SAMPLES : 0;
+  for (uint64_t k = from; k < written; k++) {
+    ring[k & (ADC_RING_SAMPLES - 1)] =
+        source(k % ADC_ENGINE_CHANNELS, k / ADC_ENGINE_CHANNELS);
+  }
+}
+
+static struct adcView view(uint32_t channel) {
+  struct adcView v = {ring, ADC_RING_SAMPLES, ADC_ENGINE_CHANNELS, channel,
+                      ADC_RING_GUARD};
+  return v;
+}
+
+static void testDepth(void) {
+  const uint32_t safe = (ADC_RING_SAMPLES - ADC_RING_GUARD) / ADC_ENGINE_CHANNELS;
+  struct adcView v3 = view(3);
+
+  fill(3);
+  CHECK_EQ(adcViewDepth(&v3, 3), 0);
+  CHECK_EQ(adcViewLatest(&v3, 3), -1);
+  CHECK_EQ(adcViewAverage(&v3, 3, 4), -1);
+
+  fill(4);
+  CHECK_EQ(adcViewDepth(&v3, 4), 1);
+  CHECK_EQ(adcViewLatest(&v3, 4), source(3, 0));
+
+  fill(8 * 10 + 2);
+  struct adcView v1 = view(1);
+  struct adcView v2 = view(2);
+  CHECK_EQ(adcViewDepth(&v1, 8 * 10 + 2), 11);
+  CHECK_EQ(adcViewDepth(&v2, 8 * 10 + 2), 10);
+
+  // past a full ring the guard keeps the newest slots out of reach
+  uint64_t written = (5ULL << 32) + 12345;
+  fill(written);
+  for (uint32_t c = 0; c < ADC_ENGINE_CHANNELS; c++) {
+    struct adcView v = view(c);
+    uint64_t count = (written - c - 1) / ADC_ENGINE_CHANNELS + 1;
+    CHECK_EQ(adcViewDepth(&v, written), safe);
+    CHECK_EQ(adcViewLatest(&v, written), source(c, count - 1));
+  }
+}
+
+static void testAverageAndMinMax(void) {
+  uint64_t written = (1ULL << 33) + 77;
+  fill(written);
+  for (uint32_t c = 0; c < ADC_ENGINE_CHANNELS; c++) {
+    struct adcView v = view(c);
+    uint64_t count = (written - c - 1) / ADC_ENGINE_CHANNELS + 1;
+    for (int n = 1; n <= 64; n *= 4) {
+      uint32_t sum = 0;
+      int low = 0xffff;
+      int high = 0;
+      for (int i = 0; i < n; i++) {
+        int sample = source(c, count - 1 - i);
+        sum += sample;
+        low = sample < low ? sample : low;
+        high = sample > high ? sample : high;
+      }
+      CHECK_EQ(adcViewAverage(&v, written, n), (sum + n / 2) / n);
+      int min;
+      int max;
+      CHECK_EQ(adcViewMinMax(&v, written, n, &min, &max), n);
+      CHECK_EQ(min, low);
+      CHECK_EQ(max, high);
+    }
+    // asking for more than is safe gets what is
+    int min;
+    int max;
+    CHECK_EQ(adcViewMinMax(&v, written, 100000, &min, &max),
+             adcViewDepth(&v, written));
+  }
+}
+
+// every block is the rounded mean of factor samples, oldest block first and
+// the newest block ending on the newest sample
+static void testDecimate(void) {
+  uint64_t written = (3ULL << 32) + 999;
+  fill(written);
+  uint16_t out[512];
+  int factors[] = {1, 2, 3, 8, 16, 100, 448, 449};
+  for (uint32_t c = 0; c < ADC_ENGINE_CHANNELS; c++) {
+    struct adcView v = view(c);
+    uint32_t depth = adcViewDepth(&v, written);
+    uint64_t count = (written - c - 1) / ADC_ENGINE_CHANNELS + 1;
+    for (int factor : factors) {
+      int blocks = adcViewDecimate(&v, written, factor, out, 512);
+      CHECK_EQ(blocks, depth / factor);
+      for (int b = 0; b < blocks; b++) {
+        uint64_t last = count - 1 - (uint64_t)(blocks - 1 - b) * factor;
+        uint32_t sum = 0;
+        for (int i = 0; i < factor; i++) {
+          sum += source(c, last - i);
+        }
+        CHECK_EQ(out[b], (sum + factor / 2) / factor);
+      }
+    }
+  }
+
+  // maxOut keeps the newest blocks
+  struct adcView v = view(5);
+  uint16_t all[512];
+  int blocks = adcViewDecimate(&v, written, 4, all, 512);
+  uint16_t few[10];
+  CHECK_EQ(adcViewDecimate(&v, written, 4, few, 10), 10);
+  for (int b = 0; b < 10; b++) {
+    CHECK_EQ(few[b], all[blocks - 10 + b]);
+  }
+  // a factor under 1 is taken as 1
+  CHECK_EQ(adcViewDecimate(&v, written, 0, out, 512), adcViewDepth(&v, written));
+}
+
+// a tone at the decimated rate's Nyquist frequency box-cars down to its DC
+// level, and a slow ramp comes through as the mean of each block
+static void testDecimateFiltering(void) {
+  uint16_t samples[4000];
+  uint8_t out8[400];
+  struct adcCapture cap;
+
+  for (int i = 0; i < 4000; i++) {
+    samples[i] = 2000 + (i % 2 == 0 ? 300 : -300);
+  }
+  uint16_t out[1000];
+  adcCaptureBegin(&cap, out, 2, 1000, 4, -1, 0);
+  int done = 0;
+  for (int i = 0; i < 4000 && done == 0; i++) {
+    done = adcCaptureFeed(&cap, samples[i]);
+  }
+  CHECK_EQ(done, 1);
+  CHECK_EQ(cap.filled, 1000);
+  for (int i = 0; i < 1000; i++) {
+    CHECK_EQ(out[i], 2000);
+  }
+
+  adcCaptureBegin(&cap, out8, 1, 400, 10, -1, 0);
+  for (int i = 0; i < 4000; i++) {
+    adcCaptureFeed(&cap, i);
+  }
+  for (int i = 0; i < 400; i++) {
+    CHECK_EQ(out8[i], (i * 10 + 5) >> 4); // mean of 10i..10i+9, top 8 bits
+  }
+  CHECK_EQ(adcCaptureFeed(&cap, 0), 1); // full stays full
+}
+
+// the trigger looks at decimated values, and the triggering value is the
+// first one kept
+static void testCaptureTrigger(void) {
+  uint16_t out[64];
+  struct adcCapture cap;
+  const int level = 2048;
+
+  for (int edge = -1; edge <= 1; edge++) {
+    adcCaptureBegin(&cap, out, 2, 64, 2, level, edge);
+    int firstKept = -1;
+    for (int i = 0; i < 4000 && cap.filled < 64; i++) {
+      double phase = 2 * M_PI * i / 200.0; // a 100 output period
+      uint16_t sample = (uint16_t)lround(2048 + 1500 * sin(phase + 1.0));
+      int before = cap.filled;
+      adcCaptureFeed(&cap, sample);
+      if (before == 0 && cap.filled == 1) {
+        firstKept = i;
+      }
+    }
+    CHECK_EQ(cap.filled, 64);
+    CHECK(firstKept > 0);
+    CHECK(cap.triggered == 1);
+    // it starts above the level, so either edge finds the falling one first
+    if (edge > 0) {
+      CHECK(out[0] >= level && out[1] > out[0]);
+    } else {
+      CHECK(out[0] <= level && out[1] < out[0]);
+    }
+  }
+
+  // never crosses, never fills
+  adcCaptureBegin(&cap, out, 2, 64, 1, level, 1);
+  for (int i = 0; i < 1000; i++) {
+    CHECK_EQ(adcCaptureFeed(&cap, 1000), 0);
+  }
+  CHECK_EQ(cap.filled, 0);
+}
+
+int main(void) {
+  testDepth();
+  testAverageAndMinMax();
+  testDecimate();
+  testDecimateFiltering();
+  testCaptureTrigger();
+  return checkResult("test_adc_engine");
+}
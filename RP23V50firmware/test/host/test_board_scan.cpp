@@ -0,0 +1,239 @@
+// SPDX-License-Identifier: MIT
+// BoardScan's route search against the rev 5 chip maps, first on an empty
+// board and then with each netlist in corpus/routing routed by the real
+// pipeline and its crosspoints closed. Every route has to be a chain of open
+// crosspoints from the ADC to the node that only passes through free lanes (so
+// measuring never joins another net), as short as a brute force search
+// finds, and every node the brute force can reach has to get one.
+#include "BoardScan.h"
+#include "FileParsing.h"
+#include "JumperlessDefines.h"
+#include "MatrixState.h"
+#include "NetManager.h"
+#include "NetsToChipConnections.h"
+#include "check.h"
+
+#include <FatFS.h>
+
+#include <string.h>
+
+#define SCAN_NODE_MAX 95
+
+static struct scanGraph graph;
+static struct scanTree tree;
+
+static void readMaps(void) {
+  mapCrosspointWires();
+  for (int chip = 0; chip < SCAN_CHIPS; chip++) {
+    for (int x = 0; x < 16; x++) {
+      graph.xWire[chip][x] = xLineWire(chip, x);
+    }
+    for (int y = 0; y < 8; y++) {
+      graph.yWire[chip][y] = yLineWire(chip, y);
+    }
+  }
+  memset(graph.closed, 0, sizeof(graph.closed));
+}
+
+// what updateChipStateArray() closes for path[]
+static void closePaths(void) {
+  memset(graph.closed, 0, sizeof(graph.closed));
+  for (int i = 0; i < numberOfPaths; i++) {
+    for (int j = 0; j < 4; j++) {
+      int chip = path[i].chip[j];
+      int x = path[i].x[j];
+      int y = path[i].y[j];
+      if (chip >= 0 && chip < SCAN_CHIPS && x >= 0 && x < 16 && y >= 0 &&
+          y < 8) {
+        graph.closed[chip][x][y] = 1;
+      }
+    }
+  }
+}
+
+/// @brief Whether a node has a line on any chip
+static bool nodeOnChips(int node) {
+  int wire = SCAN_NODE_WIRE_BASE + node;
+  for (int chip = 0; chip < SCAN_CHIPS; chip++) {
+    for (int x = 0; x < 16; x++) {
+      if (graph.xWire[chip][x] == wire) {
+        return true;
+      }
+    }
+    for (int y = 0; y < 8; y++) {
+      if (graph.yWire[chip][y] == wire) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+static void busyWires(uint8_t *busy) {
+  memset(busy, 0, SCAN_WIRES);
+  for (int chip = 0; chip < SCAN_CHIPS; chip++) {
+    for (int x = 0; x < 16; x++) {
+      for (int y = 0; y < 8; y++) {
+        if (graph.closed[chip][x][y] != 0) {
+          busy[graph.xWire[chip][x]] = 1;
+          busy[graph.yWire[chip][y]] = 1;
+        }
+      }
+    }
+  }
+}
+
+/// @brief Fewest crosspoints from source to target through free lanes, by
+/// trying every chain of up to SCAN_MAX_HOPS. 0 if there's none.
+static int bruteForceHops(const uint8_t *busy, int wire, int target, int depth,
+                          uint8_t *visited) {
+  int best = 0;
+  for (int chip = 0; chip < SCAN_CHIPS; chip++) {
+    for (int x = 0; x < 16; x++) {
+      for (int y = 0; y < 8; y++) {
+        int xSide = graph.xWire[chip][x];
+        int ySide = graph.yWire[chip][y];
+        int other = xSide == wire ? ySide : (ySide == wire ? xSide : -1);
+        if (other < 0 || graph.closed[chip][x][y] != 0) {
+          continue;
+        }
+        int hops = 0;
+        if (other == target) {
+          hops = depth + 1;
+        } else if (depth + 1 < SCAN_MAX_HOPS &&
+                   other < SCAN_NODE_WIRE_BASE && busy[other] == 0 &&
+                   visited[other] == 0) {
+          visited[other] = 1;
+          hops = bruteForceHops(busy, other, target, depth + 1, visited);
+          visited[other] = 0;
+        }
+        if (hops > 0 && (best == 0 || hops < best)) {
+          best = hops;
+        }
+      }
+    }
+  }
+  return best;
+}
+
+/// @brief The route is a chain of open crosspoints from the source to the
+/// target, and everything in between is a free lane
+static bool routeValid(const struct scanRoute *route, const uint8_t *busy,
+                       int source, int target) {
+  int wire = source;
+  for (int hop = 0; hop < route->hops; hop++) {
+    int chip = route->chip[hop];
+    int x = route->x[hop];
+    int y = route->y[hop];
+    if (graph.closed[chip][x][y] != 0) {
+      return false;
+    }
+    int xSide = graph.xWire[chip][x];
+    int ySide = graph.yWire[chip][y];
+    int other = xSide == wire ? ySide : (ySide == wire ? xSide : -1);
+    if (other < 0) {
+      return false; // doesn't carry on from the last one
+    }
+    if (hop < route->hops - 1 &&
+        (other >= SCAN_NODE_WIRE_BASE || busy[other] == 1)) {
+      return false; // through another node, or a lane a net is using
+    }
+    wire = other;
+  }
+  return wire == target;
+}
+
+/// @brief Route an ADC to every node scanBoard() could ask for, returns how
+/// many got one (-1 if the ADC is in use)
+static int checkAllNodes(const char *name, int adc, int *nodes) {
+  static uint8_t busy[SCAN_WIRES];
+  static uint8_t visited[SCAN_WIRES];
+  busyWires(busy);
+  memset(visited, 0, sizeof(visited));
+  int source = SCAN_NODE_WIRE_BASE + adc;
+  if (scanGrowTree(&graph, source, &tree) == 0) {
+    *nodes = 0;
+    return -1; // the netlist uses the ADC
+  }
+
+  int routed = 0;
+  *nodes = 0;
+  for (int node = 1; node <= SCAN_NODE_MAX; node++) {
+    if (node > 60 && node < NANO_D0) {
+      continue; // between the last row and the nano header, not nodes
+    }
+    (*nodes)++;
+    int target = SCAN_NODE_WIRE_BASE + node;
+    struct scanRoute route;
+    int hops = scanRouteTo(&graph, &tree, target, &route);
+    visited[source] = 1;
+    int shortest = bruteForceHops(busy, source, target, 0, visited);
+    visited[source] = 0;
+    bool ok = hops == shortest && (hops == 0 || routeValid(&route, busy,
+                                                           source, target));
+    CHECK(ok);
+    if (!ok) {
+      printf("  %s: node %d got %d hops, brute force found %d\n", name, node,
+             hops, shortest);
+    }
+    routed += hops > 0;
+  }
+  return routed;
+}
+
+// nothing closed: 83 of the 86 nodes get a route, the other three are the
+// nano reset pins, which have no line on any chip (scanBoard() skips them)
+static void testEmptyBoard(void) {
+  readMaps();
+  int nodes;
+  int routed = checkAllNodes("empty board", ADC2, &nodes); // scanBoard()'s
+  CHECK_EQ(nodes, 86);
+  CHECK_EQ(routed, 83);
+  for (int node : {NANO_RESET, NANO_RESET_0, NANO_RESET_1}) {
+    CHECK(nodeOnChips(node) == false);
+  }
+}
+
+// with real netlists closed, routes only take what the nets left free. A
+// netlist that uses ADC 2, or boxes it in, gets scanned from the next ADC
+// that reaches anything. With none that does, every node is left to
+// measureVoltage() rather than routed through a net.
+static void testRoutedNetlists(void) {
+  const char *files[] = {"blink.txt",      "gpio_and_adc.txt",
+                         "nano_bus.txt",   "rails_and_dacs.txt",
+                         "random_30.txt",  "random_100.txt",
+                         "random_200.txt"};
+  const int adcs[] = {ADC2, ADC3, ADC1, ADC0};
+  hostSerialOut = nullptr;
+  routingBenchmarkRunning = true;
+  initNets();
+  rebuildNetIndex();
+  for (const char *file : files) {
+    clearAllNTCC();
+    CHECK(parseNodeFileAt(file) > 0);
+    getNodesToConnect();
+    bridgesToPaths();
+    readMaps();
+    closePaths();
+    int nodes;
+    int routed = -1;
+    for (int i = 0; i < 4 && routed <= 0; i++) {
+      int got = checkAllNodes(file, adcs[i], &nodes);
+      routed = got > routed ? got : routed;
+    }
+    if (strcmp(file, "gpio_and_adc.txt") == 0) {
+      CHECK_EQ(routed, -1); // every ADC is in a net
+    } else if (strcmp(file, "rails_and_dacs.txt") == 0) {
+      CHECK_EQ(routed, 0); // ADC 3 is free, but the nets took its lanes
+    } else {
+      CHECK(routed > 0);
+    }
+  }
+}
+
+int main(void) {
+  hostFatFSRoot = "corpus/routing";
+  testEmptyBoard();
+  testRoutedNetlists();
+  return checkResult("test_board_scan");
+}
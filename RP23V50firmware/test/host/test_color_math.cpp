@@ -0,0 +1,308 @@
+// SPDX-License-Identifier: MIT
+// ColorMath against the conversions it replaced, copied below from LEDs.cpp
+// as they were before it (HsvToRgb(), RgbToHsv(), scaleBrightness()). Every
+// one of the 2^24 colors goes through each both ways and has to come out
+// the same, and scaleBrightness() is checked on every color for a few
+// factors and on a color of every value for all the others. Then both are
+// timed over a row of colors, which only prints.
+#include "ColorMath.h"
+#include "check.h"
+
+#include <chrono>
+#include <stdlib.h>
+
+#define COLORS (1UL << 24)
+#define BENCH_ROW 445 // a frame of leds
+#define BENCH_ROWS 2000
+
+// the old conversions, as they were in LEDs.cpp
+
+typedef struct rgbColor {
+  unsigned char r;
+  unsigned char g;
+  unsigned char b;
+} rgbColor;
+
+typedef struct hsvColor {
+  unsigned char h;
+  unsigned char s;
+  unsigned char v;
+} hsvColor;
+
+static rgbColor unpackRgb(uint32_t color) {
+  rgbColor rgb;
+  rgb.r = (color >> 16) & 0xFF;
+  rgb.g = (color >> 8) & 0xFF;
+  rgb.b = color & 0xFF;
+  return rgb;
+}
+
+static uint32_t packRgb(uint8_t r, uint8_t g, uint8_t b) {
+  return (uint32_t)r << 16 | (uint32_t)g << 8 | b;
+}
+
+static rgbColor HsvToRgb(hsvColor hsv) {
+  rgbColor rgb;
+  unsigned char region, p, q, t;
+  unsigned int h, s, v, remainder;
+
+  if (hsv.s == 0) {
+    rgb.r = hsv.v;
+    rgb.g = hsv.v;
+    rgb.b = hsv.v;
+    return rgb;
+  }
+
+  // converting to 16 bit to prevent overflow
+  h = hsv.h;
+  s = hsv.s;
+  v = hsv.v;
+
+  region = h / 43;
+  remainder = (h - (region * 43)) * 6;
+
+  p = (v * (255 - s)) >> 8;
+  q = (v * (255 - ((s * remainder) >> 8))) >> 8;
+  t = (v * (255 - ((s * (255 - remainder)) >> 8))) >> 8;
+
+  switch (region) {
+  case 0:
+    rgb.r = v;
+    rgb.g = t;
+    rgb.b = p;
+    break;
+  case 1:
+    rgb.r = q;
+    rgb.g = v;
+    rgb.b = p;
+    break;
+  case 2:
+    rgb.r = p;
+    rgb.g = v;
+    rgb.b = t;
+    break;
+  case 3:
+    rgb.r = p;
+    rgb.g = q;
+    rgb.b = v;
+    break;
+  case 4:
+    rgb.r = t;
+    rgb.g = p;
+    rgb.b = v;
+    break;
+  default:
+    rgb.r = v;
+    rgb.g = p;
+    rgb.b = q;
+    break;
+  }
+
+  return rgb;
+}
+
+static hsvColor RgbToHsv(rgbColor rgb) {
+  hsvColor hsv;
+  unsigned char rgbMin, rgbMax;
+
+  rgbMin = rgb.r < rgb.g ? (rgb.r < rgb.b ? rgb.r : rgb.b)
+                         : (rgb.g < rgb.b ? rgb.g : rgb.b);
+  rgbMax = rgb.r > rgb.g ? (rgb.r > rgb.b ? rgb.r : rgb.b)
+                         : (rgb.g > rgb.b ? rgb.g : rgb.b);
+
+  hsv.v = rgbMax;
+  if (hsv.v == 0) {
+    hsv.h = 0;
+    hsv.s = 0;
+    return hsv;
+  }
+
+  hsv.s = 255 * ((long)(rgbMax - rgbMin)) / hsv.v;
+  if (hsv.s == 0) {
+    hsv.h = 0;
+    return hsv;
+  }
+
+  if (rgbMax == rgb.r)
+    hsv.h = 0 + 43 * (rgb.g - rgb.b) / (rgbMax - rgbMin);
+  else if (rgbMax == rgb.g)
+    hsv.h = 85 + 43 * (rgb.b - rgb.r) / (rgbMax - rgbMin);
+  else
+    hsv.h = 171 + 43 * (rgb.r - rgb.g) / (rgbMax - rgbMin);
+
+  return hsv;
+}
+
+/// @brief The float to unsigned char as the RP2350 does it: vcvt to an
+/// unsigned word, which stops at 0, then the low byte. On a PC a plain cast
+/// of anything outside 0..255 is undefined, so it's spelled out.
+static unsigned char floatToByte(float value) {
+  return value > 0 ? (unsigned char)(uint32_t)value : 0;
+}
+
+static uint32_t scaleBrightness(uint32_t hexColor, int scaleFactor) {
+
+  if (scaleFactor == 0) {
+    return hexColor;
+  }
+  float scaleFactorF = scaleFactor / 100.0;
+
+  scaleFactorF += 1.0;
+
+  hsvColor colorToShiftHsv = RgbToHsv(unpackRgb(hexColor));
+
+  float hsvF = colorToShiftHsv.v * scaleFactorF;
+
+  colorToShiftHsv.v = floatToByte(hsvF);
+
+  rgbColor colorToShiftRgb = HsvToRgb(colorToShiftHsv);
+  return packRgb(colorToShiftRgb.r, colorToShiftRgb.g, colorToShiftRgb.b);
+}
+
+// the checks
+
+static uint32_t oldHsvToRgb(uint32_t hsv) {
+  hsvColor color = {(unsigned char)(hsv >> 16), (unsigned char)(hsv >> 8),
+                    (unsigned char)hsv};
+  rgbColor rgb = HsvToRgb(color);
+  return packRgb(rgb.r, rgb.g, rgb.b);
+}
+
+static uint32_t oldRgbToHsv(uint32_t rgb) {
+  hsvColor hsv = RgbToHsv(unpackRgb(rgb));
+  return colorPackHsv(hsv.h, hsv.s, hsv.v);
+}
+
+/// @brief Returns how many colors came out different, printing the first
+static unsigned long countMismatches(const char *name,
+                                     uint32_t (*before)(uint32_t),
+                                     uint32_t (*after)(uint32_t)) {
+  unsigned long mismatches = 0;
+  for (uint32_t color = 0; color < COLORS; color++) {
+    uint32_t want = before(color);
+    uint32_t got = after(color);
+    if (want != got && mismatches++ == 0) {
+      printf("  %s(%06x): %06x, was %06x\n", name, (unsigned int)color,
+             (unsigned int)got, (unsigned int)want);
+    }
+  }
+  return mismatches;
+}
+
+static void testConversions(void) {
+  CHECK_EQ(countMismatches("colorHsvToRgb", oldHsvToRgb, colorHsvToRgb), 0);
+  CHECK_EQ(countMismatches("colorRgbToHsv", oldRgbToHsv, colorRgbToHsv), 0);
+}
+
+// the factor the firmware uses most, either end of the table and past them
+static void testScaleEveryColor(void) {
+  const int factors[] = {-150, COLOR_SCALE_MIN, -40, 250, COLOR_SCALE_MAX, 550};
+  for (int factor : factors) {
+    unsigned long mismatches = 0;
+    for (uint32_t color = 0; color < COLORS; color++) {
+      uint32_t want = scaleBrightness(color, factor);
+      uint32_t got = colorScaleBrightness(color, factor);
+      if (want != got && mismatches++ == 0) {
+        printf("  colorScaleBrightness(%06x, %d): %06x, was %06x\n",
+               (unsigned int)color, factor, (unsigned int)got,
+               (unsigned int)want);
+      }
+    }
+    CHECK_EQ(mismatches, 0);
+  }
+}
+
+// every other factor, on a color of every value, hue and saturation. Past
+// RgbToHsv() (checked on every color above) only the value is scaled, so
+// this covers the rest of the colors too.
+static void testScaleEveryFactor(void) {
+  unsigned long mismatches = 0;
+  for (int factor = COLOR_SCALE_MIN - 20; factor <= COLOR_SCALE_MAX + 20;
+       factor++) {
+    for (uint32_t v = 0; v < 256; v++) {
+      for (uint32_t hs = 0; hs < 0x10000; hs += 0x0101) {
+        uint32_t rgb = colorHsvToRgb(hs << 8 | v);
+        uint32_t want = scaleBrightness(rgb, factor);
+        uint32_t got = colorScaleBrightness(rgb, factor);
+        if (want != got && mismatches++ == 0) {
+          printf("  colorScaleBrightness(%06x, %d): %06x, was %06x\n",
+                 (unsigned int)rgb, factor, (unsigned int)got,
+                 (unsigned int)want);
+        }
+      }
+    }
+  }
+  CHECK_EQ(mismatches, 0);
+}
+
+// the row versions match one at a time, in place too
+static void testRows(void) {
+  static uint32_t in[BENCH_ROW];
+  static uint32_t out[BENCH_ROW];
+  for (int i = 0; i < BENCH_ROW; i++) {
+    in[i] = (uint32_t)rand() & 0xffffff;
+  }
+  colorHsvToRgbRow(in, out, BENCH_ROW);
+  for (int i = 0; i < BENCH_ROW; i++) {
+    CHECK_EQ(out[i], colorHsvToRgb(in[i]));
+  }
+  colorRgbToHsvRow(in, out, BENCH_ROW);
+  for (int i = 0; i < BENCH_ROW; i++) {
+    CHECK_EQ(out[i], colorRgbToHsv(in[i]));
+  }
+  colorScaleBrightnessRow(in, out, BENCH_ROW, -40);
+  for (int i = 0; i < BENCH_ROW; i++) {
+    CHECK_EQ(out[i], colorScaleBrightness(in[i], -40));
+  }
+  for (int i = 0; i < BENCH_ROW; i++) {
+    out[i] = in[i];
+  }
+  colorScaleBrightnessRow(out, out, BENCH_ROW, 250);
+  for (int i = 0; i < BENCH_ROW; i++) {
+    CHECK_EQ(out[i], colorScaleBrightness(in[i], 250));
+  }
+}
+
+static volatile uint32_t benchSink;
+
+/// @brief Nanoseconds a conversion over rows of a frame's worth of colors
+static double benchOne(uint32_t (*convert)(uint32_t), const uint32_t *row) {
+  auto start = std::chrono::steady_clock::now();
+  uint32_t sum = 0;
+  for (int r = 0; r < BENCH_ROWS; r++) {
+    for (int i = 0; i < BENCH_ROW; i++) {
+      sum += convert(row[i] ^ r);
+    }
+  }
+  benchSink = sum;
+  std::chrono::duration<double, std::nano> took =
+      std::chrono::steady_clock::now() - start;
+  return took.count() / (BENCH_ROWS * BENCH_ROW);
+}
+
+static uint32_t oldScale(uint32_t rgb) { return scaleBrightness(rgb, -40); }
+static uint32_t newScale(uint32_t rgb) { return colorScaleBrightness(rgb, -40); }
+
+static void benchmark(void) {
+  static uint32_t row[BENCH_ROW];
+  for (int i = 0; i < BENCH_ROW; i++) {
+    row[i] = (uint32_t)rand() & 0xffffff;
+  }
+  printf("  ns per color\tbefore\tColorMath\n");
+  printf("  HsvToRgb\t%.2f\t%.2f\n", benchOne(oldHsvToRgb, row),
+         benchOne(colorHsvToRgb, row));
+  printf("  RgbToHsv\t%.2f\t%.2f\n", benchOne(oldRgbToHsv, row),
+         benchOne(colorRgbToHsv, row));
+  printf("  scale -40\t%.2f\t%.2f\n", benchOne(oldScale, row),
+         benchOne(newScale, row));
+}
+
+int main(void) {
+  srand(0x4a4c);
+  testConversions();
+  testScaleEveryColor();
+  testScaleEveryFactor();
+  testRows();
+  benchmark();
+  return checkResult("test_color_math");
+}
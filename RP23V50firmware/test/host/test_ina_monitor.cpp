@@ -0,0 +1,239 @@
+// SPDX-License-Identifier: MIT
+// The INA219 accumulator driven by a fake register source: an INA219 model
+// that converts a known load on its own schedule (shunt + bus per reading),
+// sets the ready flag, clears it when power is read and flags math overflow
+// past the shunt range, read from a timer the way the I2C section does.
+// Checks windows, energy, the ready / overflow handling and the ADC codes.
+#include "InaMonitor.h"
+#include "check.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#define CURRENT_LSB 0.0001f // 100uA, what the library calibrates for 3.2A
+#define SHUNT_RANGE 3.2f
+
+/// @brief The load the fake sees at a time
+typedef void (*loadFunction)(uint32_t micros, float *current, float *voltage);
+
+struct fakeIna {
+  loadFunction load;
+  uint32_t conversionMicros; // shunt + bus
+  uint32_t lastConversion;
+  uint16_t bus;
+  uint16_t current;
+  uint16_t power;
+};
+
+static void fakeConvert(struct fakeIna *ina, uint32_t now) {
+  float current;
+  float voltage;
+  ina->load(now, &current, &voltage);
+  uint16_t overflow = fabsf(current) > SHUNT_RANGE ? INA_BUS_OVERFLOW : 0;
+  ina->bus = (uint16_t)(lroundf(voltage / 0.004f) << 3) | INA_BUS_READY |
+             overflow;
+  ina->current = (uint16_t)(int16_t)lroundf(current / CURRENT_LSB);
+  ina->power = (uint16_t)lroundf(fabsf(current * voltage) / (20 * CURRENT_LSB));
+}
+
+/// @brief Registers as a read at `now` would see them, reading power clears
+/// the ready flag until the next conversion finishes
+static void fakeRead(struct fakeIna *ina, uint32_t now, uint16_t *bus,
+                     uint16_t *current, uint16_t *power) {
+  if (now - ina->lastConversion >= ina->conversionMicros) {
+    ina->lastConversion += (now - ina->lastConversion) / ina->conversionMicros *
+                           ina->conversionMicros;
+    fakeConvert(ina, ina->lastConversion);
+  }
+  *bus = ina->bus;
+  *current = ina->current;
+  *power = ina->power;
+  ina->bus &= ~INA_BUS_READY;
+}
+
+static void steadyLoad(uint32_t, float *current, float *voltage) {
+  *current = 0.250f;
+  *voltage = 5.0f;
+}
+
+// 1.5A for the first 30% of every 10ms, 0.1A the rest, on a sagging 3.3V
+static void pulsedLoad(uint32_t micros, float *current, float *voltage) {
+  bool high = micros % 10000 < 3000;
+  *current = high ? 1.5f : 0.1f;
+  *voltage = high ? 3.2f : 3.3f;
+}
+
+// charging backwards through the shunt
+static void reverseLoad(uint32_t, float *current, float *voltage) {
+  *current = -0.5f;
+  *voltage = 12.0f;
+}
+
+static void shortedLoad(uint32_t micros, float *current, float *voltage) {
+  *current = micros < 50000 ? 0.2f : 5.0f;
+  *voltage = 5.0f;
+}
+
+/// @brief Read the fake every tickMicros for runMicros, collecting every
+/// finished window. Returns how many readings were added.
+static int run(struct inaChannel *channel, struct fakeIna *ina,
+               uint32_t tickMicros, uint32_t from, uint32_t runMicros,
+               struct inaWindow *windows, int *windowCount, int maxWindows) {
+  int added = 0;
+  uint32_t lastSeq = 0;
+  for (uint32_t now = from; now - from < runMicros; now += tickMicros) {
+    uint16_t bus;
+    uint16_t current;
+    uint16_t power;
+    fakeRead(ina, now, &bus, &current, &power);
+    if (inaChannelAdd(channel, bus, current, power, now) == 1) {
+      added++;
+    }
+    struct inaWindow window;
+    uint32_t seq = inaChannelWindow(channel, &window);
+    if (seq != lastSeq && *windowCount < maxWindows) {
+      windows[(*windowCount)++] = window;
+      lastSeq = seq;
+    }
+  }
+  return added;
+}
+
+static struct fakeIna makeFake(loadFunction load, uint8_t adcCode,
+                               uint32_t now) {
+  struct fakeIna ina = {};
+  ina.load = load;
+  ina.conversionMicros = 2 * inaConversionMicros(adcCode);
+  ina.lastConversion = now;
+  fakeConvert(&ina, now);
+  return ina;
+}
+
+static void testAdcCodes(void) {
+  CHECK_EQ(inaAdcCode(9, 1), 0x00);
+  CHECK_EQ(inaAdcCode(12, 0), 0x03);
+  CHECK_EQ(inaAdcCode(16, 1), 0x03);
+  CHECK_EQ(inaAdcCode(12, 2), 0x09);
+  CHECK_EQ(inaAdcCode(12, 100), 0x0e); // rounds down to 64
+  CHECK_EQ(inaAdcCode(12, 128), 0x0f);
+  CHECK_EQ(inaAdcCode(12, 1000), 0x0f);
+  CHECK_EQ(inaConversionMicros(0x00), 84);
+  CHECK_EQ(inaConversionMicros(0x03), 532);
+  CHECK_EQ(inaConversionMicros(0x09), 1064);
+  CHECK_EQ(inaConversionMicros(0x0f), 68096);
+}
+
+// a steady load: every window has exactly it, one reading per conversion
+// however fast the timer polls, and energy is P * t
+static void testSteady(void) {
+  const uint32_t start = 0xfffe0000u; // micros() wraps during the run
+  struct inaChannel channel;
+  inaChannelReset(&channel, CURRENT_LSB, 100000, start);
+  struct fakeIna ina = makeFake(steadyLoad, 0x03, start); // 12 bit, 1064us
+  static struct inaWindow windows[32];
+  int windowCount = 0;
+
+  int added = run(&channel, &ina, INA_MIN_TICK_US, start, 1000000, windows,
+                  &windowCount, 32);
+  CHECK(abs(added - 1000000 / 1064) <= 1);
+  CHECK(windowCount >= 9);
+
+  for (int w = 0; w < windowCount; w++) {
+    struct inaWindow *window = &windows[w];
+    CHECK(window->samples >= 93 && window->samples <= 95);
+    CHECK(window->lengthMicros >= 100000 && window->lengthMicros < 101064 + 250);
+    CHECK(fabsf(window->minCurrent - 0.25f) < 1e-4f);
+    CHECK(fabsf(window->maxCurrent - 0.25f) < 1e-4f);
+    CHECK(fabsf(inaWindowMean(window, 0) - 0.25f) < 1e-4f);
+    CHECK(fabsf(inaWindowMean(window, 1) - 5.0f) < 1e-4f);
+    CHECK(fabsf(inaWindowMean(window, 2) - 1.25f) < 2e-3f);
+    // the windows butt up against each other, so a window's energy is its
+    // power over its whole length
+    CHECK(fabs(window->energy - 1.25 * window->lengthMicros * 1e-6) < 2e-3);
+  }
+
+  // energy adds up across windows to the running total
+  double sum = 0;
+  for (int w = 0; w < windowCount; w++) {
+    sum += windows[w].energy;
+  }
+  CHECK(sum <= channel.totalEnergy + 1e-9);
+  CHECK(fabs(channel.totalEnergy - 1.25) < 0.005);
+
+  float current;
+  float voltage;
+  float power;
+  inaChannelLatest(&channel, &current, &voltage, &power);
+  CHECK(fabsf(current - 0.25f) < 1e-4f);
+  CHECK(fabsf(voltage - 5.0f) < 1e-4f);
+}
+
+// a pulsed load: min / max catch both levels, the mean and energy come out
+// duty weighted as long as conversions are short next to the pulses
+static void testPulsed(void) {
+  struct inaChannel channel;
+  inaChannelReset(&channel, CURRENT_LSB, 50000, 0);
+  struct fakeIna ina = makeFake(pulsedLoad, 0x00, 0); // 9 bit, 168us
+  static struct inaWindow windows[32];
+  int windowCount = 0;
+
+  run(&channel, &ina, INA_MIN_TICK_US, 0, 500000, windows, &windowCount, 32);
+  CHECK(windowCount >= 9);
+  for (int w = 0; w < windowCount; w++) {
+    struct inaWindow *window = &windows[w];
+    CHECK(fabsf(window->minCurrent - 0.1f) < 1e-4f);
+    CHECK(fabsf(window->maxCurrent - 1.5f) < 1e-4f);
+    CHECK(fabsf(window->minVoltage - 3.2f) < 0.004f);
+    CHECK(fabsf(window->maxVoltage - 3.3f) < 0.004f);
+    CHECK(fabsf(inaWindowMean(window, 0) - (0.3f * 1.5f + 0.7f * 0.1f)) <
+          0.03f);
+    double watts = 0.3 * 1.5 * 3.2 + 0.7 * 0.1 * 3.3;
+    CHECK(fabs(window->energy / (window->lengthMicros * 1e-6) - watts) <
+          watts * 0.05);
+  }
+}
+
+static void testReverseAndOverflow(void) {
+  struct inaChannel channel;
+  inaChannelReset(&channel, CURRENT_LSB, 20000, 0);
+  struct fakeIna ina = makeFake(reverseLoad, 0x03, 0);
+  static struct inaWindow windows[8];
+  int windowCount = 0;
+  run(&channel, &ina, 500, 0, 100000, windows, &windowCount, 8);
+  CHECK(windowCount > 0);
+  CHECK(fabsf(windows[0].minCurrent + 0.5f) < 1e-4f);
+  CHECK(fabsf(inaWindowMean(&windows[0], 1) - 12.0f) < 1e-4f);
+  CHECK(fabsf(inaWindowMean(&windows[0], 2) - 6.0f) < 0.01f);
+
+  // past the shunt range readings get dropped and counted, not averaged in
+  inaChannelReset(&channel, CURRENT_LSB, 20000, 0);
+  ina = makeFake(shortedLoad, 0x03, 0);
+  windowCount = 0;
+  int added = run(&channel, &ina, 500, 0, 100000, windows, &windowCount, 8);
+  CHECK(channel.overflows > 40);
+  CHECK(added + (int)channel.overflows >= 93);
+  for (int w = 0; w < windowCount; w++) {
+    CHECK(windows[w].maxCurrent < 0.21f);
+  }
+
+  // a read without the ready flag is the same conversion again
+  CHECK_EQ(inaChannelAdd(&channel, 0x1000, 100, 100, 200000), -1);
+}
+
+// nothing finished yet reads as sequence 0
+static void testNoWindowYet(void) {
+  struct inaChannel channel;
+  inaChannelReset(&channel, CURRENT_LSB, 100000, 0);
+  struct inaWindow window;
+  CHECK_EQ(inaChannelWindow(&channel, &window), 0);
+  CHECK_EQ(inaWindowMean(&window, 0), 0);
+}
+
+int main(void) {
+  testAdcCodes();
+  testSteady();
+  testPulsed();
+  testReverseAndOverflow();
+  testNoWindowYet();
+  return checkResult("test_ina_monitor");
+}
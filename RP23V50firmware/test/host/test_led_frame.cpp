@@ -0,0 +1,419 @@
+// SPDX-License-Identifier: MIT
+// The LED compositor on a scripted minute of a board: rails that change
+// voltage, nets that come and go, brightness changes, clears, a menu painted
+// straight over the rows and an animated logo. Every frame is composed twice,
+// once replaying the layers whose inputs haven't changed and once rendering
+// everything, and the two have to match pixel for pixel. The frames listed
+// in corpus/led_frame/golden.txt also have to match what was saved there.
+//
+//   test_led_frame [--save]
+//
+// --save writes this run's frames as the new golden images.
+#include "LedFrame.h"
+#include "check.h"
+
+#include <string.h>
+
+#define GOLDEN_FILE "corpus/led_frame/golden.txt"
+#define FRAMES 60
+#define MAX_SCENE_NETS 8
+#define ROW_PIXELS 5
+#define RAIL_FIRST 300
+#define LOGO_FIRST 430
+
+struct sceneNet {
+  int rows[4]; // 1-60, 0 ends it
+  uint32_t color;
+};
+
+/// @brief Everything the model layers draw from
+struct scene {
+  float railVoltage[2];
+  int brightness;
+  struct sceneNet nets[MAX_SCENE_NETS];
+  int netCount;
+  int probeHighlight; // row the nets leave dark, 0 for none
+  int warningRow;     // row the animation layer blinks, 0 for none
+  int clear;          // clearLEDsExceptRails() before this frame
+  int menu;           // a menu paints straight over rows 1-8 after the layers
+};
+
+static const int goldenFrames[] = {0, 9, 10, 16, 26, 31, 36, 41, 48, 59};
+
+static uint32_t dim(uint32_t color, int brightness) {
+  uint32_t r = ((color >> 16) & 0xff) * brightness >> 8;
+  uint32_t g = ((color >> 8) & 0xff) * brightness >> 8;
+  uint32_t b = (color & 0xff) * brightness >> 8;
+  return r << 16 | g << 8 | b;
+}
+
+static uint32_t floatInputs(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+// the layers, painting the way lightUpRail() / showNets() do
+
+static void drawRails(struct ledFrame *frame, const struct scene *scene) {
+  for (int rail = 0; rail < 4; rail++) {
+    int dot = rail % 2 == 0 ? (int)(scene->railVoltage[rail / 2] * 5) : -1;
+    for (int i = 0; i < 25; i++) {
+      uint32_t color = rail % 2 == 0 ? 0x1b010b : 0x001c05;
+      if (i == dot) {
+        color = 0x06061f;
+      } else if (i < dot) {
+        color = 0x21030b;
+      }
+      ledFramePaint(frame, RAIL_FIRST + rail * 25 + i,
+                    dim(color, scene->brightness));
+    }
+  }
+}
+
+static uint32_t railInputs(const struct scene *scene) {
+  uint32_t inputs = LED_INPUTS_UNKNOWN;
+  inputs = ledInputsAdd(inputs, floatInputs(scene->railVoltage[0]));
+  inputs = ledInputsAdd(inputs, floatInputs(scene->railVoltage[1]));
+  inputs = ledInputsAdd(inputs, scene->brightness);
+  return ledInputsDone(inputs);
+}
+
+static void drawLogo(struct ledFrame *frame, int frameNumber) {
+  for (int i = 0; i < 3; i++) {
+    ledFramePaint(frame, LOGO_FIRST + i,
+                  ((frameNumber * 7 + i * 40) & 0xff) << 8 | 0x10);
+  }
+}
+
+static void drawNets(struct ledFrame *frame, const struct scene *scene) {
+  for (int n = 0; n < scene->netCount; n++) {
+    const struct sceneNet *net = &scene->nets[n];
+    for (int r = 0; r < 4 && net->rows[r] > 0; r++) {
+      if (net->rows[r] == scene->probeHighlight) {
+        continue;
+      }
+      for (int i = 0; i < ROW_PIXELS; i++) {
+        ledFramePaint(frame, (net->rows[r] - 1) * ROW_PIXELS + i,
+                      dim(net->color, scene->brightness));
+      }
+    }
+  }
+}
+
+/// @brief Everything drawNets() reads, leaving out the brightness if asked
+/// to, to show what a hash that misses an input does
+static uint32_t netInputs(const struct scene *scene, bool withBrightness) {
+  uint32_t inputs = LED_INPUTS_UNKNOWN;
+  inputs = ledInputsAdd(inputs, scene->netCount);
+  for (int n = 0; n < scene->netCount; n++) {
+    inputs = ledInputsAdd(inputs, scene->nets[n].color);
+    for (int r = 0; r < 4; r++) {
+      inputs = ledInputsAdd(inputs, scene->nets[n].rows[r]);
+    }
+  }
+  inputs = ledInputsAdd(inputs, scene->probeHighlight);
+  if (withBrightness == true) {
+    inputs = ledInputsAdd(inputs, scene->brightness);
+  }
+  return ledInputsDone(inputs);
+}
+
+static void drawAnimations(struct ledFrame *frame, const struct scene *scene,
+                           int frameNumber) {
+  if (scene->warningRow == 0) {
+    return;
+  }
+  for (int i = 0; i < ROW_PIXELS; i++) {
+    uint32_t color = (frameNumber + i) % 3 == 0 ? 0x090300 : 0x050100;
+    ledFramePaint(frame, (scene->warningRow - 1) * ROW_PIXELS + i, color);
+  }
+}
+
+/// @brief One pass of core2stuff(): direct writes, then the layers in order.
+/// With render set every layer renders, like there was no cache.
+static void composeFrame(struct ledFrame *frame, const struct scene *scene,
+                         int frameNumber, bool render, bool withBrightness) {
+  if (scene->clear == 1) {
+    for (int i = 0; i < RAIL_FIRST; i++) {
+      ledFramePaint(frame, i, 0);
+    }
+  }
+  uint32_t inputs = render ? LED_INPUTS_UNKNOWN : railInputs(scene);
+  if (ledFrameBeginLayer(frame, LED_LAYER_RAILS, inputs) == 1) {
+    drawRails(frame, scene);
+    ledFrameEndLayer(frame, inputs);
+  }
+  if (ledFrameBeginLayer(frame, LED_LAYER_LOGO, LED_INPUTS_UNKNOWN) == 1) {
+    drawLogo(frame, frameNumber);
+    ledFrameEndLayer(frame, LED_INPUTS_UNKNOWN);
+  }
+  if (ledFrameBeginLayer(frame, LED_LAYER_MEASUREMENTS, LED_INPUTS_UNKNOWN) ==
+      1) {
+    ledFrameEndLayer(frame, LED_INPUTS_UNKNOWN); // nothing measured
+  }
+  inputs = render ? LED_INPUTS_UNKNOWN : netInputs(scene, withBrightness);
+  if (ledFrameBeginLayer(frame, LED_LAYER_NETS, inputs) == 1) {
+    drawNets(frame, scene);
+    ledFrameEndLayer(frame, inputs);
+  }
+  if (ledFrameBeginLayer(frame, LED_LAYER_ANIMATIONS, LED_INPUTS_UNKNOWN) ==
+      1) {
+    drawAnimations(frame, scene, frameNumber);
+    ledFrameEndLayer(frame, LED_INPUTS_UNKNOWN);
+  }
+  if (scene->menu == 1) {
+    for (int i = 0; i < 8 * ROW_PIXELS; i++) {
+      ledFramePaint(frame, i, 0x200020);
+    }
+  }
+}
+
+/// @brief The scripted minute, one frame at a time
+static void sceneAt(int frameNumber, struct scene *scene) {
+  if (frameNumber == 0) {
+    memset(scene, 0, sizeof(struct scene));
+    scene->railVoltage[0] = 3.3f;
+    scene->railVoltage[1] = 0.0f;
+    scene->brightness = 128;
+    scene->nets[0] = {{3, 7, 0, 0}, 0x00ff30};
+    scene->nets[1] = {{12, 40, 41, 0}, 0xff4114};
+    scene->netCount = 2;
+    scene->clear = 1;
+    return;
+  }
+  scene->clear = 0;
+  switch (frameNumber) {
+  case 10:
+    scene->railVoltage[0] = 5.0f; // rail changes, nets stay as they were
+    break;
+  case 16:
+    scene->nets[2] = {{20, 21, 55, 0}, 0x4078ff};
+    scene->netCount = 3;
+    scene->clear = 1;
+    break;
+  case 22:
+    scene->brightness = 200; // everything brighter, nothing else changes
+    break;
+  case 26:
+    scene->clear = 1; // a clear with nothing changed, the layers repaint it
+    break;
+  case 30:
+    scene->menu = 1;
+    break;
+  case 35:
+    scene->menu = 0;
+    scene->clear = 1;
+    break;
+  case 40:
+    scene->probeHighlight = 41;
+    scene->warningRow = 55;
+    break;
+  case 44:
+    scene->probeHighlight = 0;
+    break;
+  case 48:
+    scene->netCount = 1; // two nets removed
+    scene->railVoltage[1] = -2.5f;
+    scene->clear = 1;
+    break;
+  case 52:
+    scene->warningRow = 0;
+    scene->clear = 1;
+    break;
+  }
+}
+
+static bool isGoldenFrame(int frameNumber) {
+  for (int golden : goldenFrames) {
+    if (golden == frameNumber) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void saveGolden(FILE *file, int frameNumber, const uint32_t *pixels) {
+  fprintf(file, "frame %d\n", frameNumber);
+  for (int i = 0; i < LED_FRAME_PIXELS; i++) {
+    if (pixels[i] != 0) {
+      fprintf(file, "%d %06x\n", i, (unsigned int)pixels[i]);
+    }
+  }
+}
+
+/// @brief Read the golden frames, pixels not listed are black. Returns how
+/// many frames were read.
+static int loadGolden(uint32_t golden[][LED_FRAME_PIXELS]) {
+  FILE *file = fopen(GOLDEN_FILE, "r");
+  if (file == nullptr) {
+    return 0;
+  }
+  char line[64];
+  int index = -1;
+  while (fgets(line, sizeof(line), file) != nullptr) {
+    int number;
+    unsigned int color;
+    if (line[0] == '#') {
+      continue;
+    }
+    if (sscanf(line, "frame %d", &number) == 1) {
+      index++;
+      if (index >= (int)(sizeof(goldenFrames) / sizeof(goldenFrames[0])) ||
+          goldenFrames[index] != number) {
+        break; // saved from a different script
+      }
+      memset(golden[index], 0, sizeof(golden[index]));
+    } else if (index >= 0 && sscanf(line, "%d %x", &number, &color) == 2 &&
+               number >= 0 && number < LED_FRAME_PIXELS) {
+      golden[index][number] = color;
+    }
+  }
+  fclose(file);
+  return index + 1;
+}
+
+static int firstDifference(const uint32_t *a, const uint32_t *b) {
+  for (int i = 0; i < LED_FRAME_PIXELS; i++) {
+    if (a[i] != b[i]) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// replaying matches rendering everything on every frame, what's shown only
+// counts the pixels that changed, and the frames match the golden ones
+static void testAgainstRendered(bool save) {
+  static struct ledFrame cached;
+  static struct ledFrame rendered;
+  static uint32_t golden[sizeof(goldenFrames) / sizeof(goldenFrames[0])]
+                        [LED_FRAME_PIXELS];
+  const int goldenCount = sizeof(goldenFrames) / sizeof(goldenFrames[0]);
+  int loaded = save ? 0 : loadGolden(golden);
+  CHECK(save || loaded == goldenCount);
+  FILE *out = save ? fopen(GOLDEN_FILE, "w") : nullptr;
+  if (out != nullptr) {
+    fprintf(out, "# test_led_frame --save: the non black pixels of each "
+                 "frame, \"pixel rrggbb\"\n");
+  }
+
+  ledFrameInit(&cached);
+  ledFrameInit(&rendered);
+  struct scene scene;
+  uint32_t previous[LED_FRAME_PIXELS] = {0};
+  int goldenIndex = 0;
+  int skipped = 0;
+  for (int frameNumber = 0; frameNumber < FRAMES; frameNumber++) {
+    sceneAt(frameNumber, &scene);
+    composeFrame(&cached, &scene, frameNumber, false, true);
+    composeFrame(&rendered, &scene, frameNumber, true, true);
+
+    int differs = firstDifference(cached.pixels, rendered.pixels);
+    CHECK_EQ(differs, -1);
+    if (differs >= 0) {
+      printf("  frame %d pixel %d: replayed %06x, rendered %06x\n",
+             frameNumber, differs, (unsigned int)cached.pixels[differs],
+             (unsigned int)rendered.pixels[differs]);
+    }
+
+    // the first show sends everything, after that only what changed
+    int changed = 0;
+    for (int i = 0; i < LED_FRAME_PIXELS; i++) {
+      changed += rendered.pixels[i] != previous[i];
+    }
+    int expected = frameNumber == 0 ? LED_FRAME_PIXELS : changed;
+    CHECK_EQ(ledFrameChanged(&cached, 0, LED_FRAME_PIXELS), expected);
+    skipped += expected == 0;
+    ledFrameMarkShown(&cached, 0, LED_FRAME_PIXELS);
+    cached.stale = 0;
+    memcpy(previous, rendered.pixels, sizeof(previous));
+
+    if (isGoldenFrame(frameNumber) == true) {
+      if (out != nullptr) {
+        saveGolden(out, frameNumber, cached.pixels);
+      } else if (goldenIndex < loaded) {
+        int off = firstDifference(cached.pixels, golden[goldenIndex]);
+        CHECK_EQ(off, -1);
+        if (off >= 0) {
+          printf("  frame %d pixel %d: %06x, golden %06x\n", frameNumber, off,
+                 (unsigned int)cached.pixels[off],
+                 (unsigned int)golden[goldenIndex][off]);
+        }
+      }
+      goldenIndex++;
+    }
+  }
+  if (out != nullptr) {
+    fclose(out);
+    printf("  saved %d frames to %s\n", goldenIndex, GOLDEN_FILE);
+  }
+
+  // the logo animates, so no show is skipped, but the nets only render when
+  // they change: 0, 16, 22, 40, 44 and 48
+  CHECK_EQ(skipped, 0);
+  CHECK_EQ(cached.layers[LED_LAYER_NETS].renders, 6);
+  CHECK_EQ(cached.layers[LED_LAYER_NETS].replays, FRAMES - 6);
+  CHECK_EQ(cached.layers[LED_LAYER_RAILS].renders, 4); // 0, 10, 22, 48
+  CHECK_EQ(cached.layers[LED_LAYER_LOGO].renders, FRAMES);
+  CHECK_EQ(rendered.layers[LED_LAYER_NETS].replays, 0);
+}
+
+// a layer whose inputs miss something it reads keeps showing what it drew
+// before that changed, the frames only agree again once something it does
+// hash changes
+static void testMissedInput(void) {
+  static struct ledFrame cached;
+  static struct ledFrame rendered;
+  ledFrameInit(&cached);
+  ledFrameInit(&rendered);
+  struct scene scene;
+  int staleFrames = 0;
+  for (int frameNumber = 0; frameNumber < FRAMES; frameNumber++) {
+    sceneAt(frameNumber, &scene);
+    composeFrame(&cached, &scene, frameNumber, false, false);
+    composeFrame(&rendered, &scene, frameNumber, true, false);
+    staleFrames += firstDifference(cached.pixels, rendered.pixels) >= 0;
+  }
+  // brightness changes at 22 and the nets next render at 40, but that leaves
+  // the highlighted row alone, so it stays as it was until 44
+  CHECK_EQ(staleFrames, 44 - 22);
+}
+
+// invalidating renders every layer on the next frame, a layer painting
+// nothing replays as nothing, and pixels off the end are ignored
+static void testInvalidate(void) {
+  static struct ledFrame frame;
+  ledFrameInit(&frame);
+  struct scene scene;
+  sceneAt(0, &scene);
+  composeFrame(&frame, &scene, 0, false, true);
+  composeFrame(&frame, &scene, 1, false, true);
+  CHECK_EQ(frame.layers[LED_LAYER_NETS].renders, 1);
+  CHECK_EQ(frame.layers[LED_LAYER_NETS].replays, 1);
+  ledFrameInvalidate(&frame);
+  composeFrame(&frame, &scene, 2, false, true);
+  CHECK_EQ(frame.layers[LED_LAYER_NETS].renders, 2);
+  CHECK_EQ(frame.layers[LED_LAYER_RAILS].renders, 2);
+
+  CHECK_EQ(ledFrameBeginLayer(&frame, LED_LAYER_NETS, 1234), 1);
+  ledFrameEndLayer(&frame, 1234);
+  uint32_t before[LED_FRAME_PIXELS];
+  memcpy(before, frame.pixels, sizeof(before));
+  CHECK_EQ(ledFrameBeginLayer(&frame, LED_LAYER_NETS, 1234), 0);
+  CHECK_EQ(firstDifference(frame.pixels, before), -1);
+
+  ledFramePaint(&frame, -1, 0xffffff);
+  ledFramePaint(&frame, LED_FRAME_PIXELS, 0xffffff);
+  CHECK_EQ(firstDifference(frame.pixels, before), -1);
+  CHECK_EQ(ledFrameBeginLayer(&frame, LED_LAYERS, 1234), 1);
+  CHECK_EQ(ledInputsDone(LED_INPUTS_UNKNOWN), 1);
+}
+
+int main(int argc, char **argv) {
+  bool save = argc > 1 && strcmp(argv[1], "--save") == 0;
+  testAgainstRendered(save);
+  testMissedInput();
+  testInvalidate();
+  return checkResult("test_led_frame");
+}
@@ -0,0 +1,257 @@
+// SPDX-License-Identifier: MIT
+// A recorded capture pushed through the SUMP side of the logic analyzer: a
+// sigrok session's command bytes go through the parser, the trigger is found
+// in a ring that has wrapped, and the readout is decoded back into the UART
+// bytes that were on GPIO 1 when it was recorded.
+#include "LogicAnalyzer.h"
+#include "check.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define BIT_SAMPLES 10 // 100kbaud at the default 1MHz
+
+// aligned like laRing, laFindTrigger reads it a word at a time
+static uint8_t ring[LA_RING_SAMPLES] __attribute__((aligned(4)));
+
+static const char message[] = "Jumperless";
+
+/// @brief The recording: idle high UART on channel 0, a free running clock on
+/// channel 1 and a slow count on 4-7. Returns the sample the first start bit
+/// begins on.
+static int64_t record(int64_t first, int64_t count, int64_t messageAt) {
+  int messageLength = strlen(message);
+  int64_t messageEnd = messageAt + messageLength * 10 * BIT_SAMPLES;
+  for (int64_t i = first; i < first + count; i++) {
+    uint8_t line = 1;
+    if (i >= messageAt && i < messageEnd) {
+      int64_t bit = (i - messageAt) / BIT_SAMPLES;
+      int frameBit = bit % 10;
+      uint8_t c = message[bit / 10];
+      line = frameBit == 0 ? 0 : (frameBit == 9 ? 1 : (c >> (frameBit - 1)) & 1);
+    }
+    uint8_t clock = (i >> 2) & 1;
+    uint8_t slow = (i >> 12) & 0x0f;
+    ring[i & (LA_RING_SAMPLES - 1)] = line | clock << 1 | slow << 4;
+  }
+  return messageAt;
+}
+
+static void feedCommand(struct sumpParser *parser, struct laSettings *settings,
+                        const uint8_t *bytes, int length, int *lastAction) {
+  for (int i = 0; i < length; i++) {
+    if (sumpFeed(parser, bytes[i]) == 1) {
+      int action = sumpApply(settings, parser);
+      if (action >= 0) {
+        *lastAction = action;
+      }
+    }
+  }
+}
+
+// what sigrok's ols driver sends to set up a 1MHz, 8192 sample capture with
+// the trigger at the middle, waiting for GPIO 1 to go low
+static void testSumpSession(void) {
+  const uint8_t session[] = {
+      0x00, 0x00, 0x00, 0x00, 0x00,       // reset, five times
+      0x02,                               // ID
+      0xC0, 0x01, 0x00, 0x00, 0x00,       // trigger mask stage 0: channel 0
+      0xC1, 0x00, 0x00, 0x00, 0x00,       // value: low
+      0xC2, 0x00, 0x00, 0x00, 0x08,       // config: start
+      0x80, 99, 0x00, 0x00, 0x00,         // divider 99, 1MHz
+      0x81, 0xff, 0x07, 0xff, 0x03,       // read 8192, delay 4096
+      0x82, 0x38, 0x00, 0x00, 0x00,       // groups 1-3 off
+      0x11,                               // XON, ignored
+  };
+  struct sumpParser parser;
+  struct laSettings settings;
+  sumpParserReset(&parser);
+  laDefaultSettings(&settings);
+  int action = -1;
+
+  feedCommand(&parser, &settings, session, 6, &action);
+  CHECK_EQ(action, SUMP_ID);
+  feedCommand(&parser, &settings, session + 6, sizeof(session) - 6, &action);
+  CHECK_EQ(action, SUMP_ID); // nothing else in it needs an answer
+  CHECK_EQ(settings.triggerMask[0], 0x01);
+  CHECK_EQ(settings.triggerValue[0], 0x00);
+  CHECK_EQ(settings.triggerConfig[0], 0x08000000u);
+  CHECK_EQ(settings.divider, 99);
+  CHECK_EQ(laSampleRate(&settings), 1000000);
+  CHECK_EQ(settings.readCount, 8192);
+  CHECK_EQ(settings.delayCount, 4096);
+  CHECK_EQ((settings.flags >> SUMP_FLAG_GROUPS_SHIFT) & 0x0f, 0x0e);
+
+  // the 32 bit counts for bigger buffers
+  const uint8_t big[] = {0x84, 0xff, 0x1b, 0x00, 0x00,
+                         0x83, 0xff, 0x0f, 0x00, 0x00, 0x01};
+  feedCommand(&parser, &settings, big, sizeof(big), &action);
+  CHECK_EQ(settings.readCount, 28672);
+  CHECK_EQ(settings.delayCount, 16384);
+  CHECK_EQ(action, SUMP_RUN);
+
+  uint8_t metadata[64];
+  int n = sumpMetadata(metadata, sizeof(metadata), "Jumperless", LA_MAX_SAMPLES,
+                       50000000);
+  CHECK_EQ(n, 1 + 11 + 4 * 5 + 1);
+  CHECK_EQ(metadata[0], 0x01);
+  CHECK(strcmp((const char *)metadata + 1, "Jumperless") == 0);
+  CHECK_EQ(metadata[12], 0x20);
+  CHECK_EQ(metadata[16], LA_CHANNELS);
+  CHECK_EQ(metadata[17], 0x21);
+  CHECK_EQ((metadata[19] << 16) | (metadata[20] << 8) | metadata[21],
+           LA_MAX_SAMPLES);
+  CHECK_EQ(metadata[n - 1], 0x00);
+  CHECK_EQ(sumpMetadata(metadata, 20, "Jumperless", 1, 1), 0);
+}
+
+// the word at a time search finds the same sample as looking at every byte,
+// from any alignment and across the end of the ring
+static void testFindTrigger(void) {
+  int64_t base = 5LL * LA_RING_SAMPLES - 3000; // wraps 3000 samples in
+  record(base, LA_MAX_SAMPLES, base + 2500);
+  srand(0x4a4c);
+  for (int trial = 0; trial < 2000; trial++) {
+    int64_t from = base + rand() % (LA_MAX_SAMPLES / 2);
+    int64_t to = from + rand() % (LA_MAX_SAMPLES / 2);
+    uint8_t mask = rand() & 0xff;
+    uint8_t value = rand() & mask;
+    if (trial % 4 == 0) {
+      mask = 0x01;
+      value = 0x00;
+    }
+    int64_t expected = -1;
+    for (int64_t i = from; i < to; i++) {
+      if ((ring[i & (LA_RING_SAMPLES - 1)] & mask) == value) {
+        expected = i;
+        break;
+      }
+    }
+    int64_t found = laFindTrigger(ring, LA_RING_SAMPLES, from, to, mask, value);
+    CHECK_EQ(found, expected);
+    if (found != expected) {
+      break;
+    }
+  }
+  // GPIO 1 going low is the start bit
+  CHECK_EQ(laFindTrigger(ring, LA_RING_SAMPLES, base, base + LA_MAX_SAMPLES,
+                         0x01, 0x00),
+           base + 2500);
+  // channels 2 and 3 never go high in the recording
+  CHECK_EQ(laFindTrigger(ring, LA_RING_SAMPLES, base, base + LA_MAX_SAMPLES,
+                         0x0c, 0x0c),
+           -1);
+  CHECK_EQ(laFindTrigger(ring, LA_RING_SAMPLES, base, base + 9, 0x01, 0x00), -1);
+}
+
+/// @brief Read the whole capture out through laReadoutFill() in max byte
+/// pieces, back into oldest first order
+static int readBack(struct laReadout *readout, int groupBytes, int max,
+                    uint8_t *samples, int capacity) {
+  static uint8_t wire[LA_RING_SAMPLES * 4];
+  int length = 0;
+  for (int pieces = 0; pieces < 1000000; pieces++) {
+    int n = laReadoutFill(readout, wire + length, max);
+    if (n == 0) {
+      break;
+    }
+    CHECK_EQ(n % groupBytes, 0);
+    length += n;
+  }
+  int count = length / groupBytes;
+  for (int i = 0; i < count && i < capacity; i++) {
+    samples[count - 1 - i] = wire[i * groupBytes]; // newest came first
+  }
+  return count;
+}
+
+/// @brief Decode 8N1 on channel 0 the way a protocol decoder would
+static int decodeUart(const uint8_t *samples, int count, char *out, int max) {
+  int n = 0;
+  int i = 1;
+  while (i < count && n < max - 1) {
+    if ((samples[i - 1] & 1) == 1 && (samples[i] & 1) == 0) {
+      int middle = i + BIT_SAMPLES / 2;
+      if (middle + 9 * BIT_SAMPLES >= count) {
+        break;
+      }
+      uint8_t c = 0;
+      for (int bit = 0; bit < 8; bit++) {
+        c |= (samples[middle + (bit + 1) * BIT_SAMPLES] & 1) << bit;
+      }
+      out[n++] = c;
+      i = middle + 9 * BIT_SAMPLES;
+    }
+    i++;
+  }
+  out[n] = '\0';
+  return n;
+}
+
+// the capture goes back newest first, a byte per enabled group, and decodes
+// back into the message with the trigger landing where SUMP's delay says
+static void testReadout(void) {
+  const uint32_t readCount = 8192;
+  const uint32_t delayCount = 6144;
+  int64_t base = 3LL * LA_RING_SAMPLES + 25000; // the window wraps
+  int64_t trigger = record(base, LA_MAX_SAMPLES, base + 4000);
+  int64_t start = trigger + delayCount - readCount;
+
+  static uint8_t samples[8192];
+  struct laReadout readout;
+  const int maxes[] = {1, 7, 64, 4096};
+  for (int max : maxes) {
+    laReadoutBegin(&readout, ring, LA_RING_SAMPLES, start, readCount, 0x01);
+    CHECK_EQ(readBack(&readout, 1, max, samples, readCount), readCount);
+    for (uint32_t i = 0; i < readCount; i++) {
+      if (samples[i] != ring[(start + i) & (LA_RING_SAMPLES - 1)]) {
+        CHECK_EQ(samples[i], ring[(start + i) & (LA_RING_SAMPLES - 1)]);
+        break;
+      }
+    }
+  }
+  char decoded[32];
+  CHECK_EQ(decodeUart(samples, readCount, decoded, sizeof(decoded)),
+           (int)strlen(message));
+  CHECK(strcmp(decoded, message) == 0);
+  CHECK_EQ(samples[trigger - start - 1] & 1, 1);
+  CHECK_EQ(samples[trigger - start] & 1, 0);
+
+  // two groups on: channel 0-7 then a zero byte for the group with no pins
+  static uint8_t wire[64];
+  laReadoutBegin(&readout, ring, LA_RING_SAMPLES, start, readCount, 0x05);
+  CHECK_EQ(laReadoutFill(&readout, wire, 7), 6);
+  CHECK_EQ(wire[0], ring[(start + readCount - 1) & (LA_RING_SAMPLES - 1)]);
+  CHECK_EQ(wire[1], 0);
+  CHECK_EQ(wire[2], ring[(start + readCount - 2) & (LA_RING_SAMPLES - 1)]);
+
+  // every group off sends nothing and finishes
+  laReadoutBegin(&readout, ring, LA_RING_SAMPLES, start, readCount, 0x00);
+  CHECK_EQ(laReadoutFill(&readout, wire, 64), 0);
+  CHECK_EQ(readout.sent, readCount);
+}
+
+// triggered before enough had been recorded: the samples from before the
+// start repeat the first real one
+static void testEarlyTrigger(void) {
+  memset(ring, 0, sizeof(ring));
+  record(0, 2000, 100);
+  struct laReadout readout;
+  static uint8_t samples[1024];
+  laReadoutBegin(&readout, ring, LA_RING_SAMPLES, -500, 1024, 0x01);
+  CHECK_EQ(readBack(&readout, 1, 256, samples, 1024), 1024);
+  for (int i = 0; i < 500; i++) {
+    CHECK_EQ(samples[i], ring[0]);
+  }
+  for (int i = 500; i < 1024; i++) {
+    CHECK_EQ(samples[i], ring[i - 500]);
+  }
+}
+
+int main(void) {
+  testSumpSession();
+  testFindTrigger();
+  testReadout();
+  testEarlyTrigger();
+  return checkResult("test_logic_analyzer");
+}
@@ -0,0 +1,221 @@
+// SPDX-License-Identifier: MIT
+// makeBeforeBreak() ordering: after every word, no two nodes are connected
+// unless they were before or will be after, and nodes connected before and
+// after never come apart (unless a swap forced it, which is counted).
+#include "MakeBeforeBreak.h"
+#include "check.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NODE_COUNT (MBB_CHIPS * 8)
+
+static struct mbbGraph graph;
+static uint8_t before[MBB_CHIPS][16][8];
+static uint8_t after[MBB_CHIPS][16][8];
+static uint8_t live[MBB_CHIPS][16][8]; // what the "chips" have right now
+static int beforeRoot[NODE_COUNT];
+static int afterRoot[NODE_COUNT];
+static int words;
+static int shorts;
+static int opens;
+
+static int nodeWire(int node) { return MBB_NODE_WIRE_BASE + node; }
+
+// Chips pair up (0-1, 2-3, ...) on x 0-7, and x 8-11 of each chip lands on
+// x 12-15 of the chip two up, so routes can take a couple of hops. Every y
+// line is its own node.
+static void makeWires(void) {
+  for (int chip = 0; chip < MBB_CHIPS; chip++) {
+    for (int x = 0; x < 8; x++) {
+      graph.xWire[chip][x] = (chip & ~1) * 24 + x;
+    }
+    for (int x = 8; x < 12; x++) {
+      graph.xWire[chip][x] = chip * 24 + x;
+    }
+    for (int y = 0; y < 8; y++) {
+      graph.yWire[chip][y] = nodeWire(chip * 8 + y);
+    }
+  }
+  for (int chip = 0; chip < MBB_CHIPS; chip++) {
+    for (int x = 12; x < 16; x++) {
+      graph.xWire[chip][x] = graph.xWire[(chip + MBB_CHIPS - 2) % MBB_CHIPS][x - 4];
+    }
+  }
+}
+
+static int parent[MBB_WIRES];
+
+static int findRoot(int wire) {
+  while (parent[wire] != wire) {
+    parent[wire] = parent[parent[wire]];
+    wire = parent[wire];
+  }
+  return wire;
+}
+
+static void nodeRoots(uint8_t state[MBB_CHIPS][16][8], int *roots) {
+  for (int wire = 0; wire < MBB_WIRES; wire++) {
+    parent[wire] = wire;
+  }
+  for (int chip = 0; chip < MBB_CHIPS; chip++) {
+    for (int x = 0; x < 16; x++) {
+      for (int y = 0; y < 8; y++) {
+        if (state[chip][x][y] != 0) {
+          parent[findRoot(graph.xWire[chip][x])] = findRoot(graph.yWire[chip][y]);
+        }
+      }
+    }
+  }
+  for (int node = 0; node < NODE_COUNT; node++) {
+    roots[node] = findRoot(nodeWire(node));
+  }
+}
+
+static void checkLive(void) {
+  int liveRoot[NODE_COUNT];
+  nodeRoots(live, liveRoot);
+  for (int a = 0; a < NODE_COUNT; a++) {
+    for (int b = a + 1; b < NODE_COUNT; b++) {
+      bool wasJoined = beforeRoot[a] == beforeRoot[b];
+      bool willBeJoined = afterRoot[a] == afterRoot[b];
+      bool joined = liveRoot[a] == liveRoot[b];
+      if (joined && !wasJoined && !willBeJoined) {
+        shorts++;
+      }
+      if (!joined && wasJoined && willBeJoined) {
+        opens++;
+      }
+    }
+  }
+}
+
+static void sendWord(int chip, int x, int y, int setOrClear) {
+  CHECK(live[chip][x][y] != setOrClear); // only words that change something
+  live[chip][x][y] = setOrClear;
+  words++;
+  checkLive();
+}
+
+static struct mbbCounts runUpdate(void) {
+  struct mbbCounts counts = {0, 0, 0, 0};
+  memcpy(graph.now, before, sizeof(before));
+  memcpy(graph.want, after, sizeof(after));
+  memcpy(live, before, sizeof(before));
+  nodeRoots(before, beforeRoot);
+  nodeRoots(after, afterRoot);
+  words = 0;
+  shorts = 0;
+  opens = 0;
+
+  makeBeforeBreak(&graph, sendWord, &counts);
+
+  CHECK(memcmp(live, after, sizeof(after)) == 0);
+  CHECK(memcmp(graph.now, after, sizeof(after)) == 0);
+  int changed = 0;
+  for (int chip = 0; chip < MBB_CHIPS; chip++) {
+    for (int x = 0; x < 16; x++) {
+      for (int y = 0; y < 8; y++) {
+        changed += before[chip][x][y] != after[chip][x][y];
+      }
+    }
+  }
+  CHECK_EQ(words, changed);
+  return counts;
+}
+
+// Net X moves from lane 0 to lane 1, which net Y is leaving for lane 2.
+// X's new lane has to wait for Y to get off it, and X's old lane has to
+// stay closed until then.
+static void testLaneMovesBehindAnotherNet(void) {
+  memset(before, 0, sizeof(before));
+  memset(after, 0, sizeof(after));
+  before[0][0][0] = before[1][0][0] = 1; // X on lane 0
+  before[0][1][1] = before[1][1][1] = 1; // Y on lane 1
+  after[0][1][0] = after[1][1][0] = 1;   // X on lane 1
+  after[0][2][1] = after[1][2][1] = 1;   // Y on lane 2
+
+  struct mbbCounts counts = runUpdate();
+  CHECK_EQ(shorts, 0);
+  CHECK_EQ(opens, 0);
+  CHECK_EQ(counts.forced, 0);
+  CHECK_EQ(counts.early, 2);
+  CHECK_EQ(counts.deferred, 2);
+  CHECK(counts.held > 0);
+}
+
+// Two nets trading lanes can't be done without one of them opening, that
+// has to show up as forced and still never short
+static void testSwapIsForced(void) {
+  memset(before, 0, sizeof(before));
+  memset(after, 0, sizeof(after));
+  before[0][0][0] = before[1][0][0] = 1;
+  before[0][1][1] = before[1][1][1] = 1;
+  after[0][1][0] = after[1][1][0] = 1;
+  after[0][0][1] = after[1][0][1] = 1;
+
+  struct mbbCounts counts = runUpdate();
+  CHECK_EQ(shorts, 0);
+  CHECK(counts.forced > 0);
+}
+
+// Two nets merging and one splitting in the same update
+static void testMergeAndSplit(void) {
+  memset(before, 0, sizeof(before));
+  memset(after, 0, sizeof(after));
+  before[2][0][0] = before[3][0][0] = 1; // A: 16-24
+  before[2][1][1] = before[3][1][1] = 1; // B: 17-25
+  before[4][0][0] = before[5][0][0] = before[5][0][1] = 1; // C: 32-40-41
+  after[2][0][0] = after[3][0][0] = 1;
+  after[2][1][1] = after[3][1][1] = 1;
+  after[3][0][1] = 1; // A and B join on chip 3
+  after[4][0][0] = after[5][0][0] = 1; // 41 leaves C
+
+  struct mbbCounts counts = runUpdate();
+  CHECK_EQ(shorts, 0);
+  CHECK_EQ(opens, 0);
+  CHECK_EQ(counts.forced, 0);
+}
+
+static void randomState(uint8_t state[MBB_CHIPS][16][8], int closed) {
+  memset(state, 0, sizeof(before));
+  for (int i = 0; i < closed; i++) {
+    state[rand() % MBB_CHIPS][rand() % 16][rand() % 8] = 1;
+  }
+}
+
+static void testRandomUpdates(void) {
+  srand(1234);
+  int forcedRuns = 0;
+  for (int trial = 0; trial < 150; trial++) {
+    randomState(before, 30 + rand() % 30);
+    memcpy(after, before, sizeof(before));
+    // move some crosspoints around so the two states overlap like reroutes do
+    int moves = 1 + rand() % 12;
+    for (int i = 0; i < moves; i++) {
+      int chip = rand() % MBB_CHIPS;
+      int x = rand() % 16;
+      int y = rand() % 8;
+      after[chip][x][y] ^= 1;
+    }
+
+    struct mbbCounts counts = runUpdate();
+    CHECK_EQ(shorts, 0);
+    if (counts.forced == 0) {
+      CHECK_EQ(opens, 0);
+    } else {
+      forcedRuns++;
+    }
+  }
+  // most random updates have nothing to swap
+  CHECK(forcedRuns < 30);
+}
+
+int main(void) {
+  makeWires();
+  testLaneMovesBehindAnotherNet();
+  testSwapIsForced();
+  testMergeAndSplit();
+  testRandomUpdates();
+  return checkResult("make before break");
+}
@@ -0,0 +1,246 @@
+// SPDX-License-Identifier: MIT
+// Fitting probe row centroids from calibration readings and classifying with
+// the table built from them. The readings come off a model board whose sense
+// ladder bows away from the straight probe_min / probe_max line by ~7 rows in
+// the middle, tapped once a pad like calibrateProbeRows() does, with skipped
+// pads, mistaps and noise. Checks the fit lands on the board, that the table
+// is the nearest centroid with the right unsure band, and that it reads the
+// board right where the old map() line misreads it.
+#include "ProbeRows.h"
+#include "check.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PROBE_MIN 15 // config.h defaults
+#define PROBE_MAX 4060
+#define MIN_READING 48 // MINIMUM_PROBE_READING
+#define MARGIN 10
+#define BOW 0.35
+
+static uint16_t board[PROBE_PADS + 1]; // where each pad really reads
+static uint8_t lut[PROBE_LUT_SIZE];
+
+static void makeBoard(void) {
+  board[0] = 0;
+  for (int pad = 1; pad <= PROBE_PADS; pad++) {
+    double u = (PROBE_PADS - pad + 0.5) / PROBE_PADS;
+    double bowed = u * (1 + BOW) / (1 + BOW * u);
+    board[pad] = (uint16_t)lround(PROBE_MIN + (PROBE_MAX - PROBE_MIN) * bowed);
+  }
+}
+
+static int noise(int amount) { return rand() % (2 * amount + 1) - amount; }
+
+/// @brief The old classification, map(reading, probe_min, probe_max, 101, 0)
+static int mapPad(int reading) {
+  return (reading - PROBE_MIN) * (0 - PROBE_PADS) / (PROBE_MAX - PROBE_MIN) +
+         PROBE_PADS;
+}
+
+static int gapAt(const uint16_t *centroids, int pad) {
+  int other = pad < PROBE_PADS ? pad + 1 : pad - 1;
+  return abs(centroids[pad] - centroids[other]);
+}
+
+// the straight line puts every centroid where map() reads that pad
+static void testLinear(void) {
+  uint16_t linear[PROBE_PADS + 1];
+  probeLinearCentroids(linear, PROBE_MIN, PROBE_MAX);
+  for (int pad = 1; pad <= PROBE_PADS; pad++) {
+    CHECK_EQ(mapPad(linear[pad]), pad);
+    if (pad > 1) {
+      CHECK(linear[pad] < linear[pad - 1]);
+    }
+  }
+}
+
+// every pad tapped once: the fit is the readings
+static void testCleanFit(void) {
+  uint8_t pads[PROBE_PADS];
+  uint16_t readings[PROBE_PADS];
+  for (int pad = 1; pad <= PROBE_PADS; pad++) {
+    pads[pad - 1] = pad;
+    readings[pad - 1] = board[pad] + noise(2);
+  }
+  uint16_t centroids[PROBE_PADS + 1];
+  CHECK_EQ(probeFitCentroids(pads, readings, PROBE_PADS, PROBE_MIN, PROBE_MAX,
+                             centroids),
+           PROBE_PADS);
+  for (int pad = 1; pad <= PROBE_PADS; pad++) {
+    CHECK_EQ(centroids[pad], readings[pad - 1]);
+  }
+
+  // several readings of a pad go to their median, a stray one doesn't move it
+  uint8_t morePads[PROBE_PADS + 4];
+  uint16_t moreReadings[PROBE_PADS + 4];
+  memcpy(morePads, pads, sizeof(pads));
+  memcpy(moreReadings, readings, sizeof(readings));
+  const uint16_t extra[4] = {(uint16_t)(board[50] + 1), (uint16_t)(board[50] - 1),
+                             board[50], (uint16_t)(board[49] + 3)};
+  for (int i = 0; i < 4; i++) {
+    morePads[PROBE_PADS + i] = 50;
+    moreReadings[PROBE_PADS + i] = extra[i];
+  }
+  moreReadings[49] = board[50];
+  probeFitCentroids(morePads, moreReadings, PROBE_PADS + 4, PROBE_MIN,
+                    PROBE_MAX, centroids);
+  CHECK(abs(centroids[50] - board[50]) <= 1);
+}
+
+// a session the way people actually do it: pads skipped, the ends never
+// reached, one tap that slipped down the board and one that went back up a
+// few rows. Returns how many readings there were.
+static int messySession(uint8_t *pads, uint16_t *readings) {
+  int count = 0;
+  for (int pad = 4; pad <= 98; pad++) {
+    if (pad % 7 == 0) {
+      continue; // skipped
+    }
+    int reading = board[pad] + noise(2);
+    if (pad == 40) {
+      reading = board[45]; // slipped five rows down
+    } else if (pad == 61) {
+      reading = board[58]; // three rows back up
+    }
+    pads[count] = pad;
+    readings[count] = reading;
+    count++;
+  }
+  return count;
+}
+
+static void testMessyFit(void) {
+  uint8_t pads[PROBE_PADS];
+  uint16_t readings[PROBE_PADS];
+  int count = messySession(pads, readings);
+  uint16_t centroids[PROBE_PADS + 1];
+  int good = probeFitCentroids(pads, readings, count, PROBE_MIN, PROBE_MAX,
+                               centroids);
+  // the two mistaps are out of order with their neighbours and get dropped
+  CHECK_EQ(good, count - 2);
+
+  for (int pad = 1; pad <= PROBE_PADS; pad++) {
+    if (pad > 1) {
+      CHECK(centroids[pad] < centroids[pad - 1]);
+    }
+    // filled in pads (the ends too) land inside their own row
+    int error = abs(centroids[pad] - board[pad]);
+    CHECK(error * 2 < gapAt(board, pad));
+    if (error * 2 >= gapAt(board, pad)) {
+      printf("  pad %d fit at %d, the board reads %d\n", pad, centroids[pad],
+             board[pad]);
+    }
+  }
+  CHECK(abs(centroids[40] - board[40]) < abs(board[45] - board[40]) / 4);
+}
+
+// the table is the nearest centroid for every reading, unsure in the middle
+// margin of each gap, nothing below minReading or well past either end
+static void testLutMatchesNearest(void) {
+  uint16_t centroids[PROBE_PADS + 1];
+  uint8_t pads[PROBE_PADS];
+  uint16_t readings[PROBE_PADS];
+  int count = messySession(pads, readings);
+  probeFitCentroids(pads, readings, count, PROBE_MIN, PROBE_MAX, centroids);
+  probeBuildLut(lut, centroids, MIN_READING, MARGIN);
+
+  for (int reading = 0; reading < PROBE_LUT_SIZE; reading++) {
+    int sure;
+    int pad = probeLutPad(lut, reading, &sure);
+    if (reading < MIN_READING) {
+      CHECK_EQ(pad, 0);
+      continue;
+    }
+    int nearest = 1;
+    for (int p = 2; p <= PROBE_PADS; p++) {
+      if (abs(reading - centroids[p]) < abs(reading - centroids[nearest])) {
+        nearest = p;
+      }
+    }
+    int distance = abs(reading - centroids[nearest]);
+    if (reading > centroids[1] + gapAt(centroids, 1) ||
+        reading < centroids[PROBE_PADS] - gapAt(centroids, PROBE_PADS)) {
+      CHECK_EQ(pad, 0);
+      continue;
+    }
+    if (pad != nearest) {
+      // a tie between two centroids can go either way
+      CHECK_EQ(distance, abs(reading - centroids[pad]));
+      continue;
+    }
+    int other = reading >= centroids[pad] ? pad - 1 : pad + 1;
+    if (other >= 1 && other <= PROBE_PADS) {
+      int gap = abs(centroids[pad] - centroids[other]);
+      // unsure within MARGIN% of the gap around the halfway point
+      int fromHalfway = gap - 2 * distance; // in half counts
+      CHECK_EQ(sure, fromHalfway * 100 >= 2 * gap * MARGIN);
+    }
+  }
+  int sure;
+  CHECK_EQ(probeLutPad(lut, -1, &sure), 0);
+  CHECK_EQ(probeLutPad(lut, PROBE_LUT_SIZE, &sure), 0);
+}
+
+// taps anywhere on the pad (within a quarter of a row of its middle) on the
+// bowed board: the fitted table gets every one, the straight line doesn't
+static void testClassifyBoard(void) {
+  uint16_t centroids[PROBE_PADS + 1];
+  uint8_t pads[PROBE_PADS];
+  uint16_t readings[PROBE_PADS];
+  int count = messySession(pads, readings);
+  probeFitCentroids(pads, readings, count, PROBE_MIN, PROBE_MAX, centroids);
+  probeBuildLut(lut, centroids, MIN_READING, MARGIN);
+
+  int taps = 0;
+  int wrong = 0;
+  int unsure = 0;
+  int mapWrong = 0;
+  for (int pad = 1; pad <= PROBE_PADS; pad++) {
+    int quarter = gapAt(board, pad) / 4;
+    for (int tap = 0; tap < 20; tap++) {
+      int reading = board[pad] + noise(quarter);
+      if (reading < MIN_READING) {
+        continue; // the bottom pad on this board reads as nothing either way
+      }
+      int sure;
+      int got = probeLutPad(lut, reading, &sure);
+      taps++;
+      wrong += got != pad;
+      unsure += sure == 0;
+      mapWrong += mapPad(reading) != pad;
+    }
+  }
+  CHECK_EQ(wrong, 0);
+  CHECK_EQ(unsure, 0);
+  CHECK(mapWrong > taps / 2);
+  if (wrong > 0 || unsure > 0) {
+    printf("  %d taps: fitted table %d wrong and %d unsure, map() line %d "
+           "wrong\n",
+           taps, wrong, unsure, mapWrong);
+  }
+}
+
+// nothing measured at all falls back to the straight line
+static void testNoReadings(void) {
+  uint16_t centroids[PROBE_PADS + 1];
+  uint16_t linear[PROBE_PADS + 1];
+  probeLinearCentroids(linear, PROBE_MIN, PROBE_MAX);
+  CHECK_EQ(probeFitCentroids(nullptr, nullptr, 0, PROBE_MIN, PROBE_MAX,
+                             centroids),
+           0);
+  CHECK(memcmp(centroids + 1, linear + 1, PROBE_PADS * sizeof(uint16_t)) == 0);
+}
+
+int main(void) {
+  srand(0x4a4c);
+  makeBoard();
+  testLinear();
+  testCleanFit();
+  testMessyFit();
+  testLutMatchesNearest();
+  testClassifyBoard();
+  testNoReadings();
+  return checkResult("test_probe_rows");
+}
@@ -0,0 +1,240 @@
+// SPDX-License-Identifier: MIT
+// ADC traces of the probe replayed through the debouncer, a look at a time
+// the way the 1 ms timer feeds it. Each trace in corpus/probe lists the
+// events it should make ("= touch 103000 30"): taps with contact bounce, a
+// re-tap of the same row, a long hold with a dropout and some drift in it, a
+// slide across three rows, and a spike that shouldn't count. Every trace runs
+// with raw readings and again through the default lookup table
+// (ProbeRows.h), and both have to come out with the same events, on time.
+// Also checks the button edges and the event queue.
+#include "ProbeRows.h"
+#include "ProbeScanner.h"
+#include "check.h"
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define TRACE_DIR "corpus/probe"
+#define MINIMUM_PROBE_READING 48 // Probing.h
+#define PROBE_MIN 15             // config.h defaults
+#define PROBE_MAX 4060
+#define PROBE_MARGIN 10
+#define EVENT_SLACK_US 8000 // bounce plus settleLooks / releaseLooks of looks
+
+struct look {
+  uint32_t micros;
+  uint16_t blocks[PROBE_LOOK_BLOCKS];
+};
+
+struct expectedEvent {
+  int type;
+  uint32_t micros;
+  int pad;
+};
+
+struct trace {
+  std::vector<struct look> looks;
+  std::vector<struct expectedEvent> expected;
+};
+
+static uint16_t centroids[PROBE_PADS + 1];
+static uint8_t lut[PROBE_LUT_SIZE];
+
+static int eventType(const char *name) {
+  if (strcmp(name, "touch") == 0) return PROBE_EVENT_TOUCH;
+  if (strcmp(name, "hold") == 0) return PROBE_EVENT_HOLD;
+  if (strcmp(name, "release") == 0) return PROBE_EVENT_RELEASE;
+  return PROBE_EVENT_NONE;
+}
+
+static int loadTrace(const std::string &path, struct trace *trace) {
+  FILE *file = fopen(path.c_str(), "r");
+  if (file == nullptr) {
+    return 0;
+  }
+  char line[128];
+  while (fgets(line, sizeof(line), file) != nullptr) {
+    if (line[0] == '#' || line[0] == '\n') {
+      continue;
+    }
+    if (line[0] == '=') {
+      char name[16];
+      struct expectedEvent event;
+      if (sscanf(line, "= %15s %u %d", name, &event.micros, &event.pad) == 3) {
+        event.type = eventType(name);
+        trace->expected.push_back(event);
+      }
+      continue;
+    }
+    struct look look;
+    unsigned int b[PROBE_LOOK_BLOCKS];
+    if (sscanf(line, "%u %u %u %u %u", &look.micros, &b[0], &b[1], &b[2],
+               &b[3]) == 5) {
+      for (int i = 0; i < PROBE_LOOK_BLOCKS; i++) {
+        look.blocks[i] = b[i];
+      }
+      trace->looks.push_back(look);
+    }
+  }
+  fclose(file);
+  return trace->looks.empty() ? 0 : 1;
+}
+
+static std::vector<std::string> traceFiles(void) {
+  std::vector<std::string> names;
+  DIR *dir = opendir(TRACE_DIR);
+  if (dir == nullptr) {
+    return names;
+  }
+  for (struct dirent *entry = readdir(dir); entry != nullptr;
+       entry = readdir(dir)) {
+    std::string name = entry->d_name;
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".txt") == 0) {
+      names.push_back(std::string(TRACE_DIR) + "/" + name);
+    }
+  }
+  closedir(dir);
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+/// @brief Replay a trace, with the lookup table or on raw readings, and
+/// match what comes out against what the trace says should
+static void replay(const std::string &name, const struct trace *trace,
+                   const uint8_t *table) {
+  struct probeDebounce debounce;
+  probeDebounceReset(&debounce, MINIMUM_PROBE_READING);
+  debounce.lut = table;
+
+  std::vector<struct probeEvent> events;
+  for (const struct look &look : trace->looks) {
+    struct probeEvent event;
+    if (probeDebounceFeed(&debounce, look.blocks, PROBE_LOOK_BLOCKS,
+                          look.micros, &event) == 1) {
+      events.push_back(event);
+    }
+  }
+
+  const char *mode = table != nullptr ? "table" : "raw";
+  CHECK_EQ(events.size(), trace->expected.size());
+  size_t count = std::min(events.size(), trace->expected.size());
+  for (size_t i = 0; i < count; i++) {
+    const struct probeEvent &got = events[i];
+    const struct expectedEvent &want = trace->expected[i];
+    int sure;
+    int pad = probeLutPad(lut, got.raw, &sure);
+    int late = (int)(got.micros - want.micros);
+    int ok = got.type == want.type && pad == want.pad && sure == 1 &&
+             late >= 0 && late <= EVENT_SLACK_US;
+    if (got.type == PROBE_EVENT_TOUCH) {
+      // tap to event: the run that settled started at most a look before.
+      // The table calls a slide as soon as it's surely on the next pad, raw
+      // readings wait until it stops there.
+      ok = ok && got.micros - got.firstMicros <= PROBE_LOOK_US;
+      ok = ok && (table != nullptr || abs(got.raw - centroids[want.pad]) <= 3);
+    }
+    CHECK(ok);
+    if (!ok) {
+      printf("  %s (%s) event %d: got type %d pad %d at %u, wanted type %d "
+             "pad %d at %u\n",
+             name.c_str(), mode, (int)i, got.type, pad, got.micros, want.type,
+             want.pad, want.micros);
+    }
+  }
+}
+
+static void testTraces(void) {
+  std::vector<std::string> files = traceFiles();
+  CHECK(!files.empty());
+  for (const std::string &file : files) {
+    struct trace trace;
+    CHECK(loadTrace(file, &trace) == 1);
+    CHECK(!trace.expected.empty());
+    replay(file, &trace, nullptr);
+    replay(file, &trace, lut);
+  }
+}
+
+// a look that doesn't hold still, or lands on the line between two pads,
+// doesn't count toward settling
+static void testLook(void) {
+  const uint16_t steady[4] = {2000, 2002, 2001, 2003};
+  const uint16_t sliding[4] = {2000, 2005, 2010, 2015};
+  int spread;
+  CHECK_EQ(probeLookMeasure(steady, 4, &spread), 2001);
+  CHECK_EQ(spread, 2);
+  CHECK_EQ(probeLookMeasure(sliding, 4, &spread), 2007);
+  CHECK_EQ(spread, 5);
+
+  int sure;
+  int pad = probeLutPad(lut, centroids[50], &sure);
+  CHECK_EQ(pad, 50);
+  uint16_t onPad[4] = {centroids[50], centroids[50], (uint16_t)(centroids[50] + 2),
+                       centroids[50]};
+  CHECK_EQ(probeLookPad(lut, onPad, 4), 50);
+  uint16_t halfway = (centroids[50] + centroids[51]) / 2;
+  uint16_t onLine[4] = {halfway, halfway, halfway, halfway};
+  CHECK_EQ(probeLookPad(lut, onLine, 4), 0);
+  uint16_t across[4] = {centroids[50], centroids[50], centroids[51],
+                        centroids[51]};
+  CHECK_EQ(probeLookPad(lut, across, 4), 0);
+}
+
+static void testButtons(void) {
+  struct probeDebounce debounce;
+  probeDebounceReset(&debounce, MINIMUM_PROBE_READING);
+  struct probeEvent event;
+  CHECK_EQ(probeButtonFeed(&debounce, 0, 1000, &event), 0);
+  CHECK_EQ(probeButtonFeed(&debounce, 2, 2000, &event), 1);
+  CHECK_EQ(event.type, PROBE_EVENT_CONNECT_BUTTON);
+  CHECK_EQ(probeButtonFeed(&debounce, 2, 3000, &event), 0); // held
+  CHECK_EQ(probeButtonFeed(&debounce, 1, 4000, &event), 1);
+  CHECK_EQ(event.type, PROBE_EVENT_REMOVE_BUTTON);
+  CHECK_EQ(probeButtonFeed(&debounce, 0, 5000, &event), 1);
+  CHECK_EQ(event.type, PROBE_EVENT_BUTTON_UP);
+  CHECK_EQ(event.raw, 1);
+}
+
+static void testQueue(void) {
+  static struct probeEventQueue queue = {};
+  struct probeEvent event = {};
+  // start near the wrap of the counts
+  queue.head = queue.tail = 0xfffffff8u;
+  for (int i = 0; i < PROBE_QUEUE_LENGTH; i++) {
+    event.raw = i;
+    CHECK_EQ(probeQueuePush(&queue, &event), 1);
+  }
+  CHECK_EQ(probeQueuePush(&queue, &event), 0); // full, dropped
+  for (int i = 0; i < PROBE_QUEUE_LENGTH / 2; i++) {
+    CHECK_EQ(probeQueuePop(&queue, &event), 1);
+    CHECK_EQ(event.raw, i);
+  }
+  event.raw = 100;
+  CHECK_EQ(probeQueuePush(&queue, &event), 1);
+  for (int i = PROBE_QUEUE_LENGTH / 2; i < PROBE_QUEUE_LENGTH; i++) {
+    CHECK_EQ(probeQueuePop(&queue, &event), 1);
+    CHECK_EQ(event.raw, i);
+  }
+  CHECK_EQ(probeQueuePop(&queue, &event), 1);
+  CHECK_EQ(event.raw, 100);
+  CHECK_EQ(probeQueuePop(&queue, &event), 0);
+
+  CHECK_EQ(probeQueuePush(&queue, &event), 1);
+  probeQueueClear(&queue);
+  CHECK_EQ(probeQueuePop(&queue, &event), 0);
+}
+
+int main(void) {
+  probeLinearCentroids(centroids, PROBE_MIN, PROBE_MAX);
+  probeBuildLut(lut, centroids, MINIMUM_PROBE_READING, PROBE_MARGIN);
+  testTraces();
+  testLook();
+  testButtons();
+  testQueue();
+  return checkResult("test_probe_scanner");
+}
@@ -0,0 +1,217 @@
+// SPDX-License-Identifier: MIT
+// The DDS core rendered into a buffer the way the waveform timer would play
+// it: frequency and phase of the sine against the ideal, the other shapes at
+// their landmarks, retuning mid-cycle without a phase jump, and params only
+// being picked up once the writer has finished posting them.
+#include "Waveforms.h"
+#include "check.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RATE WAVE_RATE_ONE
+#define CENTER 2048
+#define HALF 1800
+
+static uint16_t out[RATE * 2];
+
+static void start(struct waveChannel *channel, int shape, float frequency) {
+  struct waveParams params = {};
+  params.shape = shape;
+  params.phaseStep = wavePhaseStep(frequency, RATE);
+  params.halfAmplitude = HALF;
+  params.center = CENTER;
+  waveReset(channel);
+  wavePost(channel, &params);
+}
+
+/// @brief Interpolated rising crossings of the center, how many there were
+/// and the frequency they add up to
+static double risingFrequency(const uint16_t *samples, int count,
+                              int *crossings) {
+  double first = -1;
+  double last = -1;
+  *crossings = 0;
+  for (int i = 1; i < count; i++) {
+    if (samples[i - 1] < CENTER && samples[i] >= CENTER) {
+      double at =
+          i - 1 + (double)(CENTER - samples[i - 1]) / (samples[i] - samples[i - 1]);
+      first = first < 0 ? at : first;
+      last = at;
+      (*crossings)++;
+    }
+  }
+  return *crossings < 2 ? 0 : (*crossings - 1) * (double)RATE / (last - first);
+}
+
+static void testPhaseStep(void) {
+  CHECK_EQ(wavePhaseStep(0, RATE), 0);
+  CHECK_EQ(wavePhaseStep(100, 0), 0);
+  CHECK_EQ(wavePhaseStep(RATE / 4, RATE), 0x40000000u);
+  CHECK_EQ(wavePhaseStep(1000, RATE), 214748365u); // 2^32 / 20
+  CHECK_EQ(wavePhaseStep(RATE, RATE), 0x7fffffffu); // held at Nyquist
+}
+
+// every sample within a couple of codes of the ideal sine, starting at the
+// center heading up, and a second of it has exactly f cycles
+static void testSine(void) {
+  const float frequencies[] = {1.0f, 50.0f, 440.0f, 1000.0f, 3333.0f, 5000.0f};
+  for (float frequency : frequencies) {
+    struct waveChannel channel;
+    start(&channel, WAVE_SINE, frequency);
+    waveRender(&channel, out, RATE);
+
+    uint32_t step = wavePhaseStep(frequency, RATE);
+    double worst = 0;
+    for (int i = 0; i < RATE; i++) {
+      double phase = (double)(uint32_t)(step * (uint32_t)i) / 4294967296.0;
+      double ideal = CENTER + HALF * sin(2 * M_PI * phase);
+      worst = fmax(worst, fabs(out[i] - ideal));
+    }
+    CHECK(worst <= 2.0);
+    CHECK_EQ(out[0], CENTER);
+
+    int crossings;
+    double measured = risingFrequency(out, RATE, &crossings);
+    if (frequency >= 50.0f) {
+      CHECK(fabs(measured - frequency) < frequency * 1e-4);
+      CHECK(abs(crossings - (int)frequency) <= 1);
+    }
+    if (worst > 2.0 || (frequency >= 50.0f &&
+                        fabs(measured - frequency) >= frequency * 1e-4)) {
+      printf("  %.0fHz: off by up to %.2f codes, measured %.3fHz\n",
+             frequency, worst, measured);
+    }
+  }
+}
+
+// each shape at the quarter points of a 4 sample cycle (starting at 0 and
+// heading up, so switching shapes doesn't jump)
+static void testShapes(void) {
+  struct waveChannel channel;
+  uint16_t quarter[8];
+
+  start(&channel, WAVE_SQUARE, RATE / 4);
+  waveRender(&channel, quarter, 8);
+  CHECK_EQ(quarter[0], CENTER + HALF);
+  CHECK_EQ(quarter[1], CENTER + HALF);
+  CHECK_EQ(quarter[2], CENTER - HALF);
+  CHECK_EQ(quarter[3], CENTER - HALF);
+  CHECK_EQ(quarter[4], CENTER + HALF);
+
+  start(&channel, WAVE_TRIANGLE, RATE / 4);
+  waveRender(&channel, quarter, 8);
+  CHECK(abs(quarter[0] - CENTER) <= 1);
+  CHECK(abs(quarter[1] - (CENTER + HALF)) <= 1);
+  CHECK(abs(quarter[2] - CENTER) <= 1);
+  CHECK(abs(quarter[3] - (CENTER - HALF)) <= 1);
+
+  start(&channel, WAVE_SAW, RATE / 4);
+  waveRender(&channel, quarter, 8);
+  CHECK(abs(quarter[0] - CENTER) <= 1);
+  CHECK(abs(quarter[1] - (CENTER + HALF / 2)) <= 1);
+  CHECK(abs(quarter[2] - (CENTER - HALF)) <= 1); // wrapped to the bottom
+  CHECK(abs(quarter[3] - (CENTER - HALF / 2)) <= 1);
+
+  // an arbitrary table plays one entry per 1/length of the cycle
+  static const int16_t table[4] = {0, 32767, -32767, 16384};
+  struct waveParams params = {};
+  params.shape = WAVE_TABLE;
+  params.phaseStep = wavePhaseStep(RATE / 8, RATE);
+  params.halfAmplitude = HALF;
+  params.center = CENTER;
+  params.table = table;
+  params.tableLength = 4;
+  waveReset(&channel);
+  wavePost(&channel, &params);
+  waveRender(&channel, quarter, 8);
+  const int expected[8] = {0, 0, HALF, HALF, -HALF, -HALF, HALF / 2, HALF / 2};
+  for (int i = 0; i < 8; i++) {
+    CHECK(abs(quarter[i] - (CENTER + expected[i])) <= 1);
+  }
+
+  // noise stays inside the amplitude and averages out to the center
+  start(&channel, WAVE_NOISE, 1000);
+  waveRender(&channel, out, RATE);
+  double sum = 0;
+  int low = 4095;
+  int high = 0;
+  for (int i = 0; i < RATE; i++) {
+    sum += out[i];
+    low = out[i] < low ? out[i] : low;
+    high = out[i] > high ? out[i] : high;
+  }
+  CHECK(fabs(sum / RATE - CENTER) < 20);
+  CHECK(low >= CENTER - HALF && low < CENTER - HALF + 20);
+  CHECK(high <= CENTER + HALF && high > CENTER + HALF - 20);
+
+  // past the rails it clips rather than wrapping
+  params.shape = WAVE_SQUARE;
+  params.center = 3500;
+  params.phaseStep = wavePhaseStep(RATE / 4, RATE);
+  waveReset(&channel);
+  wavePost(&channel, &params);
+  waveRender(&channel, quarter, 4);
+  CHECK_EQ(quarter[0], 4095);
+  CHECK_EQ(quarter[2], 3500 - HALF);
+  params.center = 500;
+  wavePost(&channel, &params);
+  waveRender(&channel, quarter, 4);
+  CHECK_EQ(quarter[2], 0);
+}
+
+// retuning carries on from the accumulated phase: the first sample after a
+// change is where the old phase plus the new step puts it, so there's no
+// jump bigger than the steeper of the two slopes
+static void testRetune(void) {
+  struct waveChannel channel;
+  start(&channel, WAVE_SINE, 440);
+  waveRender(&channel, out, 1000);
+
+  uint32_t phase = channel.phase;
+  struct waveParams params = channel.active;
+  params.phaseStep = wavePhaseStep(1000, RATE);
+  params.halfAmplitude = HALF / 2;
+  wavePost(&channel, &params);
+  waveRender(&channel, out + 1000, 1000);
+
+  double ideal = CENTER + (HALF / 2) * sin(2 * M_PI * phase / 4294967296.0);
+  CHECK(fabs(out[1000] - ideal) <= 2.0);
+  double slope = HALF * 2 * M_PI * 1000.0 / RATE;
+  for (int i = 1; i < 2000; i++) {
+    CHECK(abs(out[i] - out[i - 1]) <= slope + HALF / 2 + 2);
+  }
+  int crossings;
+  double measured = risingFrequency(out + 1000, 1000, &crossings);
+  CHECK(fabs(measured - 1000.0) < 1.0);
+}
+
+// params being written (odd sequence) aren't picked up, and get applied on
+// the first sample after the writer finishes
+static void testPostSequence(void) {
+  struct waveChannel channel;
+  start(&channel, WAVE_SQUARE, RATE / 4);
+  uint16_t sample = waveNextSample(&channel);
+  CHECK_EQ(sample, CENTER + HALF);
+
+  struct waveParams params = channel.active;
+  params.center = 2000;
+  channel.pendingSeq++; // the writer's half way through
+  channel.pending = params;
+  CHECK_EQ(waveNextSample(&channel), CENTER + HALF);
+  CHECK_EQ(channel.appliedSeq, channel.pendingSeq - 1);
+  channel.pendingSeq++;
+  CHECK_EQ(waveNextSample(&channel), 2000 - HALF); // the low half, moved
+  CHECK_EQ(channel.appliedSeq, channel.pendingSeq);
+}
+
+int main(void) {
+  waveInitTables();
+  testPhaseStep();
+  testSine();
+  testShapes();
+  testRetune();
+  testPostSequence();
+  return checkResult("test_waveforms");
+}